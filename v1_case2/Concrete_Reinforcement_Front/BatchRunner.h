@@ -0,0 +1,796 @@
+#pragma once
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+#include "BeamBatch.h"
+#include "DesignCache.h"
+#include "DesignStore.h"
+#include "DrawingSheets.h"
+#include "ThreadPool.h"
+
+// --- Batch Input Row ---
+// Units follow the GUI fields: lengths in mm, wheel span in m, vehicle load in kN.
+struct BeamInput
+{
+    double span = 0;
+    double width = 0;
+    double height = 0;
+    double vehicleLoad = 0;
+    double wheelSpan = 0;
+    double girderSpacing = 0;
+    MaterialGrade grade;
+};
+
+// --- Batch Output Row ---
+struct BeamResult
+{
+    bool success = false;
+    RebarDesign design;
+    double width = 0;
+    double height = 0;
+    double h0 = 0;
+    MaterialGrade grade;
+};
+
+enum class BatchFormat
+{
+    Csv,
+    JsonLines
+};
+
+// --- Headless Batch Runner ---
+// Streams beams from a CSV or JSON-lines file through RebarCalc::runDesign on the
+// shared work-stealing pool. Rows are processed in fixed-size blocks: while one block
+// is being designed, the previous block is written out and the next one is parsed,
+// so results leave in input order with bounded memory regardless of file size.
+class BatchRunner
+{
+public:
+    explicit BatchRunner(WorkStealingPool& pool) : pool(pool) {}
+
+    // When set, width and height are chosen by RebarCalc::runSectionOptimization and
+    // the width/height input columns are ignored.
+    void setSectionOptimization(bool enabled) { optimizeSection = enabled; }
+    // Optional cache shared by all worker threads; repeated rows are then answered
+    // without redesigning. Not used together with the section optimizer.
+    void setCache(DesignCache* designCache) { cache = designCache; }
+    // Appends every design, in input order, to a binary design store.
+    void setStore(DesignStoreWriter* designStore) { store = designStore; }
+    // Hands every design, in input order, to a drawing-sheet pipeline. The pipeline's
+    // queue holds back the write stage, and with it the reader, when drawing falls behind.
+    void setSheets(SheetPipeline* sheetPipeline) { sheets = sheetPipeline; }
+    // Routes plain runDesign rows through the structure-of-arrays SIMD kernel.
+    // With verification on, every block is re-run through RebarCalc and compared.
+    void setVectorized(bool enabled, bool verify = false) { vectorized = enabled; verifyKernel = verify; }
+    // Designs every row for this axle train instead of the two-axle vehicle given by the
+    // load and wheel span columns (which are then ignored).
+    void setAxleTrain(const AxleTrain* axleTrain) { train = axleTrain; }
+    // Designs zoned stirrups (RebarCalc::setStirrupZoning) and adds the zones to the output.
+    void setStirrupZoning(bool enabled) { zonedStirrups = enabled; }
+    // Lets designs mix bar diameters (RebarCalc::setMixedDiameters) and adds the bar
+    // layout to the output.
+    void setMixedDiameters(bool enabled) { mixedDiameters = enabled; }
+    // Material grades of the rows that do not name their own in concrete / steel columns.
+    void setMaterialGrade(MaterialGrade grade) { defaultGrade = grade; }
+    // Rows per pool task. Small grains spread a handful of rows over all workers, as the
+    // design service does for its short batches.
+    void setGrainSize(size_t rows) { grainSize = rows > 0 ? rows : 1; }
+    size_t kernelMismatches() const { return mismatchCount.load(); }
+
+    bool run(std::istream& in, BatchFormat inputFormat, std::ostream& out, BatchFormat outputFormat);
+    void designBlock(const std::vector<BeamInput>& inputs, std::vector<BeamResult>& results);
+
+    size_t rowsProcessed() const { return rowCount; }
+    size_t rowsFailed() const { return failedCount; }
+    size_t rowsSkipped() const { return skippedCount; }
+    const std::string& lastError() const { return errorText; }
+
+    static constexpr size_t BLOCK_SIZE = 16384;
+    static constexpr size_t GRAIN_SIZE = 256;
+    // span, width, height, load, wheelSpan, girderSpacing, then the optional concrete and steel grades.
+    static constexpr int CSV_COLUMNS = 8;
+
+private:
+    WorkStealingPool& pool;
+    bool optimizeSection = false;
+    DesignCache* cache = nullptr;
+    DesignStoreWriter* store = nullptr;
+    SheetPipeline* sheets = nullptr;
+    bool vectorized = false;
+    bool verifyKernel = false;
+    const AxleTrain* train = nullptr;
+    bool zonedStirrups = false;
+    bool mixedDiameters = false;
+    MaterialGrade defaultGrade;
+    size_t grainSize = GRAIN_SIZE;
+    std::atomic<size_t> mismatchCount{ 0 };
+    size_t rowCount = 0;
+    size_t failedCount = 0;
+    size_t skippedCount = 0;
+    std::string errorText;
+
+    // CSV column order, resolved from an optional header line.
+    int columnMap[CSV_COLUMNS] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    bool headerChecked = false;
+
+    size_t readBlock(std::istream& in, BatchFormat format, std::vector<BeamInput>& block);
+    bool parseCsvLine(const std::string& line, BeamInput& row);
+    void writeBlock(std::ostream& out, BatchFormat format, const std::vector<BeamInput>& inputs, const std::vector<BeamResult>& results,
+        size_t firstIndex);
+    // Designs the rows rows[0..count) of `inputs`, grouped by material grade so that each
+    // group runs on one engine specialized for its grades.
+    void designRowsByGrade(const std::vector<BeamInput>& inputs, std::vector<BeamResult>& results, size_t* rows, size_t count);
+    // Plain rows go through RebarCalc::designKernel in `scratch`, behind the cache when one
+    // is set, without heap allocations.
+    template <typename Calc>
+    void designRow(Calc& calc, DesignScratch& scratch, const BeamInput& in, BeamResult& out);
+};
+
+// Parses a JSON object line such as {"span":20000,"width":400,...}. Only flat numeric
+// fields are understood; unknown keys are ignored.
+bool parseJsonNumberField(const std::string& line, const char* key, double& value);
+// Reads a string (or bare) field such as "concrete":"C40" as text.
+bool parseJsonTextField(const std::string& line, const char* key, std::string& value);
+bool parseBeamJsonLine(const std::string& line, BeamInput& row);
+// Same check as the GUI inputs: span, section, load and girder spacing must be greater than
+// zero (NaN fails too) and the wheel span must not be negative.
+bool isValidBeamInput(const BeamInput& row);
+// Writes the result fields of one design ("ok":...,"steel":"...") as JSON members without
+// the enclosing braces; stirrup zones are added as an array and the bar layout as text
+// (flexuralLayoutText) when requested. Returns the number of characters written, which
+// is always less than `size`.
+int formatBeamResultJson(char* buffer, size_t size, const BeamResult& result, bool stirrupZones, bool barLayout = false);
+BatchFormat batchFormatFromPath(const std::string& path);
+int runBatchCommandLine(int argc, char* argv[]);
+int runStoreQueryCommandLine(int argc, char* argv[]);
+
+
+// --- Function Implementations ---
+
+inline BatchFormat batchFormatFromPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    std::string ext = (dot == std::string::npos) ? "" : path.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    return (ext == "jsonl" || ext == "ndjson" || ext == "json") ? BatchFormat::JsonLines : BatchFormat::Csv;
+}
+
+inline bool parseJsonNumberField(const std::string& line, const char* key, double& value) {
+    std::string quoted = std::string("\"") + key + "\"";
+    size_t pos = line.find(quoted);
+    if (pos == std::string::npos) return false;
+    pos = line.find(':', pos + quoted.size());
+    if (pos == std::string::npos) return false;
+    const char* begin = line.c_str() + pos + 1;
+    char* end = nullptr;
+    value = std::strtod(begin, &end);
+    return end != begin;
+}
+
+inline bool parseJsonTextField(const std::string& line, const char* key, std::string& value) {
+    std::string quoted = std::string("\"") + key + "\"";
+    size_t pos = line.find(quoted);
+    if (pos == std::string::npos) return false;
+    pos = line.find(':', pos + quoted.size());
+    if (pos == std::string::npos) return false;
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos) return false;
+    size_t end;
+    if (line[pos] == '"') end = line.find('"', ++pos);
+    else end = line.find_first_of(",} \t", pos);
+    if (end == std::string::npos) end = line.size();
+    value = line.substr(pos, end - pos);
+    return !value.empty();
+}
+
+// Grades are optional; a row that leaves them out keeps the grades already in `row`.
+inline bool parseBeamJsonLine(const std::string& line, BeamInput& row) {
+    bool ok = parseJsonNumberField(line, "span", row.span)
+        && parseJsonNumberField(line, "width", row.width)
+        && parseJsonNumberField(line, "height", row.height)
+        && (parseJsonNumberField(line, "load", row.vehicleLoad) || parseJsonNumberField(line, "vehicleLoad", row.vehicleLoad))
+        && parseJsonNumberField(line, "girderSpacing", row.girderSpacing);
+    if (!parseJsonNumberField(line, "wheelSpan", row.wheelSpan)) row.wheelSpan = 0;
+    std::string grade;
+    if (parseJsonTextField(line, "concrete", grade) && !parseConcreteGrade(grade, row.grade.concrete)) ok = false;
+    if (parseJsonTextField(line, "steel", grade) && !parseSteelGrade(grade, row.grade.steel)) ok = false;
+    return ok;
+}
+
+inline bool isValidBeamInput(const BeamInput& row) {
+    return row.span > 0 && row.width > 0 && row.height > 0 && row.vehicleLoad > 0 && row.girderSpacing > 0
+        && row.wheelSpan >= 0 && std::isfinite(row.span) && std::isfinite(row.width) && std::isfinite(row.height)
+        && std::isfinite(row.vehicleLoad) && std::isfinite(row.wheelSpan) && std::isfinite(row.girderSpacing);
+}
+
+inline int formatBeamResultJson(char* buffer, size_t size, const BeamResult& r, bool stirrupZones, bool barLayout) {
+    if (size == 0) return 0;
+    const RebarDesign& d = r.design;
+    int n = snprintf(buffer, size,
+        "\"ok\":%s,\"width\":%g,\"height\":%g,\"totalCost\":%.2f,\"concreteCost\":%.2f,\"steelCost\":%.2f,\"laborCost\":%.2f,"
+        "\"diameter\":%g,\"rows\":%d,\"row1\":%d,\"row2\":%d,\"stirrupDiameter\":%g,\"stirrupLegs\":%d,"
+        "\"stirrupSpacing\":%g,\"bentBars\":%d,\"maxMoment\":%.1f,\"maxShear\":%.1f,\"h0\":%.2f,\"concrete\":\"%s\",\"steel\":\"%s\"",
+        r.success ? "true" : "false", r.width, r.height, d.totalCost, d.concreteCost, d.steelCost, d.laborCost,
+        d.flexureRebarDiameter, d.rebarRows, d.rebarCountRow1, d.rebarCountRow2, d.stirrupDiameter, d.stirrupLegs,
+        d.stirrupSpacing, d.bentRebarCount, d.maxMoment, d.maxShear, r.h0, concreteGradeName(r.grade.concrete), steelGradeName(r.grade.steel));
+    n = std::min(n, (int)size - 1);
+    if (stirrupZones) {
+        // [[start,end,spacing],...] (mm).
+        n += snprintf(buffer + n, size - n, ",\"stirrupZones\":[");
+        for (int z = 0; z < d.stirrupZoneCount && n < (int)size - 64; ++z) {
+            const StirrupZone& zone = d.stirrupZones[z];
+            n += snprintf(buffer + n, size - n, "%s[%g,%g,%g]", z > 0 ? "," : "", zone.start, zone.end, zone.spacing);
+        }
+        n = std::min(n, (int)size - 1);
+        n += snprintf(buffer + n, size - n, "]");
+    }
+    n = std::min(n, (int)size - 1);
+    if (barLayout) n += snprintf(buffer + n, size - n, ",\"layout\":\"%s\"", flexuralLayoutText(d).c_str());
+    return std::min(n, (int)size - 1);
+}
+
+inline bool BatchRunner::parseCsvLine(const std::string& line, BeamInput& row) {
+    // Split the line in place into trimmed cells.
+    const char* cells[CSV_COLUMNS];
+    size_t lengths[CSV_COLUMNS];
+    int cellCount = 0;
+    const char* cursor = line.c_str();
+    while (cellCount < CSV_COLUMNS) {
+        while (*cursor == ' ' || *cursor == '\t') ++cursor;
+        const char* begin = cursor;
+        while (*cursor && *cursor != ',' && *cursor != ';') ++cursor;
+        const char* end = cursor;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) --end;
+        cells[cellCount] = begin;
+        lengths[cellCount++] = end - begin;
+        if (!*cursor) break;
+        ++cursor;
+    }
+
+    double values[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int field = 0; field < 6; ++field) {
+        int column = columnMap[field];
+        if (column >= cellCount || lengths[column] == 0) return false;
+        char* end = nullptr;
+        values[field] = std::strtod(cells[column], &end);
+        if (end != cells[column] + lengths[column]) return false;
+    }
+    row.span = values[0];
+    row.width = values[1];
+    row.height = values[2];
+    row.vehicleLoad = values[3];
+    row.wheelSpan = values[4];
+    row.girderSpacing = values[5];
+
+    // Grade columns are optional; empty or missing cells keep the run's default grades.
+    row.grade = defaultGrade;
+    int concreteColumn = columnMap[6], steelColumn = columnMap[7];
+    if (concreteColumn < cellCount && lengths[concreteColumn] > 0
+        && !parseConcreteGrade(std::string(cells[concreteColumn], lengths[concreteColumn]), row.grade.concrete)) return false;
+    if (steelColumn < cellCount && lengths[steelColumn] > 0
+        && !parseSteelGrade(std::string(cells[steelColumn], lengths[steelColumn]), row.grade.steel)) return false;
+    return true;
+}
+
+inline size_t BatchRunner::readBlock(std::istream& in, BatchFormat format, std::vector<BeamInput>& block) {
+    block.clear();
+    std::string line;
+    while (block.size() < BLOCK_SIZE && std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        BeamInput row;
+        row.grade = defaultGrade;
+        if (format == BatchFormat::JsonLines) {
+            if (!parseBeamJsonLine(line, row)) { ++skippedCount; continue; }
+        }
+        else {
+            if (!headerChecked) {
+                headerChecked = true;
+                if (!parseCsvLine(line, row)) {
+                    // Header line: map the known column names onto their positions.
+                    const char* names[CSV_COLUMNS][3] = { { "span" }, { "width" }, { "height" }, { "load", "vehicleload", "weight" },
+                        { "wheelspan" }, { "girderspacing" }, { "concrete" }, { "steel" } };
+                    std::vector<std::string> headers;
+                    std::string cell;
+                    for (char c : line + ",") {
+                        if (c == ',' || c == ';') { headers.push_back(cell); cell.clear(); }
+                        else if (c != ' ' && c != '"') cell += (char)tolower((unsigned char)c);
+                    }
+                    for (int field = 0; field < CSV_COLUMNS; ++field) {
+                        for (size_t col = 0; col < headers.size() && col < (size_t)CSV_COLUMNS; ++col) {
+                            for (const char* name : names[field]) {
+                                if (name && headers[col].compare(0, strlen(name), name) == 0) columnMap[field] = (int)col;
+                            }
+                        }
+                    }
+                    continue;
+                }
+            }
+            else if (!parseCsvLine(line, row)) { ++skippedCount; continue; }
+        }
+        if (!isValidBeamInput(row)) { ++skippedCount; continue; }
+        block.push_back(row);
+    }
+    return block.size();
+}
+
+inline void BatchRunner::designBlock(const std::vector<BeamInput>& inputs, std::vector<BeamResult>& results) {
+    results.resize(inputs.size());
+    if (vectorized && !optimizeSection && !train && !zonedStirrups && !mixedDiameters) {
+        // The SIMD kernel is the C50 / HRB400 engine; rows of other grades are designed
+        // by their specialized RebarCalcT instead.
+        parallelFor(pool, 0, inputs.size(), grainSize, [&](size_t begin, size_t end) {
+            BeamBatch batch;
+            batch.reserve(end - begin);
+            std::vector<size_t> kernelRows, otherRows;
+            kernelRows.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                const BeamInput& in = inputs[i];
+                if (in.grade != RebarCalc::materialGrade()) {
+                    otherRows.push_back(i);
+                    continue;
+                }
+                batch.add(in.span, in.width, in.height, in.vehicleLoad, in.wheelSpan, in.girderSpacing);
+                kernelRows.push_back(i);
+            }
+            BeamBatchResults batchResults;
+            designBeamBatch(batch, batchResults);
+            if (verifyKernel) mismatchCount += countBatchMismatches(batch, batchResults);
+            for (size_t k = 0; k < kernelRows.size(); ++k) {
+                size_t i = kernelRows[k];
+                BeamResult& out = results[i];
+                out.success = batchResults.success[k] != 0;
+                out.design = batchResults.toDesign(k);
+                out.width = inputs[i].width;
+                out.height = inputs[i].height;
+                out.h0 = batchResults.h0[k];
+                out.grade = inputs[i].grade;
+            }
+            if (!otherRows.empty()) designRowsByGrade(inputs, results, otherRows.data(), otherRows.size());
+        });
+        return;
+    }
+
+    parallelFor(pool, 0, inputs.size(), grainSize, [&](size_t begin, size_t end) {
+        std::vector<size_t> rows(end - begin);
+        for (size_t i = begin; i < end; ++i) rows[i - begin] = i;
+        designRowsByGrade(inputs, results, rows.data(), rows.size());
+    });
+}
+
+inline void BatchRunner::designRowsByGrade(const std::vector<BeamInput>& inputs, std::vector<BeamResult>& results, size_t* rows, size_t count) {
+    // Usually every row has the same grades and this is a single group.
+    std::stable_sort(rows, rows + count, [&inputs](size_t a, size_t b) { return inputs[a].grade.code() < inputs[b].grade.code(); });
+    for (size_t first = 0; first < count;) {
+        MaterialGrade grade = inputs[rows[first]].grade;
+        size_t last = first + 1;
+        while (last < count && inputs[rows[last]].grade == grade) ++last;
+        dispatchMaterialGrade(grade, [&](auto tag) {
+            // One engine and scratch per grade and thread, kept from task to task, so that
+            // a warm scratch is not thrown away after every grain of rows.
+            static thread_local typename decltype(tag)::Calc calc;
+            static thread_local DesignScratch scratch;
+            calc.setStirrupZoning(zonedStirrups);
+            calc.setMixedDiameters(mixedDiameters);
+            for (size_t k = first; k < last; ++k) designRow(calc, scratch, inputs[rows[k]], results[rows[k]]);
+        });
+        first = last;
+    }
+}
+
+template <typename Calc>
+inline void BatchRunner::designRow(Calc& calc, DesignScratch& scratch, const BeamInput& in, BeamResult& out) {
+    out.grade = in.grade;
+    if (!optimizeSection && !train) {
+        DesignKernelResult result;
+        if (cache) out.success = cache->designKernel(calc, in.span, in.width, in.height, in.vehicleLoad, in.wheelSpan, in.girderSpacing, scratch, result);
+        else out.success = calc.designKernel(in.span, in.width, in.height, in.vehicleLoad, in.wheelSpan, in.girderSpacing, scratch, result);
+        static_cast<RebarDesignCore&>(out.design) = result.design;
+        out.design.errorMessage = designErrorMessage(result.error); // reuses the capacity of the row's last message
+        out.width = result.params.width;
+        out.height = result.params.height;
+        out.h0 = result.params.h0;
+        return;
+    }
+    if (optimizeSection) out.success = calc.runSectionOptimization(in.span, in.vehicleLoad, in.wheelSpan, in.girderSpacing);
+    else out.success = calc.runDesign(in.span, in.width, in.height, *train, in.girderSpacing);
+    out.design = calc.getDesignResults();
+    out.width = calc.getParams().width;
+    out.height = calc.getParams().height;
+    out.h0 = calc.getParams().h0;
+}
+
+inline void BatchRunner::writeBlock(std::ostream& out, BatchFormat format, const std::vector<BeamInput>& inputs, const std::vector<BeamResult>& results,
+    size_t firstIndex) {
+    char buffer[1024];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BeamResult& r = results[i];
+        const RebarDesign& d = r.design;
+        if (!r.success) ++failedCount;
+        int n;
+        if (format == BatchFormat::JsonLines) {
+            n = snprintf(buffer, sizeof(buffer), "{\"index\":%zu,", firstIndex + i);
+            n += formatBeamResultJson(buffer + n, sizeof(buffer) - n, r, zonedStirrups, mixedDiameters);
+            n += snprintf(buffer + n, sizeof(buffer) - n, "}\n");
+        }
+        else {
+            n = snprintf(buffer, sizeof(buffer), "%zu,%d,%g,%g,%.2f,%.2f,%.2f,%.2f,%g,%d,%d,%d,%g,%d,%g,%d,%.1f,%.1f,%.2f,%s,%s",
+                firstIndex + i, r.success ? 1 : 0, r.width, r.height, d.totalCost, d.concreteCost, d.steelCost, d.laborCost,
+                d.flexureRebarDiameter, d.rebarRows, d.rebarCountRow1, d.rebarCountRow2, d.stirrupDiameter, d.stirrupLegs,
+                d.stirrupSpacing, d.bentRebarCount, d.maxMoment, d.maxShear, r.h0, concreteGradeName(r.grade.concrete), steelGradeName(r.grade.steel));
+            n = std::min(n, (int)sizeof(buffer) - 1);
+            if (zonedStirrups) {
+                // start-end@spacing;... (mm).
+                n += snprintf(buffer + n, sizeof(buffer) - n, ",");
+                for (int z = 0; z < d.stirrupZoneCount && n < (int)sizeof(buffer) - 64; ++z) {
+                    const StirrupZone& zone = d.stirrupZones[z];
+                    n += snprintf(buffer + n, sizeof(buffer) - n, "%s%g-%g@%g", z > 0 ? ";" : "", zone.start, zone.end, zone.spacing);
+                }
+                n = std::min(n, (int)sizeof(buffer) - 1);
+            }
+            if (mixedDiameters) n += snprintf(buffer + n, sizeof(buffer) - n, ",%s", flexuralLayoutText(d).c_str());
+            n = std::min(n, (int)sizeof(buffer) - 2);
+            n += snprintf(buffer + n, sizeof(buffer) - n, "\n");
+        }
+        out.write(buffer, std::min(n, (int)sizeof(buffer) - 1));
+
+        if (store) {
+            const BeamInput& in = inputs[i];
+            store->append(makeDesignRecord(in.span, r.width, r.height, in.vehicleLoad, in.wheelSpan, in.girderSpacing, r.grade, r.success, d, r.h0));
+        }
+        if (sheets) {
+            const BeamInput& in = inputs[i];
+            SheetJob job;
+            job.index = firstIndex + i;
+            job.params.span = in.span;
+            job.params.width = r.width;
+            job.params.height = r.height;
+            job.params.h0 = r.h0;
+            job.params.wheelSpan = in.wheelSpan * 1000.0;
+            job.params.girderSpacing = in.girderSpacing;
+            job.design = d;
+            job.grade = r.grade;
+            sheets->submit(std::move(job));
+        }
+    }
+}
+
+inline bool BatchRunner::run(std::istream& in, BatchFormat inputFormat, std::ostream& out, BatchFormat outputFormat) {
+    rowCount = failedCount = skippedCount = 0;
+    headerChecked = false;
+    for (int i = 0; i < CSV_COLUMNS; ++i) columnMap[i] = i;
+
+    if (outputFormat == BatchFormat::Csv) {
+        out << "index,ok,width,height,totalCost,concreteCost,steelCost,laborCost,diameter,rows,row1,row2,"
+            "stirrupDiameter,stirrupLegs,stirrupSpacing,bentBars,maxMoment,maxShear,h0,concrete,steel" << (zonedStirrups ? ",stirrupZones" : "")
+            << (mixedDiameters ? ",layout\n" : "\n");
+    }
+
+    // Two buffers in flight: while one block is designed, the other is written and refilled.
+    std::vector<BeamInput> inputs[2];
+    std::vector<BeamResult> results[2];
+    size_t firstIndex[2] = { 0, 0 };
+    int current = 0;
+    bool pendingWrite = false;
+
+    readBlock(in, inputFormat, inputs[current]);
+    while (!inputs[current].empty() || pendingWrite) {
+        int previous = 1 - current;
+        bool haveWork = !inputs[current].empty();
+        firstIndex[current] = rowCount;
+        rowCount += inputs[current].size();
+
+        // Design the current block in the background.
+        TaskGroup group(pool);
+        if (haveWork) group.run([&, current]() { designBlock(inputs[current], results[current]); });
+
+        // Meanwhile flush the previous block and parse the next one on this thread.
+        if (pendingWrite) writeBlock(out, outputFormat, inputs[previous], results[previous], firstIndex[previous]);
+        pendingWrite = false;
+        if (haveWork) readBlock(in, inputFormat, inputs[previous]);
+        else inputs[previous].clear();
+
+        group.wait();
+        pendingWrite = haveWork;
+        current = previous;
+        if (!out) {
+            errorText = "Error: Failed writing batch output.";
+            return false;
+        }
+        if (sheets && sheets->hasFailed()) {
+            errorText = sheets->lastError();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Usage: --batch <input.csv|input.jsonl> <output.csv|output.jsonl> [--threads N] [--optimize-section] [--cache N]
+//        [--vectorized [--verify]] [--axle-train kN@m,kN@m,...] [--zoned-stirrups] [--trace trace.json]
+//        [--concrete C30..C60] [--steel HRB335|HRB400|HRB500] [--store designs.rbds] [--mixed-diameters]
+//        [--sheets dir [--sheet-format png|jpg|pdf] [--sheet-threads N]]
+inline int runBatchCommandLine(int argc, char* argv[]) {
+    std::string inputPath, outputPath;
+    unsigned threads = 0;
+    bool optimizeSection = false;
+    size_t cacheEntries = 65536;
+    bool vectorized = false, verify = false;
+    std::string trainSpec;
+    bool zonedStirrups = false;
+    bool mixedDiameters = false;
+    std::string tracePath;
+    std::string concreteName, steelName;
+    std::string storePath;
+    std::string sheetDirectory, sheetFormatName = "png";
+    unsigned sheetThreads = 0;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--optimize-section") optimizeSection = true;
+        else if (arg == "--cache" && i + 1 < argc) cacheEntries = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--vectorized") vectorized = true;
+        else if (arg == "--verify") verify = true;
+        else if (arg == "--axle-train" && i + 1 < argc) trainSpec = argv[++i];
+        else if (arg == "--zoned-stirrups") zonedStirrups = true;
+        else if (arg == "--mixed-diameters") mixedDiameters = true;
+        else if (arg == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (arg == "--concrete" && i + 1 < argc) concreteName = argv[++i];
+        else if (arg == "--steel" && i + 1 < argc) steelName = argv[++i];
+        else if (arg == "--store" && i + 1 < argc) storePath = argv[++i];
+        else if (arg == "--sheets" && i + 1 < argc) sheetDirectory = argv[++i];
+        else if (arg == "--sheet-format" && i + 1 < argc) sheetFormatName = argv[++i];
+        else if (arg == "--sheet-threads" && i + 1 < argc) sheetThreads = (unsigned)std::atoi(argv[++i]);
+        else if (inputPath.empty()) inputPath = arg;
+        else if (outputPath.empty()) outputPath = arg;
+    }
+    if (inputPath.empty() || outputPath.empty()) {
+        std::cerr << "Usage: --batch <input.csv|input.jsonl> <output.csv|output.jsonl> [--threads N] [--optimize-section] [--cache N] [--vectorized [--verify]]"
+            " [--axle-train kN@m,kN@m,...] [--zoned-stirrups] [--trace trace.json]"
+            " [--concrete C30..C60] [--steel HRB335|HRB400|HRB500] [--store designs.rbds] [--mixed-diameters]"
+            " [--sheets dir [--sheet-format png|jpg|pdf] [--sheet-threads N]]\n";
+        return 2;
+    }
+    MaterialGrade grade;
+    if (!concreteName.empty() && !parseConcreteGrade(concreteName, grade.concrete)) {
+        std::cerr << "Error: Unknown concrete grade '" << concreteName << "' (expected C30, C35, ... C60)\n";
+        return 2;
+    }
+    if (!steelName.empty() && !parseSteelGrade(steelName, grade.steel)) {
+        std::cerr << "Error: Unknown steel grade '" << steelName << "' (expected HRB335, HRB400 or HRB500)\n";
+        return 2;
+    }
+    AxleTrain train;
+    if (!trainSpec.empty()) {
+        if (!AxleTrain::parse(trainSpec, train)) {
+            std::cerr << "Error: Invalid axle train '" << trainSpec << "' (expected e.g. 35@0,145@4.3,145@8.6)\n";
+            return 2;
+        }
+        if (optimizeSection) {
+            std::cerr << "Error: --axle-train cannot be combined with --optimize-section\n";
+            return 2;
+        }
+    }
+
+    SheetFormat sheetFormat;
+    if (!parseSheetFormat(sheetFormatName, sheetFormat)) {
+        std::cerr << "Error: Unknown sheet format '" << sheetFormatName << "' (expected png, jpg or pdf)\n";
+        return 2;
+    }
+
+    if (mixedDiameters && !storePath.empty()) {
+        // Store records hold one bar diameter.
+        std::cerr << "Error: --mixed-diameters cannot be combined with --store\n";
+        return 2;
+    }
+
+#ifndef REBAR_ENABLE_INSTRUMENTATION
+    if (!tracePath.empty()) {
+        std::cerr << "Error: --trace needs a build with REBAR_ENABLE_INSTRUMENTATION defined\n";
+        return 2;
+    }
+#endif
+
+    std::ifstream in(inputPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: Cannot open input file " << inputPath << "\n";
+        return 1;
+    }
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: Cannot open output file " << outputPath << "\n";
+        return 1;
+    }
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (threads > 0) ownPool.reset(new WorkStealingPool(threads));
+    WorkStealingPool& pool = ownPool ? *ownPool : sharedDesignPool();
+
+    BatchRunner runner(pool);
+    runner.setSectionOptimization(optimizeSection);
+    runner.setVectorized(vectorized, verify);
+    if (!trainSpec.empty()) runner.setAxleTrain(&train);
+    runner.setStirrupZoning(zonedStirrups);
+    runner.setMixedDiameters(mixedDiameters);
+    runner.setMaterialGrade(grade);
+    std::unique_ptr<DesignCache> cache;
+    // The cache key has no room for an axle train, so train runs are never cached.
+    if (cacheEntries > 0 && !optimizeSection && !vectorized && trainSpec.empty()) {
+        cache.reset(new DesignCache(cacheEntries));
+        runner.setCache(cache.get());
+    }
+    DesignStoreWriter store;
+    if (!storePath.empty()) {
+        std::string storeError;
+        if (!store.open(storePath, storeError)) {
+            std::cerr << storeError << "\n";
+            return 1;
+        }
+        runner.setStore(&store);
+    }
+    std::unique_ptr<SheetPipeline> sheets;
+    if (!sheetDirectory.empty()) {
+        sheets.reset(new SheetPipeline(sheetDirectory, sheetFormat, sheetThreads));
+        std::string sheetError;
+        if (!sheets->start(sheetError)) {
+            std::cerr << sheetError << "\n";
+            return 1;
+        }
+        runner.setSheets(sheets.get());
+    }
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    Instrumentation::reset();
+    Instrumentation::setTracing(!tracePath.empty());
+#endif
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runner.run(in, batchFormatFromPath(inputPath), out, batchFormatFromPath(outputPath));
+    out.flush();
+    // The last sheets are still being drawn and written when the batch output is done.
+    if (sheets && !sheets->finish() && ok) {
+        std::cerr << sheets->lastError() << "\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!ok) {
+        std::cerr << runner.lastError() << "\n";
+        return 1;
+    }
+    std::cerr << runner.rowsProcessed() << " beams designed (" << runner.rowsFailed() << " infeasible, "
+        << runner.rowsSkipped() << " unreadable or invalid rows skipped) in " << seconds << " s on " << pool.size()
+        << " threads: " << (seconds > 0 ? runner.rowsProcessed() / seconds : 0.0) << " beams/s\n";
+    if (cache) std::cerr << "Design cache: " << cache->hits() << " hits, " << cache->misses() << " misses\n";
+    if (sheets) {
+        std::cerr << "Drawing sheets: " << sheets->sheetsWritten() << " written to " << sheetDirectory << " (" << sheets->threadsPerStage()
+            << " threads per stage; busy per thread: rasterize " << sheets->rasterizeSeconds() << " s, encode and write "
+            << sheets->encodeSeconds() << " s)\n";
+    }
+    if (!storePath.empty()) {
+        // Rebuild the index over the whole store so later queries need no linear scan. The
+        // early returns above leave this to the writer's destructor.
+        std::string storeError;
+        size_t storedRecords = 0;
+        if (!store.finish(storeError, &storedRecords)) {
+            std::cerr << storeError << "\n";
+            return 1;
+        }
+        std::cerr << "Design store: " << storedRecords << " records in " << storePath << "\n";
+    }
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    // Stage times are summed over all worker threads, so they may exceed the wall time.
+    std::cerr << "Design stages (all threads):\n";
+    writeInstrumentationSummary(std::cerr, Instrumentation::snapshot());
+    Instrumentation::setTracing(false);
+    if (!tracePath.empty()) {
+        std::ofstream trace(tracePath, std::ios::binary);
+        if (!trace) {
+            std::cerr << "Error: Cannot open trace file " << tracePath << "\n";
+            return 1;
+        }
+        Instrumentation::writeChromeTrace(trace);
+        std::cerr << "Chrome trace written to " << tracePath << "\n";
+    }
+#endif
+    if (vectorized && verify) {
+        std::cerr << "Vectorized kernel check: " << runner.kernelMismatches() << " beams differ from RebarCalc::runDesign ("
+            << (cpuSupportsAvx2() ? "AVX2" : "scalar") << " path)\n";
+        if (runner.kernelMismatches() > 0) return 1;
+    }
+    return 0;
+}
+
+// Usage: --query <designs.rbds> [--span min:max] [--load min:max] [output.csv]
+// Spans are in mm and loads in kN; an omitted bound is open. Rows go to stdout without an output file.
+inline int runStoreQueryCommandLine(int argc, char* argv[]) {
+    std::string storePath, outputPath;
+    DesignQuery query;
+    bool badRange = false;
+    auto parseRange = [&badRange](const char* text, double& low, double& high) {
+        const char* colon = std::strchr(text, ':');
+        if (!colon) { badRange = true; return; }
+        if (colon != text) low = std::atof(text);
+        if (colon[1] != '\0') high = std::atof(colon + 1);
+    };
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--span" && i + 1 < argc) parseRange(argv[++i], query.minSpan, query.maxSpan);
+        else if (arg == "--load" && i + 1 < argc) parseRange(argv[++i], query.minLoad, query.maxLoad);
+        else if (storePath.empty()) storePath = arg;
+        else if (outputPath.empty()) outputPath = arg;
+    }
+    if (storePath.empty() || badRange) {
+        std::cerr << "Usage: --query <designs.rbds> [--span min:max] [--load min:max] [output.csv]\n";
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DesignStoreReader store;
+    std::string error;
+    if (!store.open(storePath, error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    // A missing, damaged or out-of-date index is rebuilt rather than falling back to a full
+    // scan every time.
+    std::string indexPath = storePath + ".idx";
+    DesignIndexReader index;
+    if (!index.open(indexPath, store, error)) {
+        if (!buildDesignIndex(store, indexPath, error) || !index.open(indexPath, store, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cerr << "Design index rebuilt: " << indexPath << "\n";
+    }
+    std::vector<uint64_t> matches;
+    index.query(store, query, matches);
+
+    std::ofstream file;
+    if (!outputPath.empty()) {
+        file.open(outputPath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: Cannot open output file " << outputPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = outputPath.empty() ? std::cout : file;
+    out << "record,span,width,height,vehicleLoad,wheelSpan,girderSpacing,ok,totalCost,diameter,rows,row1,row2,"
+        "stirrupDiameter,stirrupLegs,stirrupSpacing,bentBars,maxMoment,maxShear,h0,concrete,steel,error\n";
+    char buffer[512];
+    for (uint64_t m : matches) {
+        const DesignRecord& r = store[(size_t)m];
+        // Only the first line of the error message, so that every design stays on one CSV row.
+        const char* error = designErrorMessage((DesignErrorCode)r.errorCode);
+        int errorLength = (int)std::strcspn(error, "\n");
+        int n = snprintf(buffer, sizeof(buffer), "%llu,%g,%g,%g,%g,%g,%g,%d,%.2f,%g,%d,%d,%d,%g,%d,%g,%d,%.1f,%.1f,%.2f,%s,%s,%.*s\n",
+            (unsigned long long)m, r.span, r.width, r.height, r.vehicleLoad, r.wheelSpan, r.girderSpacing,
+            (r.flags & DESIGN_RECORD_SUCCESS) ? 1 : 0, r.totalCost, r.flexureRebarDiameter, r.rebarRows, r.rebarCountRow1, r.rebarCountRow2,
+            r.stirrupDiameter, r.stirrupLegs, r.stirrupSpacing, r.bentRebarCount, r.maxMoment, r.maxShear, r.h0,
+            concreteGradeName((ConcreteGrade)r.concreteGrade), steelGradeName((SteelGrade)r.steelGrade),
+            errorLength, error);
+        out.write(buffer, std::min(n, (int)sizeof(buffer) - 1));
+    }
+    out.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!out) {
+        std::cerr << "Error: Failed writing query output.\n";
+        return 1;
+    }
+    std::cerr << matches.size() << " of " << store.size() << " stored designs match (" << index.recordsCovered()
+        << " indexed) in " << seconds << " s\n";
+    return 0;
+}
+
+
+#endif // BATCHRUNNER_H
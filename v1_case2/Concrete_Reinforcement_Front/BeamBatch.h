@@ -0,0 +1,505 @@
+#pragma once
+
+#ifndef BEAMBATCH_H
+#define BEAMBATCH_H
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "RebarCalc.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define REBAR_HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(REBAR_HAS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define REBAR_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define REBAR_TARGET_AVX2
+#endif
+
+// --- Beam Batch (Structure of Arrays) ---
+// Inputs for many beams, one array per field, in the same units as RebarCalc::runDesign.
+struct BeamBatch
+{
+    std::vector<double> span;
+    std::vector<double> width;
+    std::vector<double> height;
+    std::vector<double> vehicleLoad;
+    std::vector<double> wheelSpan;     // m
+    std::vector<double> girderSpacing; // mm
+
+    size_t size() const { return span.size(); }
+    void clear();
+    void reserve(size_t n);
+    void add(double beamSpan, double beamWidth, double beamHeight, double load, double beamWheelSpan, double beamGirderSpacing);
+};
+
+// --- Batch Design Results (Structure of Arrays) ---
+// Integer quantities (bar counts, rows) are stored as doubles, which is how the SIMD
+// kernel carries them; they are always whole numbers.
+struct BeamBatchResults
+{
+    std::vector<unsigned char> success;
+    std::vector<double> flexureRebarDiameter;
+    std::vector<double> rebarRows;
+    std::vector<double> rebarCountRow1;
+    std::vector<double> rebarCountRow2;
+    std::vector<double> stirrupSpacing;
+    std::vector<double> bentRebarCount;
+    std::vector<double> totalCost;
+    std::vector<double> concreteCost;
+    std::vector<double> steelCost;
+    std::vector<double> laborCost;
+    std::vector<double> maxMoment;
+    std::vector<double> maxShear;
+    std::vector<double> h0;
+
+    size_t size() const { return success.size(); }
+    void resize(size_t n);
+    // Expands one beam back into the RebarDesign RebarCalc::runDesign would have produced.
+    RebarDesign toDesign(size_t i) const;
+};
+
+// Designs every beam of the batch: the simply supported force analysis, the flexure
+// check with calculateMaxBarsPerRow packing, the 8 mm / two-leg shear design and the
+// costing, for all seven standard diameters. Uses AVX2 (four beams per register) when
+// the CPU supports it and the scalar structure-of-arrays loop otherwise. Results are
+// bit-identical to RebarCalc::runDesign (C50 / HRB400) as long as the build does not
+// contract a*b+c into FMA instructions (no /fp:fast, no -ffp-contract=fast with -mfma).
+void designBeamBatch(const BeamBatch& batch, BeamBatchResults& results);
+void designBeamBatchScalar(const BeamBatch& batch, BeamBatchResults& results, size_t begin, size_t end);
+#if defined(REBAR_HAS_X86_SIMD)
+void designBeamBatchAvx2(const BeamBatch& batch, BeamBatchResults& results, size_t begin, size_t end);
+#endif
+bool cpuSupportsAvx2();
+
+// Runs the batch kernel and RebarCalc::runDesign on the same beams and counts the
+// beams whose results differ in any field. Used by the batch self-check (--verify).
+size_t countBatchMismatches(const BeamBatch& batch, const BeamBatchResults& results);
+
+
+// --- Function Implementations ---
+
+inline void BeamBatch::clear() {
+    span.clear(); width.clear(); height.clear(); vehicleLoad.clear(); wheelSpan.clear(); girderSpacing.clear();
+}
+
+inline void BeamBatch::reserve(size_t n) {
+    span.reserve(n); width.reserve(n); height.reserve(n); vehicleLoad.reserve(n); wheelSpan.reserve(n); girderSpacing.reserve(n);
+}
+
+inline void BeamBatch::add(double beamSpan, double beamWidth, double beamHeight, double load, double beamWheelSpan, double beamGirderSpacing) {
+    span.push_back(beamSpan);
+    width.push_back(beamWidth);
+    height.push_back(beamHeight);
+    vehicleLoad.push_back(load);
+    wheelSpan.push_back(beamWheelSpan);
+    girderSpacing.push_back(beamGirderSpacing);
+}
+
+inline void BeamBatchResults::resize(size_t n) {
+    success.resize(n); flexureRebarDiameter.resize(n); rebarRows.resize(n); rebarCountRow1.resize(n); rebarCountRow2.resize(n);
+    stirrupSpacing.resize(n); bentRebarCount.resize(n); totalCost.resize(n); concreteCost.resize(n); steelCost.resize(n);
+    laborCost.resize(n); maxMoment.resize(n); maxShear.resize(n); h0.resize(n);
+}
+
+inline RebarDesign BeamBatchResults::toDesign(size_t i) const {
+    RebarDesign d = {};
+    d.maxMoment = maxMoment[i];
+    d.maxShear = maxShear[i];
+    if (!success[i]) {
+        d.designPossible = false;
+        d.errorMessage = "Error: No valid reinforcement combination found.\nIncrease beam dimensions.";
+        return d;
+    }
+    d.rebarRows = (int)rebarRows[i];
+    d.rebarCountRow1 = (int)rebarCountRow1[i];
+    d.rebarCountRow2 = (int)rebarCountRow2[i];
+    d.flexureRebarDiameter = flexureRebarDiameter[i];
+    d.stirrupLegs = 2;
+    d.stirrupDiameter = 8;
+    d.stirrupSpacing = stirrupSpacing[i];
+    d.bentRebarCount = (int)bentRebarCount[i];
+    d.bentRebarsUsed = d.bentRebarCount > 0;
+    d.totalCost = totalCost[i];
+    d.concreteCost = concreteCost[i];
+    d.steelCost = steelCost[i];
+    d.laborCost = laborCost[i];
+    return d;
+}
+
+// Per-diameter constants, evaluated with exactly the expressions RebarCalc uses.
+struct BatchDiameterConstants
+{
+    double diameter;
+    double halfDiameter;
+    double areaPerBar;
+    double rowPitch;        // diameter + min clear spacing
+    double y1;              // first row centroid from the soffit
+    double y2;              // second row centroid from the soffit
+    double bentShear;       // Vsb of two bent bars
+    double flexPricePerTon;
+};
+
+inline const BatchDiameterConstants* batchDiameterTable() {
+    static const std::vector<BatchDiameterConstants> table = [] {
+        std::vector<BatchDiameterConstants> t;
+        for (double d : STANDARD_REBAR_DIAMETERS) {
+            BatchDiameterConstants c;
+            c.diameter = d;
+            c.halfDiameter = d / 2.0;
+            c.areaPerBar = M_PI * pow(d / 2.0, 2);
+            c.rowPitch = d + std::max(25.0, d);
+            c.y1 = CONCRETE_COVER + 8.0 + d / 2.0;
+            c.y2 = c.y1 + d + 25.0;
+            c.bentShear = 0.75 * RebarCalc::STEEL_FY * (2 * c.areaPerBar) * sin(M_PI / 4.0);
+            c.flexPricePerTon = COST_REBAR_BASE_PER_TON * (1.0 + (d - 14.0) * 0.025);
+            t.push_back(c);
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+inline void designBeamBatchScalar(const BeamBatch& batch, BeamBatchResults& results, size_t begin, size_t end) {
+    const BatchDiameterConstants* table = batchDiameterTable();
+    const double stirrupTotalArea = 2 * (M_PI * pow(8 / 2.0, 2));
+    const double stirrupPricePerTon = COST_REBAR_BASE_PER_TON * (1.0 + (8 - 14.0) * 0.025);
+
+    for (size_t i = begin; i < end; ++i) {
+        double span = batch.span[i], width = batch.width[i], height = batch.height[i];
+
+        // Load distribution and forces (runDesign / calculateMaxForces)
+        double wheel = batch.wheelSpan[i] * 1000.0;
+        double gs_m = batch.girderSpacing[i] / 1000.0;
+        double lfM = (gs_m > 0) ? (gs_m / 1.7) : 1.0;
+        double lfV = (gs_m > 0) ? (gs_m / 1.4) : 1.0;
+        double loadM = (batch.vehicleLoad[i] * lfM) * 1000.0;
+        double loadV = (batch.vehicleLoad[i] * lfV) * 1000.0;
+
+        double q = width * height * RebarCalc::CONCRETE_UNIT_WEIGHT;
+        double P = loadM / 2.0;
+        double x = span / 2.0 - wheel / 4.0;
+        double RA = (P * (span - x) + P * (span - x - wheel)) / span;
+        double maxM = q * span * span / 8.0 + RA * x;
+        double Pv = loadV / 2.0;
+        double maxV = q * span / 2.0 + (Pv * span + Pv * (span - wheel)) / span;
+
+        double numGirders = 1;
+        if (batch.girderSpacing[i] > 0) {
+            numGirders = 10000.0 / batch.girderSpacing[i];
+            if (numGirders < 2) numGirders = 2;
+        }
+        double minArea = 0.45 * (RebarCalc::CONCRETE_FT / RebarCalc::STEEL_FY) * width * height;
+        double available = width - (2 * CONCRETE_COVER) - (2 * 8.0);
+
+        double best = std::numeric_limits<double>::max();
+        bool found = false;
+        double bD = 0, bRows = 0, bRow1 = 0, bRow2 = 0, bSp = 0, bBent = 0, bTotal = 0, bConc = 0, bSteel = 0, bLabor = 0, bH0 = 0;
+
+        for (int di = 0; di < STANDARD_REBAR_COUNT; ++di) {
+            const BatchDiameterConstants& c = table[di];
+            double h0 = height - CONCRETE_COVER - 8.0 - c.halfDiameter;
+            if (h0 <= 0) continue;
+
+            double req = maxM / (RebarCalc::STEEL_FY * 0.9 * h0);
+            if (req < minArea) req = minArea;
+            double totalBars = std::ceil(req / c.areaPerBar);
+            if (totalBars < 2) totalBars = 2;
+
+            if (available < c.diameter) continue;
+            double maxPerRow = 1 + std::floor((available - c.diameter) / c.rowPitch);
+
+            double rows, row1, row2;
+            if (totalBars <= maxPerRow) {
+                rows = 1; row1 = totalBars; row2 = 0;
+            }
+            else {
+                rows = 2;
+                row1 = std::ceil(totalBars / 2.0);
+                row2 = totalBars - row1;
+                if (row1 > maxPerRow || row2 > maxPerRow) continue;
+                double As1 = row1 * c.areaPerBar;
+                double As2 = row2 * c.areaPerBar;
+                h0 = height - ((As1 * c.y1 + As2 * c.y2) / (As1 + As2));
+            }
+            double xi = ((totalBars * c.areaPerBar) * RebarCalc::STEEL_FY) / (1.0 * RebarCalc::CONCRETE_FC * width) / h0;
+            if (xi >= RebarCalc::XI_B_LIMIT) continue;
+
+            // Shear (designShearForIteration with 8 mm two-leg stirrups)
+            double bent = 0, spacing = 200;
+            double Vs = maxV - 0.20 * RebarCalc::CONCRETE_FT * width * h0;
+            if (Vs > 0) {
+                double capacity = stirrupTotalArea * RebarCalc::STEEL_FY * h0;
+                if (capacity / Vs < 100.0 && row1 >= 2) {
+                    bent = 2;
+                    Vs -= c.bentShear;
+                }
+                if (Vs > 0) {
+                    spacing = std::floor(capacity / Vs / 25.0) * 25.0;
+                    if (spacing > 200) spacing = 200;
+                    if (spacing < 100) spacing = 100;
+                }
+            }
+
+            // Cost (calculateTotalCostForIteration)
+            double concrete = (span * width * height) / 1e9 * COST_CONCRETE_PER_M3 * numGirders;
+            double bars = row1 + row2;
+            double extra = (bent > 0) ? bent * (height * 0.5) : 0;
+            double flexCost = c.areaPerBar * (bars * span + extra) * RebarCalc::STEEL_DENSITY * c.flexPricePerTon;
+            double stirrups = span / spacing;
+            double stirrupCost = stirrupTotalArea * (2 * (width + height)) * stirrups * RebarCalc::STEEL_DENSITY * stirrupPricePerTon;
+            double steel = (flexCost + stirrupCost) * numGirders;
+            double labor = (bars + stirrups) * COST_PER_REBAR_TIED * numGirders;
+            double total = concrete + steel + labor;
+
+            if (total < best) {
+                found = true;
+                best = total;
+                bD = c.diameter; bRows = rows; bRow1 = row1; bRow2 = row2; bSp = spacing; bBent = bent;
+                bTotal = total; bConc = concrete; bSteel = steel; bLabor = labor; bH0 = h0;
+            }
+        }
+
+        results.success[i] = found ? 1 : 0;
+        results.flexureRebarDiameter[i] = bD;
+        results.rebarRows[i] = bRows;
+        results.rebarCountRow1[i] = bRow1;
+        results.rebarCountRow2[i] = bRow2;
+        results.stirrupSpacing[i] = bSp;
+        results.bentRebarCount[i] = bBent;
+        results.totalCost[i] = bTotal;
+        results.concreteCost[i] = bConc;
+        results.steelCost[i] = bSteel;
+        results.laborCost[i] = bLabor;
+        results.maxMoment[i] = maxM;
+        results.maxShear[i] = maxV;
+        results.h0[i] = bH0;
+    }
+}
+
+#if defined(REBAR_HAS_X86_SIMD)
+
+inline bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+REBAR_TARGET_AVX2 inline void designBeamBatchAvx2(const BeamBatch& batch, BeamBatchResults& results, size_t begin, size_t end) {
+    const BatchDiameterConstants* table = batchDiameterTable();
+    const double stirrupTotalArea = 2 * (M_PI * pow(8 / 2.0, 2));
+    const double stirrupPricePerTon = COST_REBAR_BASE_PER_TON * (1.0 + (8 - 14.0) * 0.025);
+
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d kThousand = _mm256_set1_pd(1000.0);
+    const __m256d k25 = _mm256_set1_pd(25.0);
+    const __m256d k100 = _mm256_set1_pd(100.0);
+    const __m256d k200 = _mm256_set1_pd(200.0);
+    const __m256d kHalf = _mm256_set1_pd(0.5);
+    const __m256d kCapacity = _mm256_set1_pd(stirrupTotalArea * RebarCalc::STEEL_FY);
+    const __m256d kStirrupWeightCost = _mm256_set1_pd(stirrupTotalArea);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d span = _mm256_loadu_pd(&batch.span[i]);
+        __m256d width = _mm256_loadu_pd(&batch.width[i]);
+        __m256d height = _mm256_loadu_pd(&batch.height[i]);
+        __m256d load = _mm256_loadu_pd(&batch.vehicleLoad[i]);
+        __m256d gs = _mm256_loadu_pd(&batch.girderSpacing[i]);
+        __m256d wheel = _mm256_mul_pd(_mm256_loadu_pd(&batch.wheelSpan[i]), kThousand);
+
+        // Load distribution and forces
+        __m256d gs_m = _mm256_div_pd(gs, kThousand);
+        __m256d gsPositive = _mm256_cmp_pd(gs_m, zero, _CMP_GT_OQ);
+        __m256d lfM = _mm256_blendv_pd(one, _mm256_div_pd(gs_m, _mm256_set1_pd(1.7)), gsPositive);
+        __m256d lfV = _mm256_blendv_pd(one, _mm256_div_pd(gs_m, _mm256_set1_pd(1.4)), gsPositive);
+        __m256d loadM = _mm256_mul_pd(_mm256_mul_pd(load, lfM), kThousand);
+        __m256d loadV = _mm256_mul_pd(_mm256_mul_pd(load, lfV), kThousand);
+
+        __m256d q = _mm256_mul_pd(_mm256_mul_pd(width, height), _mm256_set1_pd(RebarCalc::CONCRETE_UNIT_WEIGHT));
+        __m256d P = _mm256_div_pd(loadM, two);
+        __m256d x = _mm256_sub_pd(_mm256_div_pd(span, two), _mm256_div_pd(wheel, _mm256_set1_pd(4.0)));
+        __m256d Lx = _mm256_sub_pd(span, x);
+        __m256d RA = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(P, Lx), _mm256_mul_pd(P, _mm256_sub_pd(Lx, wheel))), span);
+        __m256d deadM = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(q, span), span), _mm256_set1_pd(8.0));
+        __m256d maxM = _mm256_add_pd(deadM, _mm256_mul_pd(RA, x));
+        __m256d Pv = _mm256_div_pd(loadV, two);
+        __m256d liveV = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(Pv, span), _mm256_mul_pd(Pv, _mm256_sub_pd(span, wheel))), span);
+        __m256d maxV = _mm256_add_pd(_mm256_div_pd(_mm256_mul_pd(q, span), two), liveV);
+
+        __m256d numGirders = _mm256_div_pd(_mm256_set1_pd(10000.0), gs);
+        numGirders = _mm256_blendv_pd(numGirders, two, _mm256_cmp_pd(numGirders, two, _CMP_LT_OQ));
+        numGirders = _mm256_blendv_pd(one, numGirders, _mm256_cmp_pd(gs, zero, _CMP_GT_OQ));
+
+        __m256d minArea = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.45 * (RebarCalc::CONCRETE_FT / RebarCalc::STEEL_FY)), width), height);
+        __m256d available = _mm256_sub_pd(_mm256_sub_pd(width, _mm256_set1_pd(2 * CONCRETE_COVER)), _mm256_set1_pd(2 * 8.0));
+        __m256d concrete = _mm256_mul_pd(_mm256_mul_pd(_mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(span, width), height),
+            _mm256_set1_pd(1e9)), _mm256_set1_pd(COST_CONCRETE_PER_M3)), numGirders);
+        __m256d stirrupLength = _mm256_mul_pd(two, _mm256_add_pd(width, height));
+
+        __m256d best = _mm256_set1_pd(std::numeric_limits<double>::max());
+        __m256d bD = zero, bRows = zero, bRow1 = zero, bRow2 = zero, bSp = zero, bBent = zero;
+        __m256d bTotal = zero, bConc = zero, bSteel = zero, bLabor = zero, bH0 = zero;
+        __m256d found = zero;
+
+        for (int di = 0; di < STANDARD_REBAR_COUNT; ++di) {
+            const BatchDiameterConstants& c = table[di];
+            __m256d d = _mm256_set1_pd(c.diameter);
+            __m256d area = _mm256_set1_pd(c.areaPerBar);
+
+            __m256d h0 = _mm256_sub_pd(_mm256_sub_pd(_mm256_sub_pd(height, _mm256_set1_pd(CONCRETE_COVER)), _mm256_set1_pd(8.0)),
+                _mm256_set1_pd(c.halfDiameter));
+            __m256d valid = _mm256_cmp_pd(h0, zero, _CMP_GT_OQ);
+
+            __m256d req = _mm256_div_pd(maxM, _mm256_mul_pd(_mm256_set1_pd(RebarCalc::STEEL_FY * 0.9), h0));
+            req = _mm256_blendv_pd(req, minArea, _mm256_cmp_pd(req, minArea, _CMP_LT_OQ));
+            __m256d totalBars = _mm256_round_pd(_mm256_div_pd(req, area), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+            totalBars = _mm256_blendv_pd(totalBars, two, _mm256_cmp_pd(totalBars, two, _CMP_LT_OQ));
+
+            valid = _mm256_and_pd(valid, _mm256_cmp_pd(available, d, _CMP_GE_OQ));
+            __m256d maxPerRow = _mm256_add_pd(one, _mm256_round_pd(_mm256_div_pd(_mm256_sub_pd(available, d), _mm256_set1_pd(c.rowPitch)),
+                _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+
+            __m256d oneRow = _mm256_cmp_pd(totalBars, maxPerRow, _CMP_LE_OQ);
+            __m256d row1Two = _mm256_round_pd(_mm256_div_pd(totalBars, two), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+            __m256d row2Two = _mm256_sub_pd(totalBars, row1Two);
+            __m256d twoRowsFit = _mm256_and_pd(_mm256_cmp_pd(row1Two, maxPerRow, _CMP_LE_OQ), _mm256_cmp_pd(row2Two, maxPerRow, _CMP_LE_OQ));
+            valid = _mm256_and_pd(valid, _mm256_or_pd(oneRow, twoRowsFit));
+
+            __m256d rows = _mm256_blendv_pd(two, one, oneRow);
+            __m256d row1 = _mm256_blendv_pd(row1Two, totalBars, oneRow);
+            __m256d row2 = _mm256_blendv_pd(row2Two, zero, oneRow);
+
+            __m256d As1 = _mm256_mul_pd(row1Two, area);
+            __m256d As2 = _mm256_mul_pd(row2Two, area);
+            __m256d h0Two = _mm256_sub_pd(height, _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(As1, _mm256_set1_pd(c.y1)),
+                _mm256_mul_pd(As2, _mm256_set1_pd(c.y2))), _mm256_add_pd(As1, As2)));
+            h0 = _mm256_blendv_pd(h0Two, h0, oneRow);
+
+            __m256d xComp = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(totalBars, area), _mm256_set1_pd(RebarCalc::STEEL_FY)),
+                _mm256_mul_pd(_mm256_set1_pd(1.0 * RebarCalc::CONCRETE_FC), width));
+            __m256d xi = _mm256_div_pd(xComp, h0);
+            valid = _mm256_and_pd(valid, _mm256_cmp_pd(xi, _mm256_set1_pd(RebarCalc::XI_B_LIMIT), _CMP_LT_OQ));
+            if (_mm256_movemask_pd(valid) == 0) continue;
+
+            // Shear
+            __m256d Vs = _mm256_sub_pd(maxV, _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.20 * RebarCalc::CONCRETE_FT), width), h0));
+            __m256d needsSteel = _mm256_cmp_pd(Vs, zero, _CMP_GT_OQ);
+            __m256d capacity = _mm256_mul_pd(kCapacity, h0);
+            __m256d useBent = _mm256_and_pd(needsSteel, _mm256_and_pd(_mm256_cmp_pd(_mm256_div_pd(capacity, Vs), k100, _CMP_LT_OQ),
+                _mm256_cmp_pd(row1, two, _CMP_GE_OQ)));
+            Vs = _mm256_blendv_pd(Vs, _mm256_sub_pd(Vs, _mm256_set1_pd(c.bentShear)), useBent);
+            __m256d spacing = _mm256_mul_pd(_mm256_round_pd(_mm256_div_pd(_mm256_div_pd(capacity, Vs), k25),
+                _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC), k25);
+            spacing = _mm256_blendv_pd(spacing, k200, _mm256_cmp_pd(spacing, k200, _CMP_GT_OQ));
+            spacing = _mm256_blendv_pd(spacing, k100, _mm256_cmp_pd(spacing, k100, _CMP_LT_OQ));
+            spacing = _mm256_blendv_pd(k200, spacing, _mm256_and_pd(needsSteel, _mm256_cmp_pd(Vs, zero, _CMP_GT_OQ)));
+            __m256d bent = _mm256_and_pd(useBent, two);
+
+            // Cost
+            __m256d bars = _mm256_add_pd(row1, row2);
+            __m256d extra = _mm256_and_pd(useBent, _mm256_mul_pd(bent, _mm256_mul_pd(height, kHalf)));
+            __m256d flexCost = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(area, _mm256_add_pd(_mm256_mul_pd(bars, span), extra)),
+                _mm256_set1_pd(RebarCalc::STEEL_DENSITY)), _mm256_set1_pd(c.flexPricePerTon));
+            __m256d stirrups = _mm256_div_pd(span, spacing);
+            __m256d stirrupCost = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(kStirrupWeightCost, stirrupLength), stirrups),
+                _mm256_set1_pd(RebarCalc::STEEL_DENSITY)), _mm256_set1_pd(stirrupPricePerTon));
+            __m256d steel = _mm256_mul_pd(_mm256_add_pd(flexCost, stirrupCost), numGirders);
+            __m256d labor = _mm256_mul_pd(_mm256_mul_pd(_mm256_add_pd(bars, stirrups), _mm256_set1_pd(COST_PER_REBAR_TIED)), numGirders);
+            __m256d total = _mm256_add_pd(_mm256_add_pd(concrete, steel), labor);
+
+            __m256d better = _mm256_and_pd(valid, _mm256_cmp_pd(total, best, _CMP_LT_OQ));
+            best = _mm256_blendv_pd(best, total, better);
+            found = _mm256_or_pd(found, better);
+            bD = _mm256_blendv_pd(bD, d, better);
+            bRows = _mm256_blendv_pd(bRows, rows, better);
+            bRow1 = _mm256_blendv_pd(bRow1, row1, better);
+            bRow2 = _mm256_blendv_pd(bRow2, row2, better);
+            bSp = _mm256_blendv_pd(bSp, spacing, better);
+            bBent = _mm256_blendv_pd(bBent, bent, better);
+            bTotal = _mm256_blendv_pd(bTotal, total, better);
+            bConc = _mm256_blendv_pd(bConc, concrete, better);
+            bSteel = _mm256_blendv_pd(bSteel, steel, better);
+            bLabor = _mm256_blendv_pd(bLabor, labor, better);
+            bH0 = _mm256_blendv_pd(bH0, h0, better);
+        }
+
+        int foundMask = _mm256_movemask_pd(found);
+        for (int lane = 0; lane < 4; ++lane) results.success[i + lane] = (foundMask >> lane) & 1;
+        _mm256_storeu_pd(&results.flexureRebarDiameter[i], bD);
+        _mm256_storeu_pd(&results.rebarRows[i], bRows);
+        _mm256_storeu_pd(&results.rebarCountRow1[i], bRow1);
+        _mm256_storeu_pd(&results.rebarCountRow2[i], bRow2);
+        _mm256_storeu_pd(&results.stirrupSpacing[i], bSp);
+        _mm256_storeu_pd(&results.bentRebarCount[i], bBent);
+        _mm256_storeu_pd(&results.totalCost[i], bTotal);
+        _mm256_storeu_pd(&results.concreteCost[i], bConc);
+        _mm256_storeu_pd(&results.steelCost[i], bSteel);
+        _mm256_storeu_pd(&results.laborCost[i], bLabor);
+        _mm256_storeu_pd(&results.maxMoment[i], maxM);
+        _mm256_storeu_pd(&results.maxShear[i], maxV);
+        _mm256_storeu_pd(&results.h0[i], bH0);
+    }
+
+    // Remaining beams that do not fill a register
+    designBeamBatchScalar(batch, results, i, end);
+}
+
+#else
+
+inline bool cpuSupportsAvx2() { return false; }
+
+#endif
+
+inline void designBeamBatch(const BeamBatch& batch, BeamBatchResults& results) {
+    results.resize(batch.size());
+#if defined(REBAR_HAS_X86_SIMD)
+    static const bool useAvx2 = cpuSupportsAvx2();
+    if (useAvx2) {
+        designBeamBatchAvx2(batch, results, 0, batch.size());
+        return;
+    }
+#endif
+    designBeamBatchScalar(batch, results, 0, batch.size());
+}
+
+inline size_t countBatchMismatches(const BeamBatch& batch, const BeamBatchResults& results) {
+    RebarCalc calc;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        bool success = calc.runDesign(batch.span[i], batch.width[i], batch.height[i], batch.vehicleLoad[i], batch.wheelSpan[i], batch.girderSpacing[i]);
+        const RebarDesign& a = calc.getDesignResults();
+        RebarDesign b = results.toDesign(i);
+        bool same = success == (results.success[i] != 0)
+            && a.maxMoment == b.maxMoment && a.maxShear == b.maxShear
+            && (!success || (a.flexureRebarDiameter == b.flexureRebarDiameter && a.rebarRows == b.rebarRows
+                && a.rebarCountRow1 == b.rebarCountRow1 && a.rebarCountRow2 == b.rebarCountRow2
+                && a.stirrupSpacing == b.stirrupSpacing && a.bentRebarCount == b.bentRebarCount
+                && a.totalCost == b.totalCost && a.concreteCost == b.concreteCost && a.steelCost == b.steelCost
+                && a.laborCost == b.laborCost && calc.getParams().h0 == results.h0[i]));
+        if (!same) ++mismatches;
+    }
+    return mismatches;
+}
+
+
+#endif // BEAMBATCH_H
@@ -1,7 +1,9 @@
 #include "stdafx.h"
 #include "Concrete_Reinforcement_Front.h"
 #include "RebarCalc.h"
+#include "DrawingExport.h"
 #include <opencv2/opencv.hpp>
+#include <QtConcurrent/QtConcurrent>
 #include <string>
 
 Concrete_Reinforcement_Front::Concrete_Reinforcement_Front(QWidget* parent)
@@ -12,13 +14,69 @@ Concrete_Reinforcement_Front::Concrete_Reinforcement_Front(QWidget* parent)
     statusBar()->showMessage("Ready. Please enter the bridge parameters.");
 }
 
-Concrete_Reinforcement_Front::~Concrete_Reinforcement_Front() {}
+Concrete_Reinforcement_Front::~Concrete_Reinforcement_Front()
+{
+    // Jobs hold pointers to designCache and designPipeline, so they must be gone before the members are.
+    redesignTimer.stop();
+    if (activeCancelFlag) activeCancelFlag->store(true);
+    designPool.waitForDone();
+    stopSweep();
+    reliabilityFuture.waitForFinished();
+}
 
 void Concrete_Reinforcement_Front::initUI()
 {
     connect(ui.pushButton_autoGenerate, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_autoGenerate_clicked);
     connect(ui.pushButton_genPic, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_genPic_clicked);
     connect(ui.pushButton_genPic_2, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_genPic2_clicked);
+    connect(ui.pushButton_optimizeSection, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_optimize_clicked);
+    connect(ui.pushButton_exportDrawing, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_export_clicked);
+    connect(ui.pushButton_designSweep, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_sweep_clicked);
+    connect(ui.pushButton_paretoFront, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_pareto_clicked);
+    connect(ui.pushButton_deckDesign, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_deck_clicked);
+    connect(ui.pushButton_reliability, &QPushButton::clicked, this, &Concrete_Reinforcement_Front::on_pushButton_reliability_clicked);
+
+    // Live redesign while typing, debounced so that only the final value is designed.
+    redesignTimer.setSingleShot(true);
+    redesignTimer.setInterval(REDESIGN_DEBOUNCE_MS);
+    connect(&redesignTimer, &QTimer::timeout, this, [this]() { handleDesignRequest(showCrossSection); });
+    for (QLineEdit* edit : { ui.lineEdit_span, ui.lineEdit_width, ui.lineEdit_height, ui.lineEdit_weight,
+        ui.lineEdit_wheelSpan, ui.lineEdit_girderSpacing }) {
+        connect(edit, &QLineEdit::textChanged, this, &Concrete_Reinforcement_Front::scheduleRedesign);
+    }
+    // At most one design runs at a time; a superseded job is cancelled and the newest waits for it.
+    designPool.setMaxThreadCount(1);
+
+    // Edits are previewed from the surrogate table when one matches the GUI design options.
+    QString surrogatePath = QCoreApplication::applicationDirPath() + "/" + SURROGATE_FILE_NAME;
+    std::string surrogateError;
+    if (QFileInfo::exists(surrogatePath) && designSurrogate.open(surrogatePath.toStdString(), surrogateError)) {
+        const SurrogateGrid& grid = designSurrogate.grid();
+        if (!grid.zonedStirrups || !grid.mixedDiameters || grid.grade != RebarCalc::materialGrade()) designSurrogate.close();
+    }
+
+    // A running sweep is redrawn periodically so that its cells fill in as they arrive.
+    sweepRefreshTimer.setInterval(SWEEP_REFRESH_MS);
+    connect(&sweepRefreshTimer, &QTimer::timeout, this, &Concrete_Reinforcement_Front::renderSweep);
+
+    // A single scene and pixmap item are reused for every design and view.
+    designScene = new QGraphicsScene(this);
+    designPixmapItem = designScene->addPixmap(QPixmap());
+    designTileItem = new DrawingTileItem();
+    designTileItem->setVisible(false);
+    designScene->addItem(designTileItem);
+    ui.graphicsView->setScene(designScene);
+
+    // Wheel zooms around the cursor, dragging pans.
+    ui.graphicsView->setDragMode(QGraphicsView::ScrollHandDrag);
+    ui.graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    ui.graphicsView->viewport()->installEventFilter(this);
+
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    diagnosticsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(diagnosticsLabel);
+#endif
+
     setWindowTitle("Concrete Rebar Simulator");
 }
 
@@ -26,11 +84,13 @@ void Concrete_Reinforcement_Front::on_pushButton_autoGenerate_clicked()
 {
     qInfo() << "Auto-generating geometric parameters...";
 
-    double span = ui.lineEdit_span->text().toDouble();
-    if (span <= 0) {
+    // A continuous girder is sized for its longest span.
+    std::vector<double> spans;
+    if (!parseSpanList(ui.lineEdit_span->text().toStdString(), spans)) {
         statusBar()->showMessage("Error: Span must be greater than zero for auto-generation.");
         return;
     }
+    double span = *std::max_element(spans.begin(), spans.end());
 
     double width, height;
     autoGeoParams(span, width, height);
@@ -42,39 +102,354 @@ void Concrete_Reinforcement_Front::on_pushButton_autoGenerate_clicked()
     statusBar()->showMessage("Geometric parameters auto-generated.");
 }
 
-void Concrete_Reinforcement_Front::handleDesignRequest(bool isCrossSection) {
-    double span = ui.lineEdit_span->text().toDouble();
-    double width = ui.lineEdit_width->text().toDouble();
-    double height = ui.lineEdit_height->text().toDouble();
-    double weight = ui.lineEdit_weight->text().toDouble();
-    double wheelSpan = ui.lineEdit_wheelSpan->text().toDouble();
+void Concrete_Reinforcement_Front::scheduleRedesign()
+{
+    redesignTimer.start();
+    showDesignPreview();
+}
+
+void Concrete_Reinforcement_Front::showDesignPreview()
+{
+    previewShown = false;
+    DesignJobRequest request;
+    SurrogatePreview preview;
+    if (!designSurrogate.isOpen() || !readInputs(request, true) || !request.spans.empty()) return;
+    if (!designSurrogate.preview(request.span, request.width, request.height, request.weight, request.wheelSpan, request.girderSpacing, preview)) return;
+
+    // Shown until the debounced exact design replaces it.
+    if (preview.success) {
+        const RebarDesign& design = preview.design;
+        ui.label_totalCostValue->setText("~" + QString::number(design.totalCost, 'f', 0) + " Yuan");
+        ui.label_concreteCostValue->setText("~" + QString::number(design.concreteCost, 'f', 0) + " Yuan");
+        ui.label_steelCostValue->setText("~" + QString::number(design.steelCost, 'f', 0) + " Yuan");
+        ui.label_laborCostValue->setText("~" + QString::number(design.laborCost, 'f', 0) + " Yuan");
+        statusBar()->showMessage(QString("Preview: about %1, confirming...").arg(QString::fromStdString(flexuralLayoutText(design))));
+    }
+    else {
+        clearCostLabels();
+        statusBar()->showMessage("Preview: probably no valid reinforcement, confirming...");
+    }
+    previewShown = true;
+    previewKey = DesignCacheKey::fromInputs(request.span, request.width, request.height, request.weight, request.wheelSpan, request.girderSpacing);
+    previewSuccess = preview.success;
+    previewCost = preview.design.totalCost;
+}
+
+bool Concrete_Reinforcement_Front::readInputs(DesignJobRequest& request, bool needSection)
+{
+    // One span, or a list of 2..6 spans for a continuous girder (span is then their sum).
+    request.spans.clear();
+    request.span = 0;
+    if (parseSpanList(ui.lineEdit_span->text().toStdString(), request.spans)) {
+        for (double span : request.spans) request.span += span;
+    }
+    if (request.spans.size() < 2) request.spans.clear();
+    request.width = ui.lineEdit_width->text().toDouble();
+    request.height = ui.lineEdit_height->text().toDouble();
+    request.weight = ui.lineEdit_weight->text().toDouble();
+    request.wheelSpan = ui.lineEdit_wheelSpan->text().toDouble();
     // Leggi il nuovo valore
-    double girderSpacing = ui.lineEdit_girderSpacing->text().toDouble();
+    request.girderSpacing = ui.lineEdit_girderSpacing->text().toDouble();
+
+    if (request.span <= 0 || request.weight <= 0 || request.girderSpacing <= 0) return false;
+    if (needSection && (request.width <= 0 || request.height <= 0)) return false;
+    return true;
+}
+
+bool Concrete_Reinforcement_Front::requireSingleSpan(const DesignJobRequest& request)
+{
+    if (request.spans.empty()) return true;
+    statusBar()->showMessage("Error: Continuous girders can only be designed directly; enter a single span for this.");
+    return false;
+}
 
-    if (span <= 0 || width <= 0 || height <= 0 || weight <= 0 || girderSpacing <= 0) {
+void Concrete_Reinforcement_Front::handleDesignRequest(bool isCrossSection) {
+    redesignTimer.stop();
+    showCrossSection = isCrossSection;
+
+    DesignJobRequest request;
+    request.kind = DesignJobRequest::Design;
+    request.crossSection = isCrossSection;
+    if (!readInputs(request, true)) {
+        // Drop whatever is still running for the old inputs.
+        if (activeCancelFlag) activeCancelFlag->store(true);
+        ++latestGeneration;
         statusBar()->showMessage("Error: Please enter valid values greater than zero in all fields.");
-        ui.label_totalCostValue->setText("---");
-        ui.label_concreteCostValue->setText("---");
-        ui.label_steelCostValue->setText("---");
-        ui.label_laborCostValue->setText("---");
+        clearCostLabels();
+        return;
+    }
+
+    // Both views of a recent design are already rendered: just switch to the requested one.
+    // Continuous girders are not kept, so they never match a single span of the same length.
+    const RenderedDesign* rendered = !request.spans.empty() ? nullptr : findRenderedDesign(DesignCacheKey::fromInputs(request.span, request.width, request.height,
+        request.weight, request.wheelSpan, request.girderSpacing));
+    if (rendered) {
+        if (activeCancelFlag) activeCancelFlag->store(true);
+        ++latestGeneration;
+        showRenderedDesign(*rendered, isCrossSection);
         return;
     }
 
     statusBar()->showMessage("Calculating...");
+    startDesignJob(request);
+}
 
-    // Passa il nuovo valore alla funzione di calcolo
-    bool success = rebarCalc.runDesign(span, width, height, weight, wheelSpan, girderSpacing);
-    const RebarDesign& design = rebarCalc.getDesignResults();
+const RenderedDesign* Concrete_Reinforcement_Front::findRenderedDesign(const DesignCacheKey& key) const
+{
+    if (hasCurrentDesign && currentDesign.key == key) return &currentDesign;
+    for (const RenderedDesign& rendered : renderCache) {
+        if (rendered.key == key) return &rendered;
+    }
+    return nullptr;
+}
 
-    cv::Mat image;
-    if (isCrossSection) {
-        image = rebarCalc.generateCrossSectionImage();
+void Concrete_Reinforcement_Front::startDesignJob(const DesignJobRequest& request)
+{
+    // Cancel the job in flight; it stops at its next check, and a superseded job that is
+    // still queued returns as soon as it starts.
+    if (activeCancelFlag) activeCancelFlag->store(true);
+
+    quint64 generation = ++latestGeneration;
+    activeCancelFlag = std::make_shared<std::atomic<bool>>(false);
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    diagnosticsBaseline = Instrumentation::snapshot();
+#endif
+
+    auto* watcher = new QFutureWatcher<DesignJobResult>(this);
+    connect(watcher, &QFutureWatcher<DesignJobResult>::finished, this, [this, watcher]() {
+        // takeResult() leaves the images uniquely owned, so they can be adopted without a copy.
+        if (!watcher->isCanceled()) applyDesignResult(watcher->future().takeResult());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&designPool, &Concrete_Reinforcement_Front::runDesignJob,
+        request, generation, activeCancelFlag, &designCache, &designPipeline));
+}
+
+DesignJobResult Concrete_Reinforcement_Front::runDesignJob(const DesignJobRequest& request, quint64 generation,
+    std::shared_ptr<std::atomic<bool>> cancelFlag, DesignCache* cache, DesignPipeline* pipeline)
+{
+    // Runs on a pool thread: only the request copy, a local RebarCalc and the
+    // (thread-safe) design cache are touched here.
+    DesignJobResult result;
+    result.generation = generation;
+    result.request = request;
+    if (cancelFlag->load()) {
+        result.cancelled = true;
+        return result;
+    }
+
+    RebarCalc calc;
+    calc.setCancellationFlag(cancelFlag.get());
+    // The GUI always designs zoned stirrups and lets bar diameters mix; designCache is only
+    // filled from here, so its entries are all designed that way as well.
+    calc.setStirrupZoning(true);
+    calc.setMixedDiameters(true);
+    bool fromPipeline = false;
+    if (request.kind == DesignJobRequest::OptimizeSection) {
+        result.success = calc.runSectionOptimization(request.span, request.weight, request.wheelSpan, request.girderSpacing);
+        result.searchStats = calc.getSearchStats();
+    }
+    else if (request.kind == DesignJobRequest::ParetoFront) {
+        result.success = calc.runParetoOptimization(request.span, request.weight, request.wheelSpan, request.girderSpacing, result.paretoFront);
+        result.searchStats = calc.getSearchStats();
+    }
+    else if (request.kind == DesignJobRequest::Deck) {
+        // The girders are designed on the shared work-stealing pool; the view shows the
+        // most expensive one.
+        DeckLayout layout;
+        layout.span = request.span;
+        layout.girderSpacing = request.girderSpacing;
+        layout.girderWidth = request.width;
+        layout.girderHeight = request.height;
+        result.success = runDeckDesign(layout, request.weight, request.wheelSpan, result.deck, sharedDesignPool(), true);
+        const GirderResult* governing = nullptr;
+        for (const GirderResult& girder : result.deck.girders) {
+            if (!governing || girder.design.totalCost > governing->design.totalCost) governing = &girder;
+        }
+        if (governing) {
+            calc.restoreDesign(governing->params, governing->design);
+        }
+        else {
+            RebarDesign failed;
+            failed.designPossible = false;
+            failed.errorMessage = result.deck.errorMessage;
+            calc.restoreDesign(calc.getParams(), failed);
+        }
+    }
+    else if (!request.spans.empty()) {
+        // The vehicle of the single-span design, moved over the whole continuous girder.
+        result.success = calc.runContinuousDesign(request.spans, request.width, request.height,
+            AxleTrain::twoAxle(request.weight, request.wheelSpan * 1000.0), request.girderSpacing);
     }
     else {
-        image = rebarCalc.generateLongitudinalSectionImage();
+        // Passa il nuovo valore alla funzione di calcolo. A cache miss goes through the
+        // pipeline, which redoes only the stages that depend on the edited field and
+        // redraws a view only when the drawn layout has changed.
+        DesignCacheKey key = DesignCacheKey::fromInputs(request.span, request.width, request.height, request.weight,
+            request.wheelSpan, request.girderSpacing, calc.materialGrade());
+        CachedDesign cached;
+        result.fromCache = cache->lookup(key, cached);
+        if (!result.fromCache) {
+            DesignInputs inputs;
+            inputs.span = request.span;
+            inputs.width = request.width;
+            inputs.height = request.height;
+            inputs.vehicleLoad = request.weight;
+            inputs.wheelSpan = request.wheelSpan;
+            inputs.girderSpacing = request.girderSpacing;
+            inputs.zonedStirrups = true;
+            inputs.mixedDiameters = true;
+            cached.success = pipeline->run(inputs);
+            cached.design = pipeline->getDesignResults();
+            cached.error = designErrorCode(pipeline->getDesignResults().errorMessage);
+            cached.params = pipeline->getParams();
+            cache->insert(key, cached);
+            fromPipeline = true;
+        }
+        calc.restoreDesign(cached.params, cached.design, cached.error);
+        result.success = cached.success;
+    }
+    result.design = calc.getDesignResults();
+    result.params = calc.getParams();
+    if (cancelFlag->load()) {
+        result.cancelled = true;
+        return result;
     }
 
-    if (success) {
+    result.crossSectionImage = fromPipeline ? shareView(pipeline->crossSection()) : drawDesignView(calc, true);
+    if (cancelFlag->load()) {
+        result.cancelled = true;
+        return result;
+    }
+    result.longitudinalImage = fromPipeline ? shareView(pipeline->longitudinal()) : drawDesignView(calc, false);
+    return result;
+}
+
+QImage Concrete_Reinforcement_Front::shareView(const cv::Mat& view)
+{
+    // The QImage holds its own reference to the BGRA buffer. The pipeline draws a changed
+    // view into a new buffer, so the pixels never change under the image.
+    cv::Mat* shared = new cv::Mat(view);
+    return QImage(shared->data, shared->cols, shared->rows, (qsizetype)shared->step, QImage::Format_RGB32,
+        [](void* info) { delete static_cast<cv::Mat*>(info); }, shared);
+}
+
+QImage Concrete_Reinforcement_Front::drawDesignView(RebarCalc& calc, bool crossSection)
+{
+    // Draw straight into the QImage buffer: Format_RGB32 is stored as B,G,R,0xff bytes on
+    // little-endian machines, which is OpenCV's BGRA order, so no conversion or copy is
+    // needed on the way to the screen.
+    const cv::Size& size = crossSection ? CROSS_SECTION_IMAGE_SIZE : LONGITUDINAL_IMAGE_SIZE;
+    QImage image(size.width, size.height, QImage::Format_RGB32);
+    cv::Mat buffer(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+    if (crossSection) calc.drawCrossSection(buffer);
+    else calc.drawLongitudinalSection(buffer);
+    return image;
+}
+
+void Concrete_Reinforcement_Front::clearCostLabels()
+{
+    ui.label_totalCostValue->setText("---");
+    ui.label_concreteCostValue->setText("---");
+    ui.label_steelCostValue->setText("---");
+    ui.label_laborCostValue->setText("---");
+}
+
+void Concrete_Reinforcement_Front::applyDesignResult(DesignJobResult result)
+{
+    // A newer request has been issued since this job started: its result is stale.
+    if (result.cancelled || result.generation != latestGeneration) return;
+
+    const DesignJobRequest& request = result.request;
+    bool optimized = request.kind != DesignJobRequest::Design;
+    bool continuous = !request.spans.empty();
+    rebarCalc.restoreDesign(result.params, result.design);
+
+    // The cached views are looked up by the inputs the user typed; an optimized design is
+    // filed under the section it chose.
+    RenderedDesign rendered;
+    if (!continuous) rendered.key = optimized
+        ? DesignCacheKey::fromInputs(request.span, result.params.width, result.params.height, request.weight, request.wheelSpan, request.girderSpacing)
+        : DesignCacheKey::fromInputs(request.span, request.width, request.height, request.weight, request.wheelSpan, request.girderSpacing);
+    rendered.success = result.success;
+    rendered.design = result.design;
+    rendered.params = result.params;
+    {
+        // Moving the images lets QPixmap adopt their buffers instead of copying them.
+        REBAR_TIME_SCOPE(ImageConversion);
+        rendered.crossSection = QPixmap::fromImage(std::move(result.crossSectionImage));
+        rendered.longitudinal = QPixmap::fromImage(std::move(result.longitudinalImage));
+    }
+
+    if (!optimized && !continuous) {
+        // Optimized designs differ from a plain runDesign of the same section, so only
+        // runDesign results go into the shared view cache.
+        for (auto it = renderCache.begin(); it != renderCache.end(); ++it) {
+            if (it->key == rendered.key) { renderCache.erase(it); break; }
+        }
+        renderCache.push_front(rendered);
+        if (renderCache.size() > RENDER_CACHE_SIZE) renderCache.pop_back();
+    }
+    currentDesign = rendered;
+    hasCurrentDesign = true;
+
+    if (result.success && optimized) {
+        // Show the optimal section without triggering a live redesign of it.
+        QSignalBlocker blockWidth(ui.lineEdit_width);
+        QSignalBlocker blockHeight(ui.lineEdit_height);
+        ui.lineEdit_width->setText(QString::number(result.params.width));
+        ui.lineEdit_height->setText(QString::number(result.params.height));
+    }
+
+    showRenderedDesign(currentDesign, request.crossSection);
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    showDiagnostics();
+#endif
+
+    if (result.success) {
+        if (request.kind == DesignJobRequest::ParetoFront) {
+            statusBar()->showMessage(QString("Pareto front: %1 designs from %2 of %3 candidates evaluated. Cheapest shown.")
+                .arg(result.paretoFront.size()).arg(result.searchStats.candidatesEvaluated).arg(result.searchStats.candidatesInSpace));
+            paretoFront = std::move(result.paretoFront);
+            paretoRequest = request;
+            showParetoFront();
+        }
+        else if (request.kind == DesignJobRequest::Deck) {
+            statusBar()->showMessage(QString("Deck designed: %1 girders, %2 lateral load positions. Most expensive girder shown.")
+                .arg(result.deck.girders.size()).arg(result.deck.loadPositions));
+        }
+        else if (optimized) {
+            statusBar()->showMessage(QString("Optimal section found: %1 of %2 candidates evaluated.")
+                .arg(result.searchStats.candidatesEvaluated).arg(result.searchStats.candidatesInSpace));
+        }
+        else {
+            statusBar()->showMessage(statusBar()->currentMessage() + QString(" (%1; cache %2 hits / %3 misses)")
+                .arg(result.fromCache ? "cached" : "computed").arg(designCache.hits()).arg(designCache.misses()));
+        }
+    }
+    // Tell how far off the preview of these inputs was, or that it got feasibility wrong.
+    if (previewShown && !optimized && !continuous && previewKey == rendered.key) {
+        if (previewSuccess != result.success) statusBar()->showMessage(statusBar()->currentMessage() + " Preview corrected.");
+        else if (result.success) statusBar()->showMessage(statusBar()->currentMessage() + QString(" Preview was %1% off.")
+            .arg(std::fabs(previewCost - result.design.totalCost) / result.design.totalCost * 100.0, 0, 'f', 1));
+    }
+    previewShown = false;
+    // A deck with a failed girder is still listed, so the failing girders can be found.
+    if (request.kind == DesignJobRequest::Deck && !result.deck.girders.empty()) {
+        deckDesign = std::move(result.deck);
+        deckRequest = request;
+        showDeckDesign();
+    }
+}
+
+void Concrete_Reinforcement_Front::showRenderedDesign(const RenderedDesign& rendered, bool isCrossSection)
+{
+    // A design takes the view back from the sweep heatmap.
+    stopSweep();
+    const RebarDesign& design = rendered.design;
+    rebarCalc.restoreDesign(rendered.params, rendered.design);
+
+    if (rendered.success) {
         ui.label_totalCostValue->setText(QString::number(design.totalCost, 'f', 2) + " Yuan");
         ui.label_concreteCostValue->setText(QString::number(design.concreteCost, 'f', 2) + " Yuan");
         ui.label_steelCostValue->setText(QString::number(design.steelCost, 'f', 2) + " Yuan");
@@ -84,25 +459,83 @@ void Concrete_Reinforcement_Front::handleDesignRequest(bool isCrossSection) {
         else statusBar()->showMessage("Design complete. Longitudinal section displayed.");
     }
     else {
-        ui.label_totalCostValue->setText("---");
-        ui.label_concreteCostValue->setText("---");
-        ui.label_steelCostValue->setText("---");
-        ui.label_laborCostValue->setText("---");
+        clearCostLabels();
         statusBar()->showMessage(QString::fromStdString(design.errorMessage));
     }
 
-    if (image.empty()) {
+    const QPixmap& pixmap = isCrossSection ? rendered.crossSection : rendered.longitudinal;
+    if (pixmap.isNull()) {
         statusBar()->showMessage("Error: Image generation failed.");
         return;
     }
 
-    QImage qimg(image.data, image.cols, image.rows, image.step, QImage::Format_RGB888);
-    QGraphicsScene* scene = new QGraphicsScene(this);
-    scene->addPixmap(QPixmap::fromImage(qimg.rgbSwapped()));
-    ui.graphicsView->setScene(scene);
+    designPixmapItem->setPixmap(pixmap);
+    designTileItem->setDesign(rendered.params, rendered.design, isCrossSection);
+    designScene->setSceneRect(designPixmapItem->boundingRect());
+    updateZoomedDrawing();
     ui.graphicsView->show();
 }
 
+bool Concrete_Reinforcement_Front::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == ui.graphicsView->viewport() && event->type() == QEvent::MouseButtonDblClick && showingSweep && sweepGrid) {
+        // Double-clicking a sweep cell loads its inputs, which redesigns it live.
+        QPointF scenePos = ui.graphicsView->mapToScene(static_cast<QMouseEvent*>(event)->position().toPoint());
+        int col, row;
+        if (!sweepCellAtPixel(*sweepGrid, scenePos.x(), scenePos.y(), col, row)) return false;
+        for (const SweepAxisRange* range : { &sweepSpec.x, &sweepSpec.y }) {
+            QString value = QString::number(range->valueAt(range == &sweepSpec.x ? col : row), 'f', range->axis == SweepAxis::Load ? 1 : 0);
+            switch (range->axis) {
+            case SweepAxis::Span: ui.lineEdit_span->setText(value); break;
+            case SweepAxis::Width: ui.lineEdit_width->setText(value); break;
+            case SweepAxis::Height: ui.lineEdit_height->setText(value); break;
+            case SweepAxis::Load: ui.lineEdit_weight->setText(value); break;
+            }
+        }
+        return true;
+    }
+    if (watched == ui.graphicsView->viewport() && event->type() == QEvent::Wheel) {
+        QWheelEvent* wheel = static_cast<QWheelEvent*>(event);
+        if (wheel->angleDelta().y() == 0) return false;
+        double current = ui.graphicsView->transform().m11();
+        double target = current * (wheel->angleDelta().y() > 0 ? 1.25 : 0.8);
+        target = std::max(1.0, std::min(MAX_VIEW_ZOOM, target));
+        ui.graphicsView->scale(target / current, target / current);
+        updateZoomedDrawing();
+        return true;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void Concrete_Reinforcement_Front::updateZoomedDrawing()
+{
+    // At 1x the prerendered picture is shown as is; zoomed in, the tiled item takes over
+    // and draws the visible part at full resolution.
+    bool zoomed = ui.graphicsView->transform().m11() > 1.0001 && !showingSweep;
+    designPixmapItem->setVisible(!zoomed);
+    designTileItem->setVisible(zoomed);
+}
+
+void Concrete_Reinforcement_Front::on_pushButton_export_clicked()
+{
+    if (!hasCurrentDesign) {
+        statusBar()->showMessage("Error: Generate a design before exporting a drawing.");
+        return;
+    }
+
+    QString path = QFileDialog::getSaveFileName(this, "Export Drawing", QString(),
+        "SVG Drawing (*.svg);;DXF Drawing (*.dxf)");
+    if (path.isEmpty()) return;
+
+    // The drawing is streamed straight to the file, in millimetres, for the view on screen.
+    std::string errorMessage;
+    if (!exportDrawing(rebarCalc, showCrossSection, path.toLocal8Bit().toStdString(), errorMessage)) {
+        statusBar()->showMessage(QString::fromStdString(errorMessage));
+        return;
+    }
+    statusBar()->showMessage(QString("%1 exported to %2").arg(showCrossSection ? "Cross-section" : "Longitudinal section").arg(path));
+}
+
 void Concrete_Reinforcement_Front::on_pushButton_genPic_clicked()
 {
     handleDesignRequest(true);
@@ -111,4 +544,526 @@ void Concrete_Reinforcement_Front::on_pushButton_genPic_clicked()
 void Concrete_Reinforcement_Front::on_pushButton_genPic2_clicked()
 {
     handleDesignRequest(false);
-}
\ No newline at end of file
+}
+
+void Concrete_Reinforcement_Front::on_pushButton_optimize_clicked()
+{
+    redesignTimer.stop();
+
+    DesignJobRequest request;
+    request.kind = DesignJobRequest::OptimizeSection;
+    request.crossSection = true;
+    showCrossSection = true;
+    if (!readInputs(request, false)) {
+        statusBar()->showMessage("Error: Span, vehicle load and girder spacing must be greater than zero to optimize.");
+        clearCostLabels();
+        return;
+    }
+    if (!requireSingleSpan(request)) return;
+
+    statusBar()->showMessage("Optimizing section...");
+    startDesignJob(request);
+}
+
+void Concrete_Reinforcement_Front::on_pushButton_sweep_clicked()
+{
+    DesignJobRequest request;
+    if (!readInputs(request, true)) {
+        statusBar()->showMessage("Error: Enter a valid design to sweep around first.");
+        return;
+    }
+    if (!requireSingleSpan(request)) return;
+    DesignSweepSpec spec;
+    spec.span = request.span;
+    spec.width = request.width;
+    spec.height = request.height;
+    spec.load = request.weight;
+    spec.wheelSpan = request.wheelSpan;
+    spec.girderSpacing = request.girderSpacing;
+    // Same stirrup design as the live views.
+    spec.zonedStirrups = true;
+    SweepLayer layer = sweepLayer;
+    if (!configureSweep(spec, layer)) return;
+    if (!spec.isValid()) {
+        statusBar()->showMessage("Error: The sweep needs two different axes with positive, increasing ranges.");
+        return;
+    }
+    startSweep(spec, layer);
+}
+
+bool Concrete_Reinforcement_Front::configureSweep(DesignSweepSpec& spec, SweepLayer& layer)
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Design Sweep");
+    QFormLayout* form = new QFormLayout(&dialog);
+
+    struct AxisControls
+    {
+        QComboBox* axis;
+        QDoubleSpinBox* minValue;
+        QDoubleSpinBox* maxValue;
+        QSpinBox* steps;
+    };
+    // Each axis defaults to +/-50% around the current design.
+    auto addAxis = [&](const QString& label, SweepAxis initial) {
+        AxisControls controls;
+        controls.axis = new QComboBox(&dialog);
+        for (SweepAxis axis : { SweepAxis::Span, SweepAxis::Width, SweepAxis::Height, SweepAxis::Load }) {
+            controls.axis->addItem(sweepAxisName(axis), (int)axis);
+        }
+        controls.minValue = new QDoubleSpinBox(&dialog);
+        controls.maxValue = new QDoubleSpinBox(&dialog);
+        for (QDoubleSpinBox* box : { controls.minValue, controls.maxValue }) {
+            box->setRange(0, 1e7);
+            box->setDecimals(1);
+        }
+        controls.steps = new QSpinBox(&dialog);
+        controls.steps->setRange(2, 2000);
+        controls.steps->setValue(500);
+        auto resetRange = [&spec, controls]() {
+            double base = spec.baseValue((SweepAxis)controls.axis->currentData().toInt());
+            controls.minValue->setValue(base * 0.5);
+            controls.maxValue->setValue(base * 1.5);
+        };
+        connect(controls.axis, &QComboBox::currentIndexChanged, &dialog, resetRange);
+        controls.axis->setCurrentIndex((int)initial);
+        resetRange();
+        form->addRow(label + " axis", controls.axis);
+        form->addRow(label + " from", controls.minValue);
+        form->addRow(label + " to", controls.maxValue);
+        form->addRow(label + " points", controls.steps);
+        return controls;
+    };
+    AxisControls x = addAxis("X", SweepAxis::Width);
+    AxisControls y = addAxis("Y", SweepAxis::Height);
+
+    QComboBox* colourBy = new QComboBox(&dialog);
+    colourBy->addItem("Total cost", (int)SweepLayer::Cost);
+    colourBy->addItem("Flexural bar diameter", (int)SweepLayer::Diameter);
+    colourBy->setCurrentIndex((int)layer);
+    form->addRow("Colour by", colourBy);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    if (dialog.exec() != QDialog::Accepted) return false;
+
+    for (auto pair : { std::make_pair(&spec.x, x), std::make_pair(&spec.y, y) }) {
+        pair.first->axis = (SweepAxis)pair.second.axis->currentData().toInt();
+        pair.first->minValue = pair.second.minValue->value();
+        pair.first->maxValue = pair.second.maxValue->value();
+        pair.first->steps = pair.second.steps->value();
+    }
+    layer = (SweepLayer)colourBy->currentData().toInt();
+    return true;
+}
+
+void Concrete_Reinforcement_Front::startSweep(const DesignSweepSpec& spec, SweepLayer layer)
+{
+    // Neither a running sweep nor a pending design may replace the heatmap.
+    stopSweep();
+    redesignTimer.stop();
+    if (activeCancelFlag) activeCancelFlag->store(true);
+    ++latestGeneration;
+
+    sweepSpec = spec;
+    sweepLayer = layer;
+    sweepGrid = std::make_shared<DesignSweepGrid>();
+    sweepGrid->reset(spec.x.steps, spec.y.steps);
+    sweepCancelFlag = std::make_shared<std::atomic<bool>>(false);
+    showingSweep = true;
+
+    // The job keeps its own references, so it can outlive a newer sweep replacing these.
+    std::shared_ptr<DesignSweepGrid> grid = sweepGrid;
+    std::shared_ptr<std::atomic<bool>> cancelFlag = sweepCancelFlag;
+    sweepFuture = QtConcurrent::run([spec, grid, cancelFlag]() {
+        return runDesignSweep(spec, *grid, sharedDesignPool(), cancelFlag.get());
+    });
+    auto* watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, grid]() {
+        if (grid == sweepGrid && showingSweep) finishSweep();
+        watcher->deleteLater();
+    });
+    watcher->setFuture(sweepFuture);
+
+    sweepClock.start();
+    ui.graphicsView->resetTransform();
+    updateZoomedDrawing();
+    renderSweep();
+    sweepRefreshTimer.start();
+}
+
+void Concrete_Reinforcement_Front::stopSweep()
+{
+    sweepRefreshTimer.stop();
+    showingSweep = false;
+    if (sweepCancelFlag) sweepCancelFlag->store(true);
+    sweepFuture.waitForFinished();
+}
+
+void Concrete_Reinforcement_Front::renderSweep()
+{
+    if (!showingSweep || !sweepGrid) return;
+
+    // Drawn straight into the QImage buffer, as for the design views.
+    QImage image(SWEEP_IMAGE_SIZE.width, SWEEP_IMAGE_SIZE.height, QImage::Format_RGB32);
+    cv::Mat buffer(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+    drawSweepHeatmap(sweepSpec, *sweepGrid, sweepLayer, buffer);
+    designPixmapItem->setPixmap(QPixmap::fromImage(std::move(image)));
+    designScene->setSceneRect(designPixmapItem->boundingRect());
+
+    statusBar()->showMessage(QString("Sweeping: %1 of %2 designs (%3 feasible) after %4 s...")
+        .arg(sweepGrid->completed.load()).arg(sweepGrid->cellCount()).arg(sweepGrid->feasible.load())
+        .arg(sweepClock.elapsed() / 1000.0, 0, 'f', 2));
+}
+
+void Concrete_Reinforcement_Front::finishSweep()
+{
+    sweepRefreshTimer.stop();
+    renderSweep();
+    double seconds = sweepClock.elapsed() / 1000.0;
+    statusBar()->showMessage(QString("Sweep finished: %1 designs (%2 feasible) in %3 s. Double-click a cell to load it.")
+        .arg(sweepGrid->completed.load()).arg(sweepGrid->feasible.load()).arg(seconds, 0, 'f', 2));
+}
+
+void Concrete_Reinforcement_Front::on_pushButton_pareto_clicked()
+{
+    redesignTimer.stop();
+
+    DesignJobRequest request;
+    request.kind = DesignJobRequest::ParetoFront;
+    request.crossSection = showCrossSection;
+    if (!readInputs(request, false)) {
+        statusBar()->showMessage("Error: Span, vehicle load and girder spacing must be greater than zero to search.");
+        clearCostLabels();
+        return;
+    }
+    if (!requireSingleSpan(request)) return;
+
+    statusBar()->showMessage("Searching the Pareto front...");
+    startDesignJob(request);
+}
+
+void Concrete_Reinforcement_Front::showParetoFront()
+{
+    if (!paretoDialog) {
+        paretoDialog = new QDialog(this);
+        paretoDialog->setWindowTitle("Pareto Front");
+        paretoDialog->resize(760, 480);
+        QVBoxLayout* layout = new QVBoxLayout(paretoDialog);
+        layout->addWidget(new QLabel("No design in this list is beaten by another on cost, steel, height and congestion at once. "
+            "Sort by any column and select a row to show that design.", paretoDialog));
+        paretoTable = new QTableWidget(paretoDialog);
+        paretoTable->setColumnCount(7);
+        paretoTable->setHorizontalHeaderLabels({ "Total Cost (Yuan)", "Steel (t)", "Height (mm)", "Width (mm)", "Congestion (%)", "Flexural Bars", "Stirrups" });
+        paretoTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        paretoTable->setSelectionMode(QAbstractItemView::SingleSelection);
+        paretoTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        paretoTable->horizontalHeader()->setStretchLastSection(true);
+        layout->addWidget(paretoTable);
+        connect(paretoTable, &QTableWidget::itemSelectionChanged, this, [this]() {
+            QList<QTableWidgetItem*> selected = paretoTable->selectedItems();
+            if (!selected.isEmpty()) showParetoDesign(paretoTable->item(selected.first()->row(), 0)->data(Qt::UserRole).toInt());
+        });
+    }
+
+    // Numbers are stored as numbers so that the columns sort numerically.
+    auto numberItem = [](double value, int decimals) {
+        QTableWidgetItem* item = new QTableWidgetItem();
+        item->setData(Qt::DisplayRole, QString::number(value, 'f', decimals).toDouble());
+        return item;
+    };
+    QSignalBlocker blockTable(paretoTable);
+    paretoTable->setSortingEnabled(false);
+    paretoTable->clearContents();
+    paretoTable->setRowCount((int)paretoFront.size());
+    for (int i = 0; i < (int)paretoFront.size(); ++i) {
+        const ParetoDesign& member = paretoFront[i];
+        const RebarDesign& design = member.design;
+        QTableWidgetItem* costItem = numberItem(design.totalCost, 2);
+        costItem->setData(Qt::UserRole, i);
+        paretoTable->setItem(i, 0, costItem);
+        paretoTable->setItem(i, 1, numberItem(member.steelWeight, 2));
+        paretoTable->setItem(i, 2, numberItem(member.params.height, 0));
+        paretoTable->setItem(i, 3, numberItem(member.params.width, 0));
+        paretoTable->setItem(i, 4, numberItem(member.congestion * 100.0, 0));
+        QString bars = QString::fromStdString(flexuralLayoutText(design));
+        paretoTable->setItem(i, 5, new QTableWidgetItem(bars));
+        paretoTable->setItem(i, 6, new QTableWidgetItem(QString("d%1, %2 legs, @%3").arg(design.stirrupDiameter)
+            .arg(design.stirrupLegs).arg(design.stirrupSpacing)));
+    }
+    paretoTable->setSortingEnabled(true);
+    paretoTable->sortByColumn(0, Qt::AscendingOrder);
+    paretoDialog->show();
+    paretoDialog->raise();
+}
+
+void Concrete_Reinforcement_Front::showParetoDesign(int index)
+{
+    if (index < 0 || index >= (int)paretoFront.size()) return;
+    const ParetoDesign& member = paretoFront[index];
+
+    // Drop any live redesign that is still on its way, as for a finished optimization.
+    redesignTimer.stop();
+    if (activeCancelFlag) activeCancelFlag->store(true);
+    ++latestGeneration;
+
+    RebarCalc calc;
+    calc.restoreDesign(member.params, member.design);
+    RenderedDesign rendered;
+    rendered.key = DesignCacheKey::fromInputs(paretoRequest.span, member.params.width, member.params.height, paretoRequest.weight,
+        paretoRequest.wheelSpan, paretoRequest.girderSpacing);
+    rendered.success = true;
+    rendered.design = member.design;
+    rendered.params = member.params;
+    rendered.crossSection = QPixmap::fromImage(drawDesignView(calc, true));
+    rendered.longitudinal = QPixmap::fromImage(drawDesignView(calc, false));
+    currentDesign = rendered;
+    hasCurrentDesign = true;
+
+    QSignalBlocker blockWidth(ui.lineEdit_width);
+    QSignalBlocker blockHeight(ui.lineEdit_height);
+    ui.lineEdit_width->setText(QString::number(member.params.width));
+    ui.lineEdit_height->setText(QString::number(member.params.height));
+    showRenderedDesign(currentDesign, showCrossSection);
+}
+
+void Concrete_Reinforcement_Front::on_pushButton_deck_clicked()
+{
+    redesignTimer.stop();
+
+    DesignJobRequest request;
+    request.kind = DesignJobRequest::Deck;
+    request.crossSection = showCrossSection;
+    if (!readInputs(request, true)) {
+        statusBar()->showMessage("Error: Please enter valid positive numbers for all parameters.");
+        clearCostLabels();
+        return;
+    }
+
+    if (!requireSingleSpan(request)) return;
+
+    statusBar()->showMessage("Solving the deck grillage and designing every girder...");
+    startDesignJob(request);
+}
+
+void Concrete_Reinforcement_Front::showDeckDesign()
+{
+    if (!deckDialog) {
+        deckDialog = new QDialog(this);
+        deckDialog->setWindowTitle("Deck Design");
+        deckDialog->resize(860, 360);
+        QVBoxLayout* layout = new QVBoxLayout(deckDialog);
+        deckSummaryLabel = new QLabel(deckDialog);
+        layout->addWidget(deckSummaryLabel);
+        deckTable = new QTableWidget(deckDialog);
+        deckTable->setColumnCount(7);
+        deckTable->setHorizontalHeaderLabels({ "Girder", "Offset (mm)", "Moment Share", "Shear Share", "Cost (Yuan)", "Flexural Bars", "Stirrups" });
+        deckTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        deckTable->setSelectionMode(QAbstractItemView::SingleSelection);
+        deckTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        deckTable->horizontalHeader()->setStretchLastSection(true);
+        layout->addWidget(deckTable);
+        connect(deckTable, &QTableWidget::itemSelectionChanged, this, [this]() {
+            QList<QTableWidgetItem*> selected = deckTable->selectedItems();
+            if (!selected.isEmpty()) showDeckGirder(selected.first()->row());
+        });
+    }
+
+    deckSummaryLabel->setText(QString("Deck total %1 Yuan: girders %2 Yuan, cross-beam concrete %3 Yuan. "
+        "Shares are the largest each girder takes of the vehicle over %4 lateral positions. Select a row to show that girder.")
+        .arg(deckDesign.totalCost, 0, 'f', 2).arg(deckDesign.girderCost, 0, 'f', 2).arg(deckDesign.crossBeamCost, 0, 'f', 2)
+        .arg(deckDesign.loadPositions));
+    QSignalBlocker blockTable(deckTable);
+    deckTable->clearContents();
+    deckTable->setRowCount((int)deckDesign.girders.size());
+    for (int i = 0; i < (int)deckDesign.girders.size(); ++i) {
+        const GirderResult& girder = deckDesign.girders[i];
+        const RebarDesign& design = girder.design;
+        deckTable->setItem(i, 0, new QTableWidgetItem(QString("G%1").arg(i + 1)));
+        deckTable->setItem(i, 1, new QTableWidgetItem(QString::number(girder.offset, 'f', 0)));
+        deckTable->setItem(i, 2, new QTableWidgetItem(QString::number(girder.momentFactor, 'f', 3)));
+        deckTable->setItem(i, 3, new QTableWidgetItem(QString::number(girder.shearFactor, 'f', 3)));
+        if (!girder.success) {
+            deckTable->setItem(i, 4, new QTableWidgetItem("---"));
+            deckTable->setItem(i, 5, new QTableWidgetItem(QString::fromStdString(design.errorMessage)));
+            continue;
+        }
+        deckTable->setItem(i, 4, new QTableWidgetItem(QString::number(design.totalCost, 'f', 2)));
+        QString bars = QString::fromStdString(flexuralLayoutText(design));
+        deckTable->setItem(i, 5, new QTableWidgetItem(bars));
+        deckTable->setItem(i, 6, new QTableWidgetItem(QString("d%1, %2 legs, @%3").arg(design.stirrupDiameter)
+            .arg(design.stirrupLegs).arg(design.stirrupSpacing)));
+    }
+    deckDialog->show();
+    deckDialog->raise();
+}
+
+void Concrete_Reinforcement_Front::showDeckGirder(int index)
+{
+    if (index < 0 || index >= (int)deckDesign.girders.size()) return;
+    const GirderResult& girder = deckDesign.girders[index];
+
+    // Drop any live redesign that is still on its way, as for a Pareto design.
+    redesignTimer.stop();
+    if (activeCancelFlag) activeCancelFlag->store(true);
+    ++latestGeneration;
+
+    RebarCalc calc;
+    calc.restoreDesign(girder.params, girder.design);
+    RenderedDesign rendered;
+    rendered.key = DesignCacheKey::fromInputs(deckRequest.span, deckRequest.width, deckRequest.height, deckRequest.weight,
+        deckRequest.wheelSpan, deckRequest.girderSpacing);
+    rendered.success = girder.success;
+    rendered.design = girder.design;
+    rendered.params = girder.params;
+    rendered.crossSection = QPixmap::fromImage(drawDesignView(calc, true));
+    rendered.longitudinal = QPixmap::fromImage(drawDesignView(calc, false));
+    currentDesign = rendered;
+    hasCurrentDesign = true;
+    showRenderedDesign(currentDesign, showCrossSection);
+}
+
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+void Concrete_Reinforcement_Front::showDiagnostics()
+{
+    InstrumentationSnapshot d = Instrumentation::snapshot() - diagnosticsBaseline;
+    diagnosticsLabel->setText(QString("forces %1 ms | diameters %2 ms | shear %3 ms | costing %4 ms | drawing %5 ms | to pixmap %6 ms"
+        " | %7 candidates, %8 xi / %9 row rejects, cache %10/%11")
+        .arg(d.milliseconds(DesignStage::ForceAnalysis), 0, 'f', 3)
+        .arg(d.milliseconds(DesignStage::DiameterLoop), 0, 'f', 3)
+        .arg(d.milliseconds(DesignStage::ShearDesign), 0, 'f', 3)
+        .arg(d.milliseconds(DesignStage::Costing), 0, 'f', 3)
+        .arg(d.milliseconds(DesignStage::Drawing), 0, 'f', 2)
+        .arg(d.milliseconds(DesignStage::ImageConversion), 0, 'f', 2)
+        .arg(d.count(DesignCounter::CandidatesEvaluated))
+        .arg(d.count(DesignCounter::XiRejects))
+        .arg(d.count(DesignCounter::RowCapacityRejects))
+        .arg(d.count(DesignCounter::CacheHits))
+        .arg(d.count(DesignCounter::CacheHits) + d.count(DesignCounter::CacheMisses)));
+}
+#endif
+
+void Concrete_Reinforcement_Front::on_pushButton_reliability_clicked()
+{
+    if (reliabilityFuture.isRunning()) return;
+    if (!hasCurrentDesign || !currentDesign.success) {
+        statusBar()->showMessage("Error: Generate a successful design before the reliability analysis.");
+        return;
+    }
+    if (currentDesign.params.spanCount > 1) {
+        statusBar()->showMessage("Error: Reliability analysis supports simply supported spans only.");
+        return;
+    }
+    ReliabilitySpec spec = reliabilitySpec;
+    if (!configureReliability(spec)) return;
+    reliabilitySpec = spec;
+
+    // The job works on its own copy of the design, so later designs cannot change it.
+    RebarCalc calc;
+    calc.restoreDesign(currentDesign.params, currentDesign.design);
+    reliabilityFuture = QtConcurrent::run([calc, spec]() {
+        ReliabilityResult result;
+        runReliabilityAnalysis(calc, spec, result, sharedDesignPool());
+        return result;
+    });
+    auto* watcher = new QFutureWatcher<ReliabilityResult>(this);
+    connect(watcher, &QFutureWatcher<ReliabilityResult>::finished, this, [this, watcher]() {
+        ui.pushButton_reliability->setEnabled(true);
+        showReliabilityResult(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(reliabilityFuture);
+    ui.pushButton_reliability->setEnabled(false);
+    statusBar()->showMessage(QString("Sampling %1 designs for the reliability analysis...").arg(spec.samples));
+}
+
+bool Concrete_Reinforcement_Front::configureReliability(ReliabilitySpec& spec)
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Reliability Analysis");
+    QFormLayout* form = new QFormLayout(&dialog);
+
+    QSpinBox* samples = new QSpinBox(&dialog);
+    samples->setRange(1000, 1000000000);
+    samples->setSingleStep(1000000);
+    samples->setValue((int)std::min<long long>(spec.samples, 1000000000));
+    form->addRow("Samples", samples);
+    QSpinBox* seed = new QSpinBox(&dialog);
+    seed->setRange(0, std::numeric_limits<int>::max());
+    seed->setValue((int)std::min<uint64_t>(spec.seed, std::numeric_limits<int>::max()));
+    form->addRow("Seed", seed);
+
+    // Mean and standard deviation of every variable; the distribution types are fixed.
+    struct VariableControls
+    {
+        RandomVariable* variable;
+        QDoubleSpinBox* mean;
+        QDoubleSpinBox* stdDev;
+    };
+    std::vector<VariableControls> controls;
+    auto addVariable = [&](const QString& label, RandomVariable& variable) {
+        static const char* distributionNames[] = { "fixed", "normal", "lognormal", "Gumbel" };
+        VariableControls row = { &variable, new QDoubleSpinBox(&dialog), new QDoubleSpinBox(&dialog) };
+        for (QDoubleSpinBox* box : { row.mean, row.stdDev }) {
+            box->setRange(box == row.mean ? -1000 : 0, 1000);
+            box->setDecimals(3);
+            box->setSingleStep(0.01);
+        }
+        row.mean->setValue(variable.mean);
+        row.stdDev->setValue(variable.stdDev);
+        QHBoxLayout* line = new QHBoxLayout();
+        line->addWidget(new QLabel("mean", &dialog));
+        line->addWidget(row.mean);
+        line->addWidget(new QLabel("std. dev.", &dialog));
+        line->addWidget(row.stdDev);
+        form->addRow(QString("%1 (%2)").arg(label).arg(distributionNames[variable.distribution]), line);
+        controls.push_back(row);
+    };
+    addVariable("Concrete strength factor", spec.concreteStrength);
+    addVariable("Steel yield factor", spec.steelYield);
+    addVariable("Cover deviation (mm)", spec.cover);
+    addVariable("Width deviation (mm)", spec.width);
+    addVariable("Height deviation (mm)", spec.height);
+    addVariable("Dead load factor", spec.deadLoad);
+    addVariable("Vehicle load factor", spec.vehicleLoad);
+    addVariable("Resistance model factor", spec.resistanceModel);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    if (dialog.exec() != QDialog::Accepted) return false;
+
+    spec.samples = samples->value();
+    spec.seed = (uint64_t)seed->value();
+    for (const VariableControls& row : controls) {
+        row.variable->mean = row.mean->value();
+        row.variable->stdDev = row.stdDev->value();
+    }
+    return true;
+}
+
+void Concrete_Reinforcement_Front::showReliabilityResult(const ReliabilityResult& result)
+{
+    if (!result.success) {
+        statusBar()->showMessage(QString::fromStdString(result.errorMessage));
+        return;
+    }
+    QString beta = QString::number(result.reliabilityIndex, 'f', 2);
+    if (result.lowerBound) beta = "above " + beta;
+    statusBar()->showMessage(QString("Reliability analysis: %1 samples in %2 s, failure probability %3, reliability index %4.")
+        .arg(result.samples).arg(result.seconds, 0, 'f', 2).arg(result.failureProbability, 0, 'g', 4).arg(beta));
+    QMessageBox::information(this, "Reliability Analysis",
+        QString("Samples: %1 (%2 s)\n\n"
+            "Failure probability: %3 (coefficient of variation %4)\n"
+            "Reliability index: %5\n\n"
+            "Flexure failures: %6 (%7)\n"
+            "Shear failures: %8 (%9)")
+        .arg(result.samples).arg(result.seconds, 0, 'f', 2)
+        .arg(result.failureProbability, 0, 'g', 4).arg(result.estimateCoV, 0, 'f', 3)
+        .arg(beta)
+        .arg(result.flexureFailures).arg(result.flexureProbability, 0, 'g', 4)
+        .arg(result.shearFailures).arg(result.shearProbability, 0, 'g', 4));
+}
@@ -1,8 +1,74 @@
 #pragma once
 
 #include <QtWidgets/QMainWindow>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QGraphicsPixmapItem>
+#include <QGraphicsScene>
+#include <QImage>
+#include <QPixmap>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <list>
+#include <memory>
 #include "ui_Concrete_Reinforcement_Front.h"
 #include "RebarCalc.h"
+#include "DesignCache.h"
+#include "DesignPipeline.h"
+#include "DrawingTileItem.h"
+#include "DesignSweep.h"
+#include "DeckGrillage.h"
+#include "Reliability.h"
+#include "DesignSurrogate.h"
+
+// --- Background Design Job ---
+// Everything a worker needs to design and draw one beam, copied out of the line edits
+// so the job never touches widgets.
+struct DesignJobRequest
+{
+    enum Kind { Design, OptimizeSection, ParetoFront, Deck };
+    Kind kind = Design;
+    bool crossSection = true;
+    double span = 0;
+    std::vector<double> spans; // two or more for a continuous girder, otherwise empty
+    double width = 0;
+    double height = 0;
+    double weight = 0;
+    double wheelSpan = 0;
+    double girderSpacing = 0;
+};
+
+struct DesignJobResult
+{
+    quint64 generation = 0;
+    DesignJobRequest request;
+    bool cancelled = false;
+    bool success = false;
+    bool fromCache = false;
+    RebarDesign design;
+    BridgeParams params = {};
+    SectionSearchStats searchStats;
+    std::vector<ParetoDesign> paretoFront; // ParetoFront jobs only, cheapest first
+    DeckDesign deck;                       // Deck jobs only; the most expensive girder is shown
+    // Both views, drawn by OpenCV directly into the QImage pixel buffers (Format_RGB32).
+    QImage crossSectionImage;
+    QImage longitudinalImage;
+};
+
+// --- Rendered Design ---
+// A finished design with both views ready for display, so switching views only swaps
+// the pixmap shown by the scene.
+struct RenderedDesign
+{
+    DesignCacheKey key = {};
+    bool success = false;
+    RebarDesign design;
+    BridgeParams params = {};
+    QPixmap crossSection;
+    QPixmap longitudinal;
+};
 
 class Concrete_Reinforcement_Front : public QMainWindow
 {
@@ -13,14 +79,125 @@ public:
     ~Concrete_Reinforcement_Front();
     void initUI();
 
+    // Delay between the last keystroke and the live redesign it triggers.
+    static constexpr int REDESIGN_DEBOUNCE_MS = 300;
+    // Number of recent designs whose rendered views are kept (about 2.4 MB each).
+    static constexpr size_t RENDER_CACHE_SIZE = 8;
+    // Mouse-wheel zoom range of the drawing view; beyond 1x the view is painted from tiles.
+    static constexpr double MAX_VIEW_ZOOM = 256.0;
+    // Redraw interval of a sweep heatmap while its cells are still arriving.
+    static constexpr int SWEEP_REFRESH_MS = 100;
+    // Surrogate table looked for next to the executable (built with --build-surrogate).
+    static constexpr const char* SURROGATE_FILE_NAME = "designs.rbsg";
+
 public slots:
     void on_pushButton_autoGenerate_clicked();
     void on_pushButton_genPic_clicked();
     void on_pushButton_genPic2_clicked();
+    void on_pushButton_optimize_clicked();
+    void scheduleRedesign();
+    void on_pushButton_export_clicked();
+    void on_pushButton_sweep_clicked();
+    void on_pushButton_pareto_clicked();
+    void on_pushButton_deck_clicked();
+    void on_pushButton_reliability_clicked();
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
 private:
     void handleDesignRequest(bool isCrossSection);
+    bool readInputs(DesignJobRequest& request, bool needSection);
+    bool requireSingleSpan(const DesignJobRequest& request);
+    void startDesignJob(const DesignJobRequest& request);
+    void applyDesignResult(DesignJobResult result);
+    void showRenderedDesign(const RenderedDesign& rendered, bool isCrossSection);
+    const RenderedDesign* findRenderedDesign(const DesignCacheKey& key) const;
+    void clearCostLabels();
+    void showDesignPreview();
+    void updateZoomedDrawing();
+    bool configureSweep(DesignSweepSpec& spec, SweepLayer& layer);
+    void startSweep(const DesignSweepSpec& spec, SweepLayer layer);
+    void stopSweep();
+    void renderSweep();
+    void finishSweep();
+    void showParetoFront();
+    void showParetoDesign(int index);
+    void showDeckDesign();
+    void showDeckGirder(int index);
+    bool configureReliability(ReliabilitySpec& spec);
+    void showReliabilityResult(const ReliabilityResult& result);
+    static QImage drawDesignView(RebarCalc& calc, bool crossSection);
+    static QImage shareView(const cv::Mat& view);
+    static DesignJobResult runDesignJob(const DesignJobRequest& request, quint64 generation,
+        std::shared_ptr<std::atomic<bool>> cancelFlag, DesignCache* cache, DesignPipeline* pipeline);
 
     Ui::Concrete_Reinforcement_FrontClass ui;
     RebarCalc rebarCalc;
+    DesignCache designCache;
+    // Live-edit designs: only jobs on designPool use it, and they never overlap.
+    DesignPipeline designPipeline;
+
+    // Live redesign: edits restart the debounce timer; each started job gets a new
+    // generation and its own cancel flag, and only the newest generation is displayed.
+    QTimer redesignTimer;
+    QThreadPool designPool;
+    quint64 latestGeneration = 0;
+    std::shared_ptr<std::atomic<bool>> activeCancelFlag;
+    bool showCrossSection = true;
+
+    // One scene and pixmap item for the whole session; the current design is also kept in
+    // renderCache (most recent first) unless it came from the section optimizer.
+    QGraphicsScene* designScene = nullptr;
+    QGraphicsPixmapItem* designPixmapItem = nullptr;
+    DrawingTileItem* designTileItem = nullptr;
+    RenderedDesign currentDesign;
+    bool hasCurrentDesign = false;
+    std::list<RenderedDesign> renderCache;
+
+    // Instant previews while typing, answered from the memory-mapped surrogate table until
+    // the exact design arrives. Only opened when it was built with the GUI design options.
+    DesignSurrogate designSurrogate;
+    bool previewShown = false;
+    bool previewSuccess = false;
+    DesignCacheKey previewKey = {};
+    double previewCost = 0;
+
+    // Design-space sweep: the grid is filled on the shared work-stealing pool and redrawn
+    // from the GUI thread by sweepRefreshTimer until the job ends.
+    DesignSweepSpec sweepSpec;
+    SweepLayer sweepLayer = SweepLayer::Cost;
+    std::shared_ptr<DesignSweepGrid> sweepGrid;
+    std::shared_ptr<std::atomic<bool>> sweepCancelFlag;
+    QFuture<bool> sweepFuture;
+    QTimer sweepRefreshTimer;
+    QElapsedTimer sweepClock;
+    bool showingSweep = false;
+
+    // Last Pareto front and the inputs it was searched for, browsed in a non-modal table.
+    std::vector<ParetoDesign> paretoFront;
+    DesignJobRequest paretoRequest;
+    QDialog* paretoDialog = nullptr;
+    QTableWidget* paretoTable = nullptr;
+
+    // Last whole-deck design and its inputs, one table row per girder.
+    DeckDesign deckDesign;
+    DesignJobRequest deckRequest;
+    QDialog* deckDialog = nullptr;
+    QLabel* deckSummaryLabel = nullptr;
+    QTableWidget* deckTable = nullptr;
+
+    // Monte Carlo reliability of the displayed design, run on the shared work-stealing pool.
+    // The settings of the last run are offered again.
+    ReliabilitySpec reliabilitySpec;
+    QFuture<ReliabilityResult> reliabilityFuture;
+
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+    // Stage times and counters of the last design, shown at the right of the status bar.
+    // Totals are taken since the job was started, so a sweep running at the same time
+    // is included.
+    QLabel* diagnosticsLabel = nullptr;
+    InstrumentationSnapshot diagnosticsBaseline;
+    void showDiagnostics();
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,299 @@
+#pragma once
+
+#ifndef CONTINUOUSBEAM_H
+#define CONTINUOUSBEAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "MovingLoad.h"
+
+// Continuous girders run over 2..MAX_CONTINUOUS_SPANS spans.
+constexpr int MAX_CONTINUOUS_SPANS = 6;
+
+// --- Continuous Beam Envelopes ---
+// Stations are equally spaced within each span; a support belongs to both spans next to
+// it, so it appears twice (once as the end of the left span, once as the start of the
+// right one) and the shear on either side of it is kept. All values are per unit of the
+// train loads (kN) as N and N*mm, sagging moments positive.
+struct ContinuousEnvelope
+{
+    std::vector<double> spans;       // mm
+    std::vector<double> stations;    // mm from the left end of the girder
+    std::vector<int> stationSpan;    // span of each station
+    std::vector<double> momentMax;   // most sagging live moment
+    std::vector<double> momentMin;   // most hogging live moment (negative)
+    std::vector<double> shearMax;
+    std::vector<double> shearMin;
+
+    size_t stationCount() const { return stations.size(); }
+    void clear() { spans.clear(); stations.clear(); stationSpan.clear(); momentMax.clear(); momentMin.clear(); shearMax.clear(); shearMin.clear(); }
+};
+
+// --- Continuous Beam Analyzer ---
+// Prismatic girder on simple supports. The support moments follow from the three-moment
+// equation, which is tridiagonal in the interior support moments and solved in O(n) with
+// the Thomas algorithm. For moving loads the support moments of a unit load are tabulated
+// once on a grid along the girder (one solve per interior support gives the inverse
+// columns, so each grid point costs O(n)). Each train position then sums the tabulated
+// support moments of its axles and adds the simple-span part exactly, so a position costs
+// O(axles * supports + stations) whatever the number of spans. Between grid points every
+// influence line is linear, so the extremes lie where some axle stands on a grid point,
+// and exactly those positions are evaluated (as MovingLoadEngine does on a single span).
+class ContinuousBeamAnalyzer
+{
+public:
+    // Support moments M_0..M_n (N*mm, hogging negative) under a uniform load q (N/mm) on
+    // every span.
+    static void uniformSupportMoments(const std::vector<double>& spans, double q, std::vector<double>& moments);
+
+    // Live-load envelopes of `train` moved over the whole girder. The stations are the grid
+    // points of the influence table; with bothDirections the train is also run reversed.
+    void computeEnvelope(const std::vector<double>& spans, const AxleTrain& train, int intervalsPerSpan, bool bothDirections,
+        ContinuousEnvelope& envelope);
+
+    static constexpr int DEFAULT_INTERVALS_PER_SPAN = 100;
+
+private:
+    // Scratch reused between calls.
+    std::vector<double> spanStart;         // mm, n + 1 entries (the last is the girder length)
+    std::vector<double> inverse;           // columns of the inverse three-moment matrix
+    std::vector<double> unitMoments;       // support moments of a unit load at each grid point
+    std::vector<double> lower, diagonal, upper, scratch;
+    std::vector<double> positionMoments;   // support moments of the train at one position
+    std::vector<double> axlePosition, axleLoad;
+    std::vector<int> axleSpan;
+    std::vector<double> leadPositions;     // every position that puts an axle on a grid point
+
+    void buildInfluenceTable(const std::vector<double>& spans, int intervalsPerSpan);
+    void accumulate(const AxleTrain& train, bool reversed, int intervalsPerSpan, ContinuousEnvelope& envelope);
+    // Solves the three-moment system for the interior supports in place.
+    void solveInterior(std::vector<double>& rhs);
+};
+
+// Parses "20000" or "20000, 25000, 20000" (mm; commas, semicolons or spaces between the
+// spans). Returns false on malformed input, a non-positive span or more than
+// MAX_CONTINUOUS_SPANS spans.
+bool parseSpanList(const std::string& text, std::vector<double>& spans);
+
+
+// --- Function Implementations ---
+
+inline void ContinuousBeamAnalyzer::solveInterior(std::vector<double>& rhs) {
+    int m = (int)diagonal.size();
+    if (m == 0) return;
+    // Thomas algorithm; the matrix is diagonally dominant, so no pivoting is needed.
+    scratch.resize(m);
+    scratch[0] = upper[0] / diagonal[0];
+    rhs[0] /= diagonal[0];
+    for (int i = 1; i < m; ++i) {
+        double pivot = diagonal[i] - lower[i] * scratch[i - 1];
+        scratch[i] = upper[i] / pivot;
+        rhs[i] = (rhs[i] - lower[i] * rhs[i - 1]) / pivot;
+    }
+    for (int i = m - 2; i >= 0; --i) rhs[i] -= scratch[i] * rhs[i + 1];
+}
+
+inline void ContinuousBeamAnalyzer::uniformSupportMoments(const std::vector<double>& spans, double q, std::vector<double>& moments) {
+    ContinuousBeamAnalyzer analyzer;
+    int n = (int)spans.size();
+    moments.assign(n + 1, 0.0);
+    if (n < 2) return;
+    // Interior support i (1..n-1) between spans i-1 and i:
+    // L_{i-1} M_{i-1} + 2 (L_{i-1} + L_i) M_i + L_i M_{i+1} = -q (L_{i-1}^3 + L_i^3) / 4
+    analyzer.lower.assign(n - 1, 0.0);
+    analyzer.diagonal.assign(n - 1, 0.0);
+    analyzer.upper.assign(n - 1, 0.0);
+    std::vector<double> rhs(n - 1);
+    for (int i = 1; i < n; ++i) {
+        analyzer.lower[i - 1] = i > 1 ? spans[i - 1] : 0.0;
+        analyzer.diagonal[i - 1] = 2.0 * (spans[i - 1] + spans[i]);
+        analyzer.upper[i - 1] = i < n - 1 ? spans[i] : 0.0;
+        rhs[i - 1] = -q * (std::pow(spans[i - 1], 3) + std::pow(spans[i], 3)) / 4.0;
+    }
+    analyzer.solveInterior(rhs);
+    for (int i = 1; i < n; ++i) moments[i] = rhs[i - 1];
+}
+
+inline void ContinuousBeamAnalyzer::buildInfluenceTable(const std::vector<double>& spans, int intervalsPerSpan) {
+    int n = (int)spans.size();
+    int m = n - 1;
+    spanStart.resize(n + 1);
+    spanStart[0] = 0;
+    for (int j = 0; j < n; ++j) spanStart[j + 1] = spanStart[j] + spans[j];
+
+    lower.assign(m, 0.0);
+    diagonal.assign(m, 0.0);
+    upper.assign(m, 0.0);
+    for (int i = 1; i < n; ++i) {
+        lower[i - 1] = i > 1 ? spans[i - 1] : 0.0;
+        diagonal[i - 1] = 2.0 * (spans[i - 1] + spans[i]);
+        upper[i - 1] = i < n - 1 ? spans[i] : 0.0;
+    }
+    // Column k of the inverse: the support moments for a unit right-hand side at support k + 1.
+    inverse.assign((size_t)m * m, 0.0);
+    std::vector<double> column(m);
+    for (int k = 0; k < m; ++k) {
+        std::fill(column.begin(), column.end(), 0.0);
+        column[k] = 1.0;
+        solveInterior(column);
+        std::copy(column.begin(), column.end(), inverse.begin() + (size_t)k * m);
+    }
+
+    // Unit load at a from the left of span j (b = L - a) loads the equations of its two
+    // supports: -a (L^2 - a^2) / L at its right support, -b (L^2 - b^2) / L at its left one.
+    int points = intervalsPerSpan + 1;
+    unitMoments.assign((size_t)n * points * (n + 1), 0.0);
+    for (int j = 0; j < n; ++j) {
+        double L = spans[j];
+        for (int k = 0; k < points; ++k) {
+            double a = L * k / intervalsPerSpan, b = L - a;
+            double* M = &unitMoments[((size_t)j * points + k) * (n + 1)];
+            double rightTerm = -a * (L * L - a * a) / L; // equation of support j + 1
+            double leftTerm = -b * (L * L - b * b) / L;  // equation of support j
+            for (int i = 1; i < n; ++i) {
+                double value = 0;
+                if (j + 1 <= m) value += inverse[(size_t)j * m + (i - 1)] * rightTerm;
+                if (j >= 1) value += inverse[(size_t)(j - 1) * m + (i - 1)] * leftTerm;
+                M[i] = value;
+            }
+        }
+    }
+}
+
+inline void ContinuousBeamAnalyzer::computeEnvelope(const std::vector<double>& spans, const AxleTrain& train, int intervalsPerSpan,
+    bool bothDirections, ContinuousEnvelope& envelope) {
+    if (intervalsPerSpan < 1) intervalsPerSpan = 1;
+    int n = (int)spans.size();
+    envelope.clear();
+    envelope.spans = spans;
+    if (n < 1) return;
+    for (double L : spans) {
+        if (L <= 0) return;
+    }
+
+    buildInfluenceTable(spans, intervalsPerSpan);
+    int points = intervalsPerSpan + 1;
+    size_t count = (size_t)n * points;
+    envelope.stations.resize(count);
+    envelope.stationSpan.resize(count);
+    for (int j = 0; j < n; ++j) {
+        for (int k = 0; k < points; ++k) {
+            envelope.stations[(size_t)j * points + k] = spanStart[j] + spans[j] * k / intervalsPerSpan;
+            envelope.stationSpan[(size_t)j * points + k] = j;
+        }
+    }
+    envelope.momentMax.assign(count, 0.0);
+    envelope.momentMin.assign(count, 0.0);
+    envelope.shearMax.assign(count, 0.0);
+    envelope.shearMin.assign(count, 0.0);
+    if (!train.isValid()) return;
+
+    accumulate(train, false, intervalsPerSpan, envelope);
+    if (bothDirections) accumulate(train, true, intervalsPerSpan, envelope);
+}
+
+inline void ContinuousBeamAnalyzer::accumulate(const AxleTrain& train, bool reversed, int intervalsPerSpan, ContinuousEnvelope& envelope) {
+    const std::vector<double>& spans = envelope.spans;
+    int n = (int)spans.size();
+    int points = intervalsPerSpan + 1;
+    size_t axles = train.size();
+    double total = spanStart[n];
+    double length = train.length();
+
+    positionMoments.resize(n + 1);
+    axlePosition.resize(axles);
+    axleLoad.resize(axles);
+    axleSpan.resize(axles);
+
+    // The leading axle at grid point + offset puts that axle on the grid point. Grid points
+    // of different spans and axles with equal offsets give the same position more than once.
+    leadPositions.clear();
+    leadPositions.reserve(envelope.stationCount() * axles);
+    for (size_t a = 0; a < axles; ++a) {
+        size_t source = reversed ? axles - 1 - a : a;
+        double offset = reversed ? length - train.offsets[source] : train.offsets[source];
+        for (double station : envelope.stations) leadPositions.push_back(station + offset);
+    }
+    std::sort(leadPositions.begin(), leadPositions.end());
+    leadPositions.erase(std::unique(leadPositions.begin(), leadPositions.end(),
+        [](double a, double b) { return b - a < 1e-6; }), leadPositions.end());
+
+    for (double lead : leadPositions) {
+        std::fill(positionMoments.begin(), positionMoments.end(), 0.0);
+        bool anyOn = false;
+        for (size_t a = 0; a < axles; ++a) {
+            size_t source = reversed ? axles - 1 - a : a;
+            double offset = reversed ? length - train.offsets[source] : train.offsets[source];
+            double p = lead - offset;
+            axleLoad[a] = train.loads[source] * 1000.0; // kN -> N
+            axleSpan[a] = -1;
+            if (p < 0 || p > total) continue;
+            int j = (int)(std::upper_bound(spanStart.begin() + 1, spanStart.end() - 1, p) - spanStart.begin()) - 1;
+            double local = p - spanStart[j];
+            axleSpan[a] = j;
+            axlePosition[a] = local;
+            anyOn = true;
+
+            // Support moments from the table, linear between its grid points.
+            double g = local / spans[j] * intervalsPerSpan;
+            int k = std::min(intervalsPerSpan - 1, (int)g);
+            double t = g - k;
+            const double* M0 = &unitMoments[((size_t)j * points + k) * (n + 1)];
+            const double* M1 = M0 + (n + 1);
+            for (int i = 1; i < n; ++i) positionMoments[i] += axleLoad[a] * (M0[i] + t * (M1[i] - M0[i]));
+        }
+        if (!anyOn) continue;
+
+        for (size_t s = 0; s < envelope.stationCount(); ++s) {
+            int j = envelope.stationSpan[s];
+            double L = spans[j];
+            double x = envelope.stations[s] - spanStart[j];
+            double moment = positionMoments[j] * (1.0 - x / L) + positionMoments[j + 1] * (x / L);
+            double shear = (positionMoments[j + 1] - positionMoments[j]) / L;
+            // An axle on the station (to rounding) counts to the left for the most negative
+            // shear and to the right for the most positive one.
+            double shearRight = shear, shearLeft = shear;
+            for (size_t a = 0; a < axles; ++a) {
+                int axleOn = axleSpan[a];
+                double P = axleLoad[a], u = axlePosition[a];
+                // An axle on the right support is also at the end of this span, where it
+                // gives the most negative shear just left of the support.
+                if (axleOn == j + 1 && u < 1e-6) {
+                    axleOn = j;
+                    u = L;
+                }
+                if (axleOn != j) continue;
+                moment += u < x ? P * u * (L - x) / L : P * x * (L - u) / L;
+                shearRight += u < x - 1e-6 ? -P * u / L : P * (1.0 - u / L);
+                shearLeft += u <= x + 1e-6 ? -P * u / L : P * (1.0 - u / L);
+            }
+            if (moment > envelope.momentMax[s]) envelope.momentMax[s] = moment;
+            if (moment < envelope.momentMin[s]) envelope.momentMin[s] = moment;
+            if (shearRight > envelope.shearMax[s]) envelope.shearMax[s] = shearRight;
+            if (shearLeft < envelope.shearMin[s]) envelope.shearMin[s] = shearLeft;
+        }
+    }
+}
+
+inline bool parseSpanList(const std::string& text, std::vector<double>& spans) {
+    spans.clear();
+    const char* cursor = text.c_str();
+    while (*cursor) {
+        while (*cursor == ' ' || *cursor == '\t') ++cursor;
+        if (!*cursor) break;
+        char* end = nullptr;
+        double span = std::strtod(cursor, &end);
+        if (end == cursor || span <= 0) return false;
+        spans.push_back(span);
+        cursor = end;
+        while (*cursor == ' ' || *cursor == '\t') ++cursor;
+        if (*cursor == ',' || *cursor == ';') ++cursor;
+    }
+    return !spans.empty() && (int)spans.size() <= MAX_CONTINUOUS_SPANS;
+}
+
+
+#endif // CONTINUOUSBEAM_H
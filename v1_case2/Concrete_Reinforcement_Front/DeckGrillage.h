@@ -0,0 +1,386 @@
+#pragma once
+
+#ifndef DECKGRILLAGE_H
+#define DECKGRILLAGE_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+#include "ThreadPool.h"
+
+// --- Deck Layout ---
+// A simply supported deck of identical parallel girders tied together by the slab and by
+// cross-beams (all lengths in mm). The girders are centred on the deck at girderSpacing.
+struct DeckLayout
+{
+    double span = 0;
+    double deckWidth = 10000; // the deck width assumed by the single-girder costing
+    double girderSpacing = 0;
+    double girderWidth = 0;
+    double girderHeight = 0;
+    double slabThickness = 200;
+    int crossBeams = 5;                 // evenly spaced, end diaphragms included
+    double crossBeamWidth = 200;
+    double crossBeamDepthRatio = 0.75;  // of the girder height
+
+    int girderCount() const { return girderSpacing > 0 ? std::max(2, (int)(deckWidth / girderSpacing)) : 0; }
+    // Distance of girder g from the left deck edge.
+    double girderOffset(int g) const { return (deckWidth - (girderCount() - 1) * girderSpacing) / 2.0 + g * girderSpacing; }
+};
+
+// --- Banded Cholesky Factorization ---
+// Symmetric positive definite matrix stored as its lower band (row i holds columns
+// i - bandwidth .. i). Factorized once in place, then solved for any number of loads.
+class BandedCholesky
+{
+public:
+    void resize(int size, int halfBandwidth);
+    double& at(int row, int column) { return band[(size_t)row * (halfBandwidth + 1) + (row - column)]; } // column <= row
+    void add(int row, int column, double value) {
+        if (column > row) std::swap(row, column);
+        at(row, column) += value;
+    }
+    // Makes the unknown exactly zero (a restrained degree of freedom).
+    void restrain(int index);
+    bool factorize();
+    void solve(std::vector<double>& rhs) const;
+    int size() const { return n; }
+
+private:
+    int n = 0;
+    int halfBandwidth = 0;
+    std::vector<double> band;
+};
+
+// --- Grillage Model ---
+// Girders and transverse members (a slab strip at every station, plus the cross-beams) as
+// a plane grid of beam elements with three unknowns per node: deflection w and the slopes
+// dw/dx and dw/dy. A girder bends with dw/dx and twists with dw/dy, a transverse member
+// the other way round. Nodes are numbered station by station, so the half bandwidth is
+// only about three times the girder count. The girder ends are simply supported. Only
+// stiffness ratios matter, so E = 1 and G = 0.4 (Poisson's ratio 0.25).
+class GrillageModel
+{
+public:
+    bool build(const DeckLayout& layout, std::string& errorMessage);
+
+    // Adds a wheel load (N, downwards) at x along the span and y across the deck. It is
+    // shared between the four surrounding nodes; a wheel outside the edge girders is
+    // carried by the two outermost ones with the lever rule.
+    void addWheelLoad(std::vector<double>& loads, double x, double y, double force) const;
+    // Replaces the nodal loads with the nodal displacements.
+    void solve(std::vector<double>& loadsThenDisplacements) const;
+    // Bending moment and shear of girder g just right of station s (N*mm, N).
+    double girderMoment(const std::vector<double>& u, int g, int s) const;
+    double girderShear(const std::vector<double>& u, int g, int s) const;
+
+    int girderCount() const { return girders; }
+    int unknownCount() const { return matrix.size(); }
+    double stationSpacing() const { return dx; }
+    int stationNearest(double x) const { return std::min(SEGMENTS, std::max(0, (int)std::lround(x / dx))); }
+
+    static constexpr int SEGMENTS = 24; // girder elements per span
+
+private:
+    DeckLayout deck;
+    int girders = 0;
+    double dx = 0;
+    double girderInertia = 0;
+    BandedCholesky matrix;
+
+    int unknown(int s, int g, int k) const { return 3 * (s * girders + g) + k; }
+    // Beam element from unknown (w, slope) pairs a and b, with torsion between the twist unknowns.
+    void addElement(int wA, int slopeA, int twistA, int wB, int slopeB, int twistB, double length, double inertia, double torsion);
+};
+
+// Torsion constant of a solid rectangle (approximation of Roark), mm^4.
+double rectangularTorsionConstant(double width, double height);
+
+// --- Deck Design ---
+struct GirderResult
+{
+    double offset = 0;        // mm from the left deck edge
+    double momentFactor = 0;  // largest share of the vehicle's midspan moment
+    double shearFactor = 0;   // largest share of the vehicle's support shear
+    bool success = false;
+    RebarDesign design;       // costs are for this girder alone
+    BridgeParams params = {};
+};
+
+struct DeckDesign
+{
+    std::vector<GirderResult> girders;
+    double girderCost = 0;
+    double crossBeamCost = 0; // concrete of the cross-beams between the edge girders
+    double totalCost = 0;
+    int loadPositions = 0;    // lateral vehicle positions solved (for moment and for shear each)
+    bool success = false;
+    std::string errorMessage;
+};
+
+// Distance of the outer wheel from the deck edge, the wheel track of the vehicle and the
+// step of its lateral positions (mm).
+constexpr double DECK_WHEEL_EDGE_DISTANCE = 500.0;
+constexpr double DECK_VEHICLE_TRACK = 1800.0;
+constexpr double DECK_LATERAL_STEP = 100.0;
+
+// Designs the whole deck for one two-axle vehicle (kN, wheel span in m, as runDesign).
+// The vehicle is moved across the deck at the critical moment position and next to the
+// support. Each girder takes the largest share it receives at any lateral position, from
+// the grillage solved with one factorization for all positions. The girders are then
+// designed one by one on `pool` with RebarCalc::runGirderDesign. The deck succeeds only
+// if every girder does.
+bool runDeckDesign(const DeckLayout& layout, double totalVehicleLoad, double wheelSpan, DeckDesign& deck,
+    WorkStealingPool& pool, bool zonedStirrups = false);
+
+
+// --- Function Implementations ---
+
+inline void BandedCholesky::resize(int size, int bandwidth) {
+    n = size;
+    halfBandwidth = bandwidth;
+    band.assign((size_t)n * (halfBandwidth + 1), 0.0);
+}
+
+inline void BandedCholesky::restrain(int index) {
+    for (int j = std::max(0, index - halfBandwidth); j < index; ++j) at(index, j) = 0;
+    for (int i = index + 1; i <= std::min(n - 1, index + halfBandwidth); ++i) at(i, index) = 0;
+    at(index, index) = 1;
+}
+
+inline bool BandedCholesky::factorize() {
+    for (int i = 0; i < n; ++i) {
+        int first = std::max(0, i - halfBandwidth);
+        for (int j = first; j <= i; ++j) {
+            double sum = at(i, j);
+            for (int k = std::max(first, j - halfBandwidth); k < j; ++k) sum -= at(i, k) * at(j, k);
+            if (j == i) {
+                if (sum <= 0) return false;
+                at(i, i) = std::sqrt(sum);
+            }
+            else {
+                at(i, j) = sum / at(j, j);
+            }
+        }
+    }
+    return true;
+}
+
+inline void BandedCholesky::solve(std::vector<double>& rhs) const {
+    auto L = [this](int row, int column) { return band[(size_t)row * (halfBandwidth + 1) + (row - column)]; };
+    for (int i = 0; i < n; ++i) {
+        double sum = rhs[i];
+        for (int k = std::max(0, i - halfBandwidth); k < i; ++k) sum -= L(i, k) * rhs[k];
+        rhs[i] = sum / L(i, i);
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double sum = rhs[i];
+        for (int k = i + 1; k <= std::min(n - 1, i + halfBandwidth); ++k) sum -= L(k, i) * rhs[k];
+        rhs[i] = sum / L(i, i);
+    }
+}
+
+inline double rectangularTorsionConstant(double width, double height) {
+    double a = std::max(width, height), b = std::min(width, height);
+    return a * b * b * b * (1.0 / 3.0 - 0.21 * (b / a) * (1.0 - std::pow(b / a, 4) / 12.0));
+}
+
+inline void GrillageModel::addElement(int wA, int slopeA, int twistA, int wB, int slopeB, int twistB, double length, double inertia, double torsion) {
+    double L = length, EI = inertia, GJ = 0.4 * torsion;
+    const int dofs[4] = { wA, slopeA, wB, slopeB };
+    const double k[4][4] = {
+        { 12, 6 * L, -12, 6 * L },
+        { 6 * L, 4 * L * L, -6 * L, 2 * L * L },
+        { -12, -6 * L, 12, -6 * L },
+        { 6 * L, 2 * L * L, -6 * L, 4 * L * L } };
+    double scale = EI / (L * L * L);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j <= i; ++j) matrix.add(dofs[i], dofs[j], k[i][j] * scale);
+    }
+    matrix.add(twistA, twistA, GJ / L);
+    matrix.add(twistB, twistB, GJ / L);
+    matrix.add(twistB, twistA, -GJ / L);
+}
+
+inline bool GrillageModel::build(const DeckLayout& layout, std::string& errorMessage) {
+    deck = layout;
+    girders = layout.girderCount();
+    if (layout.span <= 0 || layout.girderWidth <= 0 || layout.girderHeight <= 0 || girders < 2 || layout.slabThickness <= 0) {
+        errorMessage = "Error: The deck needs a span, a girder section and a girder spacing greater than zero.";
+        return false;
+    }
+    if (layout.girderSpacing * (girders - 1) > layout.deckWidth) {
+        errorMessage = "Error: The girders do not fit on the deck width.";
+        return false;
+    }
+    dx = layout.span / SEGMENTS;
+    int stations = SEGMENTS + 1;
+    matrix.resize(3 * stations * girders, 3 * girders + 2);
+
+    girderInertia = layout.girderWidth * std::pow(layout.girderHeight, 3) / 12.0;
+    double girderTorsion = rectangularTorsionConstant(layout.girderWidth, layout.girderHeight);
+    for (int s = 0; s < SEGMENTS; ++s) {
+        for (int g = 0; g < girders; ++g) {
+            addElement(unknown(s, g, 0), unknown(s, g, 1), unknown(s, g, 2), unknown(s + 1, g, 0), unknown(s + 1, g, 1), unknown(s + 1, g, 2),
+                dx, girderInertia, girderTorsion);
+        }
+    }
+
+    // Transverse members: the slab strip of each station's tributary length, plus a
+    // cross-beam at the stations nearest to the evenly spaced cross-beam positions.
+    std::vector<bool> hasCrossBeam(stations, false);
+    int crossBeams = std::max(layout.crossBeams, 0);
+    for (int c = 0; c < crossBeams; ++c) {
+        double x = crossBeams == 1 ? layout.span / 2.0 : layout.span * c / (crossBeams - 1);
+        hasCrossBeam[stationNearest(x)] = true;
+    }
+    double t = layout.slabThickness;
+    double crossBeamDepth = layout.girderHeight * layout.crossBeamDepthRatio;
+    for (int s = 0; s < stations; ++s) {
+        double tributary = (s == 0 || s == SEGMENTS) ? dx / 2.0 : dx;
+        double inertia = tributary * t * t * t / 12.0;
+        double torsion = tributary * t * t * t / 6.0;
+        if (hasCrossBeam[s]) {
+            inertia += layout.crossBeamWidth * std::pow(crossBeamDepth, 3) / 12.0;
+            torsion += rectangularTorsionConstant(layout.crossBeamWidth, crossBeamDepth);
+        }
+        for (int g = 0; g + 1 < girders; ++g) {
+            addElement(unknown(s, g, 0), unknown(s, g, 2), unknown(s, g, 1), unknown(s, g + 1, 0), unknown(s, g + 1, 2), unknown(s, g + 1, 1),
+                layout.girderSpacing, inertia, torsion);
+        }
+    }
+
+    for (int g = 0; g < girders; ++g) {
+        matrix.restrain(unknown(0, g, 0));
+        matrix.restrain(unknown(SEGMENTS, g, 0));
+    }
+    if (!matrix.factorize()) {
+        errorMessage = "Error: The grillage stiffness matrix is singular.";
+        return false;
+    }
+    return true;
+}
+
+inline void GrillageModel::addWheelLoad(std::vector<double>& loads, double x, double y, double force) const {
+    if (x < 0 || x > deck.span) return;
+    double sx = x / dx;
+    int s0 = std::min(SEGMENTS - 1, (int)sx);
+    double fx = sx - s0;
+    double gy = (y - deck.girderOffset(0)) / deck.girderSpacing;
+    int g0 = std::min(girders - 2, std::max(0, (int)std::floor(gy)));
+    double fy = gy - g0; // outside 0..1 on the cantilevers: lever rule
+    loads[unknown(s0, g0, 0)] += force * (1 - fx) * (1 - fy);
+    loads[unknown(s0, g0 + 1, 0)] += force * (1 - fx) * fy;
+    loads[unknown(s0 + 1, g0, 0)] += force * fx * (1 - fy);
+    loads[unknown(s0 + 1, g0 + 1, 0)] += force * fx * fy;
+}
+
+inline void GrillageModel::solve(std::vector<double>& loadsThenDisplacements) const {
+    // Loads on the supports go straight into them.
+    for (int g = 0; g < girders; ++g) {
+        loadsThenDisplacements[unknown(0, g, 0)] = 0;
+        loadsThenDisplacements[unknown(SEGMENTS, g, 0)] = 0;
+    }
+    matrix.solve(loadsThenDisplacements);
+}
+
+// End forces of the girder element s..s+1 at its left end; the sign is that of a sagging
+// moment and of the shear next to the left support under downward loads.
+inline double GrillageModel::girderMoment(const std::vector<double>& u, int g, int s) const {
+    double L = dx;
+    double wa = u[unknown(s, g, 0)], ta = u[unknown(s, g, 1)], wb = u[unknown(s + 1, g, 0)], tb = u[unknown(s + 1, g, 1)];
+    return girderInertia / (L * L * L) * (6 * L * wa + 4 * L * L * ta - 6 * L * wb + 2 * L * L * tb);
+}
+
+inline double GrillageModel::girderShear(const std::vector<double>& u, int g, int s) const {
+    double L = dx;
+    double wa = u[unknown(s, g, 0)], ta = u[unknown(s, g, 1)], wb = u[unknown(s + 1, g, 0)], tb = u[unknown(s + 1, g, 1)];
+    return -girderInertia / (L * L * L) * (12 * wa + 6 * L * ta - 12 * wb + 6 * L * tb);
+}
+
+inline bool runDeckDesign(const DeckLayout& layout, double totalVehicleLoad, double wheelSpan, DeckDesign& deck,
+    WorkStealingPool& pool, bool zonedStirrups) {
+    deck = DeckDesign();
+    GrillageModel model;
+    if (!model.build(layout, deck.errorMessage)) return false;
+    if (totalVehicleLoad <= 0) {
+        deck.errorMessage = "Error: The vehicle load must be greater than zero.";
+        return false;
+    }
+
+    int girders = model.girderCount();
+    double L = layout.span;
+    double d = wheelSpan * 1000.0;
+    double wheel = 1000.0 / 4.0; // N per kN of vehicle load on each of the four wheels
+
+    // Longitudinal axle positions as in RebarCalc::calculateMaxForces: the pair straddling
+    // midspan for moment (read under the leading axle), and the leading axle at the first
+    // station off the support for shear (read at the support).
+    double xMoment = L / 2.0 - d / 4.0;
+    int momentStation = std::min(GrillageModel::SEGMENTS - 1, model.stationNearest(xMoment));
+    double xShear = model.stationSpacing();
+
+    std::vector<double> momentFactor(girders, 0.0), shearFactor(girders, 0.0);
+    std::vector<double> u(model.unknownCount());
+    double firstWheel = DECK_WHEEL_EDGE_DISTANCE;
+    double lastWheel = layout.deckWidth - DECK_WHEEL_EDGE_DISTANCE - DECK_VEHICLE_TRACK;
+    if (lastWheel < firstWheel) lastWheel = firstWheel;
+    for (double y = firstWheel; y <= lastWheel + 1e-6; y += DECK_LATERAL_STEP) {
+        for (int pass = 0; pass < 2; ++pass) {
+            bool momentPass = pass == 0;
+            double x = momentPass ? xMoment : xShear;
+            std::fill(u.begin(), u.end(), 0.0);
+            for (double axle : { x, x + d }) {
+                model.addWheelLoad(u, axle, y, wheel);
+                model.addWheelLoad(u, axle, y + DECK_VEHICLE_TRACK, wheel);
+            }
+            model.solve(u);
+
+            // Girder shares of the section force; the shares always add up to 1.
+            double total = 0;
+            std::vector<double> force(girders);
+            for (int g = 0; g < girders; ++g) {
+                force[g] = momentPass ? model.girderMoment(u, g, momentStation) : model.girderShear(u, g, 0);
+                total += force[g];
+            }
+            if (std::fabs(total) < 1e-9) continue;
+            std::vector<double>& factor = momentPass ? momentFactor : shearFactor;
+            for (int g = 0; g < girders; ++g) factor[g] = std::max(factor[g], force[g] / total);
+        }
+        ++deck.loadPositions;
+    }
+
+    deck.girders.resize(girders);
+    parallelFor(pool, 0, (size_t)girders, 1, [&](size_t begin, size_t end) {
+        RebarCalc calc;
+        calc.setStirrupZoning(zonedStirrups);
+        for (size_t g = begin; g < end; ++g) {
+            GirderResult& girder = deck.girders[g];
+            girder.offset = layout.girderOffset((int)g);
+            girder.momentFactor = momentFactor[g];
+            girder.shearFactor = shearFactor[g];
+            girder.success = calc.runGirderDesign(L, layout.girderWidth, layout.girderHeight, totalVehicleLoad * momentFactor[g],
+                totalVehicleLoad * shearFactor[g], wheelSpan);
+            girder.design = calc.getDesignResults();
+            girder.params = calc.getParams();
+        }
+    });
+
+    deck.success = true;
+    for (const GirderResult& girder : deck.girders) {
+        deck.girderCost += girder.design.totalCost;
+        if (!girder.success) deck.success = false;
+    }
+    int crossBeams = std::max(layout.crossBeams, 0);
+    double clearLength = (girders - 1) * (layout.girderSpacing - layout.girderWidth);
+    double crossBeamVolume = crossBeams * clearLength * layout.crossBeamWidth * layout.girderHeight * layout.crossBeamDepthRatio / 1e9;
+    deck.crossBeamCost = crossBeamVolume * COST_CONCRETE_PER_M3;
+    deck.totalCost = deck.girderCost + deck.crossBeamCost;
+    if (!deck.success) deck.errorMessage = "Error: At least one girder could not be designed.\nIncrease the girder section.";
+    return deck.success;
+}
+
+
+#endif // DECKGRILLAGE_H
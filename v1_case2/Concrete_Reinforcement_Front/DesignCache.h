@@ -0,0 +1,227 @@
+#pragma once
+
+#ifndef DESIGNCACHE_H
+#define DESIGNCACHE_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "RebarCalc.h"
+
+// --- Cache Key ---
+// runDesign inputs quantized to integers, so that values typed slightly differently
+// (e.g. "20000" and "20000.0004") share one entry. Lengths are kept to 1 mm, the
+// wheel span (entered in m) to 1 mm and the vehicle load to 0.01 kN.
+struct DesignCacheKey
+{
+    int64_t span;
+    int64_t width;
+    int64_t height;
+    int64_t load;
+    int64_t wheelSpan;
+    int64_t girderSpacing;
+    int64_t grade; // MaterialGrade::code()
+
+    bool operator==(const DesignCacheKey& other) const {
+        return span == other.span && width == other.width && height == other.height && load == other.load
+            && wheelSpan == other.wheelSpan && girderSpacing == other.girderSpacing && grade == other.grade;
+    }
+
+    static DesignCacheKey fromInputs(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        MaterialGrade grade = MaterialGrade()) {
+        return { std::llround(span), std::llround(width), std::llround(height), std::llround(totalVehicleLoad * 100.0),
+            std::llround(wheelSpan * 1000.0), std::llround(girderSpacing), grade.code() };
+    }
+};
+
+struct DesignCacheKeyHash
+{
+    size_t operator()(const DesignCacheKey& key) const {
+        uint64_t h = 1469598103934665603ull;
+        const int64_t fields[7] = { key.span, key.width, key.height, key.load, key.wheelSpan, key.girderSpacing, key.grade };
+        for (int64_t f : fields) {
+            h ^= (uint64_t)f + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        }
+        return (size_t)h;
+    }
+};
+
+// --- Cached Value ---
+// The finished design together with the parameters it was drawn for (including h0). The
+// message is kept as its code, so an entry is a plain record and copies without allocating.
+struct CachedDesign
+{
+    bool success = false;
+    DesignErrorCode error = DesignErrorCode::None;
+    RebarDesignCore design;
+    BridgeParams params = {};
+};
+
+// --- Bounded Thread-Safe LRU Design Cache ---
+// Entries are spread over independent shards, each with its own mutex and LRU list,
+// so batch worker threads rarely contend on the same lock. Lookups never allocate, and
+// once a shard is full an insert reuses the nodes of the entry it evicts.
+class DesignCache
+{
+public:
+    explicit DesignCache(size_t capacity = 4096);
+
+    bool lookup(const DesignCacheKey& key, CachedDesign& value);
+    void insert(const DesignCacheKey& key, const CachedDesign& value);
+    void clear();
+
+    // Cached front for RebarCalc::runDesign. On a hit the stored design is restored into
+    // `calc`, so getDesignResults() and the image generators behave exactly as after a run.
+    // `servedFromCache`, when given, reports whether this particular call was a hit.
+    // Designs of different material grades are kept apart.
+    template <typename Concrete, typename Steel>
+    bool runDesign(RebarCalcT<Concrete, Steel>& calc, double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        bool* servedFromCache = nullptr);
+    // Cached front for RebarCalc::designKernel: a miss is designed by the kernel in
+    // `scratch`, and a hit only fills `result`, leaving `calc` as it was.
+    template <typename Concrete, typename Steel>
+    bool designKernel(RebarCalcT<Concrete, Steel>& calc, double span, double width, double height, double totalVehicleLoad, double wheelSpan,
+        double girderSpacing, DesignScratch& scratch, DesignKernelResult& result, bool* servedFromCache = nullptr);
+
+    uint64_t hits() const { return hitCount.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return missCount.load(std::memory_order_relaxed); }
+    size_t size() const;
+    size_t capacity() const { return shardCapacity * SHARD_COUNT; }
+
+    static constexpr size_t SHARD_COUNT = 16;
+
+private:
+    typedef std::list<std::pair<DesignCacheKey, CachedDesign>> EntryList;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        EntryList entries; // most recently used at the front
+        std::unordered_map<DesignCacheKey, EntryList::iterator, DesignCacheKeyHash> index;
+    };
+
+    Shard shards[SHARD_COUNT];
+    size_t shardCapacity;
+    std::atomic<uint64_t> hitCount{ 0 };
+    std::atomic<uint64_t> missCount{ 0 };
+
+    Shard& shardFor(const DesignCacheKey& key) { return shards[DesignCacheKeyHash()(key) % SHARD_COUNT]; }
+};
+
+
+// --- Function Implementations ---
+
+inline DesignCache::DesignCache(size_t capacity) {
+    shardCapacity = (capacity + SHARD_COUNT - 1) / SHARD_COUNT;
+    if (shardCapacity == 0) shardCapacity = 1;
+    for (Shard& shard : shards) shard.index.reserve(shardCapacity);
+}
+
+inline bool DesignCache::lookup(const DesignCacheKey& key, CachedDesign& value) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        missCount.fetch_add(1, std::memory_order_relaxed);
+        REBAR_COUNT(CacheMisses);
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    value = found->second->second;
+    hitCount.fetch_add(1, std::memory_order_relaxed);
+    REBAR_COUNT(CacheHits);
+    return true;
+}
+
+inline void DesignCache::insert(const DesignCacheKey& key, const CachedDesign& value) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        found->second->second = value;
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        return;
+    }
+    if (shard.entries.size() >= shardCapacity) {
+        // Evict the least recently used entry and reuse its list and index nodes.
+        auto last = std::prev(shard.entries.end());
+        auto node = shard.index.extract(last->first);
+        last->first = key;
+        last->second = value;
+        shard.entries.splice(shard.entries.begin(), shard.entries, last);
+        node.key() = key;
+        node.mapped() = shard.entries.begin();
+        shard.index.insert(std::move(node));
+        return;
+    }
+    shard.entries.emplace_front(key, value);
+    shard.index[key] = shard.entries.begin();
+}
+
+inline void DesignCache::clear() {
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.index.clear();
+    }
+    hitCount = 0;
+    missCount = 0;
+}
+
+inline size_t DesignCache::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+template <typename Concrete, typename Steel>
+inline bool DesignCache::runDesign(RebarCalcT<Concrete, Steel>& calc, double span, double width, double height, double totalVehicleLoad,
+    double wheelSpan, double girderSpacing, bool* servedFromCache) {
+    DesignCacheKey key = DesignCacheKey::fromInputs(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing, calc.materialGrade());
+    CachedDesign cached;
+    bool hit = lookup(key, cached);
+    if (servedFromCache) *servedFromCache = hit;
+    if (hit) {
+        calc.restoreDesign(cached.params, cached.design, cached.error);
+        return cached.success;
+    }
+
+    cached.success = calc.runDesign(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing);
+    cached.design = calc.getDesignResults();
+    cached.error = designErrorCode(calc.getDesignResults().errorMessage);
+    cached.params = calc.getParams();
+    insert(key, cached);
+    return cached.success;
+}
+
+template <typename Concrete, typename Steel>
+inline bool DesignCache::designKernel(RebarCalcT<Concrete, Steel>& calc, double span, double width, double height, double totalVehicleLoad,
+    double wheelSpan, double girderSpacing, DesignScratch& scratch, DesignKernelResult& result, bool* servedFromCache) {
+    DesignCacheKey key = DesignCacheKey::fromInputs(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing, calc.materialGrade());
+    CachedDesign cached;
+    bool hit = lookup(key, cached);
+    if (servedFromCache) *servedFromCache = hit;
+    if (hit) {
+        result.error = cached.error;
+        result.params = cached.params;
+        result.design = cached.design;
+        return cached.success;
+    }
+
+    cached.success = calc.designKernel(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing, scratch, result);
+    cached.error = result.error;
+    cached.design = result.design;
+    cached.params = result.params;
+    insert(key, cached);
+    return cached.success;
+}
+
+
+#endif // DESIGNCACHE_H
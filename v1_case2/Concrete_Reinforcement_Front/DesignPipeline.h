@@ -0,0 +1,355 @@
+#pragma once
+
+#ifndef DESIGNPIPELINE_H
+#define DESIGNPIPELINE_H
+
+#include <algorithm>
+#include <limits>
+#include <opencv2/opencv.hpp>
+#include "RebarCalc.h"
+
+// --- Design Inputs ---
+// The runDesign inputs in the same units (lengths in mm, vehicle load in kN, wheel span
+// in m), plus stirrup zoning, mixed bar diameters and the unit prices.
+struct DesignInputs
+{
+    double span = 0;
+    double width = 0;
+    double height = 0;
+    double vehicleLoad = 0;
+    double wheelSpan = 0;
+    double girderSpacing = 0;
+    bool zonedStirrups = false;
+    bool mixedDiameters = false;
+    CostRates rates;
+};
+
+// --- Pipeline Stages ---
+// In dependency order: every stage depends only on inputs and on stages listed before it.
+//   LoadDistribution  vehicle load, girder spacing
+//   Forces            load distribution, span, width, height, wheel span, zoning
+//   SectionGeometry   width, height (bar rows, one-row h0, minimum steel per diameter)
+//   Flexure           forces, section geometry (bars per diameter; mixed layouts also
+//                     read the span and unit prices, which price the bar rows)
+//   Shear             flexure, span, width, zoning (stirrups and bent bars per candidate)
+//   Cost              shear, span, width, height, girder spacing, unit prices (picks the cheapest)
+//   Rendering         cost, and only when the chosen layout is drawn differently
+enum class PipelineStage { LoadDistribution, Forces, SectionGeometry, Flexure, Shear, Cost, Rendering };
+constexpr int PIPELINE_STAGE_COUNT = 7;
+
+const char* pipelineStageName(PipelineStage stage);
+
+// --- Incremental Design Pipeline ---
+// runDesign split into cached stages. New inputs invalidate only the stages that depend
+// on the inputs that changed, and run() recomputes just those, with the same results as
+// a fresh runDesign: editing the unit prices re-runs only the costing, and editing the
+// girder spacing keeps the section geometry. The views are drawn on request, and again
+// only when the drawn layout has changed.
+template <typename Concrete, typename Steel>
+class DesignPipelineT
+{
+public:
+    typedef RebarCalcT<Concrete, Steel> Calc;
+
+    // Records the inputs and invalidates the stages that depend on the ones that changed.
+    void setInputs(const DesignInputs& newInputs);
+    // Forces the stage and everything downstream of it to be recomputed.
+    void invalidate(PipelineStage stage);
+    // Brings every design stage up to date; returns what runDesign would.
+    bool run();
+    bool run(const DesignInputs& newInputs) { setInputs(newInputs); return run(); }
+
+    // The engine holding the current design, as after runDesign.
+    const Calc& calculator() const { return calc; }
+    const RebarDesign& getDesignResults() const { return calc.getDesignResults(); }
+    const BridgeParams& getParams() const { return calc.getParams(); }
+    const DesignInputs& getInputs() const { return inputs; }
+
+    // Views of the current design (CV_8UC4, BGRA as drawCrossSection). A redrawn view gets
+    // a new buffer, so a view handed out earlier stays valid and unchanged.
+    const cv::Mat& crossSection() { return view(true); }
+    const cv::Mat& longitudinal() { return view(false); }
+
+    // Number of times each stage has been computed (Rendering counts each view drawn).
+    long long stageRuns(PipelineStage stage) const { return runs[(int)stage]; }
+
+private:
+    static constexpr unsigned stageBit(PipelineStage stage) { return 1u << (int)stage; }
+    // Stages brought up to date by run(); the views are tracked by viewCurrent instead.
+    static constexpr unsigned DESIGN_STAGES = stageBit(PipelineStage::Rendering) - 1;
+    static unsigned downstreamOf(unsigned stages);
+    static bool drawnAlike(const RebarDesign& a, const BridgeParams& pa, const RebarDesign& b, const BridgeParams& pb);
+
+    BridgeParams sectionParams() const;
+    void computeLoadDistribution();
+    void computeForces();
+    void computeSectionGeometry();
+    void computeFlexure();
+    void computeShear();
+    void computeCost();
+    const cv::Mat& view(bool crossSection);
+
+    // One candidate per standard diameter, then the mixed layouts, as tried in turn by
+    // findOptimalDesign.
+    static constexpr int CANDIDATE_COUNT = STANDARD_REBAR_COUNT + MIXED_FLEXURE_CANDIDATES;
+    struct Candidate
+    {
+        bool feasible = false;
+        RebarDesign design;
+        double h0 = 0;
+    };
+
+    Calc calc;
+    DesignInputs inputs;
+    bool hasInputs = false;
+    unsigned dirty = DESIGN_STAGES;
+    long long runs[PIPELINE_STAGE_COUNT] = {};
+
+    double momentLoad = 0, shearLoad = 0; // kN on one girder
+    RebarDesign forces;                   // maxMoment and maxShear only
+    FlexureGeometry geometry[STANDARD_REBAR_COUNT];
+    Candidate flexure[CANDIDATE_COUNT];
+    Candidate shear[CANDIDATE_COUNT];
+    DesignScratch scratch; // mixed-diameter row tables of computeFlexure
+    bool success = false;
+    RebarDesign chosen;  // the result of the last costing, as drawn by the views
+    BridgeParams chosenParams = {};
+    cv::Mat views[2];    // cross-section, longitudinal
+    bool viewCurrent[2] = {};
+};
+
+typedef DesignPipelineT<C50, HRB400> DesignPipeline;
+
+
+// --- Function Implementations ---
+
+inline const char* pipelineStageName(PipelineStage stage) {
+    static const char* names[PIPELINE_STAGE_COUNT] = { "load distribution", "forces", "section geometry", "flexure", "shear", "cost", "rendering" };
+    return names[(int)stage];
+}
+
+template <typename Concrete, typename Steel>
+inline unsigned DesignPipelineT<Concrete, Steel>::downstreamOf(unsigned stages) {
+    // Stages each stage reads, in the order of PipelineStage.
+    static const unsigned upstream[PIPELINE_STAGE_COUNT] = {
+        0,
+        stageBit(PipelineStage::LoadDistribution),
+        0,
+        stageBit(PipelineStage::Forces) | stageBit(PipelineStage::SectionGeometry),
+        stageBit(PipelineStage::Flexure) | stageBit(PipelineStage::Forces),
+        stageBit(PipelineStage::Shear),
+        0, // Rendering is invalidated by computeCost, and only when the layout changes
+    };
+    for (int s = 0; s < PIPELINE_STAGE_COUNT; ++s) {
+        if (stages & upstream[s]) stages |= 1u << s;
+    }
+    return stages;
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::invalidate(PipelineStage stage) {
+    if (stage == PipelineStage::Rendering) viewCurrent[0] = viewCurrent[1] = false;
+    else dirty |= downstreamOf(stageBit(stage));
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::setInputs(const DesignInputs& newInputs) {
+    unsigned changed = 0;
+    if (!hasInputs) changed = DESIGN_STAGES;
+    else {
+        if (newInputs.vehicleLoad != inputs.vehicleLoad) changed |= stageBit(PipelineStage::LoadDistribution);
+        if (newInputs.girderSpacing != inputs.girderSpacing) changed |= stageBit(PipelineStage::LoadDistribution) | stageBit(PipelineStage::Cost);
+        if (newInputs.span != inputs.span) changed |= stageBit(PipelineStage::Forces) | stageBit(PipelineStage::Shear) | stageBit(PipelineStage::Cost);
+        if (newInputs.width != inputs.width) {
+            changed |= stageBit(PipelineStage::Forces) | stageBit(PipelineStage::SectionGeometry) | stageBit(PipelineStage::Shear) | stageBit(PipelineStage::Cost);
+        }
+        if (newInputs.height != inputs.height) changed |= stageBit(PipelineStage::Forces) | stageBit(PipelineStage::SectionGeometry) | stageBit(PipelineStage::Cost);
+        if (newInputs.wheelSpan != inputs.wheelSpan) changed |= stageBit(PipelineStage::Forces);
+        if (newInputs.zonedStirrups != inputs.zonedStirrups) changed |= stageBit(PipelineStage::Forces) | stageBit(PipelineStage::Shear);
+        if (newInputs.rates != inputs.rates) changed |= stageBit(PipelineStage::Cost);
+        if (newInputs.mixedDiameters != inputs.mixedDiameters ||
+            (newInputs.mixedDiameters && (newInputs.span != inputs.span || newInputs.rates != inputs.rates))) {
+            changed |= stageBit(PipelineStage::Flexure);
+        }
+    }
+    inputs = newInputs;
+    hasInputs = true;
+    dirty |= downstreamOf(changed);
+}
+
+template <typename Concrete, typename Steel>
+inline bool DesignPipelineT<Concrete, Steel>::run() {
+    REBAR_TIME_SCOPE(Design);
+    if (dirty & stageBit(PipelineStage::LoadDistribution)) computeLoadDistribution();
+    if (dirty & stageBit(PipelineStage::Forces)) computeForces();
+    if (dirty & stageBit(PipelineStage::SectionGeometry)) computeSectionGeometry();
+    if (dirty & stageBit(PipelineStage::Flexure)) computeFlexure();
+    if (dirty & stageBit(PipelineStage::Shear)) computeShear();
+    if (dirty & stageBit(PipelineStage::Cost)) computeCost();
+    return success;
+}
+
+// The section as runDesign sets it up, before findOptimalDesign fills in h0.
+template <typename Concrete, typename Steel>
+inline BridgeParams DesignPipelineT<Concrete, Steel>::sectionParams() const {
+    BridgeParams section = {};
+    section.span = inputs.span;
+    section.width = inputs.width;
+    section.height = inputs.height;
+    section.wheelSpan = inputs.wheelSpan * 1000.0;
+    section.girderSpacing = inputs.girderSpacing;
+    return section;
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeLoadDistribution() {
+    calc.distributeVehicleLoad(inputs.vehicleLoad, inputs.girderSpacing, momentLoad, shearLoad);
+    ++runs[(int)PipelineStage::LoadDistribution];
+    dirty &= ~stageBit(PipelineStage::LoadDistribution);
+}
+
+// Also leaves the shear profile of the zoned stirrups in calc for computeShear.
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeForces() {
+    calc.resetDesign();
+    calc.params = sectionParams();
+    calc.setStirrupZoning(inputs.zonedStirrups);
+    calc.calculateMaxForces(momentLoad * 1000.0, shearLoad * 1000.0);
+    forces = RebarDesign();
+    forces.maxMoment = calc.design.maxMoment;
+    forces.maxShear = calc.design.maxShear;
+    ++runs[(int)PipelineStage::Forces];
+    dirty &= ~stageBit(PipelineStage::Forces);
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeSectionGeometry() {
+    BridgeParams section = sectionParams();
+    for (int i = 0; i < STANDARD_REBAR_COUNT; ++i) geometry[i] = calc.flexureGeometry(STANDARD_REBAR_DIAMETERS[i], section);
+    ++runs[(int)PipelineStage::SectionGeometry];
+    dirty &= ~stageBit(PipelineStage::SectionGeometry);
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeFlexure() {
+    REBAR_TIME_SCOPE(DiameterLoop);
+    for (int i = 0; i < STANDARD_REBAR_COUNT; ++i) {
+        Candidate& candidate = flexure[i];
+        candidate.design = forces;
+        BridgeParams tempParams = sectionParams();
+        candidate.feasible = calc.designFlexure(geometry[i], candidate.design, tempParams);
+        candidate.h0 = tempParams.h0;
+    }
+    if (inputs.mixedDiameters) {
+        calc.setCostRates(inputs.rates);
+        calc.buildBarRowTable(sectionParams(), scratch);
+    }
+    for (int i = 0; i < MIXED_FLEXURE_CANDIDATES; ++i) {
+        Candidate& candidate = flexure[STANDARD_REBAR_COUNT + i];
+        candidate.feasible = false;
+        if (!inputs.mixedDiameters) continue;
+        candidate.design = forces;
+        BridgeParams tempParams = sectionParams();
+        candidate.feasible = calc.designMixedFlexure(scratch.barRows, i / 2, 1 + i % 2, candidate.design, tempParams);
+        candidate.h0 = tempParams.h0;
+    }
+    ++runs[(int)PipelineStage::Flexure];
+    dirty &= ~stageBit(PipelineStage::Flexure);
+}
+
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeShear() {
+    for (int i = 0; i < CANDIDATE_COUNT; ++i) {
+        shear[i] = flexure[i];
+        if (!shear[i].feasible) continue;
+        BridgeParams tempParams = sectionParams();
+        tempParams.h0 = shear[i].h0;
+        calc.designShearForIteration(shear[i].design, tempParams);
+        if (inputs.zonedStirrups) calc.designStirrupZones(shear[i].design, tempParams);
+    }
+    ++runs[(int)PipelineStage::Shear];
+    dirty &= ~stageBit(PipelineStage::Shear);
+}
+
+// Costs every candidate and keeps the cheapest, as findOptimalDesign does.
+template <typename Concrete, typename Steel>
+inline void DesignPipelineT<Concrete, Steel>::computeCost() {
+    calc.setCostRates(inputs.rates);
+    calc.params = sectionParams();
+    double bestCost = std::numeric_limits<double>::max();
+    int best = -1;
+    RebarDesign costed[CANDIDATE_COUNT];
+    for (int i = 0; i < CANDIDATE_COUNT; ++i) {
+        if (!shear[i].feasible) continue;
+        costed[i] = shear[i].design;
+        BridgeParams tempParams = sectionParams();
+        tempParams.h0 = shear[i].h0;
+        calc.calculateTotalCostForIteration(costed[i], tempParams);
+        if (costed[i].totalCost < bestCost) {
+            bestCost = costed[i].totalCost;
+            best = i;
+        }
+    }
+
+    success = best >= 0;
+    if (success) {
+        calc.design = costed[best];
+        calc.params.h0 = shear[best].h0;
+    }
+    else {
+        calc.design = forces;
+        calc.design.designPossible = false;
+        calc.design.errorMessage = "Error: No valid reinforcement combination found.\nIncrease beam dimensions.";
+    }
+    ++runs[(int)PipelineStage::Cost];
+    dirty &= ~stageBit(PipelineStage::Cost);
+
+    if (!drawnAlike(chosen, chosenParams, calc.design, calc.params)) {
+        viewCurrent[0] = viewCurrent[1] = false;
+    }
+    chosen = calc.design;
+    chosenParams = calc.params;
+}
+
+// True when both designs give the same drawings: the drawings show the section and the
+// bars, but no forces or costs.
+template <typename Concrete, typename Steel>
+inline bool DesignPipelineT<Concrete, Steel>::drawnAlike(const RebarDesign& a, const BridgeParams& pa, const RebarDesign& b, const BridgeParams& pb) {
+    if (pa.span != pb.span || pa.width != pb.width || pa.height != pb.height || pa.h0 != pb.h0 || pa.spanCount != pb.spanCount) return false;
+    if (a.designPossible != b.designPossible || a.errorMessage != b.errorMessage) return false;
+    if (a.rebarRows != b.rebarRows || a.rebarCountRow1 != b.rebarCountRow1 || a.rebarCountRow2 != b.rebarCountRow2 ||
+        a.flexureRebarDiameter != b.flexureRebarDiameter || a.mixedDiameters != b.mixedDiameters) return false;
+    for (int row = 0; a.mixedDiameters && row < 2; ++row) {
+        for (int j = 0; j < 2; ++j) {
+            if (a.rowDiameters[row][j] != b.rowDiameters[row][j] || a.rowBarCounts[row][j] != b.rowBarCounts[row][j]) return false;
+        }
+    }
+    if (a.stirrupLegs != b.stirrupLegs || a.stirrupDiameter != b.stirrupDiameter || a.stirrupSpacing != b.stirrupSpacing ||
+        a.stirrupZoneCount != b.stirrupZoneCount) return false;
+    for (int z = 0; z < a.stirrupZoneCount; ++z) {
+        const StirrupZone& za = a.stirrupZones[z];
+        const StirrupZone& zb = b.stirrupZones[z];
+        if (za.start != zb.start || za.end != zb.end || za.spacing != zb.spacing) return false;
+    }
+    return a.bentRebarsUsed == b.bentRebarsUsed && a.bentRebarCount == b.bentRebarCount &&
+        a.topRebarDiameter == b.topRebarDiameter && a.topRebarCount == b.topRebarCount && a.topRebarRows == b.topRebarRows;
+}
+
+template <typename Concrete, typename Steel>
+inline const cv::Mat& DesignPipelineT<Concrete, Steel>::view(bool crossSection) {
+    run();
+    int v = crossSection ? 0 : 1;
+    if (!viewCurrent[v]) {
+        const cv::Size& size = crossSection ? CROSS_SECTION_IMAGE_SIZE : LONGITUDINAL_IMAGE_SIZE;
+        cv::Mat image(size.height, size.width, CV_8UC4);
+        if (crossSection) calc.drawCrossSection(image);
+        else calc.drawLongitudinalSection(image);
+        views[v] = image;
+        viewCurrent[v] = true;
+        ++runs[(int)PipelineStage::Rendering];
+    }
+    return views[v];
+}
+
+
+#endif // DESIGNPIPELINE_H
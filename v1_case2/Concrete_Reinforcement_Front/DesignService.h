@@ -0,0 +1,632 @@
+#pragma once
+
+#ifndef DESIGNSERVICE_H
+#define DESIGNSERVICE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BatchRunner.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+typedef SOCKET ServiceSocket;
+#define SERVICE_INVALID_SOCKET INVALID_SOCKET
+#define closeServiceSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int ServiceSocket;
+#define SERVICE_INVALID_SOCKET (-1)
+#define closeServiceSocket ::close
+#endif
+// Sending to a client that has gone away must fail with an error, not raise SIGPIPE and
+// end the service. Linux takes a flag per send; macOS sets SO_NOSIGPIPE on the socket.
+#if defined(MSG_NOSIGNAL)
+#define SERVICE_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SERVICE_SEND_FLAGS 0
+#endif
+#if defined(_WIN32)
+#define SERVICE_SHUTDOWN_BOTH SD_BOTH
+#define SERVICE_SHUTDOWN_READ SD_RECEIVE
+#else
+#define SERVICE_SHUTDOWN_BOTH SHUT_RDWR
+#define SERVICE_SHUTDOWN_READ SHUT_RD
+#endif
+
+// --- Service Client ---
+// One request stream: stdin/stdout, or one local socket connection. Responses to a
+// client leave in the order its requests arrived.
+class ServiceConnection
+{
+public:
+    virtual ~ServiceConnection() = default;
+    // Called from the dispatcher thread only, with one or more complete response lines.
+    // Must not wait on the client, or one slow reader would hold up every other client.
+    virtual void write(const char* data, size_t length) = 0;
+
+private:
+    friend class DesignService;
+    std::string outgoing; // responses collected during one batch
+};
+
+// --- Latency Histogram ---
+// 1 us buckets up to 100 ms; slower requests share the last bucket.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : buckets(BUCKETS, 0) {}
+
+    void add(double microseconds);
+    // Latency below which the fraction q of the requests fall (us).
+    double quantile(double q) const;
+    uint64_t count() const { return total; }
+    double mean() const { return total ? sum / total : 0.0; }
+    double maximum() const { return largest; }
+
+    static constexpr size_t BUCKETS = 100000;
+
+private:
+    std::vector<uint64_t> buckets;
+    uint64_t total = 0;
+    double sum = 0;
+    double largest = 0;
+};
+
+// --- Design Service ---
+// Long-running front end for other programs. Requests are JSON lines with the fields of
+// a batch row plus an optional "id" that is echoed back, e.g.
+//   {"id":7,"span":20000,"width":400,"height":1200,"load":550,"wheelSpan":1.8,"girderSpacing":2000}
+// Any number of clients submit concurrently. A single dispatcher thread takes every
+// request that is waiting, up to maxBatch, designs them as one block on the work-stealing
+// pool and answers each client. A request that arrives while a block is being designed
+// joins the next block, so single requests are designed at once and heavy traffic forms
+// large blocks that keep every core busy without any added waiting.
+// {"command":"stats"} answers with the service counters and latency percentiles.
+class DesignService
+{
+public:
+    explicit DesignService(WorkStealingPool& pool);
+    ~DesignService() { stop(); }
+
+    DesignService(const DesignService&) = delete;
+    DesignService& operator=(const DesignService&) = delete;
+
+    // Settings shared with batch mode; call before start().
+    void setCache(DesignCache* designCache) { runner.setCache(designCache); }
+    void setStirrupZoning(bool enabled) { zonedStirrups = enabled; runner.setStirrupZoning(enabled); }
+    void setMaterialGrade(MaterialGrade grade) { defaultGrade = grade; }
+    void setMaxBatch(size_t requests) { maxBatch = std::max<size_t>(1, requests); }
+
+    void start();
+    // Answers every request already submitted, then stops the dispatcher.
+    void stop();
+    // Thread-safe. `line` is one request; blank lines are ignored.
+    void submit(const std::shared_ptr<ServiceConnection>& client, const std::string& line);
+
+    // Summary of the counters, as written to stderr when the service ends.
+    void writeSummary(std::ostream& out);
+
+    static constexpr size_t DEFAULT_MAX_BATCH = 4096;
+
+private:
+    enum class RequestKind
+    {
+        Design,
+        Stats,
+        Invalid
+    };
+
+    struct Request
+    {
+        std::shared_ptr<ServiceConnection> client;
+        RequestKind kind = RequestKind::Design;
+        std::string id; // JSON token as received, quotes included
+        BeamInput input;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    WorkStealingPool& pool;
+    BatchRunner runner;
+    MaterialGrade defaultGrade;
+    bool zonedStirrups = false;
+    size_t maxBatch = DEFAULT_MAX_BATCH;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<Request> queue;
+    bool stopping = false;
+    std::thread dispatcher;
+
+    // Owned by the dispatcher thread; guarded by statsMutex only for writeSummary.
+    std::mutex statsMutex;
+    LatencyHistogram latency;
+    uint64_t batchCount = 0;
+    uint64_t designCount = 0;
+    uint64_t failedCount = 0;
+    uint64_t invalidCount = 0;
+    size_t largestBatch = 0;
+    double designSeconds = 0;
+    Clock::time_point startTime;
+
+    void dispatchLoop();
+    void answerBatch(std::vector<Request>& batch);
+    int formatStats(char* buffer, size_t size);
+};
+
+bool parseJsonIdToken(const std::string& line, std::string& token);
+int runServiceCommandLine(int argc, char* argv[]);
+
+
+// --- Function Implementations ---
+
+inline void LatencyHistogram::add(double microseconds) {
+    size_t bucket = microseconds <= 0 ? 0 : std::min((size_t)microseconds, BUCKETS - 1);
+    ++buckets[bucket];
+    ++total;
+    sum += microseconds;
+    largest = std::max(largest, microseconds);
+}
+
+inline double LatencyHistogram::quantile(double q) const {
+    if (total == 0) return 0.0;
+    uint64_t rank = (uint64_t)std::ceil(q * total);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min((double)(b + 1), largest);
+    }
+    return largest;
+}
+
+// Raw value of the "id" member: a quoted string (quotes kept) or a bare token.
+inline bool parseJsonIdToken(const std::string& line, std::string& token) {
+    size_t pos = line.find("\"id\"");
+    if (pos == std::string::npos) return false;
+    pos = line.find(':', pos + 4);
+    if (pos == std::string::npos) return false;
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos) return false;
+    size_t end;
+    if (line[pos] == '"') {
+        end = pos + 1;
+        while (end < line.size() && line[end] != '"') end += (line[end] == '\\') ? 2 : 1;
+        end = std::min(end + 1, line.size());
+    }
+    else {
+        end = line.find_first_of(",} \t", pos);
+        if (end == std::string::npos) end = line.size();
+    }
+    token = line.substr(pos, end - pos);
+    if (token.size() > 128) token.clear(); // too long to echo
+    return !token.empty();
+}
+
+inline DesignService::DesignService(WorkStealingPool& pool) : pool(pool), runner(pool) {
+}
+
+inline void DesignService::start() {
+    if (dispatcher.joinable()) return;
+    stopping = false;
+    startTime = Clock::now();
+    dispatcher = std::thread(&DesignService::dispatchLoop, this);
+}
+
+inline void DesignService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_one();
+    if (dispatcher.joinable()) dispatcher.join();
+}
+
+inline void DesignService::submit(const std::shared_ptr<ServiceConnection>& client, const std::string& line) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) return;
+    Request request;
+    request.received = Clock::now();
+    request.client = client;
+    parseJsonIdToken(line, request.id);
+    std::string command;
+    if (parseJsonTextField(line, "command", command)) {
+        request.kind = command == "stats" ? RequestKind::Stats : RequestKind::Invalid;
+    }
+    else {
+        request.input.grade = defaultGrade;
+        if (!parseBeamJsonLine(line, request.input) || !isValidBeamInput(request.input)) request.kind = RequestKind::Invalid;
+    }
+    // Parsing happens on the client's thread; the dispatcher only designs and answers.
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        wake = queue.empty();
+        queue.push_back(std::move(request));
+    }
+    if (wake) queueCondition.notify_one();
+}
+
+inline void DesignService::dispatchLoop() {
+    std::vector<Request> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            size_t take = std::min(queue.size(), maxBatch);
+            batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + take));
+            queue.erase(queue.begin(), queue.begin() + take);
+        }
+        answerBatch(batch);
+        batch.clear();
+    }
+}
+
+inline void DesignService::answerBatch(std::vector<Request>& batch) {
+    std::vector<BeamInput> inputs;
+    std::vector<size_t> designRows;
+    inputs.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].kind != RequestKind::Design) continue;
+        inputs.push_back(batch[i].input);
+        designRows.push_back(i);
+    }
+
+    Clock::time_point designStart = Clock::now();
+    std::vector<BeamResult> results;
+    if (!inputs.empty()) {
+        // About two tasks per worker, so that even a short block uses every core.
+        runner.setGrainSize((inputs.size() + 2 * pool.size() - 1) / (2 * pool.size()));
+        runner.designBlock(inputs, results);
+    }
+    Clock::time_point designEnd = Clock::now();
+    double designMicroseconds = std::chrono::duration<double, std::micro>(designEnd - designStart).count();
+
+    std::lock_guard<std::mutex> statsLock(statsMutex);
+    ++batchCount;
+    largestBatch = std::max(largestBatch, batch.size());
+    designSeconds += designMicroseconds * 1e-6;
+
+    // Responses are gathered per client and written with one call each.
+    std::vector<ServiceConnection*> clients;
+    char buffer[1536];
+    size_t designIndex = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Request& request = batch[i];
+        int n = snprintf(buffer, sizeof(buffer), "{");
+        if (!request.id.empty()) n += snprintf(buffer + n, sizeof(buffer) - n, "\"id\":%s,", request.id.c_str());
+        if (request.kind == RequestKind::Design) {
+            const BeamResult& result = results[designIndex++];
+            n += formatBeamResultJson(buffer + n, sizeof(buffer) - n, result, zonedStirrups);
+            if (!result.success) {
+                // Only the first line of the message, which needs no JSON escaping.
+                const std::string& message = result.design.errorMessage;
+                n += snprintf(buffer + n, sizeof(buffer) - n, ",\"error\":\"%.*s\"", (int)std::min(message.find('\n'), message.size()), message.c_str());
+                ++failedCount;
+            }
+            ++designCount;
+            double queueMicroseconds = std::chrono::duration<double, std::micro>(designStart - request.received).count();
+            double totalMicroseconds = std::chrono::duration<double, std::micro>(Clock::now() - request.received).count();
+            latency.add(totalMicroseconds);
+            n += snprintf(buffer + n, sizeof(buffer) - n, ",\"batch\":%zu,\"queueUs\":%.1f,\"designUs\":%.1f,\"latencyUs\":%.1f}\n",
+                inputs.size(), queueMicroseconds, designMicroseconds, totalMicroseconds);
+        }
+        else if (request.kind == RequestKind::Stats) {
+            n += formatStats(buffer + n, sizeof(buffer) - n);
+            n += snprintf(buffer + n, sizeof(buffer) - n, "}\n");
+        }
+        else {
+            ++invalidCount;
+            n += snprintf(buffer + n, sizeof(buffer) - n,
+                "\"ok\":false,\"error\":\"Error: Expected span, width, height, load and girderSpacing greater than zero, or a known command.\"}\n");
+        }
+        n = std::min(n, (int)sizeof(buffer) - 1);
+        ServiceConnection* client = request.client.get();
+        if (client->outgoing.empty()) clients.push_back(client);
+        client->outgoing.append(buffer, n);
+    }
+    for (ServiceConnection* client : clients) {
+        client->write(client->outgoing.data(), client->outgoing.size());
+        client->outgoing.clear();
+    }
+}
+
+inline int DesignService::formatStats(char* buffer, size_t size) {
+    double uptime = std::chrono::duration<double>(Clock::now() - startTime).count();
+    int n = snprintf(buffer, size,
+        "\"ok\":true,\"designs\":%llu,\"failed\":%llu,\"invalid\":%llu,\"batches\":%llu,\"meanBatch\":%.1f,\"largestBatch\":%zu,"
+        "\"threads\":%u,\"uptimeS\":%.1f,\"designsPerS\":%.1f,\"meanUs\":%.1f,\"p50Us\":%.0f,\"p99Us\":%.0f,\"p999Us\":%.0f,\"maxUs\":%.1f",
+        (unsigned long long)designCount, (unsigned long long)failedCount, (unsigned long long)invalidCount, (unsigned long long)batchCount,
+        batchCount ? (double)(designCount + invalidCount) / batchCount : 0.0, largestBatch, pool.size(), uptime,
+        designSeconds > 0 ? designCount / designSeconds : 0.0, latency.mean(), latency.quantile(0.5), latency.quantile(0.99),
+        latency.quantile(0.999), latency.maximum());
+    return std::min(n, (int)size - 1);
+}
+
+inline void DesignService::writeSummary(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    out << designCount << " designs (" << failedCount << " infeasible, " << invalidCount << " invalid requests) in " << batchCount
+        << " batches (largest " << largestBatch << ") on " << pool.size() << " threads\n";
+    out << "Latency (us): mean " << latency.mean() << ", p50 " << latency.quantile(0.5) << ", p99 " << latency.quantile(0.99)
+        << ", p99.9 " << latency.quantile(0.999) << ", max " << latency.maximum() << "\n";
+}
+
+// --- Front Ends ---
+
+class StdoutConnection : public ServiceConnection
+{
+public:
+    void write(const char* data, size_t length) override {
+        fwrite(data, 1, length, stdout);
+        fflush(stdout);
+    }
+};
+
+// Responses are handed to a writer thread of the connection's own, so the dispatcher
+// never blocks in send. The writer keeps the socket open until everything queued has
+// been sent, even after the connection itself is released.
+class SocketConnection : public ServiceConnection
+{
+public:
+    explicit SocketConnection(ServiceSocket socket);
+    ~SocketConnection() override;
+
+    void write(const char* data, size_t length) override;
+
+    // Feeds every complete line received on the socket to the service until the client
+    // closes. A line longer than MAX_REQUEST_LINE is answered with an error and ends the
+    // connection, so a client cannot grow the read buffer without bound.
+    void readRequests(DesignService& service, const std::shared_ptr<ServiceConnection>& self) {
+        std::string pending;
+        char buffer[65536];
+        while (true) {
+            int received = (int)recv(socket, buffer, (int)sizeof(buffer), 0);
+            if (received <= 0) break;
+            pending.append(buffer, (size_t)received);
+            size_t begin = 0, newline;
+            while ((newline = pending.find('\n', begin)) != std::string::npos && newline - begin <= MAX_REQUEST_LINE) {
+                service.submit(self, pending.substr(begin, newline - begin));
+                begin = newline + 1;
+            }
+            pending.erase(0, begin);
+            if (pending.size() > MAX_REQUEST_LINE) {
+                rejectLongLine();
+                return;
+            }
+        }
+        if (!pending.empty()) service.submit(self, pending);
+    }
+
+    // A client that lets this much output pile up unread is dropped.
+    static constexpr size_t MAX_PENDING_BYTES = 64u << 20;
+    // Longest request line accepted, in bytes; real requests are well under 200.
+    static constexpr size_t MAX_REQUEST_LINE = 4096;
+
+private:
+    // Shared by the connection and its writer thread.
+    struct Outbox
+    {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::string pending;
+        bool closed = false; // no more writes will come
+        bool broken = false; // the client is gone; further output is dropped
+    };
+
+    ServiceSocket socket;
+    std::shared_ptr<Outbox> outbox;
+
+    static void writeLoop(ServiceSocket socket, std::shared_ptr<Outbox> outbox);
+    void rejectLongLine();
+};
+
+inline SocketConnection::SocketConnection(ServiceSocket socket) : socket(socket), outbox(std::make_shared<Outbox>()) {
+    std::thread(&SocketConnection::writeLoop, socket, outbox).detach();
+}
+
+inline SocketConnection::~SocketConnection() {
+    // Every request holds the connection, so nothing more will be written; the writer
+    // sends what is left and closes the socket.
+    {
+        std::lock_guard<std::mutex> lock(outbox->mutex);
+        outbox->closed = true;
+    }
+    outbox->ready.notify_one();
+}
+
+inline void SocketConnection::write(const char* data, size_t length) {
+    {
+        std::lock_guard<std::mutex> lock(outbox->mutex);
+        if (outbox->broken) return;
+        if (outbox->pending.size() + length > MAX_PENDING_BYTES) {
+            // Not reading its answers; end the connection, which also ends its reader.
+            outbox->broken = true;
+            outbox->pending.clear();
+            shutdown(socket, SERVICE_SHUTDOWN_BOTH);
+            return;
+        }
+        outbox->pending.append(data, length);
+    }
+    outbox->ready.notify_one();
+}
+
+inline void SocketConnection::rejectLongLine() {
+    char reply[128];
+    int n = snprintf(reply, sizeof(reply), "{\"ok\":false,\"error\":\"Error: Request line longer than %zu bytes.\"}\n", MAX_REQUEST_LINE);
+    write(reply, (size_t)std::min(n, (int)sizeof(reply) - 1));
+    // Stop reading; the writer sends the reply (after any answers still due) and closes the socket.
+    shutdown(socket, SERVICE_SHUTDOWN_READ);
+}
+
+inline void SocketConnection::writeLoop(ServiceSocket socket, std::shared_ptr<Outbox> outbox) {
+    std::string sending;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(outbox->mutex);
+            outbox->ready.wait(lock, [&outbox]() { return outbox->closed || !outbox->pending.empty(); });
+            if (outbox->pending.empty()) break;
+            sending.swap(outbox->pending);
+        }
+        const char* data = sending.data();
+        size_t length = sending.size();
+        while (length > 0) {
+            int sent = (int)send(socket, data, (int)std::min<size_t>(length, 1 << 20), SERVICE_SEND_FLAGS);
+            if (sent <= 0) break;
+            data += sent;
+            length -= (size_t)sent;
+        }
+        sending.clear();
+        if (length > 0) {
+            // The client is gone; drop what it would have been sent.
+            std::lock_guard<std::mutex> lock(outbox->mutex);
+            outbox->broken = true;
+            outbox->pending.clear();
+        }
+    }
+    closeServiceSocket(socket);
+}
+
+// Accepts clients on 127.0.0.1:port until the process is stopped; each client has its own reader thread.
+inline bool serveLocalSocket(DesignService& service, int port, std::string& errorMessage) {
+#if defined(_WIN32)
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        errorMessage = "Error: Cannot initialize Winsock.";
+        return false;
+    }
+#endif
+    ServiceSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == SERVICE_INVALID_SOCKET) {
+        errorMessage = "Error: Cannot create the service socket.";
+        return false;
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local clients only
+    address.sin_port = htons((unsigned short)port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        closeServiceSocket(listener);
+        errorMessage = "Error: Cannot listen on 127.0.0.1:" + std::to_string(port) + ".";
+        return false;
+    }
+    std::cerr << "Design service listening on 127.0.0.1:" << port << "\n";
+    while (true) {
+        ServiceSocket client = accept(listener, nullptr, nullptr);
+        if (client == SERVICE_INVALID_SOCKET) continue;
+        // Responses are small and latency-bound; do not let Nagle hold them back.
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&yes), sizeof(yes));
+#if defined(SO_NOSIGPIPE)
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, reinterpret_cast<const char*>(&yes), sizeof(yes));
+#endif
+        std::shared_ptr<SocketConnection> connection = std::make_shared<SocketConnection>(client);
+        std::thread([&service, connection]() { connection->readRequests(service, connection); }).detach();
+    }
+}
+
+// Usage: --serve [--port N] [--threads N] [--cache N] [--max-batch N] [--zoned-stirrups]
+//        [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]
+// Without --port, requests are read from stdin and answered on stdout until end of input.
+inline int runServiceCommandLine(int argc, char* argv[]) {
+    int port = 0;
+    unsigned threads = 0;
+    size_t cacheEntries = 65536;
+    size_t maxBatch = DesignService::DEFAULT_MAX_BATCH;
+    bool zonedStirrups = false;
+    std::string concreteName, steelName;
+    bool badArgument = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) port = std::atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--cache" && i + 1 < argc) cacheEntries = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--max-batch" && i + 1 < argc) maxBatch = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--zoned-stirrups") zonedStirrups = true;
+        else if (arg == "--concrete" && i + 1 < argc) concreteName = argv[++i];
+        else if (arg == "--steel" && i + 1 < argc) steelName = argv[++i];
+        else badArgument = true;
+    }
+    if (badArgument || port < 0 || port > 65535) {
+        std::cerr << "Usage: --serve [--port N] [--threads N] [--cache N] [--max-batch N] [--zoned-stirrups]"
+            " [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]\n";
+        return 2;
+    }
+    MaterialGrade grade;
+    if (!concreteName.empty() && !parseConcreteGrade(concreteName, grade.concrete)) {
+        std::cerr << "Error: Unknown concrete grade '" << concreteName << "' (expected C30, C35, ... C60)\n";
+        return 2;
+    }
+    if (!steelName.empty() && !parseSteelGrade(steelName, grade.steel)) {
+        std::cerr << "Error: Unknown steel grade '" << steelName << "' (expected HRB335, HRB400 or HRB500)\n";
+        return 2;
+    }
+
+#if !defined(_WIN32)
+    // A client or stdout reader that goes away must not end the service.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (threads > 0) ownPool.reset(new WorkStealingPool(threads));
+    WorkStealingPool& pool = ownPool ? *ownPool : sharedDesignPool();
+
+    DesignService service(pool);
+    std::unique_ptr<DesignCache> cache;
+    if (cacheEntries > 0) {
+        cache.reset(new DesignCache(cacheEntries));
+        service.setCache(cache.get());
+    }
+    service.setStirrupZoning(zonedStirrups);
+    service.setMaterialGrade(grade);
+    service.setMaxBatch(maxBatch);
+    service.start();
+
+    if (port > 0) {
+        std::string error;
+        serveLocalSocket(service, port, error);
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::shared_ptr<ServiceConnection> console = std::make_shared<StdoutConnection>();
+    std::string line;
+    while (std::getline(std::cin, line)) service.submit(console, line);
+    service.stop();
+    service.writeSummary(std::cerr);
+    if (cache) std::cerr << "Design cache: " << cache->hits() << " hits, " << cache->misses() << " misses\n";
+    return 0;
+}
+
+
+#endif // DESIGNSERVICE_H
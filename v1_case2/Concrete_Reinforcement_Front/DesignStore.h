@@ -0,0 +1,491 @@
+#pragma once
+
+#ifndef DESIGNSTORE_H
+#define DESIGNSTORE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Stored Design Record ---
+// One design with its inputs, as a fixed 376-byte record. Units follow the batch input
+// (lengths in mm, vehicle load in kN, wheel span in m); width and height are the designed
+// section. Records are stored in the byte order of the writing machine, which is
+// little-endian on every platform the project builds for.
+struct DesignRecord
+{
+    double span;
+    double width;
+    double height;
+    double vehicleLoad;
+    double wheelSpan;
+    double girderSpacing;
+    double h0;
+    double totalCost;
+    double concreteCost;
+    double steelCost;
+    double laborCost;
+    double maxMoment;
+    double maxShear;
+    double hoggingMoment;
+    double flexureRebarDiameter;
+    double stirrupDiameter;
+    double stirrupSpacing;
+    double topRebarDiameter;
+    double stirrupZones[MAX_STIRRUP_ZONES][3]; // start, end, spacing (mm)
+    uint16_t rebarCountRow1;
+    uint16_t rebarCountRow2;
+    uint16_t topRebarCount;
+    uint16_t errorCode;       // DesignErrorCode
+    uint8_t rebarRows;
+    uint8_t stirrupLegs;
+    uint8_t bentRebarCount;
+    uint8_t topRebarRows;
+    uint8_t stirrupZoneCount;
+    uint8_t flags;            // DESIGN_RECORD_* bits
+    uint8_t concreteGrade;    // ConcreteGrade
+    uint8_t steelGrade;       // SteelGrade
+};
+static_assert(sizeof(DesignRecord) == 376, "DesignRecord must keep its stored size");
+
+constexpr uint8_t DESIGN_RECORD_SUCCESS = 1;
+constexpr uint8_t DESIGN_RECORD_BENT_BARS = 2;
+
+DesignRecord makeDesignRecord(double span, double width, double height, double vehicleLoad, double wheelSpan, double girderSpacing,
+    MaterialGrade grade, bool success, const RebarDesign& design, double h0);
+// The stored design as a RebarDesign; the error message is the one of its code.
+RebarDesign designFromRecord(const DesignRecord& record);
+
+// --- File Layout ---
+// A store is a 64-byte header followed by records. Its record count is implied by the
+// file size, so appending never rewrites the header. The index next to it (path + ".idx")
+// is a 64-byte header followed by one entry per record, sorted by span, then load. The
+// index header repeats the stamp of its store and the number of records it covers; an
+// index whose stamp differs (the store was recreated) or that covers more records than the
+// store holds (the store was cut short) is out of date and is not used.
+struct DesignFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t entrySize;
+    uint64_t recordCount; // index only: the store records it covers
+    uint64_t storeStamp;  // store: drawn when it is created; index: the stamp of its store
+    char reserved[32];
+};
+static_assert(sizeof(DesignFileHeader) == 64, "DesignFileHeader must keep its stored size");
+
+struct DesignIndexEntry
+{
+    double span;
+    double vehicleLoad;
+    uint64_t record;
+};
+
+constexpr uint32_t DESIGN_STORE_VERSION = 1;
+constexpr char DESIGN_STORE_MAGIC[4] = { 'R', 'B', 'D', 'S' };
+constexpr char DESIGN_INDEX_MAGIC[4] = { 'R', 'B', 'D', 'I' };
+
+// --- Read-Only Memory-Mapped File ---
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& errorMessage);
+    void close();
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+// --- Append-Only Store Writer ---
+// Opens a store for appending, creating it if needed. A record left half-written by an
+// interrupted run is cut off, so appending always starts on a record boundary.
+class DesignStoreWriter
+{
+public:
+    DesignStoreWriter() = default;
+    // A store still open here is finished, so a run that stops early leaves an index too.
+    ~DesignStoreWriter();
+    DesignStoreWriter(const DesignStoreWriter&) = delete;
+    DesignStoreWriter& operator=(const DesignStoreWriter&) = delete;
+
+    bool open(const std::string& path, std::string& errorMessage);
+    bool append(const DesignRecord& record) { return (bool)out.write(reinterpret_cast<const char*>(&record), sizeof(record)); }
+    bool close() { out.close(); return !out.fail(); }
+    bool isOpen() const { return out.is_open(); }
+    // Closes the store and rebuilds its index over every record. `recordCount`, when
+    // given, receives the number of records in the store.
+    bool finish(std::string& errorMessage, size_t* recordCount = nullptr);
+
+private:
+    std::ofstream out;
+    std::string storePath;
+};
+
+// --- Memory-Mapped Store Reader ---
+// Records are read in place from the mapped file; nothing is parsed or copied.
+class DesignStoreReader
+{
+public:
+    bool open(const std::string& path, std::string& errorMessage);
+    size_t size() const { return count; }
+    uint64_t creationStamp() const { return stamp; }
+    const DesignRecord& operator[](size_t i) const { return records[i]; }
+
+private:
+    MappedFile file;
+    const DesignRecord* records = nullptr;
+    size_t count = 0;
+    uint64_t stamp = 0;
+};
+
+// --- Span / Load Index ---
+struct DesignQuery
+{
+    double minSpan = 0;
+    double maxSpan = 1e300;
+    double minLoad = 0;
+    double maxLoad = 1e300;
+
+    bool matches(double span, double load) const { return span >= minSpan && span <= maxSpan && load >= minLoad && load <= maxLoad; }
+};
+
+// Writes the index of `store` to indexPath. Only the entries (24 bytes per record) are
+// held in memory while they are sorted.
+bool buildDesignIndex(const DesignStoreReader& store, const std::string& indexPath, std::string& errorMessage);
+
+class DesignIndexReader
+{
+public:
+    // Fails for an index that is out of date for `store` (see DesignFileHeader).
+    bool open(const std::string& path, const DesignStoreReader& store, std::string& errorMessage);
+    size_t size() const { return count; }
+    uint64_t recordsCovered() const { return covered; }
+
+    // Appends to `matches` the records within both ranges: a binary search for the first
+    // span in range, then a scan to the last one. Records appended to `store` after the
+    // index was built are checked one by one. Matches come in index order (by span and
+    // load), then in store order for the unindexed records.
+    void query(const DesignStoreReader& store, const DesignQuery& query, std::vector<uint64_t>& matches) const;
+
+private:
+    MappedFile file;
+    const DesignIndexEntry* entries = nullptr;
+    size_t count = 0;
+    uint64_t covered = 0;
+};
+
+
+// --- Function Implementations ---
+
+inline DesignRecord makeDesignRecord(double span, double width, double height, double vehicleLoad, double wheelSpan, double girderSpacing,
+    MaterialGrade grade, bool success, const RebarDesign& design, double h0) {
+    DesignRecord record;
+    std::memset(&record, 0, sizeof(record)); // no stray padding bytes in the file
+    record.span = span;
+    record.width = width;
+    record.height = height;
+    record.vehicleLoad = vehicleLoad;
+    record.wheelSpan = wheelSpan;
+    record.girderSpacing = girderSpacing;
+    record.h0 = h0;
+    record.totalCost = design.totalCost;
+    record.concreteCost = design.concreteCost;
+    record.steelCost = design.steelCost;
+    record.laborCost = design.laborCost;
+    record.maxMoment = design.maxMoment;
+    record.maxShear = design.maxShear;
+    record.hoggingMoment = design.hoggingMoment;
+    record.flexureRebarDiameter = design.flexureRebarDiameter;
+    record.stirrupDiameter = design.stirrupDiameter;
+    record.stirrupSpacing = design.stirrupSpacing;
+    record.topRebarDiameter = design.topRebarDiameter;
+    record.stirrupZoneCount = (uint8_t)design.stirrupZoneCount;
+    for (int z = 0; z < design.stirrupZoneCount; ++z) {
+        record.stirrupZones[z][0] = design.stirrupZones[z].start;
+        record.stirrupZones[z][1] = design.stirrupZones[z].end;
+        record.stirrupZones[z][2] = design.stirrupZones[z].spacing;
+    }
+    record.rebarCountRow1 = (uint16_t)design.rebarCountRow1;
+    record.rebarCountRow2 = (uint16_t)design.rebarCountRow2;
+    record.topRebarCount = (uint16_t)design.topRebarCount;
+    record.errorCode = (uint16_t)designErrorCode(design.errorMessage);
+    record.rebarRows = (uint8_t)design.rebarRows;
+    record.stirrupLegs = (uint8_t)design.stirrupLegs;
+    record.bentRebarCount = (uint8_t)design.bentRebarCount;
+    record.topRebarRows = (uint8_t)design.topRebarRows;
+    record.flags = (success ? DESIGN_RECORD_SUCCESS : 0) | (design.bentRebarsUsed ? DESIGN_RECORD_BENT_BARS : 0);
+    record.concreteGrade = (uint8_t)grade.concrete;
+    record.steelGrade = (uint8_t)grade.steel;
+    return record;
+}
+
+inline RebarDesign designFromRecord(const DesignRecord& record) {
+    RebarDesign design;
+    design.rebarRows = record.rebarRows;
+    design.rebarCountRow1 = record.rebarCountRow1;
+    design.rebarCountRow2 = record.rebarCountRow2;
+    design.flexureRebarDiameter = record.flexureRebarDiameter;
+    design.stirrupLegs = record.stirrupLegs;
+    design.stirrupDiameter = record.stirrupDiameter;
+    design.stirrupSpacing = record.stirrupSpacing;
+    design.stirrupZoneCount = std::min<int>(record.stirrupZoneCount, MAX_STIRRUP_ZONES);
+    for (int z = 0; z < design.stirrupZoneCount; ++z) {
+        design.stirrupZones[z] = { record.stirrupZones[z][0], record.stirrupZones[z][1], record.stirrupZones[z][2] };
+    }
+    design.bentRebarsUsed = (record.flags & DESIGN_RECORD_BENT_BARS) != 0;
+    design.bentRebarCount = record.bentRebarCount;
+    design.totalCost = record.totalCost;
+    design.concreteCost = record.concreteCost;
+    design.steelCost = record.steelCost;
+    design.laborCost = record.laborCost;
+    design.maxMoment = record.maxMoment;
+    design.maxShear = record.maxShear;
+    design.hoggingMoment = record.hoggingMoment;
+    design.topRebarDiameter = record.topRebarDiameter;
+    design.topRebarCount = record.topRebarCount;
+    design.topRebarRows = record.topRebarRows;
+    design.designPossible = record.errorCode == (uint16_t)DesignErrorCode::None;
+    design.errorMessage = designErrorMessage((DesignErrorCode)record.errorCode);
+    return design;
+}
+
+// Checks the header of a mapped store or index and returns the number of entries.
+inline bool checkDesignFileHeader(const MappedFile& file, const char (&magic)[4], uint32_t entrySize, const std::string& path,
+    size_t& count, std::string& errorMessage) {
+    DesignFileHeader header;
+    if (file.size() < sizeof(header)) {
+        errorMessage = "Error: " + path + " is too short to be a design store.";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, magic, 4) != 0) {
+        errorMessage = "Error: " + path + " is not a design store.";
+        return false;
+    }
+    if (header.version != DESIGN_STORE_VERSION || header.entrySize != entrySize || header.headerSize != sizeof(header)) {
+        errorMessage = "Error: " + path + " was written by an incompatible version.";
+        return false;
+    }
+    count = (file.size() - sizeof(header)) / entrySize;
+    return true;
+}
+
+inline bool MappedFile::open(const std::string& path, std::string& errorMessage) {
+    close();
+#if defined(_WIN32)
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+        errorMessage = "Error: Cannot open " + path + ".";
+        close();
+        return false;
+    }
+    length = (size_t)fileSize.QuadPart;
+    if (length > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        bytes = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) ::close(fd);
+        errorMessage = "Error: Cannot open " + path + ".";
+        return false;
+    }
+    length = (size_t)info.st_size;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        bytes = mapped != MAP_FAILED ? static_cast<const char*>(mapped) : nullptr;
+    }
+    ::close(fd); // the mapping keeps the file open
+#endif
+    if (length > 0 && !bytes) {
+        errorMessage = "Error: Cannot map " + path + " into memory.";
+        close();
+        return false;
+    }
+    return true;
+}
+
+inline void MappedFile::close() {
+#if defined(_WIN32)
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+#endif
+    bytes = nullptr;
+    length = 0;
+}
+
+inline bool DesignStoreWriter::open(const std::string& path, std::string& errorMessage) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    if (size > 0) {
+        MappedFile existing;
+        size_t count = 0;
+        if (!existing.open(path, errorMessage) ||
+            !checkDesignFileHeader(existing, DESIGN_STORE_MAGIC, sizeof(DesignRecord), path, count, errorMessage)) return false;
+        existing.close();
+        uintmax_t whole = sizeof(DesignFileHeader) + (uintmax_t)count * sizeof(DesignRecord);
+        std::error_code resizeError;
+        if (whole != size) std::filesystem::resize_file(path, whole, resizeError);
+        if (resizeError) {
+            errorMessage = "Error: Cannot repair the truncated record at the end of " + path + ".";
+            return false;
+        }
+    }
+
+    out.open(path, std::ios::binary | std::ios::app);
+    if (!out) {
+        errorMessage = "Error: Cannot open " + path + " for writing.";
+        return false;
+    }
+    if (size == 0) {
+        DesignFileHeader header = {};
+        std::memcpy(header.magic, DESIGN_STORE_MAGIC, 4);
+        header.version = DESIGN_STORE_VERSION;
+        header.headerSize = sizeof(header);
+        header.entrySize = sizeof(DesignRecord);
+        // The creation time alone could repeat when a store is recreated at once.
+        header.storeStamp = (uint64_t)std::chrono::system_clock::now().time_since_epoch().count() ^ ((uint64_t)std::random_device()() << 32);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    storePath = path;
+    return (bool)out;
+}
+
+inline DesignStoreWriter::~DesignStoreWriter() {
+    if (!isOpen()) return;
+    std::string ignored;
+    finish(ignored);
+}
+
+inline bool DesignStoreWriter::finish(std::string& errorMessage, size_t* recordCount) {
+    if (!close()) {
+        errorMessage = "Error: Failed writing design store " + storePath + ".";
+        return false;
+    }
+    DesignStoreReader reader;
+    if (!reader.open(storePath, errorMessage) || !buildDesignIndex(reader, storePath + ".idx", errorMessage)) return false;
+    if (recordCount) *recordCount = reader.size();
+    return true;
+}
+
+inline bool DesignStoreReader::open(const std::string& path, std::string& errorMessage) {
+    records = nullptr;
+    count = 0;
+    if (!file.open(path, errorMessage) ||
+        !checkDesignFileHeader(file, DESIGN_STORE_MAGIC, sizeof(DesignRecord), path, count, errorMessage)) return false;
+    DesignFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    stamp = header.storeStamp;
+    records = reinterpret_cast<const DesignRecord*>(file.data() + sizeof(DesignFileHeader));
+    return true;
+}
+
+inline bool buildDesignIndex(const DesignStoreReader& store, const std::string& indexPath, std::string& errorMessage) {
+    std::vector<DesignIndexEntry> entries(store.size());
+    for (size_t i = 0; i < store.size(); ++i) entries[i] = { store[i].span, store[i].vehicleLoad, (uint64_t)i };
+    std::sort(entries.begin(), entries.end(), [](const DesignIndexEntry& a, const DesignIndexEntry& b) {
+        if (a.span != b.span) return a.span < b.span;
+        if (a.vehicleLoad != b.vehicleLoad) return a.vehicleLoad < b.vehicleLoad;
+        return a.record < b.record;
+    });
+
+    std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        errorMessage = "Error: Cannot open " + indexPath + " for writing.";
+        return false;
+    }
+    DesignFileHeader header = {};
+    std::memcpy(header.magic, DESIGN_INDEX_MAGIC, 4);
+    header.version = DESIGN_STORE_VERSION;
+    header.headerSize = sizeof(header);
+    header.entrySize = sizeof(DesignIndexEntry);
+    header.recordCount = store.size();
+    header.storeStamp = store.creationStamp();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(DesignIndexEntry));
+    out.close();
+    if (out.fail()) {
+        errorMessage = "Error: Failed writing " + indexPath + ".";
+        return false;
+    }
+    return true;
+}
+
+inline bool DesignIndexReader::open(const std::string& path, const DesignStoreReader& store, std::string& errorMessage) {
+    entries = nullptr;
+    count = 0;
+    covered = 0;
+    if (!file.open(path, errorMessage) ||
+        !checkDesignFileHeader(file, DESIGN_INDEX_MAGIC, sizeof(DesignIndexEntry), path, count, errorMessage)) return false;
+    DesignFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.storeStamp != store.creationStamp() || header.recordCount > store.size() || header.recordCount != count) {
+        errorMessage = "Error: " + path + " does not match its design store.";
+        file.close();
+        count = 0;
+        return false;
+    }
+    covered = header.recordCount;
+    entries = reinterpret_cast<const DesignIndexEntry*>(file.data() + sizeof(DesignFileHeader));
+    return true;
+}
+
+inline void DesignIndexReader::query(const DesignStoreReader& store, const DesignQuery& query, std::vector<uint64_t>& matches) const {
+    const DesignIndexEntry* end = entries + count;
+    const DesignIndexEntry* first = std::lower_bound(entries, end, query.minSpan,
+        [](const DesignIndexEntry& entry, double span) { return entry.span < span; });
+    for (const DesignIndexEntry* entry = first; entry != end && entry->span <= query.maxSpan; ++entry) {
+        if (entry->vehicleLoad >= query.minLoad && entry->vehicleLoad <= query.maxLoad && entry->record < store.size()) {
+            matches.push_back(entry->record);
+        }
+    }
+    for (size_t i = (size_t)covered; i < store.size(); ++i) {
+        if (query.matches(store[i].span, store[i].vehicleLoad)) matches.push_back(i);
+    }
+}
+
+
+#endif // DESIGNSTORE_H
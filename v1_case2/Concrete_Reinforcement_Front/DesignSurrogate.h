@@ -0,0 +1,560 @@
+#pragma once
+
+#ifndef DESIGNSURROGATE_H
+#define DESIGNSURROGATE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+#include "DesignStore.h"
+#include "ThreadPool.h"
+
+// --- Surrogate Grid ---
+// The optimal design is tabulated on a regular grid over span (mm), vehicle load (kN),
+// width (mm), height (mm) and girder spacing (mm), in this order, for one wheel span and
+// one set of design options. Axis a has count points first + i * step.
+constexpr int SURROGATE_AXES = 5;
+
+struct SurrogateAxis
+{
+    double first;
+    double step;
+    uint32_t count;
+
+    double last() const { return first + step * (count - 1); }
+    // At least two points, a finite start and a positive finite step.
+    bool isValid() const { return count >= 2 && std::isfinite(first) && std::isfinite(step) && step > 0; }
+};
+
+struct SurrogateGrid
+{
+    SurrogateAxis axes[SURROGATE_AXES] = {
+        { 6000, 2000, 18 },  // span
+        { 100, 100, 10 },    // vehicle load
+        { 300, 50, 15 },     // width
+        { 600, 100, 19 },    // height
+        { 1500, 500, 4 },    // girder spacing
+    };
+    double wheelSpan = 1.8;  // m
+    bool zonedStirrups = true;
+    bool mixedDiameters = true;
+    MaterialGrade grade;
+
+    size_t cellCount() const;
+};
+
+const char* surrogateAxisName(int axis);
+
+// --- Stored Cell ---
+// The design at one grid point in 36 bytes: the costs as floats and the layout in bytes.
+// Stirrup spacing is the densest zone of zoned stirrups.
+struct SurrogateCell
+{
+    float totalCost;
+    float concreteCost;
+    float steelCost;
+    float laborCost;
+    uint16_t stirrupSpacing;
+    uint8_t errorCode;        // DesignErrorCode
+    uint8_t flags;            // SURROGATE_CELL_* bits
+    uint8_t flexureRebarDiameter;
+    uint8_t rebarRows;
+    uint8_t rebarCountRow1;
+    uint8_t rebarCountRow2;
+    uint8_t stirrupDiameter;
+    uint8_t stirrupLegs;
+    uint8_t bentRebarCount;
+    uint8_t reserved;
+    uint8_t rowDiameters[2][2];
+    uint8_t rowBarCounts[2][2];
+};
+static_assert(sizeof(SurrogateCell) == 36, "SurrogateCell must keep its stored size");
+
+constexpr uint8_t SURROGATE_CELL_SUCCESS = 1;
+constexpr uint8_t SURROGATE_CELL_BENT_BARS = 2;
+constexpr uint8_t SURROGATE_CELL_MIXED = 4;
+
+// --- File Layout ---
+// A 160-byte header with the grid, then one cell per grid point with the last axis
+// (girder spacing) varying fastest. Stored in the byte order of the writing machine.
+struct SurrogateFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t cellSize;
+    uint32_t options;         // SURROGATE_OPTION_* bits
+    uint32_t grade;           // MaterialGrade::code()
+    double wheelSpan;
+    double first[SURROGATE_AXES];
+    double step[SURROGATE_AXES];
+    uint32_t count[SURROGATE_AXES];
+    char reserved[28];
+};
+static_assert(sizeof(SurrogateFileHeader) == 160, "SurrogateFileHeader must keep its stored size");
+
+constexpr uint32_t SURROGATE_VERSION = 1;
+constexpr char SURROGATE_MAGIC[4] = { 'R', 'B', 'S', 'G' };
+constexpr uint32_t SURROGATE_OPTION_ZONED = 1;
+constexpr uint32_t SURROGATE_OPTION_MIXED = 2;
+
+// --- Preview ---
+// The costs are interpolated multilinearly between the feasible grid points around the
+// query; the layout in `design` is that of the nearest grid point, which also decides
+// whether the design is feasible at all. Costs in `design` are the interpolated ones.
+struct SurrogatePreview
+{
+    bool success = false;
+    RebarDesign design;
+};
+
+// --- Memory-Mapped Surrogate Table ---
+class DesignSurrogate
+{
+public:
+    bool open(const std::string& path, std::string& errorMessage);
+    void close() { file.close(); cells = nullptr; }
+    bool isOpen() const { return cells != nullptr; }
+    const SurrogateGrid& grid() const { return tableGrid; }
+
+    // Answers from the table; false when it is not open, the wheel span differs from the
+    // tabulated one or a value lies outside the grid. Arguments are those of runDesign.
+    bool preview(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        SurrogatePreview& result) const;
+
+private:
+    MappedFile file;
+    const SurrogateCell* cells = nullptr;
+    SurrogateGrid tableGrid;
+};
+
+// Designs every grid point on `pool` and writes the table to `path`.
+bool buildDesignSurrogate(const SurrogateGrid& grid, const std::string& path, WorkStealingPool& pool, std::string& errorMessage);
+
+// --- Accuracy Check ---
+// Random points inside the grid, previewed and designed exactly with the options of the
+// table. Cost errors are relative to the exact cost and only taken where both agree the
+// beam is feasible; the layout matches when the flexural bars and rows are the same.
+struct SurrogateCheckResult
+{
+    size_t samples = 0;
+    size_t feasibilityMismatches = 0;
+    size_t compared = 0;
+    size_t layoutMatches = 0;
+    double meanError = 0;
+    double p95Error = 0;
+    double maxError = 0;
+    double previewSeconds = 0;
+    double exactSeconds = 0;
+};
+
+bool checkDesignSurrogate(const DesignSurrogate& surrogate, size_t samples, uint64_t seed, WorkStealingPool& pool, SurrogateCheckResult& result);
+
+int runBuildSurrogateCommandLine(int argc, char* argv[]);
+int runSurrogateCheckCommandLine(int argc, char* argv[]);
+
+
+// --- Function Implementations ---
+
+inline size_t SurrogateGrid::cellCount() const {
+    size_t count = 1;
+    for (const SurrogateAxis& axis : axes) count *= axis.count;
+    return count;
+}
+
+inline const char* surrogateAxisName(int axis) {
+    static const char* names[SURROGATE_AXES] = { "span", "load", "width", "height", "girder-spacing" };
+    return names[axis];
+}
+
+inline SurrogateCell makeSurrogateCell(bool success, const RebarDesign& design) {
+    SurrogateCell cell;
+    std::memset(&cell, 0, sizeof(cell));
+    cell.totalCost = (float)design.totalCost;
+    cell.concreteCost = (float)design.concreteCost;
+    cell.steelCost = (float)design.steelCost;
+    cell.laborCost = (float)design.laborCost;
+    cell.stirrupSpacing = (uint16_t)design.stirrupSpacing;
+    cell.errorCode = (uint8_t)designErrorCode(design.errorMessage);
+    cell.flags = (success ? SURROGATE_CELL_SUCCESS : 0) | (design.bentRebarsUsed ? SURROGATE_CELL_BENT_BARS : 0) |
+        (design.mixedDiameters ? SURROGATE_CELL_MIXED : 0);
+    cell.flexureRebarDiameter = (uint8_t)design.flexureRebarDiameter;
+    cell.rebarRows = (uint8_t)design.rebarRows;
+    cell.rebarCountRow1 = (uint8_t)design.rebarCountRow1;
+    cell.rebarCountRow2 = (uint8_t)design.rebarCountRow2;
+    cell.stirrupDiameter = (uint8_t)design.stirrupDiameter;
+    cell.stirrupLegs = (uint8_t)design.stirrupLegs;
+    cell.bentRebarCount = (uint8_t)design.bentRebarCount;
+    for (int row = 0; row < 2; ++row) {
+        for (int j = 0; j < 2; ++j) {
+            cell.rowDiameters[row][j] = (uint8_t)design.rowDiameters[row][j];
+            cell.rowBarCounts[row][j] = (uint8_t)design.rowBarCounts[row][j];
+        }
+    }
+    return cell;
+}
+
+inline RebarDesign designFromSurrogateCell(const SurrogateCell& cell) {
+    RebarDesign design;
+    design.totalCost = cell.totalCost;
+    design.concreteCost = cell.concreteCost;
+    design.steelCost = cell.steelCost;
+    design.laborCost = cell.laborCost;
+    design.stirrupSpacing = cell.stirrupSpacing;
+    design.flexureRebarDiameter = cell.flexureRebarDiameter;
+    design.rebarRows = cell.rebarRows;
+    design.rebarCountRow1 = cell.rebarCountRow1;
+    design.rebarCountRow2 = cell.rebarCountRow2;
+    design.stirrupDiameter = cell.stirrupDiameter;
+    design.stirrupLegs = cell.stirrupLegs;
+    design.bentRebarsUsed = (cell.flags & SURROGATE_CELL_BENT_BARS) != 0;
+    design.bentRebarCount = cell.bentRebarCount;
+    design.mixedDiameters = (cell.flags & SURROGATE_CELL_MIXED) != 0;
+    for (int row = 0; row < 2; ++row) {
+        for (int j = 0; j < 2; ++j) {
+            design.rowDiameters[row][j] = cell.rowDiameters[row][j];
+            design.rowBarCounts[row][j] = cell.rowBarCounts[row][j];
+        }
+    }
+    design.designPossible = cell.errorCode == (uint8_t)DesignErrorCode::None;
+    design.errorMessage = designErrorMessage((DesignErrorCode)cell.errorCode);
+    return design;
+}
+
+inline bool DesignSurrogate::open(const std::string& path, std::string& errorMessage) {
+    close();
+    if (!file.open(path, errorMessage)) return false;
+    SurrogateFileHeader header;
+    if (file.size() < sizeof(header)) {
+        errorMessage = "Error: " + path + " is too short to be a design surrogate table.";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SURROGATE_MAGIC, 4) != 0) {
+        errorMessage = "Error: " + path + " is not a design surrogate table.";
+        return false;
+    }
+    if (header.version != SURROGATE_VERSION || header.headerSize != sizeof(header) || header.cellSize != sizeof(SurrogateCell)) {
+        errorMessage = "Error: " + path + " was written by an incompatible version.";
+        return false;
+    }
+    SurrogateGrid grid;
+    grid.wheelSpan = header.wheelSpan;
+    grid.zonedStirrups = (header.options & SURROGATE_OPTION_ZONED) != 0;
+    grid.mixedDiameters = (header.options & SURROGATE_OPTION_MIXED) != 0;
+    if (header.grade >= (uint32_t)MaterialGrade::CODE_COUNT || !MaterialGrade::fromCode((int)header.grade, grid.grade)) {
+        errorMessage = "Error: " + path + " has an unknown material grade.";
+        return false;
+    }
+    // The cell count is multiplied out against the cells actually present, so that huge
+    // axis counts cannot overflow into a match.
+    size_t storedCells = (file.size() - sizeof(header)) / sizeof(SurrogateCell);
+    size_t cellCount = 1;
+    for (int a = 0; a < SURROGATE_AXES; ++a) {
+        grid.axes[a] = { header.first[a], header.step[a], header.count[a] };
+        if (!grid.axes[a].isValid()) {
+            errorMessage = "Error: " + path + " has an invalid " + surrogateAxisName(a) + " axis.";
+            return false;
+        }
+        if (cellCount > storedCells / grid.axes[a].count) {
+            cellCount = 0;
+            break;
+        }
+        cellCount *= grid.axes[a].count;
+    }
+    if (cellCount != storedCells || file.size() != sizeof(header) + cellCount * sizeof(SurrogateCell)) {
+        errorMessage = "Error: " + path + " does not hold the cells of its grid.";
+        return false;
+    }
+    tableGrid = grid;
+    cells = reinterpret_cast<const SurrogateCell*>(file.data() + sizeof(header));
+    return true;
+}
+
+inline bool DesignSurrogate::preview(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+    SurrogatePreview& result) const {
+    if (!cells || std::fabs(wheelSpan - tableGrid.wheelSpan) > 1e-9) return false;
+    const double values[SURROGATE_AXES] = { span, totalVehicleLoad, width, height, girderSpacing };
+    size_t lower = 0, nearest = 0, stride[SURROGATE_AXES];
+    double fraction[SURROGATE_AXES];
+    stride[SURROGATE_AXES - 1] = 1;
+    for (int a = SURROGATE_AXES - 1; a > 0; --a) stride[a - 1] = stride[a] * tableGrid.axes[a].count;
+    for (int a = 0; a < SURROGATE_AXES; ++a) {
+        const SurrogateAxis& axis = tableGrid.axes[a];
+        double u = axis.step > 0 ? (values[a] - axis.first) / axis.step : 0;
+        if (u < -1e-9 || u > axis.count - 1 + 1e-9) return false;
+        u = std::min(std::max(u, 0.0), (double)(axis.count - 1));
+        size_t i = std::min((size_t)u, (size_t)axis.count - 1);
+        if (i + 1 == axis.count && i > 0) --i;
+        fraction[a] = u - i;
+        lower += i * stride[a];
+        nearest += (size_t)std::lround(u) * stride[a];
+    }
+
+    const SurrogateCell& cell = cells[nearest];
+    result.success = (cell.flags & SURROGATE_CELL_SUCCESS) != 0;
+    result.design = designFromSurrogateCell(cell);
+    if (!result.success) return true;
+
+    // Weights of the 32 corners of the grid cell; infeasible corners are left out and the
+    // rest scaled up, so a cost is never blended with the zeros of a failed design.
+    double weightSum = 0, costs[4] = {};
+    for (int corner = 0; corner < (1 << SURROGATE_AXES); ++corner) {
+        double weight = 1;
+        size_t index = lower;
+        for (int a = 0; a < SURROGATE_AXES && weight > 0; ++a) {
+            bool upper = (corner >> a) & 1;
+            weight *= upper ? fraction[a] : 1.0 - fraction[a];
+            if (upper) index += stride[a];
+        }
+        if (weight <= 0) continue;
+        const SurrogateCell& c = cells[index];
+        if (!(c.flags & SURROGATE_CELL_SUCCESS)) continue;
+        weightSum += weight;
+        costs[0] += weight * c.totalCost;
+        costs[1] += weight * c.concreteCost;
+        costs[2] += weight * c.steelCost;
+        costs[3] += weight * c.laborCost;
+    }
+    result.design.totalCost = costs[0] / weightSum;
+    result.design.concreteCost = costs[1] / weightSum;
+    result.design.steelCost = costs[2] / weightSum;
+    result.design.laborCost = costs[3] / weightSum;
+    return true;
+}
+
+inline bool buildDesignSurrogate(const SurrogateGrid& grid, const std::string& path, WorkStealingPool& pool, std::string& errorMessage) {
+    for (const SurrogateAxis& axis : grid.axes) {
+        if (!axis.isValid()) {
+            errorMessage = "Error: Each surrogate grid axis needs at least two points and a positive step.";
+            return false;
+        }
+    }
+    size_t cellCount = grid.cellCount();
+    std::vector<SurrogateCell> cells(cellCount);
+    parallelFor(pool, 0, cellCount, 64, [&](size_t begin, size_t end) {
+        dispatchMaterialGrade(grid.grade, [&](auto tag) {
+            typename decltype(tag)::Calc calc;
+            calc.setStirrupZoning(grid.zonedStirrups);
+            calc.setMixedDiameters(grid.mixedDiameters);
+            for (size_t c = begin; c < end; ++c) {
+                double values[SURROGATE_AXES];
+                size_t rest = c;
+                for (int a = SURROGATE_AXES - 1; a >= 0; --a) {
+                    values[a] = grid.axes[a].first + grid.axes[a].step * (rest % grid.axes[a].count);
+                    rest /= grid.axes[a].count;
+                }
+                bool success = calc.runDesign(values[0], values[2], values[3], values[1], grid.wheelSpan, values[4]);
+                cells[c] = makeSurrogateCell(success, calc.getDesignResults());
+            }
+            return true;
+        });
+    });
+
+    SurrogateFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SURROGATE_MAGIC, 4);
+    header.version = SURROGATE_VERSION;
+    header.headerSize = sizeof(header);
+    header.cellSize = sizeof(SurrogateCell);
+    header.options = (grid.zonedStirrups ? SURROGATE_OPTION_ZONED : 0) | (grid.mixedDiameters ? SURROGATE_OPTION_MIXED : 0);
+    header.grade = (uint32_t)grid.grade.code();
+    header.wheelSpan = grid.wheelSpan;
+    for (int a = 0; a < SURROGATE_AXES; ++a) {
+        header.first[a] = grid.axes[a].first;
+        header.step[a] = grid.axes[a].step;
+        header.count[a] = grid.axes[a].count;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(cells.data()), cells.size() * sizeof(SurrogateCell));
+    out.close();
+    if (!out) {
+        errorMessage = "Error: Failed writing design surrogate table " + path;
+        return false;
+    }
+    return true;
+}
+
+inline bool checkDesignSurrogate(const DesignSurrogate& surrogate, size_t samples, uint64_t seed, WorkStealingPool& pool, SurrogateCheckResult& result) {
+    if (!surrogate.isOpen()) return false;
+    result = SurrogateCheckResult();
+    result.samples = samples;
+    const SurrogateGrid& grid = surrogate.grid();
+    std::mt19937_64 rng(seed);
+    std::vector<double> points(samples * SURROGATE_AXES);
+    for (size_t i = 0; i < samples; ++i) {
+        for (int a = 0; a < SURROGATE_AXES; ++a) {
+            std::uniform_real_distribution<double> value(grid.axes[a].first, grid.axes[a].last());
+            points[i * SURROGATE_AXES + a] = value(rng);
+        }
+    }
+
+    std::vector<SurrogatePreview> previews(samples);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < samples; ++i) {
+        const double* p = &points[i * SURROGATE_AXES];
+        surrogate.preview(p[0], p[2], p[3], p[1], grid.wheelSpan, p[4], previews[i]);
+    }
+    result.previewSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<RebarDesign> exact(samples);
+    std::vector<char> exactSuccess(samples);
+    start = std::chrono::steady_clock::now();
+    parallelFor(pool, 0, samples, 16, [&](size_t begin, size_t end) {
+        dispatchMaterialGrade(grid.grade, [&](auto tag) {
+            typename decltype(tag)::Calc calc;
+            calc.setStirrupZoning(grid.zonedStirrups);
+            calc.setMixedDiameters(grid.mixedDiameters);
+            for (size_t i = begin; i < end; ++i) {
+                const double* p = &points[i * SURROGATE_AXES];
+                exactSuccess[i] = calc.runDesign(p[0], p[2], p[3], p[1], grid.wheelSpan, p[4]);
+                exact[i] = calc.getDesignResults();
+            }
+            return true;
+        });
+    });
+    result.exactSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> errors;
+    for (size_t i = 0; i < samples; ++i) {
+        if (previews[i].success != (exactSuccess[i] != 0)) ++result.feasibilityMismatches;
+        if (!previews[i].success || !exactSuccess[i]) continue;
+        const RebarDesign& p = previews[i].design;
+        const RebarDesign& e = exact[i];
+        errors.push_back(std::fabs(p.totalCost - e.totalCost) / e.totalCost);
+        if (flexuralLayoutText(p) == flexuralLayoutText(e)) ++result.layoutMatches;
+    }
+    result.compared = errors.size();
+    if (!errors.empty()) {
+        std::sort(errors.begin(), errors.end());
+        for (double error : errors) result.meanError += error;
+        result.meanError /= errors.size();
+        result.p95Error = errors[std::min(errors.size() - 1, (size_t)(0.95 * errors.size()))];
+        result.maxError = errors.back();
+    }
+    return true;
+}
+
+// Usage: --build-surrogate <table.rbsg> [--span first:last:step] [--load ...] [--width ...] [--height ...]
+//        [--girder-spacing ...] [--wheel-span m] [--uniform-stirrups] [--single-diameter] [--threads N]
+//        [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]
+// The defaults are the grid of SurrogateGrid with the design options of the GUI.
+inline int runBuildSurrogateCommandLine(int argc, char* argv[]) {
+    SurrogateGrid grid;
+    std::string path;
+    unsigned threads = 0;
+    std::string concreteName, steelName;
+    bool badArgument = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        int axis = -1;
+        for (int a = 0; a < SURROGATE_AXES; ++a) {
+            if (arg == std::string("--") + surrogateAxisName(a)) axis = a;
+        }
+        if (axis >= 0 && i + 1 < argc) {
+            double first, last, step;
+            if (std::sscanf(argv[++i], "%lf:%lf:%lf", &first, &last, &step) != 3 || step <= 0 || last < first) badArgument = true;
+            else grid.axes[axis] = { first, step, (uint32_t)std::floor((last - first) / step + 1e-9) + 1 };
+        }
+        else if (arg == "--wheel-span" && i + 1 < argc) grid.wheelSpan = std::atof(argv[++i]);
+        else if (arg == "--uniform-stirrups") grid.zonedStirrups = false;
+        else if (arg == "--single-diameter") grid.mixedDiameters = false;
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--concrete" && i + 1 < argc) concreteName = argv[++i];
+        else if (arg == "--steel" && i + 1 < argc) steelName = argv[++i];
+        else if (path.empty()) path = arg;
+        else badArgument = true;
+    }
+    if (path.empty() || badArgument) {
+        std::cerr << "Usage: --build-surrogate <table.rbsg> [--span first:last:step] [--load ...] [--width ...] [--height ...]"
+            " [--girder-spacing ...] [--wheel-span m] [--uniform-stirrups] [--single-diameter] [--threads N]"
+            " [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]\n";
+        return 2;
+    }
+    if (!concreteName.empty() && !parseConcreteGrade(concreteName, grid.grade.concrete)) {
+        std::cerr << "Error: Unknown concrete grade '" << concreteName << "' (expected C30, C35, ... C60)\n";
+        return 2;
+    }
+    if (!steelName.empty() && !parseSteelGrade(steelName, grid.grade.steel)) {
+        std::cerr << "Error: Unknown steel grade '" << steelName << "' (expected HRB335, HRB400 or HRB500)\n";
+        return 2;
+    }
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (threads > 0) ownPool.reset(new WorkStealingPool(threads));
+    WorkStealingPool& pool = ownPool ? *ownPool : sharedDesignPool();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string errorMessage;
+    if (!buildDesignSurrogate(grid, path, pool, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << grid.cellCount() << " designs tabulated in " << seconds << " s on " << pool.size() << " threads ("
+        << grid.cellCount() * sizeof(SurrogateCell) / 1024 << " KiB)\n";
+    return 0;
+}
+
+// Usage: --surrogate-check <table.rbsg> [--samples N] [--seed S] [--max-error percent] [--threads N]
+// Fails when the 95th percentile of the cost error exceeds --max-error (default 5 %).
+inline int runSurrogateCheckCommandLine(int argc, char* argv[]) {
+    std::string path;
+    size_t samples = 10000;
+    uint64_t seed = 1;
+    double maxError = 5.0;
+    unsigned threads = 0;
+    bool badArgument = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc) samples = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = (uint64_t)std::atoll(argv[++i]);
+        else if (arg == "--max-error" && i + 1 < argc) maxError = std::atof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (path.empty()) path = arg;
+        else badArgument = true;
+    }
+    if (path.empty() || badArgument || samples == 0) {
+        std::cerr << "Usage: --surrogate-check <table.rbsg> [--samples N] [--seed S] [--max-error percent] [--threads N]\n";
+        return 2;
+    }
+    DesignSurrogate surrogate;
+    std::string errorMessage;
+    if (!surrogate.open(path, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (threads > 0) ownPool.reset(new WorkStealingPool(threads));
+    WorkStealingPool& pool = ownPool ? *ownPool : sharedDesignPool();
+
+    SurrogateCheckResult result;
+    checkDesignSurrogate(surrogate, samples, seed, pool, result);
+    std::cout << result.samples << " random designs: " << result.feasibilityMismatches << " disagree on feasibility, "
+        << result.layoutMatches << " of " << result.compared << " feasible ones have the exact bar layout\n";
+    std::cout << "Cost error: mean " << result.meanError * 100 << " %, 95th percentile " << result.p95Error * 100
+        << " %, maximum " << result.maxError * 100 << " %\n";
+    std::cout << "Preview " << result.previewSeconds * 1e9 / result.samples << " ns, exact design "
+        << result.exactSeconds * 1e6 / result.samples << " us per beam on " << pool.size() << " threads\n";
+    if (result.p95Error * 100 > maxError) {
+        std::cerr << "Error: 95th percentile cost error above " << maxError << " %\n";
+        return 1;
+    }
+    return 0;
+}
+
+
+#endif // DESIGNSURROGATE_H
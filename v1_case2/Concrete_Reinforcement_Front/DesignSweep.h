@@ -0,0 +1,328 @@
+#pragma once
+
+#ifndef DESIGNSWEEP_H
+#define DESIGNSWEEP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "RebarCalc.h"
+#include "DesignPipeline.h"
+#include "ThreadPool.h"
+
+// --- Sweep Axes ---
+// runDesign inputs that can be swept. Units follow the GUI fields (mm, load in kN).
+enum class SweepAxis
+{
+    Span,
+    Width,
+    Height,
+    Load
+};
+
+const char* sweepAxisName(SweepAxis axis);
+
+struct SweepAxisRange
+{
+    SweepAxis axis = SweepAxis::Width;
+    double minValue = 0;
+    double maxValue = 0;
+    int steps = 500;
+
+    double valueAt(int i) const { return steps > 1 ? minValue + (maxValue - minValue) * i / (steps - 1) : minValue; }
+};
+
+// --- Sweep Definition ---
+// The design the sweep is taken around; the two swept inputs replace its own values.
+struct DesignSweepSpec
+{
+    double span = 0;
+    double width = 0;
+    double height = 0;
+    double load = 0;
+    double wheelSpan = 0; // m
+    double girderSpacing = 0;
+    SweepAxisRange x;
+    SweepAxisRange y;
+    bool zonedStirrups = false;
+
+    bool isValid() const;
+    double baseValue(SweepAxis axis) const;
+};
+
+// --- Sweep Results ---
+// One cell per grid point, row-major, row 0 at y.minValue. Workers write a cell's cost
+// and diameter before publishing its state, so a reader that sees a finished state can
+// use the other fields while the sweep is still running.
+struct DesignSweepGrid
+{
+    enum CellState : uint8_t { Pending = 0, Feasible = 1, Infeasible = 2 };
+
+    int cols = 0;
+    int rows = 0;
+    int coarsestStride = 1; // stride of the first pass, see runDesignSweep
+    std::vector<float> cost;
+    std::vector<uint8_t> diameter;
+    std::unique_ptr<std::atomic<uint8_t>[]> state;
+    std::atomic<size_t> completed{ 0 };
+    std::atomic<size_t> feasible{ 0 };
+
+    void reset(int columnCount, int rowCount);
+    size_t cellCount() const { return (size_t)cols * rows; }
+    CellState cellState(size_t index) const { return (CellState)state[index].load(std::memory_order_acquire); }
+    // Nearest finished cell of a coarser pass for a cell that is still pending, so a
+    // partial sweep can be drawn as a blocky preview. Returns false if there is none yet.
+    bool previewCell(int col, int row, size_t& index) const;
+};
+
+// Designs every grid point on the pool. The grid is filled coarse to fine: the first pass
+// designs every coarsestStride-th point in both directions and each following pass halves
+// the stride, so the whole range is covered at low resolution within the first few hundred
+// designs. Returns false if the spec is invalid or `cancelFlag` was set.
+bool runDesignSweep(const DesignSweepSpec& spec, DesignSweepGrid& grid, WorkStealingPool& pool,
+    const std::atomic<bool>* cancelFlag = nullptr);
+
+// --- Heatmap Drawing ---
+enum class SweepLayer
+{
+    Cost,
+    Diameter
+};
+
+const cv::Size SWEEP_IMAGE_SIZE(1000, 620);
+
+// Draws the grid (finished cells, previews for pending ones) with axes, a legend and a
+// cross at the design the sweep was taken around. Takes the same CV_8UC3 / CV_8UC4
+// buffers as RebarCalc::drawCrossSection.
+void drawSweepHeatmap(const DesignSweepSpec& spec, const DesignSweepGrid& grid, SweepLayer layer, cv::Mat& image);
+// Grid cell under a pixel of the heatmap image; false outside the plot area.
+bool sweepCellAtPixel(const DesignSweepGrid& grid, double px, double py, int& col, int& row);
+
+
+// --- Function Implementations ---
+
+namespace sweep_detail {
+    // Plot area inside SWEEP_IMAGE_SIZE.
+    constexpr int PLOT_LEFT = 110, PLOT_TOP = 30, PLOT_RIGHT = 830, PLOT_BOTTOM = 540;
+
+    // Viridis, sampled at five stops and interpolated linearly (BGR).
+    inline cv::Scalar costColor(double t) {
+        static const double stops[5][3] = { { 84, 1, 68 }, { 139, 82, 59 }, { 140, 145, 33 }, { 98, 201, 94 }, { 37, 231, 253 } };
+        t = std::max(0.0, std::min(1.0, t)) * 4.0;
+        int i = std::min(3, (int)t);
+        double f = t - i;
+        return cv::Scalar(stops[i][0] + f * (stops[i + 1][0] - stops[i][0]), stops[i][1] + f * (stops[i + 1][1] - stops[i][1]),
+            stops[i][2] + f * (stops[i + 1][2] - stops[i][2]), 255);
+    }
+
+    inline std::string formatValue(double value) {
+        char text[32];
+        snprintf(text, sizeof(text), std::fabs(value) >= 1e6 ? "%.3g" : "%.0f", value);
+        return text;
+    }
+}
+
+inline const char* sweepAxisName(SweepAxis axis) {
+    switch (axis) {
+    case SweepAxis::Span: return "Span (mm)";
+    case SweepAxis::Width: return "Width (mm)";
+    case SweepAxis::Height: return "Height (mm)";
+    case SweepAxis::Load: return "Vehicle Load (kN)";
+    }
+    return "";
+}
+
+inline bool DesignSweepSpec::isValid() const {
+    if (x.axis == y.axis || x.steps < 1 || y.steps < 1) return false;
+    if (x.minValue <= 0 || y.minValue <= 0 || x.maxValue < x.minValue || y.maxValue < y.minValue) return false;
+    return girderSpacing > 0;
+}
+
+inline double DesignSweepSpec::baseValue(SweepAxis axis) const {
+    switch (axis) {
+    case SweepAxis::Span: return span;
+    case SweepAxis::Width: return width;
+    case SweepAxis::Height: return height;
+    case SweepAxis::Load: return load;
+    }
+    return 0;
+}
+
+inline void DesignSweepGrid::reset(int columnCount, int rowCount) {
+    cols = columnCount;
+    rows = rowCount;
+    cost.assign(cellCount(), 0.0f);
+    diameter.assign(cellCount(), 0);
+    state.reset(new std::atomic<uint8_t>[cellCount()]);
+    for (size_t i = 0; i < cellCount(); ++i) state[i].store(Pending, std::memory_order_relaxed);
+    completed = 0;
+    feasible = 0;
+}
+
+inline bool DesignSweepGrid::previewCell(int col, int row, size_t& index) const {
+    for (int stride = 1; stride <= coarsestStride; stride *= 2) {
+        index = (size_t)(row - row % stride) * cols + (col - col % stride);
+        if (cellState(index) != Pending) return true;
+    }
+    return false;
+}
+
+inline bool runDesignSweep(const DesignSweepSpec& spec, DesignSweepGrid& grid, WorkStealingPool& pool, const std::atomic<bool>* cancelFlag) {
+    if (!spec.isValid()) return false;
+    grid.reset(spec.x.steps, spec.y.steps);
+    // Aim for a first pass of about 16 x 16 points.
+    int stride = 1;
+    while (stride < 64 && stride * 16 < std::max(grid.cols, grid.rows)) stride *= 2;
+    grid.coarsestStride = stride;
+
+    auto isCancelled = [cancelFlag]() { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); };
+    for (int s = stride; s >= 1; s /= 2) {
+        if (isCancelled()) return false;
+        size_t passRows = (size_t)(grid.rows + s - 1) / s;
+        parallelFor(pool, 0, passRows, 1, [&](size_t begin, size_t end) {
+            // Cells of a row differ in the x value only, so the pipeline redoes just the
+            // stages that depend on that input.
+            DesignPipeline pipeline;
+            DesignInputs inputs;
+            inputs.wheelSpan = spec.wheelSpan;
+            inputs.girderSpacing = spec.girderSpacing;
+            inputs.zonedStirrups = spec.zonedStirrups;
+            for (size_t pr = begin; pr < end && !isCancelled(); ++pr) {
+                int row = (int)pr * s;
+                // Indexed by SweepAxis, which follows the runDesign argument order.
+                double values[4] = { spec.span, spec.width, spec.height, spec.load };
+                values[(int)spec.y.axis] = spec.y.valueAt(row);
+                for (int col = 0; col < grid.cols; col += s) {
+                    // Points on the coarser grid were designed by an earlier pass.
+                    if (s < stride && row % (2 * s) == 0 && col % (2 * s) == 0) continue;
+                    values[(int)spec.x.axis] = spec.x.valueAt(col);
+                    inputs.span = values[0];
+                    inputs.width = values[1];
+                    inputs.height = values[2];
+                    inputs.vehicleLoad = values[3];
+                    bool ok = pipeline.run(inputs);
+                    size_t index = (size_t)row * grid.cols + col;
+                    const RebarDesign& design = pipeline.getDesignResults();
+                    grid.cost[index] = (float)design.totalCost;
+                    grid.diameter[index] = (uint8_t)design.flexureRebarDiameter;
+                    grid.state[index].store(ok ? DesignSweepGrid::Feasible : DesignSweepGrid::Infeasible, std::memory_order_release);
+                    grid.completed.fetch_add(1, std::memory_order_relaxed);
+                    if (ok) grid.feasible.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    return !isCancelled();
+}
+
+inline bool sweepCellAtPixel(const DesignSweepGrid& grid, double px, double py, int& col, int& row) {
+    using namespace sweep_detail;
+    if (grid.cols <= 0 || grid.rows <= 0 || px < PLOT_LEFT || px >= PLOT_RIGHT || py < PLOT_TOP || py >= PLOT_BOTTOM) return false;
+    col = std::min(grid.cols - 1, (int)((px - PLOT_LEFT) * grid.cols / (PLOT_RIGHT - PLOT_LEFT)));
+    row = std::min(grid.rows - 1, (int)((PLOT_BOTTOM - py) * grid.rows / (PLOT_BOTTOM - PLOT_TOP)));
+    return true;
+}
+
+inline void drawSweepHeatmap(const DesignSweepSpec& spec, const DesignSweepGrid& grid, SweepLayer layer, cv::Mat& image) {
+    using namespace sweep_detail;
+    int img_w = SWEEP_IMAGE_SIZE.width, img_h = SWEEP_IMAGE_SIZE.height;
+    if (image.size() != SWEEP_IMAGE_SIZE || (image.type() != CV_8UC3 && image.type() != CV_8UC4)) image.create(img_h, img_w, CV_8UC3);
+    image.setTo(cv::Scalar(255, 255, 255, 255));
+    if (grid.cols <= 0 || grid.rows <= 0) return;
+
+    // Colour scale over the finished feasible cells.
+    float minCost = std::numeric_limits<float>::max(), maxCost = 0;
+    for (size_t i = 0; i < grid.cellCount(); ++i) {
+        if (grid.cellState(i) != DesignSweepGrid::Feasible) continue;
+        minCost = std::min(minCost, grid.cost[i]);
+        maxCost = std::max(maxCost, grid.cost[i]);
+    }
+    double costRange = maxCost > minCost ? maxCost - minCost : 1.0;
+
+    static const RebarCalc palette;
+    const cv::Scalar pendingColor(255, 255, 255, 255), infeasibleColor(70, 70, 70, 255);
+
+    // Every plot pixel looks up its cell, or the preview of a cell that is still pending.
+    int channels = image.channels();
+    int plotW = PLOT_RIGHT - PLOT_LEFT, plotH = PLOT_BOTTOM - PLOT_TOP;
+    for (int py = 0; py < plotH; ++py) {
+        int row = std::min(grid.rows - 1, (int)((double)(plotH - 1 - py) * grid.rows / plotH));
+        unsigned char* pixel = image.ptr(PLOT_TOP + py) + (size_t)PLOT_LEFT * channels;
+        for (int px = 0; px < plotW; ++px, pixel += channels) {
+            int col = std::min(grid.cols - 1, (int)((double)px * grid.cols / plotW));
+            size_t index;
+            cv::Scalar color = pendingColor;
+            if (grid.previewCell(col, row, index)) {
+                if (grid.cellState(index) == DesignSweepGrid::Infeasible) color = infeasibleColor;
+                else if (layer == SweepLayer::Cost) color = costColor((grid.cost[index] - minCost) / costRange);
+                else color = palette.getRebarColor(grid.diameter[index]);
+            }
+            pixel[0] = (unsigned char)color[0];
+            pixel[1] = (unsigned char)color[1];
+            pixel[2] = (unsigned char)color[2];
+            if (channels == 4) pixel[3] = 255;
+        }
+    }
+    cv::rectangle(image, cv::Point(PLOT_LEFT - 1, PLOT_TOP - 1), cv::Point(PLOT_RIGHT, PLOT_BOTTOM), cv::Scalar(0, 0, 0, 255), 1);
+
+    // Axes: end and middle values along each side.
+    const cv::Scalar black(0, 0, 0, 255);
+    for (int k = 0; k <= 2; ++k) {
+        double t = k / 2.0;
+        int x = PLOT_LEFT + (int)(t * (plotW - 1));
+        int y = PLOT_BOTTOM - (int)(t * (plotH - 1));
+        cv::line(image, cv::Point(x, PLOT_BOTTOM), cv::Point(x, PLOT_BOTTOM + 6), black, 1);
+        cv::putText(image, formatValue(spec.x.minValue + t * (spec.x.maxValue - spec.x.minValue)), cv::Point(x - 25, PLOT_BOTTOM + 24),
+            cv::FONT_HERSHEY_SIMPLEX, 0.5, black, 1);
+        cv::line(image, cv::Point(PLOT_LEFT - 6, y), cv::Point(PLOT_LEFT, y), black, 1);
+        cv::putText(image, formatValue(spec.y.minValue + t * (spec.y.maxValue - spec.y.minValue)), cv::Point(10, y + 5),
+            cv::FONT_HERSHEY_SIMPLEX, 0.5, black, 1);
+    }
+    cv::putText(image, sweepAxisName(spec.x.axis), cv::Point(PLOT_LEFT + plotW / 2 - 60, PLOT_BOTTOM + 55), cv::FONT_HERSHEY_SIMPLEX, 0.6, black, 1);
+    cv::putText(image, sweepAxisName(spec.y.axis), cv::Point(10, PLOT_TOP - 10), cv::FONT_HERSHEY_SIMPLEX, 0.6, black, 1);
+
+    // The design the sweep was taken around.
+    double bx = spec.baseValue(spec.x.axis), by = spec.baseValue(spec.y.axis);
+    if (bx >= spec.x.minValue && bx <= spec.x.maxValue && by >= spec.y.minValue && by <= spec.y.maxValue) {
+        double tx = spec.x.maxValue > spec.x.minValue ? (bx - spec.x.minValue) / (spec.x.maxValue - spec.x.minValue) : 0.5;
+        double ty = spec.y.maxValue > spec.y.minValue ? (by - spec.y.minValue) / (spec.y.maxValue - spec.y.minValue) : 0.5;
+        cv::Point centre(PLOT_LEFT + (int)(tx * (plotW - 1)), PLOT_BOTTOM - (int)(ty * (plotH - 1)));
+        cv::line(image, cv::Point(centre.x - 8, centre.y), cv::Point(centre.x + 8, centre.y), cv::Scalar(0, 0, 255, 255), 2);
+        cv::line(image, cv::Point(centre.x, centre.y - 8), cv::Point(centre.x, centre.y + 8), cv::Scalar(0, 0, 255, 255), 2);
+    }
+
+    // Legend.
+    int lx = PLOT_RIGHT + 30;
+    if (layer == SweepLayer::Cost) {
+        cv::putText(image, "Total cost", cv::Point(lx, PLOT_TOP - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, black, 1);
+        int barH = 300;
+        for (int i = 0; i < barH; ++i) {
+            cv::line(image, cv::Point(lx, PLOT_TOP + i), cv::Point(lx + 20, PLOT_TOP + i), costColor(1.0 - (double)i / (barH - 1)), 1);
+        }
+        if (maxCost >= minCost) {
+            cv::putText(image, formatValue(maxCost), cv::Point(lx + 28, PLOT_TOP + 10), cv::FONT_HERSHEY_SIMPLEX, 0.45, black, 1);
+            cv::putText(image, formatValue(minCost), cv::Point(lx + 28, PLOT_TOP + barH), cv::FONT_HERSHEY_SIMPLEX, 0.45, black, 1);
+        }
+    }
+    else {
+        cv::putText(image, "Flexural bar", cv::Point(lx, PLOT_TOP - 10), cv::FONT_HERSHEY_SIMPLEX, 0.5, black, 1);
+        for (int i = 0; i < STANDARD_REBAR_COUNT; ++i) {
+            int y = PLOT_TOP + i * 28;
+            cv::rectangle(image, cv::Point(lx, y), cv::Point(lx + 20, y + 20), palette.getRebarColor(STANDARD_REBAR_DIAMETERS[i]), -1);
+            cv::putText(image, "d" + std::to_string((int)STANDARD_REBAR_DIAMETERS[i]), cv::Point(lx + 28, y + 15), cv::FONT_HERSHEY_SIMPLEX, 0.45, black, 1);
+        }
+    }
+    int iy = PLOT_TOP + 330;
+    cv::rectangle(image, cv::Point(lx, iy), cv::Point(lx + 20, iy + 20), infeasibleColor, -1);
+    cv::putText(image, "Infeasible", cv::Point(lx + 28, iy + 15), cv::FONT_HERSHEY_SIMPLEX, 0.45, black, 1);
+}
+
+
+#endif // DESIGNSWEEP_H
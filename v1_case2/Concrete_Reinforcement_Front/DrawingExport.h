@@ -0,0 +1,621 @@
+#pragma once
+
+#ifndef DRAWINGEXPORT_H
+#define DRAWINGEXPORT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <opencv2/opencv.hpp>
+#include "RebarCalc.h"
+
+// --- Drawing Primitives ---
+// The cross-section and longitudinal drawings are described once, in millimetres with the
+// origin at the top-left corner of the beam and y pointing down, and replayed into a sink:
+// SVG or DXF files (streamed straight to disk) or raster tiles for on-screen zoom.
+struct DrawingStyle
+{
+    cv::Scalar stroke = cv::Scalar(0, 0, 0, 255); // BGR, like the OpenCV drawings
+    double strokeWidth = 0;                       // mm; 0 is a hairline, < 0 draws no outline
+    bool filled = false;
+    cv::Scalar fill = cv::Scalar(255, 255, 255, 255);
+};
+
+class DrawingSink
+{
+public:
+    virtual ~DrawingSink() {}
+    // Called once before any primitive with the extent of the drawing (mm).
+    virtual void begin(double minX, double minY, double maxX, double maxY) = 0;
+    virtual void line(double x1, double y1, double x2, double y2, const DrawingStyle& style) = 0;
+    virtual void rect(double x, double y, double w, double h, const DrawingStyle& style) = 0;
+    virtual void circle(double cx, double cy, double r, const DrawingStyle& style) = 0;
+    // (x, y) is the left end of the baseline; height is the cap height in mm.
+    virtual void text(double x, double y, const std::string& str, double height, const cv::Scalar& color) = 0;
+    virtual void end() = 0;
+};
+
+// --- Viewport ---
+// Maps drawing millimetres to pixels: px = originX + x * scaleX (likewise for y). The
+// longitudinal view uses a larger vertical than horizontal scale, as on screen.
+struct DrawingViewport
+{
+    double originX = 0;
+    double originY = 0;
+    double scaleX = 1;
+    double scaleY = 1;
+    int width = 0;
+    int height = 0;
+
+    double left() const { return -originX / scaleX; }
+    double right() const { return (width - originX) / scaleX; }
+    double top() const { return -originY / scaleY; }
+    double bottom() const { return (height - originY) / scaleY; }
+};
+
+// Below this pitch (in pixels) individual stirrups are replaced by a shaded band.
+constexpr double MIN_STIRRUP_PITCH_PX = 4.0;
+
+// Emit the drawings of the design currently held by `calc`. With a viewport, only what
+// falls inside it is emitted and stirrups are drawn at a level of detail that suits its scale.
+void emitCrossSectionDrawing(const RebarCalc& calc, DrawingSink& sink);
+void emitLongitudinalDrawing(const RebarCalc& calc, DrawingSink& sink, const DrawingViewport* viewport = nullptr);
+
+// The viewports used by drawCrossSection / drawLongitudinalSection, so that tiles line up
+// with the standard pictures.
+DrawingViewport crossSectionFitViewport(const RebarCalc& calc);
+DrawingViewport longitudinalFitViewport(const RebarCalc& calc);
+
+// Renders one viewport of a drawing into `tile` (CV_8UC3 or CV_8UC4, viewport-sized).
+void renderDrawingTile(const RebarCalc& calc, bool crossSection, const DrawingViewport& viewport, cv::Mat& tile);
+
+// Writes the drawing as SVG or DXF, chosen by the extension of `path`.
+bool exportDrawing(const RebarCalc& calc, bool crossSection, const std::string& path, std::string& errorMessage);
+
+// --- SVG Sink ---
+class SvgDrawingSink : public DrawingSink
+{
+public:
+    explicit SvgDrawingSink(std::ostream& out) : out(out) {}
+    void begin(double minX, double minY, double maxX, double maxY) override;
+    void line(double x1, double y1, double x2, double y2, const DrawingStyle& style) override;
+    void rect(double x, double y, double w, double h, const DrawingStyle& style) override;
+    void circle(double cx, double cy, double r, const DrawingStyle& style) override;
+    void text(double x, double y, const std::string& str, double height, const cv::Scalar& color) override;
+    void end() override;
+
+private:
+    std::ostream& out;
+    char buffer[512];
+
+    static std::string color(const cv::Scalar& c);
+    std::string styleAttributes(const DrawingStyle& style) const;
+};
+
+// --- DXF Sink ---
+// AutoCAD R12 ASCII DXF: LINE, CIRCLE, SOLID and TEXT entities on per-colour layers.
+// DXF y points up, so the drawing is mirrored about the x axis.
+class DxfDrawingSink : public DrawingSink
+{
+public:
+    explicit DxfDrawingSink(std::ostream& out) : out(out) {}
+    void begin(double minX, double minY, double maxX, double maxY) override;
+    void line(double x1, double y1, double x2, double y2, const DrawingStyle& style) override;
+    void rect(double x, double y, double w, double h, const DrawingStyle& style) override;
+    void circle(double cx, double cy, double r, const DrawingStyle& style) override;
+    void text(double x, double y, const std::string& str, double height, const cv::Scalar& color) override;
+    void end() override;
+
+private:
+    std::ostream& out;
+    char buffer[256];
+
+    static int aciColor(const cv::Scalar& c);
+    void entity(const char* type, const cv::Scalar& c);
+    void point(int code, double x, double y);
+};
+
+// --- Raster Sink ---
+// Draws into a viewport-sized Mat, skipping every primitive whose bounds miss it.
+class RasterDrawingSink : public DrawingSink
+{
+public:
+    RasterDrawingSink(cv::Mat& image, const DrawingViewport& viewport) : image(image), vp(viewport) {}
+    void begin(double, double, double, double) override { image.setTo(cv::Scalar(255, 255, 255, 255)); }
+    void line(double x1, double y1, double x2, double y2, const DrawingStyle& style) override;
+    void rect(double x, double y, double w, double h, const DrawingStyle& style) override;
+    void circle(double cx, double cy, double r, const DrawingStyle& style) override;
+    void text(double x, double y, const std::string& str, double height, const cv::Scalar& color) override;
+    void end() override {}
+
+    int culledCount() const { return culled; }
+
+private:
+    cv::Mat& image;
+    DrawingViewport vp;
+    int culled = 0;
+
+    int thickness(double widthMm) const;
+    bool visible(double x0, double y0, double x1, double y1, double marginPx) const;
+    cv::Point toPixel(double x, double y) const {
+        return cv::Point((int)std::lround(vp.originX + x * vp.scaleX), (int)std::lround(vp.originY + y * vp.scaleY));
+    }
+};
+
+
+// --- Function Implementations ---
+
+inline void emitCrossSectionDrawing(const RebarCalc& calc, DrawingSink& sink) {
+    const BridgeParams& params = calc.getParams();
+    const RebarDesign& design = calc.getDesignResults();
+    double w = params.width, h = params.height;
+    double textHeight = std::max(w, h) * 0.03;
+
+    if (!design.designPossible || w <= 0 || h <= 0) {
+        double size = std::max(1000.0, std::max(w, h));
+        sink.begin(0, 0, size, size * 0.3);
+        sink.text(size * 0.05, size * 0.12, "DESIGN FAILED", size * 0.05, cv::Scalar(0, 0, 255, 255));
+        sink.text(size * 0.05, size * 0.2, design.errorMessage, size * 0.02, cv::Scalar(0, 0, 0, 255));
+        sink.end();
+        return;
+    }
+
+    sink.begin(-8 * textHeight, -3 * textHeight, w + 14 * textHeight, h + textHeight);
+
+    DrawingStyle concrete;
+    concrete.strokeWidth = -1;
+    concrete.filled = true;
+    concrete.fill = cv::Scalar(211, 211, 211, 255);
+    sink.rect(0, 0, w, h, concrete);
+
+    // The drawn stirrup and bar positions use the 8 mm stirrup assumed by the flexural design.
+    DrawingStyle stirrup;
+    stirrup.strokeWidth = design.stirrupDiameter > 0 ? design.stirrupDiameter : 8.0;
+    sink.rect(CONCRETE_COVER, CONCRETE_COVER, w - 2 * CONCRETE_COVER, h - 2 * CONCRETE_COVER, stirrup);
+
+    double d = design.flexureRebarDiameter;
+    double r = d / 2.0;
+    double xStart = CONCRETE_COVER + 8.0 + r;
+    double xEnd = w - CONCRETE_COVER - 8.0 - r;
+    cv::Scalar black(0, 0, 0, 255);
+
+    DrawingStyle bar;
+    bar.strokeWidth = -1;
+    bar.filled = true;
+    bar.fill = calc.getRebarColor(d);
+    DrawingStyle bentBar = bar;
+    bentBar.fill = cv::Scalar(0, 0, 255, 255);
+
+    int straightBarsInRow1 = design.rebarCountRow1 - design.bentRebarCount;
+    int barsInRow2 = (design.rebarRows > 1) ? design.rebarCountRow2 : 0;
+    int bottomRowCount = std::max(straightBarsInRow1, barsInRow2);
+    int secondRowCount = std::min(straightBarsInRow1, barsInRow2);
+    double yBottomRow = h - CONCRETE_COVER - 8.0 - r;
+    double ySecondRow = yBottomRow - 2 * r - 25.0;
+    double yTop = CONCRETE_COVER + 8.0 + r;
+    std::string barName = " x d" + std::to_string((int)d);
+
+    auto barRow = [&](int count, double y, const DrawingStyle& style, const std::string& label) {
+        for (int i = 0; i < count; ++i) {
+            double t = (count > 1) ? (double)i / (count - 1) : 0.5;
+            sink.circle(xStart + t * (xEnd - xStart), y, r, style);
+        }
+        sink.text(w + textHeight, y + textHeight / 2, std::to_string(count) + label, textHeight, black);
+    };
+    if (design.mixedDiameters) {
+        // Each bar at its own size and colour, the rows as designed.
+        double yRowBase = h - CONCRETE_COVER - 8.0;
+        for (int row = 0; row < design.rebarRows; ++row) {
+            double diameters[64];
+            int skip = (row == 0) ? design.bentRebarCount : 0;
+            int count = flexuralRowBars(design, row, skip, diameters, 64);
+            for (int i = 0; i < count; ++i) {
+                double t = (count > 1) ? (double)i / (count - 1) : 0.5;
+                DrawingStyle rowBar = bar;
+                rowBar.fill = calc.getRebarColor(diameters[i]);
+                sink.circle(xStart + t * (xEnd - xStart), yRowBase - diameters[i] / 2.0, diameters[i] / 2.0, rowBar);
+            }
+            double yText = yRowBase - design.rowDiameters[row][0] / 2.0;
+            if (count > 0) sink.text(w + textHeight, yText + textHeight / 2, flexuralRowText(design, row, skip), textHeight, black);
+            yRowBase -= design.rowDiameters[row][0] + 25.0;
+        }
+    }
+    else {
+        if (bottomRowCount > 0) barRow(bottomRowCount, yBottomRow, bar, barName);
+        if (secondRowCount > 0) barRow(secondRowCount, ySecondRow, bar, barName);
+    }
+    if (design.topRebarCount > 0) {
+        // Hogging bars of a continuous girder, as in the section over a support.
+        double rTop = design.topRebarDiameter / 2.0;
+        DrawingStyle topBar = bar;
+        topBar.fill = calc.getRebarColor(design.topRebarDiameter);
+        double yTopBars = CONCRETE_COVER + 8.0 + rTop;
+        double xTopStart = CONCRETE_COVER + 8.0 + rTop, xTopEnd = w - CONCRETE_COVER - 8.0 - rTop;
+        int topRow1 = (design.topRebarRows > 1) ? (design.topRebarCount + 1) / 2 : design.topRebarCount;
+        for (int row = 0, count = topRow1; row < design.topRebarRows; ++row, count = design.topRebarCount - topRow1) {
+            for (int i = 0; i < count; ++i) {
+                double t = (count > 1) ? (double)i / (count - 1) : 0.5;
+                sink.circle(xTopStart + t * (xTopEnd - xTopStart), yTopBars, rTop, topBar);
+            }
+            sink.text(w + textHeight, yTopBars + textHeight / 2, std::to_string(count) + " x d" +
+                std::to_string((int)design.topRebarDiameter) + " (Top, supports)", textHeight, black);
+            yTopBars += 2 * rTop + 25.0;
+        }
+        yTop = yTopBars - rTop + r;
+    }
+    if (design.bentRebarsUsed && design.bentRebarCount > 0) barRow(design.bentRebarCount, yTop, bentBar, barName + " (Bent)");
+
+    sink.text(0, -textHeight, std::to_string((int)w) + "mm", textHeight * 1.5, black);
+    sink.text(-7.5 * textHeight, h / 2, std::to_string((int)h) + "mm", textHeight * 1.5, black);
+    sink.end();
+}
+
+inline void emitLongitudinalDrawing(const RebarCalc& calc, DrawingSink& sink, const DrawingViewport* viewport) {
+    const BridgeParams& params = calc.getParams();
+    const RebarDesign& design = calc.getDesignResults();
+    double span = params.span, h = params.height;
+    if (span <= 0 || h <= 0) {
+        sink.begin(0, 0, 1, 1);
+        sink.end();
+        return;
+    }
+    if (!design.designPossible) {
+        sink.begin(0, 0, span, h);
+        sink.text(span * 0.05, h * 0.4, "DESIGN FAILED", h * 0.12, cv::Scalar(0, 0, 255, 255));
+        sink.text(span * 0.05, h * 0.6, design.errorMessage, h * 0.06, cv::Scalar(0, 0, 0, 255));
+        sink.end();
+        return;
+    }
+
+    // Continuous girders have support symbols below the beam.
+    sink.begin(0, 0, span, params.spanCount > 1 ? h * 1.3 : h);
+
+    DrawingStyle concrete;
+    concrete.strokeWidth = 0;
+    concrete.filled = true;
+    concrete.fill = cv::Scalar(211, 211, 211, 255);
+    sink.rect(0, 0, span, h, concrete);
+
+    DrawingStyle stirrup;
+    stirrup.stroke = cv::Scalar(128, 128, 128, 255);
+    stirrup.strokeWidth = design.stirrupDiameter;
+    StirrupZone zones[MAX_STIRRUP_ZONES];
+    int zoneCount = calc.getStirrupZones(zones);
+    for (int z = 0; z < zoneCount; ++z) {
+        // Stirrups at start + k * s inside the zone; the first zone starts a spacing in from the support.
+        double start = zones[z].start, s = zones[z].spacing;
+        if (s <= 0) continue;
+        long first = (z == 0) ? 1 : 0, last = (long)std::floor((zones[z].end - start - 1e-9) / s);
+        if (last < first) continue;
+        if (viewport && s * viewport->scaleX < MIN_STIRRUP_PITCH_PX) {
+            // Too dense to tell apart at this scale: one shaded band stands for the zone.
+            DrawingStyle band;
+            band.strokeWidth = -1;
+            band.filled = true;
+            band.fill = cv::Scalar(170, 170, 170, 255);
+            sink.rect(start + first * s, 0, (last - first) * s, h, band);
+        }
+        else {
+            // Only the stirrups inside the visible range are emitted.
+            if (viewport) {
+                first = std::max(first, (long)std::ceil((viewport->left() - start) / s));
+                last = std::min(last, (long)std::floor((viewport->right() - start) / s));
+            }
+            for (long k = first; k <= last; ++k) sink.line(start + k * s, 0, start + k * s, h, stirrup);
+        }
+    }
+
+    double d = design.flexureRebarDiameter;
+    double yRow1 = h - CONCRETE_COVER - 8.0 - d / 2.0;
+    double yRow2 = yRow1 - d - 25.0;
+    double yTop = CONCRETE_COVER + 8.0;
+    DrawingStyle bar;
+    bar.stroke = calc.getRebarColor(d);
+    bar.strokeWidth = d;
+    DrawingStyle bentBar = bar;
+    bentBar.stroke = cv::Scalar(0, 0, 255, 255);
+
+    if (design.rebarCountRow2 > 0) sink.line(0, yRow2, span, yRow2, bar);
+
+    int bentCount = design.bentRebarsUsed ? design.bentRebarCount : 0;
+    if (design.rebarCountRow1 - bentCount > 0) sink.line(0, yRow1, span, yRow1, bar);
+
+    int spanCount = girderSpanCount(params);
+    for (int j = 0; j < spanCount && bentCount > 0; ++j) {
+        // Bent up at 45 degrees from the quarter points of each span to the top of the section.
+        double rise = yRow1 - yTop;
+        double left = supportPosition(params, j), right = supportPosition(params, j + 1);
+        double leftBend = left + (right - left) / 4, rightBend = left + (right - left) * 3 / 4;
+        sink.line(left, yTop, leftBend - rise, yTop, bentBar);
+        sink.line(leftBend - rise, yTop, leftBend, yRow1, bentBar);
+        sink.line(leftBend, yRow1, rightBend, yRow1, bentBar);
+        sink.line(rightBend, yRow1, rightBend + rise, yTop, bentBar);
+        sink.line(rightBend + rise, yTop, right, yTop, bentBar);
+    }
+
+    if (params.spanCount > 1) {
+        // Top bars over the interior supports, and a support symbol under every support.
+        if (design.topRebarCount > 0) {
+            DrawingStyle topBar;
+            topBar.stroke = calc.getRebarColor(design.topRebarDiameter);
+            topBar.strokeWidth = design.topRebarDiameter;
+            double yTopRow1 = CONCRETE_COVER + 8.0 + design.topRebarDiameter / 2.0;
+            double yTopRow2 = yTopRow1 + design.topRebarDiameter + 25.0;
+            for (int i = 1; i < spanCount; ++i) {
+                double start, end;
+                hoggingBarExtent(params, i, start, end);
+                sink.line(start, yTopRow1, end, yTopRow1, topBar);
+                if (design.topRebarRows > 1) sink.line(start, yTopRow2, end, yTopRow2, topBar);
+            }
+        }
+        DrawingStyle support;
+        support.strokeWidth = h * 0.02;
+        for (int i = 0; i <= spanCount; ++i) {
+            double x = supportPosition(params, i);
+            sink.line(x, h, x - h * 0.15, h * 1.25, support);
+            sink.line(x - h * 0.15, h * 1.25, x + h * 0.15, h * 1.25, support);
+            sink.line(x + h * 0.15, h * 1.25, x, h, support);
+        }
+    }
+    sink.end();
+}
+
+inline DrawingViewport crossSectionFitViewport(const RebarCalc& calc) {
+    const BridgeParams& params = calc.getParams();
+    DrawingViewport vp;
+    vp.width = CROSS_SECTION_IMAGE_SIZE.width;
+    vp.height = CROSS_SECTION_IMAGE_SIZE.height;
+    if (params.width <= 0 || params.height <= 0) return vp;
+    double scale = std::min((double)vp.width * 0.8 / params.width, (double)vp.height * 0.8 / params.height);
+    vp.scaleX = vp.scaleY = scale;
+    vp.originX = (vp.width - (int)(params.width * scale)) / 2;
+    vp.originY = (vp.height - (int)(params.height * scale)) / 2;
+    return vp;
+}
+
+inline DrawingViewport longitudinalFitViewport(const RebarCalc& calc) {
+    const BridgeParams& params = calc.getParams();
+    DrawingViewport vp;
+    vp.width = LONGITUDINAL_IMAGE_SIZE.width;
+    vp.height = LONGITUDINAL_IMAGE_SIZE.height;
+    if (params.span <= 0 || params.height <= 0) return vp;
+    vp.scaleX = (vp.width * 0.9) / params.span;
+    vp.scaleY = (vp.height * 0.6) / params.height;
+    vp.originX = (vp.width - (int)(params.span * vp.scaleX)) / 2;
+    vp.originY = (vp.height - (int)(params.height * vp.scaleY)) / 2;
+    return vp;
+}
+
+inline void renderDrawingTile(const RebarCalc& calc, bool crossSection, const DrawingViewport& viewport, cv::Mat& tile) {
+    REBAR_TIME_SCOPE(Drawing);
+    RasterDrawingSink sink(tile, viewport);
+    if (crossSection) emitCrossSectionDrawing(calc, sink);
+    else emitLongitudinalDrawing(calc, sink, &viewport);
+}
+
+inline bool exportDrawing(const RebarCalc& calc, bool crossSection, const std::string& path, std::string& errorMessage) {
+    size_t dot = path.find_last_of('.');
+    std::string ext = (dot == std::string::npos) ? "" : path.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    if (ext != "svg" && ext != "dxf") {
+        errorMessage = "Error: Unsupported drawing format (use .svg or .dxf).";
+        return false;
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        errorMessage = "Error: Cannot open " + path + " for writing.";
+        return false;
+    }
+
+    SvgDrawingSink svg(out);
+    DxfDrawingSink dxf(out);
+    DrawingSink& sink = (ext == "svg") ? (DrawingSink&)svg : (DrawingSink&)dxf;
+    if (crossSection) emitCrossSectionDrawing(calc, sink);
+    else emitLongitudinalDrawing(calc, sink);
+
+    out.flush();
+    if (!out) {
+        errorMessage = "Error: Failed writing " + path + ".";
+        return false;
+    }
+    return true;
+}
+
+// SVG
+
+inline std::string SvgDrawingSink::color(const cv::Scalar& c) {
+    char hex[8];
+    snprintf(hex, sizeof(hex), "#%02x%02x%02x", (int)c[2], (int)c[1], (int)c[0]);
+    return hex;
+}
+
+inline std::string SvgDrawingSink::styleAttributes(const DrawingStyle& style) const {
+    std::string attributes = " fill=\"" + (style.filled ? color(style.fill) : std::string("none")) + "\"";
+    if (style.strokeWidth < 0) return attributes;
+    attributes += " stroke=\"" + color(style.stroke) + "\"";
+    if (style.strokeWidth == 0) return attributes + " stroke-width=\"1\" vector-effect=\"non-scaling-stroke\"";
+    char width[32];
+    snprintf(width, sizeof(width), " stroke-width=\"%g\"", style.strokeWidth);
+    return attributes + width;
+}
+
+inline void SvgDrawingSink::begin(double minX, double minY, double maxX, double maxY) {
+    snprintf(buffer, sizeof(buffer),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%gmm\" height=\"%gmm\" viewBox=\"%g %g %g %g\">\n",
+        maxX - minX, maxY - minY, minX, minY, maxX - minX, maxY - minY);
+    out << buffer;
+}
+
+inline void SvgDrawingSink::line(double x1, double y1, double x2, double y2, const DrawingStyle& style) {
+    DrawingStyle stroke = style;
+    stroke.filled = false;
+    snprintf(buffer, sizeof(buffer), "<line x1=\"%g\" y1=\"%g\" x2=\"%g\" y2=\"%g\"", x1, y1, x2, y2);
+    out << buffer << styleAttributes(stroke) << "/>\n";
+}
+
+inline void SvgDrawingSink::rect(double x, double y, double w, double h, const DrawingStyle& style) {
+    snprintf(buffer, sizeof(buffer), "<rect x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\"", x, y, w, h);
+    out << buffer << styleAttributes(style) << "/>\n";
+}
+
+inline void SvgDrawingSink::circle(double cx, double cy, double r, const DrawingStyle& style) {
+    snprintf(buffer, sizeof(buffer), "<circle cx=\"%g\" cy=\"%g\" r=\"%g\"", cx, cy, r);
+    out << buffer << styleAttributes(style) << "/>\n";
+}
+
+inline void SvgDrawingSink::text(double x, double y, const std::string& str, double height, const cv::Scalar& c) {
+    std::string escaped;
+    for (char ch : str) {
+        if (ch == '&') escaped += "&amp;";
+        else if (ch == '<') escaped += "&lt;";
+        else if (ch == '>') escaped += "&gt;";
+        else if (ch == '\n') escaped += ' ';
+        else escaped += ch;
+    }
+    snprintf(buffer, sizeof(buffer), "<text x=\"%g\" y=\"%g\" font-family=\"sans-serif\" font-size=\"%g\" fill=\"%s\">",
+        x, y, height * 1.4, color(c).c_str());
+    out << buffer << escaped << "</text>\n";
+}
+
+inline void SvgDrawingSink::end() {
+    out << "</svg>\n";
+}
+
+// DXF
+
+inline int DxfDrawingSink::aciColor(const cv::Scalar& c) {
+    // Nearest of the basic AutoCAD colour indices (BGR order, 7 drawn black on paper).
+    static const int palette[9][4] = { { 1, 0, 0, 255 }, { 2, 0, 255, 255 }, { 3, 0, 255, 0 }, { 4, 255, 255, 0 },
+        { 5, 255, 0, 0 }, { 6, 255, 0, 255 }, { 7, 0, 0, 0 }, { 8, 128, 128, 128 }, { 9, 192, 192, 192 } };
+    int best = 7;
+    double bestDistance = 1e30;
+    for (const int* entry : palette) {
+        double db = c[0] - entry[1], dg = c[1] - entry[2], dr = c[2] - entry[3];
+        double distance = db * db + dg * dg + dr * dr;
+        if (distance < bestDistance) { bestDistance = distance; best = entry[0]; }
+    }
+    return best;
+}
+
+inline void DxfDrawingSink::entity(const char* type, const cv::Scalar& c) {
+    int aci = aciColor(c);
+    snprintf(buffer, sizeof(buffer), "0\n%s\n8\nCOLOR_%d\n62\n%d\n", type, aci, aci);
+    out << buffer;
+}
+
+inline void DxfDrawingSink::point(int code, double x, double y) {
+    snprintf(buffer, sizeof(buffer), "%d\n%.4f\n%d\n%.4f\n", code, x, code + 10, -y);
+    out << buffer;
+}
+
+inline void DxfDrawingSink::begin(double minX, double minY, double maxX, double maxY) {
+    out << "0\nSECTION\n2\nHEADER\n9\n$INSUNITS\n70\n4\n9\n$EXTMIN\n";
+    point(10, minX, maxY);
+    out << "9\n$EXTMAX\n";
+    point(10, maxX, minY);
+    out << "0\nENDSEC\n0\nSECTION\n2\nENTITIES\n";
+}
+
+inline void DxfDrawingSink::line(double x1, double y1, double x2, double y2, const DrawingStyle& style) {
+    if (style.strokeWidth < 0) return;
+    entity("LINE", style.stroke);
+    point(10, x1, y1);
+    point(11, x2, y2);
+}
+
+inline void DxfDrawingSink::rect(double x, double y, double w, double h, const DrawingStyle& style) {
+    if (style.filled) {
+        // SOLID corners run 1-2-4-3, i.e. the third and fourth points cross over.
+        entity("SOLID", style.fill);
+        point(10, x, y);
+        point(11, x + w, y);
+        point(12, x, y + h);
+        point(13, x + w, y + h);
+    }
+    if (style.strokeWidth >= 0) {
+        line(x, y, x + w, y, style);
+        line(x + w, y, x + w, y + h, style);
+        line(x + w, y + h, x, y + h, style);
+        line(x, y + h, x, y, style);
+    }
+}
+
+inline void DxfDrawingSink::circle(double cx, double cy, double r, const DrawingStyle& style) {
+    entity("CIRCLE", style.filled ? style.fill : style.stroke);
+    point(10, cx, cy);
+    snprintf(buffer, sizeof(buffer), "40\n%.4f\n", r);
+    out << buffer;
+}
+
+inline void DxfDrawingSink::text(double x, double y, const std::string& str, double height, const cv::Scalar& c) {
+    entity("TEXT", c);
+    point(10, x, y);
+    snprintf(buffer, sizeof(buffer), "40\n%.4f\n1\n", height);
+    std::string singleLine = str;
+    std::replace(singleLine.begin(), singleLine.end(), '\n', ' ');
+    out << buffer << singleLine << "\n";
+}
+
+inline void DxfDrawingSink::end() {
+    out << "0\nENDSEC\n0\nEOF\n";
+}
+
+// Raster
+
+inline int RasterDrawingSink::thickness(double widthMm) const {
+    // Real width once zoomed in far enough, never thinner than one pixel.
+    double px = widthMm * std::min(vp.scaleX, vp.scaleY);
+    return std::max(1, std::min(64, (int)std::lround(px)));
+}
+
+inline bool RasterDrawingSink::visible(double x0, double y0, double x1, double y1, double marginPx) const {
+    double px0 = vp.originX + std::min(x0, x1) * vp.scaleX - marginPx;
+    double px1 = vp.originX + std::max(x0, x1) * vp.scaleX + marginPx;
+    double py0 = vp.originY + std::min(y0, y1) * vp.scaleY - marginPx;
+    double py1 = vp.originY + std::max(y0, y1) * vp.scaleY + marginPx;
+    return px1 >= 0 && py1 >= 0 && px0 < vp.width && py0 < vp.height;
+}
+
+inline void RasterDrawingSink::line(double x1, double y1, double x2, double y2, const DrawingStyle& style) {
+    if (style.strokeWidth < 0) return;
+    int t = thickness(style.strokeWidth);
+    if (!visible(x1, y1, x2, y2, t)) { ++culled; return; }
+    cv::line(image, toPixel(x1, y1), toPixel(x2, y2), style.stroke, t);
+}
+
+inline void RasterDrawingSink::rect(double x, double y, double w, double h, const DrawingStyle& style) {
+    int t = style.strokeWidth < 0 ? 0 : thickness(style.strokeWidth);
+    if (!visible(x, y, x + w, y + h, t)) { ++culled; return; }
+    // Clamp to just outside the viewport so deep zoom never overflows pixel coordinates.
+    auto clampPoint = [this](cv::Point p) {
+        return cv::Point(std::max(-64, std::min(vp.width + 64, p.x)), std::max(-64, std::min(vp.height + 64, p.y)));
+    };
+    cv::Point p0 = clampPoint(toPixel(x, y)), p1 = clampPoint(toPixel(x + w, y + h));
+    if (style.filled) cv::rectangle(image, p0, p1, style.fill, -1);
+    if (t > 0) cv::rectangle(image, p0, p1, style.stroke, t);
+}
+
+inline void RasterDrawingSink::circle(double cx, double cy, double r, const DrawingStyle& style) {
+    if (!visible(cx - r, cy - r, cx + r, cy + r, 2)) { ++culled; return; }
+    int radius = std::max(1, (int)std::lround(r * std::min(vp.scaleX, vp.scaleY)));
+    if (style.filled) cv::circle(image, toPixel(cx, cy), radius, style.fill, -1);
+    if (style.strokeWidth >= 0) cv::circle(image, toPixel(cx, cy), radius, style.stroke, thickness(style.strokeWidth));
+}
+
+inline void RasterDrawingSink::text(double x, double y, const std::string& str, double height, const cv::Scalar& color) {
+    // Hershey simplex capitals are about 22 px tall at scale 1; unreadably small text is skipped.
+    double heightPx = height * vp.scaleY;
+    if (heightPx < 6) { ++culled; return; }
+    double fontScale = std::min(heightPx / 22.0, 8.0);
+    double widthMm = str.size() * 20.0 * fontScale / vp.scaleX;
+    if (!visible(x, y - height, x + widthMm, y, 2)) { ++culled; return; }
+    cv::putText(image, str, toPixel(x, y), cv::FONT_HERSHEY_SIMPLEX, fontScale, color, std::max(1, (int)(fontScale * 1.5)));
+}
+
+
+#endif // DRAWINGEXPORT_H
@@ -0,0 +1,361 @@
+#pragma once
+
+#ifndef DRAWINGSHEETS_H
+#define DRAWINGSHEETS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "RebarCalc.h"
+#include "ThreadPool.h"
+
+// --- Drawing Sheets ---
+// One sheet per designed beam: the cross-section at the top left, its cost table at the
+// top right and the longitudinal section across the bottom, all at the sizes of the
+// GUI pictures. Sheets are written as PNG or JPEG images or as one-page PDFs that
+// embed the JPEG.
+enum class SheetFormat
+{
+    Png,
+    Jpeg,
+    Pdf
+};
+
+const cv::Size SHEET_IMAGE_SIZE(std::max(LONGITUDINAL_IMAGE_SIZE.width, 2 * CROSS_SECTION_IMAGE_SIZE.width),
+    CROSS_SECTION_IMAGE_SIZE.height + LONGITUDINAL_IMAGE_SIZE.height);
+// Resolution the PDF page is sized for; the page of a 1200 x 1000 sheet is 8 x 6.7 in.
+constexpr double SHEET_PDF_DPI = 150.0;
+
+// One design waiting for its sheet. index numbers the file, as in the batch output.
+struct SheetJob
+{
+    size_t index = 0;
+    BridgeParams params = {};
+    RebarDesign design;
+    MaterialGrade grade;
+};
+
+bool parseSheetFormat(const std::string& name, SheetFormat& format);
+const char* sheetFileExtension(SheetFormat format);
+// Draws the sheet of `job` into `sheet`, which is reallocated only when it is not a
+// SHEET_IMAGE_SIZE CV_8UC3 image. `calc` is only used to draw and keeps the design.
+void drawSheet(RebarCalc& calc, const SheetJob& job, cv::Mat& sheet);
+// Writes a one-page PDF showing a JPEG of width x height pixels at SHEET_PDF_DPI.
+bool writeJpegPdf(std::ostream& out, const std::vector<unsigned char>& jpeg, int width, int height);
+
+// --- Sheet Pipeline ---
+// Designs arrive through submit in the caller's order (the batch runner's write stage).
+// Rasterizer threads draw them into a fixed pool of sheet buffers and encoder threads
+// turn the buffers into files, handing each buffer back as soon as it is encoded. The
+// stages meet in bounded queues and the pool bounds the sheets in flight, so drawing,
+// encoding and disk I/O overlap and a long batch runs at the pace of the slowest stage
+// with constant memory. Files are named by index, so the order they finish in does not
+// matter.
+class SheetPipeline
+{
+public:
+    // Zero threads picks half the hardware threads for each of the two stages.
+    SheetPipeline(const std::string& directory, SheetFormat format, unsigned threadsPerStage = 0, size_t queueDepth = 16);
+    ~SheetPipeline() { finish(); }
+
+    SheetPipeline(const SheetPipeline&) = delete;
+    SheetPipeline& operator=(const SheetPipeline&) = delete;
+
+    // Creates the output directory and starts the stage threads.
+    bool start(std::string& errorMessage);
+    // Queues one design. Blocks while the rasterizers are queueDepth sheets behind, and
+    // returns false once a sheet could not be written.
+    bool submit(SheetJob job);
+    // Waits until every queued sheet is written and stops the threads. False if any
+    // sheet failed, with the first failure in lastError.
+    bool finish();
+
+    size_t sheetsWritten() const { return written.load(); }
+    // Once a sheet has failed the message no longer changes and may be read from any thread.
+    bool hasFailed() const { return failed.load(); }
+    const std::string& lastError() const { return errorText; }
+    unsigned threadsPerStage() const { return threadCount; }
+    // Seconds each stage spent working, averaged over its threads. The larger of the
+    // two is the stage that paced the run.
+    double rasterizeSeconds() const { return stageSeconds[0] / threadCount; }
+    double encodeSeconds() const { return stageSeconds[1] / threadCount; }
+
+private:
+    struct RasterizedSheet
+    {
+        size_t index;
+        cv::Mat* sheet;
+    };
+
+    std::string directory;
+    SheetFormat format;
+    unsigned threadCount;
+    std::vector<cv::Mat> buffers;
+    BoundedQueue<SheetJob> designed;
+    BoundedQueue<cv::Mat*> freeSheets;
+    BoundedQueue<RasterizedSheet> rasterized;
+    std::vector<std::thread> rasterizers, encoders;
+    std::atomic<size_t> written{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex statsMutex;
+    std::string errorText;
+    double stageSeconds[2] = {};
+    bool running = false;
+
+    void rasterizeLoop();
+    void encodeLoop();
+    bool writeSheet(const std::string& path, const std::vector<unsigned char>& encoded) const;
+    void fail(const std::string& message);
+    void addStageTime(int stage, double seconds);
+};
+
+
+// --- Function Implementations ---
+
+inline bool parseSheetFormat(const std::string& name, SheetFormat& format) {
+    std::string lower = name;
+    for (char& c : lower) c = (char)tolower((unsigned char)c);
+    if (lower == "png") format = SheetFormat::Png;
+    else if (lower == "jpg" || lower == "jpeg") format = SheetFormat::Jpeg;
+    else if (lower == "pdf") format = SheetFormat::Pdf;
+    else return false;
+    return true;
+}
+
+inline const char* sheetFileExtension(SheetFormat format) {
+    switch (format) {
+    case SheetFormat::Jpeg: return ".jpg";
+    case SheetFormat::Pdf: return ".pdf";
+    default: return ".png";
+    }
+}
+
+inline void drawSheet(RebarCalc& calc, const SheetJob& job, cv::Mat& sheet) {
+    if (sheet.size() != SHEET_IMAGE_SIZE || sheet.type() != CV_8UC3) sheet.create(SHEET_IMAGE_SIZE.height, SHEET_IMAGE_SIZE.width, CV_8UC3);
+    sheet.setTo(cv::Scalar(255, 255, 255));
+
+    // The views draw straight into their part of the sheet.
+    calc.restoreDesign(job.params, job.design);
+    cv::Mat crossSection = sheet(cv::Rect(0, 0, CROSS_SECTION_IMAGE_SIZE.width, CROSS_SECTION_IMAGE_SIZE.height));
+    calc.drawCrossSection(crossSection);
+    cv::Mat longitudinal = sheet(cv::Rect(0, CROSS_SECTION_IMAGE_SIZE.height, LONGITUDINAL_IMAGE_SIZE.width, LONGITUDINAL_IMAGE_SIZE.height));
+    calc.drawLongitudinalSection(longitudinal);
+
+    // Cost table, in the units of the GUI.
+    const RebarDesign& d = job.design;
+    cv::Scalar black(0, 0, 0), grey(128, 128, 128);
+    int left = CROSS_SECTION_IMAGE_SIZE.width + 30, right = SHEET_IMAGE_SIZE.width - 30;
+    int y = 60;
+    char text[160];
+    auto line = [&](const char* label, const char* value, double fontScale, int thickness) {
+        cv::putText(sheet, label, cv::Point(left, y), cv::FONT_HERSHEY_SIMPLEX, fontScale, black, thickness);
+        if (value[0] != '\0') {
+            int baseline = 0;
+            cv::Size size = cv::getTextSize(value, cv::FONT_HERSHEY_SIMPLEX, fontScale, thickness, &baseline);
+            cv::putText(sheet, value, cv::Point(right - size.width, y), cv::FONT_HERSHEY_SIMPLEX, fontScale, black, thickness);
+        }
+        y += 32;
+    };
+    auto rule = [&]() {
+        cv::line(sheet, cv::Point(left, y - 20), cv::Point(right, y - 20), grey, 1);
+        y += 8;
+    };
+
+    snprintf(text, sizeof(text), "Beam %zu", job.index);
+    line(text, "", 0.9, 2);
+    snprintf(text, sizeof(text), "%s / %s", concreteGradeName(job.grade.concrete), steelGradeName(job.grade.steel));
+    line("Materials", text, 0.6, 1);
+    snprintf(text, sizeof(text), "%.2f m", job.params.span / 1000.0);
+    line("Span", text, 0.6, 1);
+    snprintf(text, sizeof(text), "%g x %g mm", job.params.width, job.params.height);
+    line("Section", text, 0.6, 1);
+    rule();
+    if (!d.designPossible) {
+        line("No design", "", 0.6, 1);
+    }
+    else {
+        snprintf(text, sizeof(text), "%.1f mm", job.params.h0);
+        line("Effective depth h0", text, 0.6, 1);
+        line("Flexural bars", flexuralLayoutText(d).c_str(), 0.6, 1);
+        if (d.stirrupZoneCount > 0) snprintf(text, sizeof(text), "d%g, %d legs, %d zones", d.stirrupDiameter, d.stirrupLegs, d.stirrupZoneCount);
+        else snprintf(text, sizeof(text), "d%g, %d legs, @%g", d.stirrupDiameter, d.stirrupLegs, d.stirrupSpacing);
+        line("Stirrups", text, 0.6, 1);
+        snprintf(text, sizeof(text), "%d", d.bentRebarCount);
+        line("Bent bars", text, 0.6, 1);
+        rule();
+        snprintf(text, sizeof(text), "%.2f Yuan", d.concreteCost);
+        line("Concrete", text, 0.6, 1);
+        snprintf(text, sizeof(text), "%.2f Yuan", d.steelCost);
+        line("Steel", text, 0.6, 1);
+        snprintf(text, sizeof(text), "%.2f Yuan", d.laborCost);
+        line("Labor", text, 0.6, 1);
+        rule();
+        snprintf(text, sizeof(text), "%.2f Yuan", d.totalCost);
+        line("Total", text, 0.7, 2);
+    }
+
+    // Frame the three panels.
+    cv::rectangle(sheet, cv::Point(0, 0), cv::Point(SHEET_IMAGE_SIZE.width - 1, SHEET_IMAGE_SIZE.height - 1), black, 2);
+    cv::line(sheet, cv::Point(CROSS_SECTION_IMAGE_SIZE.width, 0), cv::Point(CROSS_SECTION_IMAGE_SIZE.width, CROSS_SECTION_IMAGE_SIZE.height), black, 1);
+    cv::line(sheet, cv::Point(0, CROSS_SECTION_IMAGE_SIZE.height), cv::Point(SHEET_IMAGE_SIZE.width, CROSS_SECTION_IMAGE_SIZE.height), black, 1);
+}
+
+// The smallest PDF that shows one image: catalog, page tree, page, the JPEG as a
+// DCTDecode image XObject and a content stream scaling it over the page.
+inline bool writeJpegPdf(std::ostream& out, const std::vector<unsigned char>& jpeg, int width, int height) {
+    double pageWidth = width * 72.0 / SHEET_PDF_DPI, pageHeight = height * 72.0 / SHEET_PDF_DPI;
+    char content[128];
+    int contentLength = snprintf(content, sizeof(content), "q %.2f 0 0 %.2f 0 0 cm /Im0 Do Q\n", pageWidth, pageHeight);
+    char text[256];
+    std::streamoff offsets[6] = {};
+    std::streamoff start = out.tellp();
+    auto object = [&](int number, const char* body) {
+        offsets[number] = out.tellp() - start;
+        out << number << " 0 obj\n" << body;
+    };
+
+    out << "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+    object(1, "<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    object(2, "<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+    snprintf(text, sizeof(text), "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] /Resources << /XObject << /Im0 4 0 R >> >> /Contents 5 0 R >>\nendobj\n",
+        pageWidth, pageHeight);
+    object(3, text);
+    snprintf(text, sizeof(text), "<< /Type /XObject /Subtype /Image /Width %d /Height %d /ColorSpace /DeviceRGB /BitsPerComponent 8"
+        " /Filter /DCTDecode /Length %zu >>\nstream\n", width, height, jpeg.size());
+    object(4, text);
+    out.write((const char*)jpeg.data(), (std::streamsize)jpeg.size());
+    out << "\nendstream\nendobj\n";
+    snprintf(text, sizeof(text), "<< /Length %d >>\nstream\n", contentLength);
+    object(5, text);
+    out.write(content, contentLength);
+    out << "endstream\nendobj\n";
+
+    std::streamoff xref = out.tellp() - start;
+    out << "xref\n0 6\n0000000000 65535 f \n";
+    for (int i = 1; i < 6; ++i) {
+        snprintf(text, sizeof(text), "%010lld 00000 n \n", (long long)offsets[i]);
+        out << text;
+    }
+    out << "trailer\n<< /Size 6 /Root 1 0 R >>\nstartxref\n" << xref << "\n%%EOF\n";
+    return (bool)out;
+}
+
+inline SheetPipeline::SheetPipeline(const std::string& directory, SheetFormat format, unsigned threadsPerStage, size_t queueDepth)
+    : directory(directory), format(format),
+      threadCount(threadsPerStage > 0 ? threadsPerStage : std::max(1u, std::thread::hardware_concurrency() / 2)),
+      // Every rasterizer and encoder holds at most one buffer, and queueDepth more wait
+      // between them, so the pool never runs dry while a stage is idle.
+      buffers(2 * threadCount + queueDepth), designed(queueDepth), freeSheets(buffers.size()), rasterized(buffers.size()) {}
+
+inline bool SheetPipeline::start(std::string& errorMessage) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || !std::filesystem::is_directory(directory)) {
+        errorMessage = "Error: Cannot create sheet directory " + directory + ".";
+        return false;
+    }
+    for (cv::Mat& buffer : buffers) {
+        buffer.create(SHEET_IMAGE_SIZE.height, SHEET_IMAGE_SIZE.width, CV_8UC3);
+        freeSheets.push(&buffer);
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        rasterizers.emplace_back(&SheetPipeline::rasterizeLoop, this);
+        encoders.emplace_back(&SheetPipeline::encodeLoop, this);
+    }
+    running = true;
+    return true;
+}
+
+inline bool SheetPipeline::submit(SheetJob job) {
+    if (failed.load(std::memory_order_relaxed)) return false;
+    return designed.push(std::move(job));
+}
+
+inline bool SheetPipeline::finish() {
+    if (running) {
+        // Shut the stages down front to back, so that each drains what it was handed.
+        designed.close();
+        for (std::thread& thread : rasterizers) thread.join();
+        rasterized.close();
+        for (std::thread& thread : encoders) thread.join();
+        freeSheets.close();
+        rasterizers.clear();
+        encoders.clear();
+        running = false;
+    }
+    return !failed.load();
+}
+
+inline void SheetPipeline::rasterizeLoop() {
+    RebarCalc calc; // drawing only, so the grade of the design does not matter
+    SheetJob job;
+    cv::Mat* sheet = nullptr;
+    double busy = 0;
+    while (designed.pop(job)) {
+        if (failed.load(std::memory_order_relaxed) || !freeSheets.pop(sheet)) continue;
+        auto start = std::chrono::steady_clock::now();
+        drawSheet(calc, job, *sheet);
+        busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rasterized.push({ job.index, sheet });
+    }
+    addStageTime(0, busy);
+}
+
+inline void SheetPipeline::encodeLoop() {
+    std::vector<unsigned char> encoded; // reused, so it settles at the largest sheet
+    const std::vector<int> pngParams = { cv::IMWRITE_PNG_COMPRESSION, 3 };
+    const std::vector<int> jpegParams = { cv::IMWRITE_JPEG_QUALITY, 90 };
+    const char* extension = sheetFileExtension(format);
+    char name[64];
+    RasterizedSheet item;
+    double busy = 0;
+    while (rasterized.pop(item)) {
+        if (failed.load(std::memory_order_relaxed)) {
+            freeSheets.push(item.sheet);
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool encodedOk = (format == SheetFormat::Png) ? cv::imencode(".png", *item.sheet, encoded, pngParams)
+            : cv::imencode(".jpg", *item.sheet, encoded, jpegParams);
+        freeSheets.push(item.sheet);
+        snprintf(name, sizeof(name), "sheet_%06zu%s", item.index, extension);
+        std::string path = (std::filesystem::path(directory) / name).string();
+        if (!encodedOk) fail("Error: Cannot encode sheet " + path + ".");
+        else if (!writeSheet(path, encoded)) fail("Error: Failed writing sheet " + path + ".");
+        else written.fetch_add(1, std::memory_order_relaxed);
+        busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    addStageTime(1, busy);
+}
+
+inline bool SheetPipeline::writeSheet(const std::string& path, const std::vector<unsigned char>& encoded) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    if (format == SheetFormat::Pdf) writeJpegPdf(out, encoded, SHEET_IMAGE_SIZE.width, SHEET_IMAGE_SIZE.height);
+    else out.write((const char*)encoded.data(), (std::streamsize)encoded.size());
+    out.flush();
+    return (bool)out;
+}
+
+inline void SheetPipeline::fail(const std::string& message) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    if (failed.load()) return;
+    errorText = message;
+    failed.store(true);
+}
+
+inline void SheetPipeline::addStageTime(int stage, double seconds) {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stageSeconds[stage] += seconds;
+}
+
+
+#endif // DRAWINGSHEETS_H
@@ -0,0 +1,73 @@
+#include "stdafx.h"
+#include "DrawingTileItem.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+
+DrawingTileItem::DrawingTileItem()
+{
+    // Needed for option->exposedRect, so that only the visible tiles are painted.
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    tiles.setMaxCost(MAX_CACHED_TILES);
+}
+
+void DrawingTileItem::setDesign(const BridgeParams& params, const RebarDesign& design, bool isCrossSection)
+{
+    prepareGeometryChange();
+    calc.restoreDesign(params, design);
+    crossSection = isCrossSection;
+    fitViewport = crossSection ? crossSectionFitViewport(calc) : longitudinalFitViewport(calc);
+    tiles.clear();
+    update();
+}
+
+QRectF DrawingTileItem::boundingRect() const
+{
+    return QRectF(0, 0, fitViewport.width, fitViewport.height);
+}
+
+void DrawingTileItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    Q_UNUSED(widget);
+
+    // Zoom levels are steps of sqrt(2); tiles are rendered at the next level up and
+    // scaled down slightly by the painter, so they always stay sharp.
+    qreal zoom = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int level = std::max(0, (int)std::ceil(2.0 * std::log2(std::max(zoom, (qreal)1.0)) - 1e-6));
+    double tileExtent = TILE_SIZE / std::pow(2.0, level / 2.0); // scene units covered by one tile
+
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty()) return;
+    int firstX = (int)std::floor(exposed.left() / tileExtent), lastX = (int)std::ceil(exposed.right() / tileExtent) - 1;
+    int firstY = (int)std::floor(exposed.top() / tileExtent), lastY = (int)std::ceil(exposed.bottom() / tileExtent) - 1;
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            const QPixmap* pixmap = tile(level, tx, ty);
+            if (!pixmap) continue;
+            painter->drawPixmap(QRectF(tx * tileExtent, ty * tileExtent, tileExtent, tileExtent), *pixmap, QRectF(pixmap->rect()));
+        }
+    }
+}
+
+const QPixmap* DrawingTileItem::tile(int level, int tx, int ty)
+{
+    quint64 key = ((quint64)level << 48) | ((quint64)(quint32)tx << 24) | (quint64)(quint32)ty;
+    if (QPixmap* cached = tiles.object(key)) return cached;
+
+    double levelScale = std::pow(2.0, level / 2.0);
+    DrawingViewport viewport;
+    viewport.scaleX = fitViewport.scaleX * levelScale;
+    viewport.scaleY = fitViewport.scaleY * levelScale;
+    viewport.originX = fitViewport.originX * levelScale - tx * TILE_SIZE;
+    viewport.originY = fitViewport.originY * levelScale - ty * TILE_SIZE;
+    viewport.width = TILE_SIZE;
+    viewport.height = TILE_SIZE;
+
+    // Same zero-copy hand-off as the full pictures: OpenCV draws into the QImage buffer.
+    QImage image(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+    cv::Mat buffer(image.height(), image.width(), CV_8UC4, image.bits(), image.bytesPerLine());
+    renderDrawingTile(calc, crossSection, viewport, buffer);
+
+    tiles.insert(key, new QPixmap(QPixmap::fromImage(std::move(image))));
+    return tiles.object(key);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QCache>
+#include <QGraphicsItem>
+#include <QPixmap>
+#include "RebarCalc.h"
+#include "DrawingExport.h"
+
+// --- Zoomable Drawing Item ---
+// Shows a design drawing in the scene coordinates of the standard 600x600 / 1200x400
+// picture, but paints it from raster tiles rendered at the current zoom level. Only the
+// tiles inside the exposed area are drawn, and each tile only draws the primitives that
+// fall inside it, so deep zoom on long girders stays cheap.
+class DrawingTileItem : public QGraphicsItem
+{
+public:
+    DrawingTileItem();
+
+    void setDesign(const BridgeParams& params, const RebarDesign& design, bool crossSection);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+    static constexpr int TILE_SIZE = 256;
+    static constexpr int MAX_CACHED_TILES = 128;
+
+private:
+    RebarCalc calc;
+    bool crossSection = true;
+    DrawingViewport fitViewport;
+    QCache<quint64, QPixmap> tiles;
+
+    const QPixmap* tile(int level, int tx, int ty);
+};
@@ -0,0 +1,397 @@
+#pragma once
+
+#ifndef FATIGUE_H
+#define FATIGUE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+#include "DesignStore.h"
+#include "ThreadPool.h"
+
+// --- Fatigue Settings ---
+// S-N curve of the reinforcing steel, by default EN 1992-1-1 Table 6.3N for straight and
+// bent bars: N = kneeCycles * (kneeRange / (partialFactor * range))^k, with k = slopeHigh
+// above the knee range and slopeLow below it. Ranges up to cutoffRange cause no damage.
+// section is the position of the checked section as a fraction of the span.
+struct FatigueSpec
+{
+    double kneeRange = 162.5;  // MPa
+    double kneeCycles = 1e6;
+    double slopeHigh = 5;
+    double slopeLow = 9;
+    double partialFactor = 1.15;
+    double cutoffRange = 0;    // MPa
+    double section = 0.5;
+    size_t chunkBytes = 4 << 20;
+
+    double cycleDamage(double range) const;
+};
+
+// --- Fatigue Results ---
+// cycles counts closed cycles as 1 and the half cycles of the final residue as 0.5.
+struct FatigueResult
+{
+    long long vehicles = 0;
+    long long skippedLines = 0;
+    double cycles = 0;
+    double damage = 0;          // Miner sum over the record
+    double deadStress = 0;      // MPa, bar stress with no vehicle on the span
+    double maxStress = 0;       // MPa
+    double maxStressRange = 0;  // MPa, largest counted range
+    double seconds = 0;
+    bool success = false;
+    std::string errorMessage;
+};
+
+// --- Rainflow Counter ---
+// Single-pass four-point rainflow count. Values are pushed one at a time; runs in one
+// direction collapse to their extreme, and the middle range of the last four turning
+// points is counted as a cycle as soon as both neighbouring ranges enclose it. Only the
+// unclosed residue is kept, which stays small for any realistic stress history.
+// Counting a history in pieces and then pushing the residues of the pieces, in order,
+// into another counter gives the same cycles as one pass over the whole history.
+class RainflowCounter
+{
+public:
+    explicit RainflowCounter(const FatigueSpec& spec) : spec(spec) {}
+
+    void push(double value);
+    // Counts the residue as half cycles; no more values may be pushed afterwards.
+    void finish();
+
+    const std::vector<double>& residue() const { return points; }
+    double cycles() const { return cycleCount; }
+    double damage() const { return damageSum; }
+    double maxRange() const { return largestRange; }
+
+private:
+    const FatigueSpec& spec;
+    std::vector<double> points;
+    double cycleCount = 0;
+    double damageSum = 0;
+    double largestRange = 0;
+
+    void count(double range, double weight);
+};
+
+// --- Vehicle Stress History ---
+// Bar stress at one section of a simply supported span as a vehicle crosses it. The
+// moment at the section is piecewise linear in the vehicle position, with corners only
+// where an axle passes a support or the section itself, so evaluating those 3N positions
+// gives every peak and valley exactly. Axle loads are in kN and offsets in mm.
+class VehicleStressHistory
+{
+public:
+    // stressPerMoment converts N*mm at the section into MPa in the bars; girderShare is
+    // the fraction of each axle load that this girder carries.
+    VehicleStressHistory(double span, double section, double deadStress, double stressPerMoment, double girderShare);
+
+    // Calls emit(stress) for the stresses at the corners, in order of the vehicle position,
+    // starting and ending with the dead-load stress.
+    template <typename Emit>
+    void evaluate(const double* loads, const double* offsets, int axles, Emit&& emit);
+
+    static constexpr int MAX_AXLES = 32;
+
+private:
+    double span;
+    double section;
+    double deadStress;
+    double stressPerNewtonMm;
+    double share;
+    double corners[3 * MAX_AXLES];
+};
+
+// Parses one weigh-in-motion line "load@offset,load@offset,..." (kN, m from the leading
+// axle) into loads and offsets (kN, mm). Returns the axle count, or -1 for a malformed
+// line or one with more than VehicleStressHistory::MAX_AXLES axles.
+int parseWimVehicle(const char* text, double* loads, double* offsets);
+
+// Streams the weigh-in-motion file at `path` through the bar stress history at
+// spec.section of the design held by `calc` and rainflow-counts the whole record. The
+// file is memory-mapped and split into chunks of spec.chunkBytes that are counted in
+// parallel on `pool`; their residues are then counted in file order. Blank lines and
+// lines starting with '#' are ignored. Vehicles cross the span one at a time.
+template <typename Concrete, typename Steel>
+bool runFatigueAnalysis(const RebarCalcT<Concrete, Steel>& calc, const std::string& path, const FatigueSpec& spec,
+    FatigueResult& result, WorkStealingPool& pool);
+
+int runFatigueCommandLine(int argc, char* argv[]);
+
+
+// --- Function Implementations ---
+
+inline double FatigueSpec::cycleDamage(double range) const {
+    if (range <= cutoffRange || range <= 0) return 0.0;
+    double factored = partialFactor * range;
+    double slope = factored >= kneeRange ? slopeHigh : slopeLow;
+    return std::pow(factored / kneeRange, slope) / kneeCycles;
+}
+
+inline void RainflowCounter::push(double value) {
+    size_t n = points.size();
+    if (n > 0 && value == points[n - 1]) return;
+    if (n >= 2 && (points[n - 1] - points[n - 2]) * (value - points[n - 1]) > 0) points[n - 1] = value; // same direction
+    else points.push_back(value);
+
+    while (points.size() >= 4) {
+        n = points.size();
+        double inner = std::fabs(points[n - 2] - points[n - 3]);
+        if (inner > std::fabs(points[n - 3] - points[n - 4]) || inner > std::fabs(points[n - 1] - points[n - 2])) break;
+        count(inner, 1.0);
+        points.erase(points.end() - 3, points.end() - 1);
+    }
+}
+
+inline void RainflowCounter::finish() {
+    for (size_t i = 1; i < points.size(); ++i) count(std::fabs(points[i] - points[i - 1]), 0.5);
+    points.clear();
+}
+
+inline void RainflowCounter::count(double range, double weight) {
+    cycleCount += weight;
+    damageSum += weight * spec.cycleDamage(range);
+    largestRange = std::max(largestRange, range);
+}
+
+inline VehicleStressHistory::VehicleStressHistory(double span, double section, double deadStress, double stressPerMoment, double girderShare)
+    : span(span), section(section), deadStress(deadStress), stressPerNewtonMm(stressPerMoment), share(girderShare) {
+}
+
+template <typename Emit>
+inline void VehicleStressHistory::evaluate(const double* loads, const double* offsets, int axles, Emit&& emit) {
+    // The leading axle is at p, axle i at p - offsets[i].
+    int cornerCount = 0;
+    for (int i = 0; i < axles; ++i) {
+        corners[cornerCount++] = offsets[i];
+        corners[cornerCount++] = offsets[i] + section;
+        corners[cornerCount++] = offsets[i] + span;
+    }
+    std::sort(corners, corners + cornerCount);
+    double kiloNewtonToStress = 1000.0 * share * stressPerNewtonMm;
+    emit(deadStress);
+    for (int c = 0; c < cornerCount; ++c) {
+        double p = corners[c];
+        // Moment influence line of the section: x (L - a) / L left of it, a (L - x) / L right of it.
+        double moment = 0;
+        for (int i = 0; i < axles; ++i) {
+            double x = p - offsets[i];
+            if (x <= 0 || x >= span) continue;
+            moment += loads[i] * (x <= section ? x * (span - section) : section * (span - x));
+        }
+        emit(deadStress + kiloNewtonToStress * moment / span);
+    }
+    emit(deadStress);
+}
+
+inline int parseWimVehicle(const char* text, double* loads, double* offsets) {
+    int axles = 0;
+    const char* cursor = text;
+    double lead = 0;
+    while (*cursor) {
+        char* end = nullptr;
+        double load = std::strtod(cursor, &end);
+        if (end == cursor || *end != '@') return -1;
+        cursor = end + 1;
+        double offset = std::strtod(cursor, &end);
+        if (end == cursor || axles == VehicleStressHistory::MAX_AXLES || !(load >= 0)) return -1;
+        if (axles == 0) lead = offset;
+        loads[axles] = load;
+        offsets[axles++] = (offset - lead) * 1000.0;
+        cursor = end;
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') ++cursor;
+        if (*cursor == ',' || *cursor == ';') ++cursor;
+        else if (*cursor) return -1;
+    }
+    return axles > 0 ? axles : -1;
+}
+
+template <typename Concrete, typename Steel>
+inline bool runFatigueAnalysis(const RebarCalcT<Concrete, Steel>& calc, const std::string& path, const FatigueSpec& spec,
+    FatigueResult& result, WorkStealingPool& pool) {
+    typedef RebarCalcT<Concrete, Steel> Calc;
+    result = FatigueResult();
+    const RebarDesign& design = calc.getDesignResults();
+    const BridgeParams& params = calc.getParams();
+    if (!design.designPossible || design.flexureRebarDiameter <= 0) {
+        result.errorMessage = "Error: There is no successful design to analyse.";
+        return false;
+    }
+    if (params.spanCount > 1) {
+        result.errorMessage = "Error: Fatigue analysis supports simply supported spans only.";
+        return false;
+    }
+    if (!(spec.section > 0 && spec.section < 1) || spec.kneeRange <= 0 || spec.kneeCycles <= 0 || spec.partialFactor <= 0) {
+        result.errorMessage = "Error: Invalid fatigue settings.";
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(path, result.errorMessage)) return false;
+    auto start = std::chrono::steady_clock::now();
+
+    // Cracked-section bar stress of GB 50010: M / (0.87 h0 As).
+    double L = params.span;
+    double a = spec.section * L;
+    double q = params.width * params.height * Calc::CONCRETE_UNIT_WEIGHT;
+    double As = flexuralSteelArea(design);
+    double stressPerMoment = 1.0 / (0.87 * params.h0 * As);
+    double deadStress = q * a * (L - a) / 2.0 * stressPerMoment;
+    double momentShare, shearShare;
+    calc.distributeVehicleLoad(1.0, params.girderSpacing, momentShare, shearShare);
+
+    struct Chunk
+    {
+        long long vehicles = 0;
+        long long skipped = 0;
+        double cycles = 0;
+        double damage = 0;
+        double maxStress = 0;
+        double maxRange = 0;
+        std::vector<double> residue;
+    };
+    const char* data = file.data();
+    size_t size = file.size();
+    size_t chunkBytes = std::max<size_t>(spec.chunkBytes, 4096);
+    size_t chunkCount = (size + chunkBytes - 1) / chunkBytes;
+    std::vector<Chunk> chunks(chunkCount);
+
+    parallelFor(pool, 0, chunkCount, 1, [&](size_t first, size_t last) {
+        VehicleStressHistory history(L, a, deadStress, stressPerMoment, momentShare);
+        double loads[VehicleStressHistory::MAX_AXLES], offsets[VehicleStressHistory::MAX_AXLES];
+        char line[1024];
+        for (size_t c = first; c < last; ++c) {
+            Chunk& chunk = chunks[c];
+            RainflowCounter counter(spec);
+            double maxStress = deadStress;
+            // A chunk owns the lines that start inside it.
+            size_t pos = c * chunkBytes, end = std::min(size, pos + chunkBytes);
+            if (pos > 0 && data[pos - 1] != '\n') {
+                const char* newline = (const char*)std::memchr(data + pos, '\n', size - pos);
+                pos = newline ? (size_t)(newline - data) + 1 : size;
+            }
+            while (pos < end) {
+                const char* newline = (const char*)std::memchr(data + pos, '\n', size - pos);
+                size_t lineEnd = newline ? (size_t)(newline - data) : size;
+                size_t length = lineEnd - pos;
+                const char* text = data + pos;
+                pos = lineEnd + 1;
+                while (length > 0 && (text[length - 1] == '\r' || text[length - 1] == ' ')) --length;
+                if (length == 0 || text[0] == '#') continue;
+                if (length >= sizeof(line)) { ++chunk.skipped; continue; }
+                // The mapping is not NUL-terminated, so strtod works on a copy of the line.
+                std::memcpy(line, text, length);
+                line[length] = '\0';
+                int axles = parseWimVehicle(line, loads, offsets);
+                if (axles < 0) { ++chunk.skipped; continue; }
+                ++chunk.vehicles;
+                history.evaluate(loads, offsets, axles, [&](double stress) {
+                    maxStress = std::max(maxStress, stress);
+                    counter.push(stress);
+                });
+            }
+            chunk.cycles = counter.cycles();
+            chunk.damage = counter.damage();
+            chunk.maxStress = maxStress;
+            chunk.maxRange = counter.maxRange();
+            chunk.residue = counter.residue();
+        }
+    });
+
+    // Chunks in file order, so the sums do not depend on the thread count.
+    RainflowCounter residues(spec);
+    result.deadStress = result.maxStress = deadStress;
+    for (const Chunk& chunk : chunks) {
+        result.vehicles += chunk.vehicles;
+        result.skippedLines += chunk.skipped;
+        result.cycles += chunk.cycles;
+        result.damage += chunk.damage;
+        result.maxStress = std::max(result.maxStress, chunk.maxStress);
+        result.maxStressRange = std::max(result.maxStressRange, chunk.maxRange);
+        for (double value : chunk.residue) residues.push(value);
+    }
+    residues.finish();
+    result.cycles += residues.cycles();
+    result.damage += residues.damage();
+    result.maxStressRange = std::max(result.maxStressRange, residues.maxRange());
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.success = true;
+    return true;
+}
+
+// Usage: --fatigue <vehicles.wim> --span mm --width mm --height mm --load kN --wheel-span m --girder-spacing mm
+//        [--section 0.5] [--days D] [--threads N] [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]
+// The beam is designed with runDesign for the given vehicle, then checked for the record.
+inline int runFatigueCommandLine(int argc, char* argv[]) {
+    std::string recordPath;
+    double span = 0, width = 0, height = 0, load = 0, wheelSpan = 0, girderSpacing = 0, days = 0;
+    unsigned threads = 0;
+    std::string concreteName, steelName;
+    FatigueSpec spec;
+    bool badArgument = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--span" && i + 1 < argc) span = std::atof(argv[++i]);
+        else if (arg == "--width" && i + 1 < argc) width = std::atof(argv[++i]);
+        else if (arg == "--height" && i + 1 < argc) height = std::atof(argv[++i]);
+        else if (arg == "--load" && i + 1 < argc) load = std::atof(argv[++i]);
+        else if (arg == "--wheel-span" && i + 1 < argc) wheelSpan = std::atof(argv[++i]);
+        else if (arg == "--girder-spacing" && i + 1 < argc) girderSpacing = std::atof(argv[++i]);
+        else if (arg == "--section" && i + 1 < argc) spec.section = std::atof(argv[++i]);
+        else if (arg == "--days" && i + 1 < argc) days = std::atof(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--concrete" && i + 1 < argc) concreteName = argv[++i];
+        else if (arg == "--steel" && i + 1 < argc) steelName = argv[++i];
+        else if (recordPath.empty()) recordPath = arg;
+        else badArgument = true;
+    }
+    if (recordPath.empty() || badArgument || span <= 0 || width <= 0 || height <= 0) {
+        std::cerr << "Usage: --fatigue <vehicles.wim> --span mm --width mm --height mm --load kN --wheel-span m --girder-spacing mm"
+            " [--section 0.5] [--days D] [--threads N] [--concrete C30..C60] [--steel HRB335|HRB400|HRB500]\n";
+        return 2;
+    }
+    MaterialGrade grade;
+    if (!concreteName.empty() && !parseConcreteGrade(concreteName, grade.concrete)) {
+        std::cerr << "Error: Unknown concrete grade '" << concreteName << "' (expected C30, C35, ... C60)\n";
+        return 2;
+    }
+    if (!steelName.empty() && !parseSteelGrade(steelName, grade.steel)) {
+        std::cerr << "Error: Unknown steel grade '" << steelName << "' (expected HRB335, HRB400 or HRB500)\n";
+        return 2;
+    }
+
+    std::unique_ptr<WorkStealingPool> ownPool;
+    if (threads > 0) ownPool.reset(new WorkStealingPool(threads));
+    WorkStealingPool& pool = ownPool ? *ownPool : sharedDesignPool();
+
+    FatigueResult result;
+    bool designed = dispatchMaterialGrade(grade, [&](auto tag) {
+        typename decltype(tag)::Calc calc;
+        if (!calc.runDesign(span, width, height, load, wheelSpan, girderSpacing)) {
+            result.errorMessage = calc.getDesignResults().errorMessage;
+            return false;
+        }
+        return runFatigueAnalysis(calc, recordPath, spec, result, pool);
+    });
+    if (!designed) {
+        std::cerr << result.errorMessage << "\n";
+        return 1;
+    }
+    std::cerr << result.vehicles << " vehicles (" << result.skippedLines << " unreadable lines skipped) in " << result.seconds
+        << " s on " << pool.size() << " threads: " << (result.seconds > 0 ? result.vehicles / result.seconds : 0.0) << " vehicles/s\n";
+    std::cout << "Bar stress at " << spec.section << " L: dead load " << result.deadStress << " MPa, maximum " << result.maxStress << " MPa\n";
+    std::cout << "Rainflow: " << result.cycles << " cycles, largest range " << result.maxStressRange << " MPa\n";
+    std::cout << "Fatigue damage (Miner sum): " << result.damage << "\n";
+    if (days > 0 && result.damage > 0) std::cout << "Fatigue life at this traffic: " << days / result.damage / 365.0 << " years\n";
+    return 0;
+}
+
+
+#endif // FATIGUE_H
@@ -0,0 +1,261 @@
+#pragma once
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// --- Design Stage Instrumentation ---
+// Scoped timers and event counters for the stages of a design. Everything here is only
+// compiled in with REBAR_ENABLE_INSTRUMENTATION defined (the Debug configuration does);
+// otherwise the REBAR_* macros expand to nothing and the engine is exactly as without them.
+//
+// Each thread accumulates into its own record, so timing a scope costs two clock reads
+// and two uncontended relaxed stores. Snapshots may be taken from any thread at any time.
+// Individual scopes are additionally kept as trace events while tracing is switched on,
+// for a Chrome trace (chrome://tracing, Perfetto) of a batch run.
+
+enum class DesignStage
+{
+    Design,          // RebarCalc::runDesign end to end
+    ForceAnalysis,   // calculateMaxForces / calculateEnvelopeForces
+    DiameterLoop,    // findOptimalDesign
+    ShearDesign,     // designShearForIteration and zoning
+    Costing,         // calculateTotalCostForIteration
+    Drawing,         // OpenCV drawing of either view
+    ImageConversion, // QImage -> QPixmap in the GUI
+    Count
+};
+
+enum class DesignCounter
+{
+    CandidatesEvaluated, // flexural layouts that were designed for shear and costed
+    XiRejects,           // layouts rejected by the xi <= xi_b ductility limit
+    RowCapacityRejects,  // layouts whose bars do not fit in two rows
+    CacheHits,
+    CacheMisses,
+    Count
+};
+
+constexpr int DESIGN_STAGE_COUNT = (int)DesignStage::Count;
+constexpr int DESIGN_COUNTER_COUNT = (int)DesignCounter::Count;
+
+inline const char* designStageName(DesignStage stage) {
+    static const char* const names[DESIGN_STAGE_COUNT] = { "Design", "Force analysis", "Diameter loop", "Shear design",
+        "Costing", "Drawing", "Image conversion" };
+    return names[(int)stage];
+}
+
+inline const char* designCounterName(DesignCounter counter) {
+    static const char* const names[DESIGN_COUNTER_COUNT] = { "candidatesEvaluated", "xiRejects", "rowCapacityRejects",
+        "cacheHits", "cacheMisses" };
+    return names[(int)counter];
+}
+
+// Totals over all threads. Stage times are inclusive: a Design scope contains the force
+// analysis and diameter loop below it.
+struct InstrumentationSnapshot
+{
+    long long stageNanoseconds[DESIGN_STAGE_COUNT] = {};
+    long long stageCalls[DESIGN_STAGE_COUNT] = {};
+    long long counters[DESIGN_COUNTER_COUNT] = {};
+
+    InstrumentationSnapshot operator-(const InstrumentationSnapshot& earlier) const {
+        InstrumentationSnapshot d;
+        for (int i = 0; i < DESIGN_STAGE_COUNT; ++i) {
+            d.stageNanoseconds[i] = stageNanoseconds[i] - earlier.stageNanoseconds[i];
+            d.stageCalls[i] = stageCalls[i] - earlier.stageCalls[i];
+        }
+        for (int i = 0; i < DESIGN_COUNTER_COUNT; ++i) d.counters[i] = counters[i] - earlier.counters[i];
+        return d;
+    }
+    double milliseconds(DesignStage stage) const { return stageNanoseconds[(int)stage] / 1e6; }
+    long long count(DesignCounter counter) const { return counters[(int)counter]; }
+};
+
+// One line per stage (calls, total and mean time) followed by the counters.
+inline void writeInstrumentationSummary(std::ostream& out, const InstrumentationSnapshot& totals) {
+    char line[160];
+    for (int i = 0; i < DESIGN_STAGE_COUNT; ++i) {
+        long long calls = totals.stageCalls[i];
+        if (calls == 0) continue;
+        std::snprintf(line, sizeof(line), "  %-18s %12lld calls %12.3f ms %10.1f ns/call\n", designStageName((DesignStage)i), calls,
+            totals.stageNanoseconds[i] / 1e6, (double)totals.stageNanoseconds[i] / calls);
+        out << line;
+    }
+    for (int i = 0; i < DESIGN_COUNTER_COUNT; ++i) {
+        std::snprintf(line, sizeof(line), "  %-18s %12lld\n", designCounterName((DesignCounter)i), totals.counters[i]);
+        out << line;
+    }
+}
+
+#ifdef REBAR_ENABLE_INSTRUMENTATION
+
+class Instrumentation
+{
+public:
+    struct TraceEvent
+    {
+        int64_t start;    // ns since the instrumentation epoch
+        int64_t duration; // ns
+        DesignStage stage;
+    };
+
+    static InstrumentationSnapshot snapshot();
+    // Zeroes all totals and drops the trace events. Only call this while no instrumented
+    // code is running (between batch runs, or on the GUI thread with no design job).
+    static void reset();
+    static void setTracing(bool enabled) { tracingFlag().store(enabled, std::memory_order_relaxed); }
+    static bool tracing() { return tracingFlag().load(std::memory_order_relaxed); }
+    // Writes the trace events and the final counter values in the Chrome trace event
+    // format. Like reset(), only call this once the traced work has finished.
+    static void writeChromeTrace(std::ostream& out);
+
+    static void addTime(DesignStage stage, int64_t start, int64_t duration);
+    static void count(DesignCounter counter, long long amount = 1) {
+        std::atomic<long long>& c = threadRecord().counters[(int)counter];
+        c.store(c.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch()).count();
+    }
+
+    // At most this many trace events are kept per thread; later scopes are still timed
+    // and counted, just not traced.
+    static constexpr size_t MAX_TRACE_EVENTS_PER_THREAD = 1 << 20;
+
+private:
+    // Written only by the owning thread; atomics so that snapshot() may read them.
+    // Records are never freed, so a snapshot stays valid after a worker thread exits.
+    struct ThreadRecord
+    {
+        std::atomic<long long> stageNanoseconds[DESIGN_STAGE_COUNT];
+        std::atomic<long long> stageCalls[DESIGN_STAGE_COUNT];
+        std::atomic<long long> counters[DESIGN_COUNTER_COUNT];
+        std::vector<TraceEvent> events;
+        int threadIndex = 0;
+
+        ThreadRecord() {
+            for (auto& v : stageNanoseconds) v.store(0, std::memory_order_relaxed);
+            for (auto& v : stageCalls) v.store(0, std::memory_order_relaxed);
+            for (auto& v : counters) v.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    static std::mutex& registryMutex() { static std::mutex mutex; return mutex; }
+    static std::vector<ThreadRecord*>& registry() { static std::vector<ThreadRecord*> records; return records; }
+    static std::atomic<bool>& tracingFlag() { static std::atomic<bool> flag(false); return flag; }
+    static std::chrono::steady_clock::time_point epoch() {
+        static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        return start;
+    }
+    static ThreadRecord& threadRecord();
+};
+
+// Times the enclosing scope as one call of `stage`.
+class ScopedStageTimer
+{
+public:
+    explicit ScopedStageTimer(DesignStage stage) : stage(stage), start(Instrumentation::now()) {}
+    ~ScopedStageTimer() { Instrumentation::addTime(stage, start, Instrumentation::now() - start); }
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    DesignStage stage;
+    int64_t start;
+};
+
+#define REBAR_CONCAT_INNER(a, b) a##b
+#define REBAR_CONCAT(a, b) REBAR_CONCAT_INNER(a, b)
+#define REBAR_TIME_SCOPE(stage) ScopedStageTimer REBAR_CONCAT(rebarStageTimer, __LINE__)(DesignStage::stage)
+#define REBAR_COUNT(counter) Instrumentation::count(DesignCounter::counter)
+
+
+// --- Function Implementations ---
+
+inline Instrumentation::ThreadRecord& Instrumentation::threadRecord() {
+    thread_local ThreadRecord* record = nullptr;
+    if (!record) {
+        record = new ThreadRecord();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        record->threadIndex = (int)registry().size();
+        registry().push_back(record);
+    }
+    return *record;
+}
+
+inline void Instrumentation::addTime(DesignStage stage, int64_t start, int64_t duration) {
+    ThreadRecord& record = threadRecord();
+    std::atomic<long long>& ns = record.stageNanoseconds[(int)stage];
+    std::atomic<long long>& calls = record.stageCalls[(int)stage];
+    ns.store(ns.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (tracing() && record.events.size() < MAX_TRACE_EVENTS_PER_THREAD) {
+        record.events.push_back({ start, duration, stage });
+    }
+}
+
+inline InstrumentationSnapshot Instrumentation::snapshot() {
+    InstrumentationSnapshot total;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const ThreadRecord* record : registry()) {
+        for (int i = 0; i < DESIGN_STAGE_COUNT; ++i) {
+            total.stageNanoseconds[i] += record->stageNanoseconds[i].load(std::memory_order_relaxed);
+            total.stageCalls[i] += record->stageCalls[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < DESIGN_COUNTER_COUNT; ++i) total.counters[i] += record->counters[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+inline void Instrumentation::reset() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (ThreadRecord* record : registry()) {
+        for (auto& v : record->stageNanoseconds) v.store(0, std::memory_order_relaxed);
+        for (auto& v : record->stageCalls) v.store(0, std::memory_order_relaxed);
+        for (auto& v : record->counters) v.store(0, std::memory_order_relaxed);
+        record->events.clear();
+    }
+}
+
+inline void Instrumentation::writeChromeTrace(std::ostream& out) {
+    InstrumentationSnapshot totals = snapshot();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    int64_t end = now();
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    char line[192];
+    for (const ThreadRecord* record : registry()) {
+        for (const TraceEvent& e : record->events) {
+            // Chrome trace times are in microseconds; fractions keep the nanoseconds.
+            std::snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"design\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",\n", designStageName(e.stage), record->threadIndex, e.start / 1000.0, e.duration / 1000.0);
+            out << line;
+            first = false;
+        }
+    }
+    for (int i = 0; i < DESIGN_COUNTER_COUNT; ++i) {
+        std::snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+            first ? "" : ",\n", designCounterName((DesignCounter)i), end / 1000.0, totals.counters[i]);
+        out << line;
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+#else
+
+#define REBAR_TIME_SCOPE(stage) ((void)0)
+#define REBAR_COUNT(counter) ((void)0)
+
+#endif // REBAR_ENABLE_INSTRUMENTATION
+
+
+#endif // INSTRUMENTATION_H
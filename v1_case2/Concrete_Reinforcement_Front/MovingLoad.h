@@ -0,0 +1,202 @@
+#pragma once
+
+#ifndef MOVINGLOAD_H
+#define MOVINGLOAD_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// --- Axle Train ---
+// Axle loads in kN and axle offsets in mm, measured back from the leading axle (so the
+// first offset is 0 and offsets never decrease).
+struct AxleTrain
+{
+    std::vector<double> loads;
+    std::vector<double> offsets;
+
+    size_t size() const { return loads.size(); }
+    double length() const { return offsets.empty() ? 0.0 : offsets.back(); }
+    double totalLoad() const;
+    bool isValid() const;
+
+    // The two equal axles assumed by RebarCalc::runDesign (wheel span in mm).
+    static AxleTrain twoAxle(double totalLoad, double wheelSpan);
+    // Parses "load@offset,load@offset,..." with loads in kN and offsets in m from the
+    // leading axle, e.g. "35@0,145@4.3,145@8.6". Returns false on malformed input.
+    static bool parse(const std::string& text, AxleTrain& train);
+};
+
+// --- Force Envelopes ---
+// Live-load extremes of one train at equally spaced stations 0..span (train loads are
+// in kN, the envelopes in N and N*mm).
+struct ForceEnvelope
+{
+    double span = 0;
+    std::vector<double> stations;  // mm
+    std::vector<double> momentMax; // N*mm, sagging
+    std::vector<double> shearMax;  // N, most positive
+    std::vector<double> shearMin;  // N, most negative
+
+    size_t stationCount() const { return stations.size(); }
+    void clear() { span = 0; stations.clear(); momentMax.clear(); shearMax.clear(); shearMin.clear(); }
+};
+
+// --- Moving-Load Engine ---
+// Steps the train across a simply supported span by influence-line superposition. For a
+// given station the moment (and the shear just beside it) is piecewise linear in the train
+// position, with its peaks where an axle stands on the station, so only those N positions
+// are evaluated. Prefix sums over the axles give the sum for each position in O(1), and
+// the range of axles on the span is tracked with two pointers that only move forward,
+// which makes one envelope O(N * stations).
+class MovingLoadEngine
+{
+public:
+    // `intervals` is the number of station intervals (stations = intervals + 1). With
+    // bothDirections the train is also run reversed, as for two-way traffic.
+    void computeEnvelope(const AxleTrain& train, double span, int intervals, bool bothDirections, ForceEnvelope& envelope);
+
+    static constexpr int DEFAULT_INTERVALS = 1000;
+
+private:
+    // Scratch for the prefix sums, reused between calls.
+    std::vector<double> offsets;
+    std::vector<double> loadSum;
+    std::vector<double> momentSum;
+
+    void accumulate(const AxleTrain& train, bool reversed, ForceEnvelope& envelope);
+};
+
+
+// --- Function Implementations ---
+
+inline double AxleTrain::totalLoad() const {
+    double total = 0;
+    for (double load : loads) total += load;
+    return total;
+}
+
+inline bool AxleTrain::isValid() const {
+    if (loads.empty() || loads.size() != offsets.size() || offsets[0] != 0) return false;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        if (loads[i] < 0) return false;
+        if (i > 0 && offsets[i] < offsets[i - 1]) return false;
+    }
+    return true;
+}
+
+inline AxleTrain AxleTrain::twoAxle(double totalLoad, double wheelSpan) {
+    AxleTrain train;
+    train.loads = { totalLoad / 2.0, totalLoad / 2.0 };
+    train.offsets = { 0.0, wheelSpan };
+    return train;
+}
+
+inline bool AxleTrain::parse(const std::string& text, AxleTrain& train) {
+    train.loads.clear();
+    train.offsets.clear();
+    const char* cursor = text.c_str();
+    while (*cursor) {
+        char* end = nullptr;
+        double load = std::strtod(cursor, &end);
+        if (end == cursor || *end != '@') return false;
+        cursor = end + 1;
+        double offset = std::strtod(cursor, &end);
+        if (end == cursor) return false;
+        train.loads.push_back(load);
+        train.offsets.push_back(offset * 1000.0);
+        cursor = end;
+        if (*cursor == ',' || *cursor == ';') ++cursor;
+        else if (*cursor) return false;
+    }
+    // Offsets may be given in any order; keep them sorted from the leading axle back.
+    std::vector<size_t> order(train.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return train.offsets[a] < train.offsets[b]; });
+    AxleTrain sorted;
+    double lead = order.empty() ? 0.0 : train.offsets[order[0]];
+    for (size_t i : order) {
+        sorted.loads.push_back(train.loads[i]);
+        sorted.offsets.push_back(train.offsets[i] - lead);
+    }
+    train = sorted;
+    return train.isValid();
+}
+
+inline void MovingLoadEngine::computeEnvelope(const AxleTrain& train, double span, int intervals, bool bothDirections, ForceEnvelope& envelope) {
+    if (intervals < 1) intervals = 1;
+    size_t count = (size_t)intervals + 1;
+    envelope.span = span;
+    envelope.stations.resize(count);
+    envelope.momentMax.assign(count, 0.0);
+    envelope.shearMax.assign(count, 0.0);
+    envelope.shearMin.assign(count, 0.0);
+    for (size_t i = 0; i < count; ++i) envelope.stations[i] = span * (double)i / intervals;
+    if (span <= 0 || !train.isValid()) return;
+
+    accumulate(train, false, envelope);
+    if (bothDirections) accumulate(train, true, envelope);
+}
+
+inline void MovingLoadEngine::accumulate(const AxleTrain& train, bool reversed, ForceEnvelope& envelope) {
+    size_t n = train.size();
+    double L = envelope.span;
+    double length = train.length();
+
+    // Axle j sits at p_j = s - a_j when the leading axle is at s. Prefix sums of P_j and
+    // P_j * a_j over the axles turn any run of axles into two multiply-adds.
+    offsets.resize(n);
+    loadSum.resize(n + 1);
+    momentSum.resize(n + 1);
+    loadSum[0] = momentSum[0] = 0;
+    for (size_t j = 0; j < n; ++j) {
+        size_t source = reversed ? n - 1 - j : j;
+        double a = reversed ? length - train.offsets[source] : train.offsets[source];
+        double P = train.loads[source] * 1000.0; // kN -> N
+        offsets[j] = a;
+        loadSum[j + 1] = loadSum[j] + P;
+        momentSum[j + 1] = momentSum[j] + P * a;
+    }
+
+    const double* x = envelope.stations.data();
+    double* mMax = envelope.momentMax.data();
+    double* vMax = envelope.shearMax.data();
+    double* vMin = envelope.shearMin.data();
+    size_t count = envelope.stations.size();
+
+    for (size_t k = 0; k < n; ++k) {
+        double ak = offsets[k];
+        // first: first axle still on the span (p_j <= L, i.e. a_j >= s - L);
+        // past: first axle that has not yet entered it (p_j < 0, i.e. a_j > s).
+        size_t first = 0, past = 0;
+        for (size_t i = 0; i < count; ++i) {
+            double s = x[i] + ak; // axle k on station i
+            while (first < n && offsets[first] < s - L) ++first;
+            while (past < n && offsets[past] <= s) ++past;
+
+            // Axles ahead of k (right of the station) and from k back (left of it).
+            double rightLoad = loadSum[k] - loadSum[first];
+            double rightMoment = momentSum[k] - momentSum[first];
+            double leftLoad = loadSum[past] - loadSum[k];
+            double leftMoment = momentSum[past] - momentSum[k];
+            double rightReaction = (L - s) * rightLoad + rightMoment; // sum P_j (L - p_j)
+            double leftReaction = s * leftLoad - leftMoment;          // sum P_j p_j
+
+            double moment = (x[i] * rightReaction + (L - x[i]) * leftReaction) / L;
+            if (moment > mMax[i]) mMax[i] = moment;
+
+            // Axle k just left of the station gives the most negative shear, just right
+            // of it (moving its share to the other side) the most positive.
+            double Pk = loadSum[k + 1] - loadSum[k];
+            double pk = s - ak;
+            double shearLeft = (rightReaction - leftReaction) / L;
+            double shearRight = shearLeft + Pk;
+            if (shearRight > vMax[i] && pk < L) vMax[i] = shearRight;
+            if (shearLeft < vMin[i] && pk > 0) vMin[i] = shearLeft;
+        }
+    }
+}
+
+
+#endif // MOVINGLOAD_H
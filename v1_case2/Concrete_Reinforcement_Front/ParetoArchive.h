@@ -0,0 +1,268 @@
+#pragma once
+
+#ifndef PARETOARCHIVE_H
+#define PARETOARCHIVE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// --- Incremental Pareto Archive (ND-tree) ---
+// Keeps the non-dominated set of points under insertion, all objectives minimized.
+// Points live in the leaves of a tree whose nodes carry the ideal (component-wise best)
+// and nadir (component-wise worst) point of their subtree. A new point is compared only
+// with the subtrees whose box it can interact with: a subtree whose nadir weakly
+// dominates the point rejects it at once, a subtree whose ideal it weakly dominates is
+// dropped whole, and a subtree it neither touches is skipped. For the low-dimensional
+// fronts of the section search this avoids almost all of the point-by-point comparisons
+// of a plain O(n^2) filter. (After Jaszkiewicz & Lust, "ND-Tree-Based Update", 2018.)
+template <typename Payload, int Objectives>
+class ParetoArchive
+{
+public:
+    struct Entry
+    {
+        double objectives[Objectives];
+        Payload payload;
+    };
+
+    ParetoArchive() : root(new Node()) {}
+
+    // Adds the point unless an archived point weakly dominates it (duplicates included);
+    // archived points it dominates are removed. Returns whether it was added.
+    bool insert(const double (&objectives)[Objectives], Payload payload);
+    size_t size() const { return count; }
+    void clear() { root.reset(new Node()); count = 0; }
+    // Point comparisons made so far, for judging the pruning.
+    long long comparisons() const { return comparisonCount; }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const { forEachIn(*root, visit); }
+    std::vector<Entry> entries() const;
+
+    static constexpr size_t MAX_LEAF_SIZE = 20;
+    static constexpr size_t MAX_CHILDREN = Objectives + 1;
+
+private:
+    struct Node
+    {
+        double ideal[Objectives];
+        double nadir[Objectives];
+        std::vector<Entry> points;                  // leaf
+        std::vector<std::unique_ptr<Node>> children; // internal node
+
+        Node() {
+            std::fill(ideal, ideal + Objectives, std::numeric_limits<double>::max());
+            std::fill(nadir, nadir + Objectives, std::numeric_limits<double>::lowest());
+        }
+        bool isLeaf() const { return children.empty(); }
+        bool isEmpty() const { return points.empty() && children.empty(); }
+    };
+
+    enum class Outcome { Keep, Reject };
+
+    std::unique_ptr<Node> root;
+    size_t count = 0;
+    long long comparisonCount = 0;
+
+    static bool weaklyDominates(const double* a, const double* b);
+    static void extend(Node& node, const double* objectives);
+    static double distanceToMiddle(const Node& node, const double* objectives);
+    static size_t countPoints(const Node& node);
+
+    Outcome update(Node& node, const double* objectives);
+    void insertInto(Node& node, Entry&& entry);
+    void split(Node& leaf);
+
+    template <typename Visitor>
+    static void forEachIn(const Node& node, Visitor& visit);
+};
+
+
+// --- Function Implementations ---
+
+template <typename Payload, int Objectives>
+bool ParetoArchive<Payload, Objectives>::weaklyDominates(const double* a, const double* b) {
+    for (int k = 0; k < Objectives; ++k) {
+        if (a[k] > b[k]) return false;
+    }
+    return true;
+}
+
+template <typename Payload, int Objectives>
+void ParetoArchive<Payload, Objectives>::extend(Node& node, const double* objectives) {
+    for (int k = 0; k < Objectives; ++k) {
+        node.ideal[k] = std::min(node.ideal[k], objectives[k]);
+        node.nadir[k] = std::max(node.nadir[k], objectives[k]);
+    }
+}
+
+template <typename Payload, int Objectives>
+double ParetoArchive<Payload, Objectives>::distanceToMiddle(const Node& node, const double* objectives) {
+    double sum = 0;
+    for (int k = 0; k < Objectives; ++k) {
+        double d = objectives[k] - (node.ideal[k] + node.nadir[k]) / 2.0;
+        sum += d * d;
+    }
+    return sum;
+}
+
+template <typename Payload, int Objectives>
+size_t ParetoArchive<Payload, Objectives>::countPoints(const Node& node) {
+    size_t total = node.points.size();
+    for (const auto& child : node.children) total += countPoints(*child);
+    return total;
+}
+
+template <typename Payload, int Objectives>
+bool ParetoArchive<Payload, Objectives>::insert(const double (&objectives)[Objectives], Payload payload) {
+    if (!root->isEmpty() && update(*root, objectives) == Outcome::Reject) return false;
+    if (root->isEmpty()) root.reset(new Node());
+
+    Entry entry;
+    std::copy(objectives, objectives + Objectives, entry.objectives);
+    entry.payload = std::move(payload);
+    insertInto(*root, std::move(entry));
+    ++count;
+    return true;
+}
+
+// Bounds are only widened on insertion, so after removals they may be looser than the
+// points below them. Both tests stay correct with looser bounds; they just prune less.
+template <typename Payload, int Objectives>
+typename ParetoArchive<Payload, Objectives>::Outcome ParetoArchive<Payload, Objectives>::update(Node& node, const double* objectives) {
+    if (weaklyDominates(node.nadir, objectives)) return Outcome::Reject;
+    if (weaklyDominates(objectives, node.ideal)) {
+        count -= countPoints(node);
+        node.points.clear();
+        node.children.clear();
+        return Outcome::Keep;
+    }
+    if (!weaklyDominates(objectives, node.nadir) && !weaklyDominates(node.ideal, objectives)) return Outcome::Keep;
+
+    if (node.isLeaf()) {
+        for (size_t i = 0; i < node.points.size();) {
+            ++comparisonCount;
+            if (weaklyDominates(node.points[i].objectives, objectives)) return Outcome::Reject;
+            if (weaklyDominates(objectives, node.points[i].objectives)) {
+                node.points[i] = std::move(node.points.back());
+                node.points.pop_back();
+                --count;
+            }
+            else {
+                ++i;
+            }
+        }
+        return Outcome::Keep;
+    }
+
+    for (size_t i = 0; i < node.children.size();) {
+        if (update(*node.children[i], objectives) == Outcome::Reject) return Outcome::Reject;
+        if (node.children[i]->isEmpty()) node.children.erase(node.children.begin() + i);
+        else ++i;
+    }
+    // An internal node left with one child takes its place.
+    if (node.children.size() == 1) {
+        std::unique_ptr<Node> only = std::move(node.children[0]);
+        node.children = std::move(only->children);
+        node.points = std::move(only->points);
+    }
+    return Outcome::Keep;
+}
+
+template <typename Payload, int Objectives>
+void ParetoArchive<Payload, Objectives>::insertInto(Node& node, Entry&& entry) {
+    extend(node, entry.objectives);
+    if (node.isLeaf()) {
+        node.points.push_back(std::move(entry));
+        if (node.points.size() > MAX_LEAF_SIZE) split(node);
+        return;
+    }
+    Node* closest = node.children[0].get();
+    double best = distanceToMiddle(*closest, entry.objectives);
+    for (size_t i = 1; i < node.children.size(); ++i) {
+        double d = distanceToMiddle(*node.children[i], entry.objectives);
+        if (d < best) { best = d; closest = node.children[i].get(); }
+    }
+    insertInto(*closest, std::move(entry));
+}
+
+// Turns an overfull leaf into an internal node. The seeds of the new leaves are spread
+// out greedily (each is the point farthest, on average, from the seeds chosen so far)
+// and every other point joins the leaf of its nearest seed.
+template <typename Payload, int Objectives>
+void ParetoArchive<Payload, Objectives>::split(Node& leaf) {
+    std::vector<Entry> points = std::move(leaf.points);
+    leaf.points.clear();
+
+    auto distance = [](const Entry& a, const Entry& b) {
+        double sum = 0;
+        for (int k = 0; k < Objectives; ++k) sum += (a.objectives[k] - b.objectives[k]) * (a.objectives[k] - b.objectives[k]);
+        return sum;
+    };
+
+    std::vector<double> seedDistance(points.size(), 0.0);
+    std::vector<bool> isSeed(points.size(), false);
+    std::vector<size_t> seeds;
+    // First seed: the point farthest on average from all others.
+    size_t first = 0;
+    double firstScore = -1;
+    for (size_t i = 0; i < points.size(); ++i) {
+        double score = 0;
+        for (size_t j = 0; j < points.size(); ++j) score += distance(points[i], points[j]);
+        if (score > firstScore) { firstScore = score; first = i; }
+    }
+    seeds.push_back(first);
+    isSeed[first] = true;
+    while (seeds.size() < MAX_CHILDREN) {
+        size_t next = points.size();
+        double nextScore = -1;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (isSeed[i]) continue;
+            seedDistance[i] += distance(points[i], points[seeds.back()]);
+            if (seedDistance[i] > nextScore) { nextScore = seedDistance[i]; next = i; }
+        }
+        if (next == points.size()) break;
+        seeds.push_back(next);
+        isSeed[next] = true;
+    }
+
+    for (size_t s : seeds) {
+        std::unique_ptr<Node> child(new Node());
+        extend(*child, points[s].objectives);
+        child->points.push_back(std::move(points[s]));
+        leaf.children.push_back(std::move(child));
+    }
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (isSeed[i]) continue;
+        Node* closest = leaf.children[0].get();
+        double best = distanceToMiddle(*closest, points[i].objectives);
+        for (size_t c = 1; c < leaf.children.size(); ++c) {
+            double d = distanceToMiddle(*leaf.children[c], points[i].objectives);
+            if (d < best) { best = d; closest = leaf.children[c].get(); }
+        }
+        extend(*closest, points[i].objectives);
+        closest->points.push_back(std::move(points[i]));
+    }
+}
+
+template <typename Payload, int Objectives>
+template <typename Visitor>
+void ParetoArchive<Payload, Objectives>::forEachIn(const Node& node, Visitor& visit) {
+    for (const Entry& entry : node.points) visit(entry);
+    for (const auto& child : node.children) forEachIn(*child, visit);
+}
+
+template <typename Payload, int Objectives>
+std::vector<typename ParetoArchive<Payload, Objectives>::Entry> ParetoArchive<Payload, Objectives>::entries() const {
+    std::vector<Entry> all;
+    all.reserve(count);
+    forEach([&all](const Entry& entry) { all.push_back(entry); });
+    return all;
+}
+
+
+#endif // PARETOARCHIVE_H
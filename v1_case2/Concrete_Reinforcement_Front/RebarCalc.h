@@ -10,7 +10,14 @@
 #include <string>
 #include <limits>
 #include <map>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
 #include <opencv2/opencv.hpp>
+#include "MovingLoad.h"
+#include "ContinuousBeam.h"
+#include "ParetoArchive.h"
+#include "Instrumentation.h"
 
 // Use M_PI from cmath for better precision
 #ifndef M_PI
@@ -21,12 +28,106 @@ class Concrete_Reinforcement_Front;
 
 // --- Engineering and Design Constants ---
 constexpr double CONCRETE_COVER = 30.0;
-constexpr double CONCRETE_UNIT_WEIGHT = 2.5e-5; // N/mm^3
-constexpr double CONCRETE_FC = 32.4;            // C50 Concrete Compressive Strength (MPa)
-constexpr double CONCRETE_FT = 2.65;            // C50 Concrete Tensile Strength (MPa)
-constexpr double STEEL_FY = 400.0;              // HRB400 Steel Yield Strength (MPa)
-constexpr double STEEL_DENSITY = 7.85e-6;       // ton/mm^3
-constexpr double XI_B_LIMIT = 0.518;            // Ductile failure limit
+
+// --- Material Grades ---
+// Each grade is a policy class of compile-time constants. RebarCalcT is specialized on one
+// concrete and one steel grade, so the design loops only ever see literals. Strengths are
+// the characteristic values of GB 50010 in MPa (C50 keeps the 2.65 MPa tensile strength the
+// engine has always used); beta1 and epsilonCu describe the concrete stress block.
+enum class ConcreteGrade { C30, C35, C40, C45, C50, C55, C60 };
+enum class SteelGrade { HRB335, HRB400, HRB500 };
+
+struct C30 { static constexpr ConcreteGrade grade = ConcreteGrade::C30; static constexpr double fc = 20.1, ft = 2.01, beta1 = 0.80, epsilonCu = 0.0033, unitWeight = 2.5e-5; };
+struct C35 { static constexpr ConcreteGrade grade = ConcreteGrade::C35; static constexpr double fc = 23.4, ft = 2.20, beta1 = 0.80, epsilonCu = 0.0033, unitWeight = 2.5e-5; };
+struct C40 { static constexpr ConcreteGrade grade = ConcreteGrade::C40; static constexpr double fc = 26.8, ft = 2.39, beta1 = 0.80, epsilonCu = 0.0033, unitWeight = 2.5e-5; };
+struct C45 { static constexpr ConcreteGrade grade = ConcreteGrade::C45; static constexpr double fc = 29.6, ft = 2.51, beta1 = 0.80, epsilonCu = 0.0033, unitWeight = 2.5e-5; };
+struct C50 { static constexpr ConcreteGrade grade = ConcreteGrade::C50; static constexpr double fc = 32.4, ft = 2.65, beta1 = 0.80, epsilonCu = 0.0033, unitWeight = 2.5e-5; };
+struct C55 { static constexpr ConcreteGrade grade = ConcreteGrade::C55; static constexpr double fc = 35.5, ft = 2.74, beta1 = 0.79, epsilonCu = 0.00325, unitWeight = 2.5e-5; };
+struct C60 { static constexpr ConcreteGrade grade = ConcreteGrade::C60; static constexpr double fc = 38.5, ft = 2.85, beta1 = 0.78, epsilonCu = 0.0032, unitWeight = 2.5e-5; };
+
+// fy is the strength used in the design; fyDesign (the code's design value) only sets xi_b.
+struct HRB335 { static constexpr SteelGrade grade = SteelGrade::HRB335; static constexpr double fy = 335.0, fyDesign = 300.0, Es = 2.0e5, density = 7.85e-6; };
+struct HRB400 { static constexpr SteelGrade grade = SteelGrade::HRB400; static constexpr double fy = 400.0, fyDesign = 360.0, Es = 2.0e5, density = 7.85e-6; };
+struct HRB500 { static constexpr SteelGrade grade = SteelGrade::HRB500; static constexpr double fy = 500.0, fyDesign = 435.0, Es = 2.0e5, density = 7.85e-6; };
+
+// Relative depth of the compression zone at balanced failure, rounded to three decimals as
+// tabulated in the code (C50 / HRB400 gives 0.518).
+constexpr double balancedXiLimit(double beta1, double epsilonCu, double fyDesign, double Es) {
+    return (double)(long long)(beta1 / (1.0 + fyDesign / (Es * epsilonCu)) * 1000.0 + 0.5) / 1000.0;
+}
+
+// A grade combination as chosen at run time (batch rows, command line).
+struct MaterialGrade
+{
+    ConcreteGrade concrete = ConcreteGrade::C50;
+    SteelGrade steel = SteelGrade::HRB400;
+
+    bool operator==(const MaterialGrade& other) const { return concrete == other.concrete && steel == other.steel; }
+    bool operator!=(const MaterialGrade& other) const { return !(*this == other); }
+    int code() const { return (int)concrete * 3 + (int)steel; }
+    // The inverse of code(); false for a number that is not the code of any combination.
+    static bool fromCode(int code, MaterialGrade& grade) {
+        if (code < 0 || code >= CODE_COUNT) return false;
+        grade.concrete = (ConcreteGrade)(code / 3);
+        grade.steel = (SteelGrade)(code % 3);
+        return true;
+    }
+
+    static constexpr int CODE_COUNT = 7 * 3;
+};
+
+inline const char* concreteGradeName(ConcreteGrade grade) {
+    static const char* const names[] = { "C30", "C35", "C40", "C45", "C50", "C55", "C60" };
+    return names[(int)grade];
+}
+
+inline const char* steelGradeName(SteelGrade grade) {
+    static const char* const names[] = { "HRB335", "HRB400", "HRB500" };
+    return names[(int)grade];
+}
+
+// Accepts "C40", "c40" or just the cube strength "40".
+inline bool parseConcreteGrade(const std::string& text, ConcreteGrade& grade) {
+    std::string digits = (!text.empty() && (text[0] == 'C' || text[0] == 'c')) ? text.substr(1) : text;
+    static const char* const strengths[] = { "30", "35", "40", "45", "50", "55", "60" };
+    for (int i = 0; i < 7; ++i) {
+        if (digits == strengths[i]) { grade = (ConcreteGrade)i; return true; }
+    }
+    return false;
+}
+
+// Accepts "HRB400", "hrb400" or just the yield strength "400".
+inline bool parseSteelGrade(const std::string& text, SteelGrade& grade) {
+    std::string digits = text;
+    if (digits.size() > 3 && (digits.compare(0, 3, "HRB") == 0 || digits.compare(0, 3, "hrb") == 0)) digits = digits.substr(3);
+    static const char* const strengths[] = { "335", "400", "500" };
+    for (int i = 0; i < 3; ++i) {
+        if (digits == strengths[i]) { grade = (SteelGrade)i; return true; }
+    }
+    return false;
+}
+
+// --- Standard Bars and Unit Prices ---
+constexpr double STANDARD_REBAR_DIAMETERS[] = { 14, 16, 18, 20, 22, 25, 28 };
+constexpr int STANDARD_REBAR_COUNT = sizeof(STANDARD_REBAR_DIAMETERS) / sizeof(STANDARD_REBAR_DIAMETERS[0]);
+constexpr double COST_CONCRETE_PER_M3 = 600.0;
+constexpr double COST_REBAR_BASE_PER_TON = 3500.0;
+constexpr double COST_PER_REBAR_TIED = 300.0;
+
+// --- Unit Prices ---
+// Prices used for costing (Yuan); the defaults are the constants above. The vectorized
+// batch kernel always prices with the defaults.
+struct CostRates
+{
+    double concretePerM3 = COST_CONCRETE_PER_M3;
+    double rebarBasePerTon = COST_REBAR_BASE_PER_TON;
+    double perRebarTied = COST_PER_REBAR_TIED;
+
+    bool operator==(const CostRates& other) const {
+        return concretePerM3 == other.concretePerM3 && rebarBasePerTon == other.rebarBasePerTon && perRebarTied == other.perRebarTied;
+    }
+    bool operator!=(const CostRates& other) const { return !(*this == other); }
+};
 
 // --- Bridge Structural Parameters ---
 struct BridgeParams
@@ -37,10 +138,92 @@ struct BridgeParams
     double h0; // Effective height
     double wheelSpan;
     double girderSpacing;
+    // Continuous girders only: the spans (mm) from left to right, with span their sum.
+    // spanCount is 0 for a simply supported span.
+    int spanCount;
+    double spans[MAX_CONTINUOUS_SPANS];
+};
+
+// Top bars over an interior support run this fraction of the longer adjacent span past
+// it on either side.
+constexpr double HOGGING_BAR_EXTENSION = 0.3;
+
+// Number of spans drawn and costed: spanCount for a continuous girder, otherwise 1.
+inline int girderSpanCount(const BridgeParams& params) {
+    return params.spanCount > 1 ? params.spanCount : 1;
+}
+
+// Distance (mm) of support 0..girderSpanCount from the left end of the girder.
+inline double supportPosition(const BridgeParams& params, int support) {
+    if (params.spanCount <= 1) return support > 0 ? params.span : 0.0;
+    double x = 0;
+    for (int j = 0; j < support && j < params.spanCount; ++j) x += params.spans[j];
+    return x;
+}
+
+// Extent (mm) of the top bars over interior support 1..spanCount-1.
+inline void hoggingBarExtent(const BridgeParams& params, int support, double& start, double& end) {
+    double x = supportPosition(params, support);
+    double reach = HOGGING_BAR_EXTENSION * std::max(params.spans[support - 1], params.spans[support]);
+    start = std::max(0.0, x - reach);
+    end = std::min(params.span, x + reach);
+}
+
+// --- Stirrup Zones ---
+// A stretch of the span (mm from the left support) with one stirrup spacing. Zones are
+// symmetric about midspan and densest at the supports; half a span holds at most one zone
+// per spacing step (100..200 mm in 25 mm steps), so a full span needs at most 9.
+struct StirrupZone
+{
+    double start;
+    double end;
+    double spacing;
+};
+constexpr int MAX_STIRRUP_ZONES = 9;
+
+// --- Design Error Codes ---
+// The failures of a design as codes, for the design kernel and the stored designs.
+// designErrorCode maps a RebarDesign::errorMessage back; messages without a code of their
+// own map to Other and come back as a generic message.
+enum class DesignErrorCode : uint16_t
+{
+    None,
+    NoReinforcement,
+    NoTopReinforcement,
+    InvalidAxleTrain,
+    InvalidSpans,
+    EmptySearchSpace,
+    NoFeasibleSection,
+    Cancelled,
+    Other
 };
 
+inline const char* designErrorMessage(DesignErrorCode code) {
+    switch (code) {
+    case DesignErrorCode::None: return "";
+    case DesignErrorCode::NoReinforcement: return "Error: No valid reinforcement combination found.\nIncrease beam dimensions.";
+    case DesignErrorCode::NoTopReinforcement: return "Error: No top reinforcement fits over the supports.\nIncrease beam dimensions.";
+    case DesignErrorCode::InvalidAxleTrain: return "Error: Invalid axle train.";
+    case DesignErrorCode::InvalidSpans: return "Error: A continuous girder needs 2 to 6 spans greater than zero.";
+    case DesignErrorCode::EmptySearchSpace: return "Error: Empty section search space.";
+    case DesignErrorCode::NoFeasibleSection: return "Error: No feasible section in the search space.\nWiden the width/height ranges.";
+    case DesignErrorCode::Cancelled: return "Design cancelled.";
+    default: return "Error: The design failed.";
+    }
+}
+
+inline DesignErrorCode designErrorCode(const std::string& errorMessage) {
+    if (errorMessage.empty()) return DesignErrorCode::None;
+    for (int code = (int)DesignErrorCode::NoReinforcement; code < (int)DesignErrorCode::Other; ++code) {
+        if (errorMessage == designErrorMessage((DesignErrorCode)code)) return (DesignErrorCode)code;
+    }
+    return DesignErrorCode::Other;
+}
+
 // --- Reinforcement Design Results ---
-struct RebarDesign
+// Everything of a design but its message. Trivially copyable, so the design kernel
+// (RebarCalc::designKernel) can hand one over without touching the heap.
+struct RebarDesignCore
 {
     int rebarRows = 0;
     int rebarCountRow1 = 0;
@@ -48,7 +231,9 @@ struct RebarDesign
     double flexureRebarDiameter = 0;
     int stirrupLegs = 0;
     double stirrupDiameter = 0;
-    double stirrupSpacing = 0;
+    double stirrupSpacing = 0; // the densest zone when the stirrups are zoned
+    int stirrupZoneCount = 0;  // 0: stirrupSpacing applies over the whole span
+    StirrupZone stirrupZones[MAX_STIRRUP_ZONES] = {};
     bool bentRebarsUsed = false;
     int bentRebarCount = 0;
     double totalCost = 0;
@@ -57,61 +242,387 @@ struct RebarDesign
     double laborCost = 0;
     double maxMoment = 0; // N*mm
     double maxShear = 0;  // N
+    // Continuous girders: top bars over every interior support for the largest hogging
+    // moment, which is stored as a positive value. Two rows split the bars as below.
+    double hoggingMoment = 0; // N*mm
+    double topRebarDiameter = 0;
+    int topRebarCount = 0;
+    int topRebarRows = 0;
+    // Mixed-diameter layouts (RebarCalc::setMixedDiameters): row r holds rowBarCounts[r][0]
+    // bars of rowDiameters[r][0] and rowBarCounts[r][1] of the smaller rowDiameters[r][1].
+    // rebarCountRow1/2 are the row totals and flexureRebarDiameter is the larger bar of the
+    // bottom row, which also gives the bent bars. Unused when every bar has one diameter.
+    bool mixedDiameters = false;
+    double rowDiameters[2][2] = {};
+    int rowBarCounts[2][2] = {};
     bool designPossible = true;
+};
+static_assert(std::is_trivially_copyable<RebarDesignCore>::value, "RebarDesignCore must stay a plain record");
+
+struct RebarDesign : RebarDesignCore
+{
     std::string errorMessage;
 };
 
+// Flexural steel area (mm^2) of a layout, with one or mixed diameters.
+inline double flexuralSteelArea(const RebarDesignCore& design) {
+    if (!design.mixedDiameters) return (design.rebarCountRow1 + design.rebarCountRow2) * (M_PI * pow(design.flexureRebarDiameter / 2.0, 2));
+    double area = 0;
+    for (int row = 0; row < 2; ++row) {
+        for (int j = 0; j < 2; ++j) area += design.rowBarCounts[row][j] * (M_PI * pow(design.rowDiameters[row][j] / 2.0, 2));
+    }
+    return area;
+}
+
+// Bars of row 0 (bottom) or 1 from left to right: the larger bars at both corners and
+// spread over the row, the smaller ones between them. The first `skipLarge` larger bars
+// are left out (bent bars, which are drawn on their own). Returns the number written.
+inline int flexuralRowBars(const RebarDesignCore& design, int row, int skipLarge, double* diameters, int capacity) {
+    if (row >= design.rebarRows) return 0;
+    double large = design.mixedDiameters ? design.rowDiameters[row][0] : design.flexureRebarDiameter;
+    double small = design.rowDiameters[row][1];
+    int largeCount = design.mixedDiameters ? design.rowBarCounts[row][0] : (row == 0 ? design.rebarCountRow1 : design.rebarCountRow2);
+    int smallCount = design.mixedDiameters ? design.rowBarCounts[row][1] : 0;
+    largeCount = std::max(0, largeCount - skipLarge);
+    int count = std::min(capacity, largeCount + smallCount);
+    for (int i = 0; i < count; ++i) diameters[i] = small;
+    // With every larger bar bent up, only smaller bars are left to draw.
+    if (largeCount == 1 || (largeCount > 0 && count == 1)) diameters[count / 2] = large;
+    else if (largeCount > 1) {
+        for (int i = 0; i < largeCount; ++i) diameters[(int)std::lround((double)i * (count - 1) / (largeCount - 1))] = large;
+    }
+    return count;
+}
+
+// One row as text, such as "3 x d25 + 2 x d22", leaving out bent bars as above.
+inline std::string flexuralRowText(const RebarDesignCore& design, int row, int skipLarge) {
+    double large = design.mixedDiameters ? design.rowDiameters[row][0] : design.flexureRebarDiameter;
+    int largeCount = design.mixedDiameters ? design.rowBarCounts[row][0] : (row == 0 ? design.rebarCountRow1 : design.rebarCountRow2);
+    std::string text = std::to_string(std::max(0, largeCount - skipLarge)) + " x d" + std::to_string((int)large);
+    if (design.mixedDiameters && design.rowBarCounts[row][1] > 0) {
+        text += " + " + std::to_string(design.rowBarCounts[row][1]) + " x d" + std::to_string((int)design.rowDiameters[row][1]);
+    }
+    return text;
+}
+
+// The whole layout: "6 x d25 (4 + 2)" with one diameter, the rows from the bottom up
+// separated by " / " with mixed diameters.
+inline std::string flexuralLayoutText(const RebarDesignCore& design) {
+    if (design.mixedDiameters) {
+        std::string text = flexuralRowText(design, 0, 0);
+        if (design.rebarRows > 1) text += " / " + flexuralRowText(design, 1, 0);
+        return text;
+    }
+    std::string text = std::to_string(design.rebarCountRow1 + design.rebarCountRow2) + " x d" + std::to_string((int)design.flexureRebarDiameter);
+    if (design.rebarRows > 1) text += " (" + std::to_string(design.rebarCountRow1) + " + " + std::to_string(design.rebarCountRow2) + ")";
+    return text;
+}
+
+// --- Joint Section Search Space ---
+// Ranges explored by the section optimizer (all lengths in mm). Flexural bars
+// always come from STANDARD_REBAR_DIAMETERS.
+struct SectionSearchSpace
+{
+    double minWidth = 200;
+    double maxWidth = 1200;
+    double widthStep = 50;
+    double minHeight = 400;
+    double maxHeight = 2500;
+    double heightStep = 50;
+    std::vector<double> stirrupDiameters = { 8, 10, 12 };
+    std::vector<int> stirrupLegCounts = { 2, 4 };
+};
+
+// --- Section Optimizer Statistics ---
+struct SectionSearchStats
+{
+    long long candidatesInSpace = 0;      // sections x flexural diameters x stirrup options
+    long long candidatesEvaluated = 0;    // candidates that were fully designed and costed
+    long long sectionsVisited = 0;
+    long long sectionsPrunedByCost = 0;   // cut by the lower cost bound
+    long long flexurePrunedByBound = 0;   // cut by a known xi / row-capacity failure of a deeper section
+};
+
+// --- Pareto Front Member ---
+// One non-dominated design of the multi-objective search. All four objectives are
+// minimized: total cost, steel weight, section height and congestion.
+struct ParetoDesign
+{
+    RebarDesign design;
+    BridgeParams params = {};
+    double steelWeight = 0; // ton, flexural bars and stirrups of all girders
+    double congestion = 0;  // fullest bar row as a fraction of calculateMaxBarsPerRow
+};
+constexpr int PARETO_OBJECTIVES = 4;
+
+// --- Flexural Section Geometry ---
+// The parts of the flexural check that depend only on the section and the bar diameter,
+// so they can be kept while the design forces change.
+struct FlexureGeometry
+{
+    double diameter = 0;
+    double barArea = 0;      // mm^2
+    double h0OneRow = 0;     // effective depth with a single row of bars
+    double minRebarArea = 0; // mm^2
+    int maxBarsPerRow = 0;
+};
+
+// --- Mixed-Diameter Bar Rows ---
+// One way to fill a bar row: largeCount bars of largeDiameter and smallCount bars of the
+// smaller smallDiameter. cost is that of the bars over the span, tying included, and
+// firstMoment is sum(A * d / 2) about the underside of the row (mm^3).
+struct BarRowFill
+{
+    double largeDiameter;
+    double smallDiameter;
+    int largeCount;
+    int smallCount;
+    double area;
+    double cost;
+    double firstMoment;
+};
+
+// Every fill of one section that meets the bar spacing rules, for the bottom row (at
+// least two large bars, for the corners and the bent bars) and the row above it.
+// rows[r][k] holds the fills whose larger bar is STANDARD_REBAR_DIAMETERS[k] by
+// increasing area, and with it increasing cost: a fill costing as much as one with more
+// area is dropped. This is the knapsack table of the row, and the cheapest fill with
+// enough area is a binary search away.
+struct BarRowTable
+{
+    std::vector<BarRowFill> rows[2][STANDARD_REBAR_COUNT];
+};
+// Mixed layouts tried by findOptimalDesign: one and two rows for every bottom-row bar.
+constexpr int MIXED_FLEXURE_CANDIDATES = 2 * STANDARD_REBAR_COUNT;
+
+// --- Design Kernel ---
+// Buffers a design works in. They grow to fit the widest section seen and are then
+// reused, so that once warm a design no longer allocates. One per thread.
+struct DesignScratch
+{
+    BarRowTable barRows;
+    std::vector<BarRowFill> fills; // every fill of one larger bar, before the cost filter
+};
+
+// What RebarCalc::designKernel hands back: a fixed-size record with an error code in
+// place of the message (designErrorMessage gives the text).
+struct DesignKernelResult
+{
+    DesignErrorCode error = DesignErrorCode::None;
+    BridgeParams params = {};
+    RebarDesignCore design;
+};
+
+// --- Drawing Sizes (pixels) ---
+const cv::Size CROSS_SECTION_IMAGE_SIZE(600, 600);
+const cv::Size LONGITUDINAL_IMAGE_SIZE(1200, 400);
+
+template <typename Concrete, typename Steel>
+class DesignPipelineT;
+
 // --- Main Calculation Class ---
-class RebarCalc
+// Specialized on the concrete and steel grade policies above; RebarCalc is the C50 / HRB400
+// engine used by the GUI. dispatchMaterialGrade picks a specialization at run time.
+template <typename Concrete, typename Steel>
+class RebarCalcT
 {
 public:
-    RebarCalc();
-    ~RebarCalc();
+    // Material constants of this grade combination, all evaluated at compile time.
+    static constexpr double CONCRETE_FC = Concrete::fc;                 // Compressive strength (MPa)
+    static constexpr double CONCRETE_FT = Concrete::ft;                 // Tensile strength (MPa)
+    static constexpr double CONCRETE_UNIT_WEIGHT = Concrete::unitWeight; // N/mm^3
+    static constexpr double STEEL_FY = Steel::fy;                       // Yield strength (MPa)
+    static constexpr double STEEL_DENSITY = Steel::density;             // ton/mm^3
+    static constexpr double XI_B_LIMIT = balancedXiLimit(Concrete::beta1, Concrete::epsilonCu, Steel::fyDesign, Steel::Es); // Ductile failure limit
+    static MaterialGrade materialGrade() { return { Concrete::grade, Steel::grade }; }
+
+    RebarCalcT();
+    ~RebarCalcT();
     bool runDesign(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing);
+    // The runDesign design for hot loops: it formats no message and works in the caller's
+    // scratch, so it makes no heap allocation once the scratch is warm. The result is
+    // also stored like a runDesign one, with an empty errorMessage.
+    bool designKernel(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        DesignScratch& scratch, DesignKernelResult& result);
+    // Same design, but the live load is an arbitrary axle train stepped across the span;
+    // the governing forces come from the moment and shear envelopes.
+    bool runDesign(double span, double width, double height, const AxleTrain& train, double girderSpacing);
+    // Live-load envelopes of the last train design (already scaled by the girder distribution factors).
+    const ForceEnvelope& getForceEnvelope() const { return liveEnvelope; }
+    // Continuous girder over 2..MAX_CONTINUOUS_SPANS spans (mm) under a moving axle train.
+    // Support moments come from the three-moment equation; the bottom bars are designed
+    // for the largest sagging moment and run the full length, top bars over the interior
+    // supports for the largest hogging moment. Stirrups are uniform at the governing shear.
+    bool runContinuousDesign(const std::vector<double>& spans, double width, double height, const AxleTrain& train, double girderSpacing);
+    // Live-load envelopes of the last continuous design (already scaled by the girder distribution factors).
+    const ContinuousEnvelope& getContinuousEnvelope() const { return continuousEnvelope; }
+    // Designs one girder of a deck whose lateral distribution is already known (e.g. from
+    // a grillage): the vehicle loads in kN are this girder's shares, no AASHTO factors are
+    // applied and the cost is that of this girder alone.
+    bool runGirderDesign(double span, double width, double height, double momentVehicleLoad, double shearVehicleLoad, double wheelSpan);
+    // Searches width, height, flexural bar, stirrup bar and stirrup legs together for the
+    // cheapest feasible section. The winning section is stored like a runDesign result.
+    bool runSectionOptimization(double span, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        const SectionSearchSpace& space = SectionSearchSpace());
+    const SectionSearchStats& getSearchStats() const { return searchStats; }
+    // Searches the same space as runSectionOptimization, plus a two-row bar layout where one
+    // row would do, and returns every design that no other beats on cost, steel weight,
+    // height and congestion together, cheapest first. The cheapest is stored like a
+    // runDesign result.
+    bool runParetoOptimization(double span, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+        std::vector<ParetoDesign>& front, const SectionSearchSpace& space = SectionSearchSpace());
+    // Long searches poll this flag and give up early once it is set (used by the GUI
+    // to abandon a design whose inputs have already changed).
+    void setCancellationFlag(const std::atomic<bool>* flag) { cancelFlag = flag; }
+    bool cancelled() const { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); }
+    // When enabled the stirrup spacing follows the shear demand along the span (dense near
+    // the supports, sparse at midspan) instead of the support shear over the whole span.
+    // Off by default, which keeps runDesign identical to the BeamBatch kernel.
+    void setStirrupZoning(bool enabled) { zonedStirrups = enabled; }
+    bool stirrupZoningEnabled() const { return zonedStirrups; }
+    // Unit prices of all later designs. DesignCache entries assume the default prices.
+    void setCostRates(const CostRates& rates) { costRates = rates; }
+    const CostRates& getCostRates() const { return costRates; }
+    // When enabled, designs may combine two bar diameters in a row and use other bars in
+    // the second row; the cheapest such layout competes with the one-diameter layouts.
+    // The section and Pareto searches keep one diameter. Off by default, like zoning.
+    void setMixedDiameters(bool enabled) { mixedDiameters = enabled; }
+    bool mixedDiametersEnabled() const { return mixedDiameters; }
     cv::Mat generateCrossSectionImage();
     cv::Mat generateLongitudinalSectionImage();
+    // Draw into a caller-owned buffer (e.g. one shared with a QImage) instead of a new Mat.
+    // The buffer must be CROSS_SECTION_IMAGE_SIZE / LONGITUDINAL_IMAGE_SIZE and CV_8UC3 or
+    // CV_8UC4 (BGRA byte order, alpha written as 255); anything else is reallocated as CV_8UC3.
+    void drawCrossSection(cv::Mat& image);
+    void drawLongitudinalSection(cv::Mat& image);
     const RebarDesign& getDesignResults() const { return design; }
+    const BridgeParams& getParams() const { return params; }
+    // Shares (kN) of a vehicle load carried by one girder for moment and shear, by the
+    // AASHTO lever factors for this girder spacing (mm).
+    void distributeVehicleLoad(double totalVehicleLoad, double girderSpacing, double& momentLoad, double& shearLoad) const;
+    // Stirrup zones of the current design, always at least one (a uniformly spaced design
+    // reports a single zone over the whole span). Returns the number of zones written.
+    int getStirrupZones(StirrupZone (&zones)[MAX_STIRRUP_ZONES]) const;
+    // Drawing colour (BGR) of a flexural bar diameter; black for diameters without one.
+    cv::Scalar getRebarColor(double diameter) const {
+        auto found = rebarColorMap.find(diameter);
+        return found != rebarColorMap.end() ? found->second : cv::Scalar(0, 0, 0, 255);
+    }
+    // Loads a previously computed design (e.g. from a cache) as if runDesign had produced it.
+    void restoreDesign(const BridgeParams& savedParams, const RebarDesign& savedDesign) { params = savedParams; design = savedDesign; }
+    void restoreDesign(const BridgeParams& savedParams, const RebarDesignCore& savedDesign, DesignErrorCode error) {
+        params = savedParams;
+        static_cast<RebarDesignCore&>(design) = savedDesign;
+        design.errorMessage = designErrorMessage(error);
+    }
 
 private:
+    // Times the private design stages one by one (bench/RebarCalcBench.cpp).
+    friend class RebarCalcBench;
+    // Runs the design stages one by one and keeps their results (DesignPipeline.h).
+    friend class DesignPipelineT<Concrete, Steel>;
+
     // Member variables store the FINAL optimized design
     BridgeParams params;
     RebarDesign design;
+    SectionSearchStats searchStats;
+    const std::atomic<bool>* cancelFlag = nullptr;
+    MovingLoadEngine movingLoad;
+    ForceEnvelope liveEnvelope;
+    ContinuousBeamAnalyzer continuousBeam;
+    ContinuousEnvelope continuousEnvelope;
+    bool zonedStirrups = false;
+    bool mixedDiameters = false;
+    CostRates costRates;
+    DesignScratch scratch; // of the runDesign family; designKernel brings its own
+    // Shear demand (N) at the support-side end of each interval of the half span, already
+    // made non-increasing towards midspan. Only filled when zoning is enabled.
+    static constexpr int SHEAR_PROFILE_INTERVALS = 16;
+    double shearDemand[SHEAR_PROFILE_INTERVALS] = {};
     std::map<double, cv::Scalar> rebarColorMap;
 
     void initializeColorMap();
     void resetDesign();
+    void loadSimpleSpan(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing);
     void calculateMaxForces(double vehicleLoadForMoment, double vehicleLoadForShear);
+    void calculateEnvelopeForces(const AxleTrain& train, double momentFactor, double shearFactor);
+    void calculateContinuousForces(const std::vector<double>& spans, const AxleTrain& train, double momentFactor, double shearFactor);
+    bool designHoggingReinforcement();
 
     // Core optimization function
     bool findOptimalDesign();
+    bool findOptimalLayout(DesignScratch& workspace); // findOptimalDesign without the message
 
     // Helper functions for calculations on temporary data
+    bool designFlexureForDiameter(double diameter, RebarDesign& tempDesign, BridgeParams& tempParams, int minRows = 1) const;
+    FlexureGeometry flexureGeometry(double diameter, const BridgeParams& section) const;
+    bool designFlexure(const FlexureGeometry& geometry, RebarDesign& tempDesign, BridgeParams& tempParams, int minRows = 1) const;
+    void buildBarRowTable(const BridgeParams& section, DesignScratch& workspace) const;
+    bool designMixedFlexure(const BarRowTable& table, int bottomBar, int rows, RebarDesign& tempDesign, BridgeParams& tempParams) const;
     void designShearForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const;
+    void designShearForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams, double stirrupDiameter, int stirrupLegs) const;
+    void designStirrupZones(RebarDesign& tempDesign, const BridgeParams& tempParams) const;
     void calculateTotalCostForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const;
+    static void steelQuantities(const RebarDesign& tempDesign, const BridgeParams& tempParams, double& flexuralTon, double& stirrupTon, double& stirrupCount);
+    static double stirrupSpacingFor(double Vs_required, double stirrupResistance);
     int calculateMaxBarsPerRow(double diameter, const BridgeParams& tempParams) const;
+    double sectionCostLowerBound(const RebarDesign& forces, const BridgeParams& section, const SectionSearchSpace& space) const;
+    static double girderCount(const BridgeParams& tempParams);
 };
 
 
 // --- Function Implementations ---
 
-inline RebarCalc::RebarCalc() {
+template <typename Concrete, typename Steel>
+inline RebarCalcT<Concrete, Steel>::RebarCalcT() {
     initializeColorMap();
     resetDesign();
 }
 
-inline void RebarCalc::initializeColorMap() {
-    rebarColorMap[14] = cv::Scalar(255, 0, 0); rebarColorMap[16] = cv::Scalar(0, 128, 0); rebarColorMap[18] = cv::Scalar(0, 255, 255); rebarColorMap[20] = cv::Scalar(0, 165, 255); rebarColorMap[22] = cv::Scalar(255, 0, 255); rebarColorMap[25] = cv::Scalar(128, 0, 128); rebarColorMap[28] = cv::Scalar(42, 42, 165);
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::initializeColorMap() {
+    rebarColorMap[14] = cv::Scalar(255, 0, 0, 255); rebarColorMap[16] = cv::Scalar(0, 128, 0, 255); rebarColorMap[18] = cv::Scalar(0, 255, 255, 255); rebarColorMap[20] = cv::Scalar(0, 165, 255, 255); rebarColorMap[22] = cv::Scalar(255, 0, 255, 255); rebarColorMap[25] = cv::Scalar(128, 0, 128, 255); rebarColorMap[28] = cv::Scalar(42, 42, 165, 255);
 }
 
-inline RebarCalc::~RebarCalc() {}
+template <typename Concrete, typename Steel>
+inline RebarCalcT<Concrete, Steel>::~RebarCalcT() {}
 
-inline void RebarCalc::resetDesign() {
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::resetDesign() {
     params = {};
     design = {};
     design.designPossible = true;
+    liveEnvelope.clear();
+    continuousEnvelope.clear();
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runDesign(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing)
+{
+    REBAR_TIME_SCOPE(Design);
+    loadSimpleSpan(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing);
+    return findOptimalDesign();
 }
 
-inline bool RebarCalc::runDesign(double span, double width, double height, double totalVehicleLoad, double wheelSpan, double girderSpacing)
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::designKernel(double span, double width, double height, double totalVehicleLoad, double wheelSpan,
+    double girderSpacing, DesignScratch& workspace, DesignKernelResult& result)
+{
+    REBAR_TIME_SCOPE(Design);
+    loadSimpleSpan(span, width, height, totalVehicleLoad, wheelSpan, girderSpacing);
+    bool success = findOptimalLayout(workspace);
+    if (!success) design.designPossible = false;
+    result.error = success ? DesignErrorCode::None : DesignErrorCode::NoReinforcement;
+    result.params = params;
+    result.design = design;
+    return success;
+}
+
+// Everything runDesign does before the search: the section, the girder's share of the
+// vehicle load and the governing forces.
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::loadSimpleSpan(double span, double width, double height, double totalVehicleLoad, double wheelSpan,
+    double girderSpacing)
 {
     resetDesign();
 
@@ -121,6 +632,59 @@ inline bool RebarCalc::runDesign(double span, double width, double height, doubl
     params.wheelSpan = wheelSpan * 1000.0; // Convert m to mm
     params.girderSpacing = girderSpacing;   // Keep in mm for cost calc
 
+    double effectiveLoad_moment, effectiveLoad_shear;
+    distributeVehicleLoad(totalVehicleLoad, girderSpacing, effectiveLoad_moment, effectiveLoad_shear);
+
+    calculateMaxForces(effectiveLoad_moment * 1000.0, effectiveLoad_shear * 1000.0);
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runGirderDesign(double span, double width, double height, double momentVehicleLoad, double shearVehicleLoad, double wheelSpan)
+{
+    REBAR_TIME_SCOPE(Design);
+    resetDesign();
+
+    params.span = span;
+    params.width = width;
+    params.height = height;
+    params.wheelSpan = wheelSpan * 1000.0;
+    params.girderSpacing = 0; // a single girder in the cost
+
+    calculateMaxForces(momentVehicleLoad * 1000.0, shearVehicleLoad * 1000.0);
+
+    return findOptimalDesign();
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runDesign(double span, double width, double height, const AxleTrain& train, double girderSpacing)
+{
+    REBAR_TIME_SCOPE(Design);
+    resetDesign();
+
+    params.span = span;
+    params.width = width;
+    params.height = height;
+    params.wheelSpan = train.length();
+    params.girderSpacing = girderSpacing;
+
+    if (!train.isValid()) {
+        design.designPossible = false;
+        design.errorMessage = "Error: Invalid axle train.";
+        return false;
+    }
+
+    // Distribution factors per kN of vehicle load.
+    double momentFactor, shearFactor;
+    distributeVehicleLoad(1.0, girderSpacing, momentFactor, shearFactor);
+
+    calculateEnvelopeForces(train, momentFactor, shearFactor);
+
+    return findOptimalDesign();
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::distributeVehicleLoad(double totalVehicleLoad, double girderSpacing, double& momentLoad, double& shearLoad) const
+{
     constexpr double AASHTO_DIVISOR_MOMENT = 1.7;
     constexpr double AASHTO_DIVISOR_SHEAR = 1.4;
     double girderSpacing_m = girderSpacing / 1000.0;
@@ -128,16 +692,14 @@ inline bool RebarCalc::runDesign(double span, double width, double height, doubl
     double loadFactor_moment = (girderSpacing_m > 0) ? (girderSpacing_m / AASHTO_DIVISOR_MOMENT) : 1.0;
     double loadFactor_shear = (girderSpacing_m > 0) ? (girderSpacing_m / AASHTO_DIVISOR_SHEAR) : 1.0;
 
-    double effectiveLoad_moment = totalVehicleLoad * loadFactor_moment;
-    double effectiveLoad_shear = totalVehicleLoad * loadFactor_shear;
-
-    calculateMaxForces(effectiveLoad_moment * 1000.0, effectiveLoad_shear * 1000.0);
-
-    return findOptimalDesign();
+    momentLoad = totalVehicleLoad * loadFactor_moment;
+    shearLoad = totalVehicleLoad * loadFactor_shear;
 }
 
-inline void RebarCalc::calculateMaxForces(double vehicleLoadForMoment, double vehicleLoadForShear)
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::calculateMaxForces(double vehicleLoadForMoment, double vehicleLoadForShear)
 {
+    REBAR_TIME_SCOPE(ForceAnalysis);
     double L = params.span;
     double q = params.width * params.height * CONCRETE_UNIT_WEIGHT;
     double maxDeadMoment = q * L * L / 8.0;
@@ -155,68 +717,231 @@ inline void RebarCalc::calculateMaxForces(double vehicleLoadForMoment, double ve
     double maxLiveShear = (P_shear_axle * L + P_shear_axle * (L - d_wheel)) / L;
 
     design.maxShear = maxDeadShear + maxLiveShear;
+
+    if (zonedStirrups) {
+        // Leading axle at x heading for the far support, the second one behind it while it
+        // is still on the span. Both parts fall off towards midspan, so the profile does too.
+        double w = L / 2.0 / SHEAR_PROFILE_INTERVALS;
+        shearDemand[0] = design.maxShear;
+        for (int i = 1; i < SHEAR_PROFILE_INTERVALS; ++i) {
+            double x = i * w;
+            double liveShear = (P_shear_axle * (L - x) + P_shear_axle * std::max(0.0, L - x - d_wheel)) / L;
+            shearDemand[i] = q * (L / 2.0 - x) + liveShear;
+        }
+    }
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::calculateEnvelopeForces(const AxleTrain& train, double momentFactor, double shearFactor)
+{
+    REBAR_TIME_SCOPE(ForceAnalysis);
+    double L = params.span;
+    double q = params.width * params.height * CONCRETE_UNIT_WEIGHT;
+
+    movingLoad.computeEnvelope(train, L, MovingLoadEngine::DEFAULT_INTERVALS, true, liveEnvelope);
+
+    // For zoning, each interval of the half span takes the largest demand of the stations in
+    // or next to it, with the other half of the span folded onto it.
+    bool profile = zonedStirrups && L > 0 && liveEnvelope.stationCount() > 1;
+    double w = L / 2.0 / SHEAR_PROFILE_INTERVALS;
+    double pitch = profile ? L / (liveEnvelope.stationCount() - 1) : 0;
+    std::fill(shearDemand, shearDemand + SHEAR_PROFILE_INTERVALS, 0.0);
+
+    // Dead load is added station by station, so the maxima need not coincide with the live ones.
+    double maxMoment = 0, maxShear = 0;
+    for (size_t i = 0; i < liveEnvelope.stationCount(); ++i) {
+        double x = liveEnvelope.stations[i];
+        liveEnvelope.momentMax[i] *= momentFactor;
+        liveEnvelope.shearMax[i] *= shearFactor;
+        liveEnvelope.shearMin[i] *= shearFactor;
+
+        double deadMoment = q * x * (L - x) / 2.0;
+        double deadShear = q * (L / 2.0 - x);
+        double shear = std::max(deadShear + liveEnvelope.shearMax[i], -(deadShear + liveEnvelope.shearMin[i]));
+        maxMoment = std::max(maxMoment, deadMoment + liveEnvelope.momentMax[i]);
+        maxShear = std::max(maxShear, shear);
+
+        if (profile) {
+            double folded = std::min(x, L - x);
+            int first = std::max(0, (int)std::floor((folded - pitch) / w));
+            int last = std::min(SHEAR_PROFILE_INTERVALS - 1, (int)std::floor((folded + pitch) / w));
+            for (int k = first; k <= last; ++k) shearDemand[k] = std::max(shearDemand[k], shear);
+        }
+    }
+    // Zones only ever get sparser towards midspan.
+    for (int k = SHEAR_PROFILE_INTERVALS - 2; k >= 0; --k) shearDemand[k] = std::max(shearDemand[k], shearDemand[k + 1]);
+
+    design.maxMoment = maxMoment;
+    design.maxShear = maxShear;
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runContinuousDesign(const std::vector<double>& spans, double width, double height, const AxleTrain& train, double girderSpacing)
+{
+    REBAR_TIME_SCOPE(Design);
+    resetDesign();
+
+    int spanCount = (int)spans.size();
+    params.width = width;
+    params.height = height;
+    params.wheelSpan = train.length();
+    params.girderSpacing = girderSpacing;
+    params.spanCount = std::min(spanCount, MAX_CONTINUOUS_SPANS);
+    for (int j = 0; j < params.spanCount; ++j) {
+        params.spans[j] = spans[j];
+        params.span += spans[j];
+    }
+
+    bool validSpans = spanCount >= 2 && spanCount <= MAX_CONTINUOUS_SPANS;
+    for (double span : spans) validSpans = validSpans && span > 0;
+    if (!validSpans) {
+        design.designPossible = false;
+        design.errorMessage = "Error: A continuous girder needs 2 to 6 spans greater than zero.";
+        return false;
+    }
+    if (!train.isValid()) {
+        design.designPossible = false;
+        design.errorMessage = "Error: Invalid axle train.";
+        return false;
+    }
+
+    double momentFactor, shearFactor;
+    distributeVehicleLoad(1.0, girderSpacing, momentFactor, shearFactor);
+    calculateContinuousForces(spans, train, momentFactor, shearFactor);
+
+    // The stirrup zones are laid out about the middle of a single span, so a continuous
+    // girder is given uniform stirrups for its governing shear.
+    bool zoned = zonedStirrups;
+    zonedStirrups = false;
+    bool found = findOptimalDesign();
+    zonedStirrups = zoned;
+    return found && designHoggingReinforcement();
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::calculateContinuousForces(const std::vector<double>& spans, const AxleTrain& train, double momentFactor, double shearFactor)
+{
+    REBAR_TIME_SCOPE(ForceAnalysis);
+    double q = params.width * params.height * CONCRETE_UNIT_WEIGHT;
+
+    continuousBeam.computeEnvelope(spans, train, ContinuousBeamAnalyzer::DEFAULT_INTERVALS_PER_SPAN, true, continuousEnvelope);
+    std::vector<double> deadSupport;
+    ContinuousBeamAnalyzer::uniformSupportMoments(spans, q, deadSupport);
+
+    // Dead load is added station by station, as for the envelope of a single span.
+    double maxMoment = 0, maxHogging = 0, maxShear = 0;
+    for (size_t i = 0; i < continuousEnvelope.stationCount(); ++i) {
+        int j = continuousEnvelope.stationSpan[i];
+        double L = spans[j];
+        double x = continuousEnvelope.stations[i] - supportPosition(params, j);
+        continuousEnvelope.momentMax[i] *= momentFactor;
+        continuousEnvelope.momentMin[i] *= momentFactor;
+        continuousEnvelope.shearMax[i] *= shearFactor;
+        continuousEnvelope.shearMin[i] *= shearFactor;
+
+        double deadMoment = deadSupport[j] * (1.0 - x / L) + deadSupport[j + 1] * (x / L) + q * x * (L - x) / 2.0;
+        double deadShear = (deadSupport[j + 1] - deadSupport[j]) / L + q * (L / 2.0 - x);
+        maxMoment = std::max(maxMoment, deadMoment + continuousEnvelope.momentMax[i]);
+        maxHogging = std::max(maxHogging, -(deadMoment + continuousEnvelope.momentMin[i]));
+        maxShear = std::max(maxShear, std::max(deadShear + continuousEnvelope.shearMax[i], -(deadShear + continuousEnvelope.shearMin[i])));
+    }
+
+    design.maxMoment = maxMoment;
+    design.hoggingMoment = maxHogging;
+    design.maxShear = maxShear;
+}
+
+// Top bars over the interior supports: the section is designed for the hogging moment
+// as it is for the sagging one (rows, minimum steel, xi limit), and the cheapest standard
+// diameter is kept. Its steel and ties are added to the cost of the design.
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::designHoggingReinforcement()
+{
+    int supports = girderSpanCount(params) - 1;
+    if (supports <= 0 || design.hoggingMoment <= 0) return true;
+
+    double barLength = 0;
+    for (int i = 1; i <= supports; ++i) {
+        double start, end;
+        hoggingBarExtent(params, i, start, end);
+        barLength += end - start;
+    }
+
+    double bestCost = std::numeric_limits<double>::max();
+    for (double diameter : STANDARD_REBAR_DIAMETERS) {
+        RebarDesign top = {};
+        top.maxMoment = design.hoggingMoment;
+        BridgeParams topParams = params;
+        if (!designFlexureForDiameter(diameter, top, topParams)) continue;
+
+        int bars = top.rebarCountRow1 + top.rebarCountRow2;
+        double ton = bars * M_PI * pow(diameter / 2.0, 2) * barLength * STEEL_DENSITY;
+        double cost = ton * costRates.rebarBasePerTon * (1.0 + (diameter - 14.0) * 0.025) + bars * supports * costRates.perRebarTied;
+        if (cost < bestCost) {
+            bestCost = cost;
+            design.topRebarDiameter = diameter;
+            design.topRebarCount = bars;
+            design.topRebarRows = top.rebarRows;
+        }
+    }
+
+    if (design.topRebarCount == 0) {
+        design.designPossible = false;
+        design.errorMessage = "Error: No top reinforcement fits over the supports.\nIncrease beam dimensions.";
+        return false;
+    }
+    double numGirders = girderCount(params);
+    double ton = design.topRebarCount * M_PI * pow(design.topRebarDiameter / 2.0, 2) * barLength * STEEL_DENSITY;
+    design.steelCost += ton * costRates.rebarBasePerTon * (1.0 + (design.topRebarDiameter - 14.0) * 0.025) * numGirders;
+    design.laborCost += design.topRebarCount * supports * costRates.perRebarTied * numGirders;
+    design.totalCost = design.concreteCost + design.steelCost + design.laborCost;
+    return true;
 }
 
 // =================================================================================
 // == RE-ARCHITECTED CORE LOGIC ==
 // =================================================================================
-inline bool RebarCalc::findOptimalDesign()
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::findOptimalDesign()
+{
+    if (findOptimalLayout(scratch)) return true;
+    this->design.designPossible = false;
+    this->design.errorMessage = designErrorMessage(DesignErrorCode::NoReinforcement);
+    return false;
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::findOptimalLayout(DesignScratch& workspace)
 {
-    std::vector<double> standardDiameters = { 14, 16, 18, 20, 22, 25, 28 };
+    REBAR_TIME_SCOPE(DiameterLoop);
     double bestCost = std::numeric_limits<double>::max();
     bool solutionFound = false;
 
-    for (double currentDiameter : standardDiameters) {
+    // The one-diameter layouts first, then the mixed ones for every bottom-row bar.
+    const BarRowTable& barRows = workspace.barRows;
+    if (mixedDiameters) buildBarRowTable(this->params, workspace);
+    int candidateCount = STANDARD_REBAR_COUNT + (mixedDiameters ? MIXED_FLEXURE_CANDIDATES : 0);
+    for (int candidate = 0; candidate < candidateCount; ++candidate) {
         RebarDesign tempDesign = {};
+        // Carry the governing forces along so that storing the best candidate below
+        // does not wipe them out for the diameters that are still to be checked.
+        tempDesign.maxMoment = this->design.maxMoment;
+        tempDesign.maxShear = this->design.maxShear;
+        tempDesign.hoggingMoment = this->design.hoggingMoment;
         BridgeParams tempParams = this->params;
 
         // --- 1. FLEXURAL DESIGN FOR CURRENT DIAMETER ---
-        tempDesign.flexureRebarDiameter = currentDiameter;
-        double area_per_bar = M_PI * pow(currentDiameter / 2.0, 2);
-
-        // Tentatively assume one row to calculate initial h0
-        tempParams.h0 = tempParams.height - CONCRETE_COVER - 8.0 - currentDiameter / 2.0;
-        if (tempParams.h0 <= 0) continue;
-
-        double requiredArea = this->design.maxMoment / (STEEL_FY * 0.9 * tempParams.h0);
-        double minRebarArea = 0.45 * (CONCRETE_FT / STEEL_FY) * tempParams.width * tempParams.height;
-        if (requiredArea < minRebarArea) requiredArea = minRebarArea;
-
-        int totalBars = std::ceil(requiredArea / area_per_bar);
-        if (totalBars < 2) totalBars = 2;
-
-        int max_bars_per_row = calculateMaxBarsPerRow(currentDiameter, tempParams);
-        if (max_bars_per_row == 0) continue;
-
-        if (totalBars <= max_bars_per_row) {
-            tempDesign.rebarRows = 1;
-            tempDesign.rebarCountRow1 = totalBars;
+        if (candidate < STANDARD_REBAR_COUNT) {
+            if (!designFlexureForDiameter(STANDARD_REBAR_DIAMETERS[candidate], tempDesign, tempParams)) continue;
         }
         else {
-            tempDesign.rebarRows = 2;
-            tempDesign.rebarCountRow1 = std::ceil((double)totalBars / 2.0);
-            tempDesign.rebarCountRow2 = totalBars - tempDesign.rebarCountRow1;
-
-            if (tempDesign.rebarCountRow1 > max_bars_per_row || tempDesign.rebarCountRow2 > max_bars_per_row) {
-                continue;
-            }
-            // Recalculate h0 for two rows
-            double y1 = CONCRETE_COVER + 8.0 + currentDiameter / 2.0;
-            double y2 = y1 + currentDiameter + 25.0;
-            double As1 = tempDesign.rebarCountRow1 * area_per_bar;
-            double As2 = tempDesign.rebarCountRow2 * area_per_bar;
-            tempParams.h0 = tempParams.height - ((As1 * y1 + As2 * y2) / (As1 + As2));
-        }
-
-        double finalArea = totalBars * area_per_bar;
-        double x_comp = (finalArea * STEEL_FY) / (1.0 * CONCRETE_FC * tempParams.width);
-        double xi = x_comp / tempParams.h0;
-        if (xi >= XI_B_LIMIT) {
-            continue;
+            int mixed = candidate - STANDARD_REBAR_COUNT;
+            if (!designMixedFlexure(barRows, mixed / 2, 1 + mixed % 2, tempDesign, tempParams)) continue;
         }
 
         // --- 2. SHEAR DESIGN FOR THIS VALID FLEXURAL LAYOUT ---
         designShearForIteration(tempDesign, tempParams);
+        if (zonedStirrups) designStirrupZones(tempDesign, tempParams);
 
         // --- 3. TRUE COST CALCULATION ---
         calculateTotalCostForIteration(tempDesign, tempParams);
@@ -230,22 +955,237 @@ inline bool RebarCalc::findOptimalDesign()
         }
     }
 
-    if (!solutionFound) {
-        this->design.designPossible = false;
-        this->design.errorMessage = "Error: No valid reinforcement combination found.\nIncrease beam dimensions.";
+    return solutionFound;
+}
+
+// With minRows = 2 the bars are split over two rows even when one would hold them all
+// (at least two bars per row), trading depth for a less congested bottom row.
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::designFlexureForDiameter(double diameter, RebarDesign& tempDesign, BridgeParams& tempParams, int minRows) const
+{
+    return designFlexure(flexureGeometry(diameter, tempParams), tempDesign, tempParams, minRows);
+}
+
+template <typename Concrete, typename Steel>
+inline FlexureGeometry RebarCalcT<Concrete, Steel>::flexureGeometry(double diameter, const BridgeParams& section) const
+{
+    FlexureGeometry geometry;
+    geometry.diameter = diameter;
+    geometry.barArea = M_PI * pow(diameter / 2.0, 2);
+    geometry.h0OneRow = section.height - CONCRETE_COVER - 8.0 - diameter / 2.0;
+    geometry.minRebarArea = 0.45 * (CONCRETE_FT / STEEL_FY) * section.width * section.height;
+    geometry.maxBarsPerRow = calculateMaxBarsPerRow(diameter, section);
+    return geometry;
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::designFlexure(const FlexureGeometry& geometry, RebarDesign& tempDesign, BridgeParams& tempParams, int minRows) const
+{
+    double diameter = geometry.diameter;
+    tempDesign.flexureRebarDiameter = diameter;
+    double area_per_bar = geometry.barArea;
+
+    // Tentatively assume one row to calculate initial h0
+    tempParams.h0 = geometry.h0OneRow;
+    if (tempParams.h0 <= 0) return false;
+
+    double requiredArea = tempDesign.maxMoment / (STEEL_FY * 0.9 * tempParams.h0);
+    double minRebarArea = geometry.minRebarArea;
+    if (requiredArea < minRebarArea) requiredArea = minRebarArea;
+
+    int totalBars = std::ceil(requiredArea / area_per_bar);
+    if (totalBars < 2) totalBars = 2;
+
+    int max_bars_per_row = geometry.maxBarsPerRow;
+    if (max_bars_per_row == 0) {
+        REBAR_COUNT(RowCapacityRejects);
+        return false;
     }
+    if (minRows > 1 && totalBars < 4) return false;
 
-    return solutionFound;
+    if (totalBars <= max_bars_per_row && minRows < 2) {
+        tempDesign.rebarRows = 1;
+        tempDesign.rebarCountRow1 = totalBars;
+    }
+    else {
+        tempDesign.rebarRows = 2;
+        tempDesign.rebarCountRow1 = std::ceil((double)totalBars / 2.0);
+        tempDesign.rebarCountRow2 = totalBars - tempDesign.rebarCountRow1;
+
+        if (tempDesign.rebarCountRow1 > max_bars_per_row || tempDesign.rebarCountRow2 > max_bars_per_row) {
+            REBAR_COUNT(RowCapacityRejects);
+            return false;
+        }
+        // Recalculate h0 for two rows
+        double y1 = CONCRETE_COVER + 8.0 + diameter / 2.0;
+        double y2 = y1 + diameter + 25.0;
+        double As1 = tempDesign.rebarCountRow1 * area_per_bar;
+        double As2 = tempDesign.rebarCountRow2 * area_per_bar;
+        tempParams.h0 = tempParams.height - ((As1 * y1 + As2 * y2) / (As1 + As2));
+    }
+
+    double finalArea = totalBars * area_per_bar;
+    double x_comp = (finalArea * STEEL_FY) / (1.0 * CONCRETE_FC * tempParams.width);
+    double xi = x_comp / tempParams.h0;
+    if (xi >= XI_B_LIMIT) {
+        REBAR_COUNT(XiRejects);
+        return false;
+    }
+    return true;
+}
+
+// Row fills are enumerated per pair of diameters with the spacing rule of
+// calculateMaxBarsPerRow: the clear gap between bars is max(25, larger bar) whatever
+// their sizes. Bar costs follow calculateTotalCostForIteration for one girder.
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::buildBarRowTable(const BridgeParams& section, DesignScratch& workspace) const
+{
+    BarRowTable& table = workspace.barRows;
+    std::vector<BarRowFill>& fills = workspace.fills;
+    double availableWidth = section.width - (2 * CONCRETE_COVER) - (2 * 8.0);
+    double barArea[STANDARD_REBAR_COUNT], barCost[STANDARD_REBAR_COUNT];
+    for (int k = 0; k < STANDARD_REBAR_COUNT; ++k) {
+        double d = STANDARD_REBAR_DIAMETERS[k];
+        barArea[k] = M_PI * pow(d / 2.0, 2);
+        barCost[k] = barArea[k] * section.span * STEEL_DENSITY * costRates.rebarBasePerTon * (1.0 + (d - 14.0) * 0.025) + costRates.perRebarTied;
+    }
+
+    for (int large = 0; large < STANDARD_REBAR_COUNT; ++large) {
+        double D = STANDARD_REBAR_DIAMETERS[large];
+        double gap = std::max(25.0, D);
+        fills.clear();
+        int maxLarge = calculateMaxBarsPerRow(D, section);
+        for (int small = large; small >= 0; --small) {
+            double d = STANDARD_REBAR_DIAMETERS[small];
+            for (int a = 1; a <= maxLarge; ++a) {
+                for (int b = (small == large) ? 0 : 1;; ++b) {
+                    if (small == large && b > 0) break;
+                    if (b > 0 && a * D + b * d + (a + b - 1) * gap > availableWidth + 1e-9) break;
+                    BarRowFill fill;
+                    fill.largeDiameter = D;
+                    fill.smallDiameter = (b > 0) ? d : 0;
+                    fill.largeCount = a;
+                    fill.smallCount = b;
+                    fill.area = a * barArea[large] + b * barArea[small];
+                    fill.cost = a * barCost[large] + b * barCost[small];
+                    fill.firstMoment = a * barArea[large] * D / 2.0 + b * barArea[small] * d / 2.0;
+                    fills.push_back(fill);
+                }
+            }
+        }
+        std::sort(fills.begin(), fills.end(), [](const BarRowFill& x, const BarRowFill& y) {
+            return x.area != y.area ? x.area < y.area : x.cost > y.cost;
+        });
+        // Keep the fills that are cheaper than every fill with more area, for each row.
+        for (int row = 0; row < 2; ++row) {
+            std::vector<BarRowFill>& kept = table.rows[row][large];
+            kept.clear();
+            double cheapest = std::numeric_limits<double>::max();
+            for (size_t i = fills.size(); i-- > 0;) {
+                if ((row == 0 && fills[i].largeCount < 2) || fills[i].cost >= cheapest) continue;
+                cheapest = fills[i].cost;
+                kept.push_back(fills[i]);
+            }
+            std::reverse(kept.begin(), kept.end());
+        }
+    }
 }
 
-inline void RebarCalc::designShearForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const
+// The cheapest layout of `rows` rows whose bottom row has STANDARD_REBAR_DIAMETERS[bottomBar]
+// as its larger bar, with the bars of the upper row no larger than that. Each row is a
+// fill of the table: the bottom fills are taken in order of cost, and for each the
+// cheapest upper fill is found by binary search on the area still missing and checked
+// with the exact h0 of the two rows. Steel area and xi are checked as in designFlexure.
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::designMixedFlexure(const BarRowTable& table, int bottomBar, int rows, RebarDesign& tempDesign, BridgeParams& tempParams) const
 {
+    const std::vector<BarRowFill>& bottom = table.rows[0][bottomBar];
+    double H = tempParams.height, b = tempParams.width;
+    double base1 = CONCRETE_COVER + 8.0;
+    double base2 = base1 + STANDARD_REBAR_DIAMETERS[bottomBar] + 25.0;
+    double minRebarArea = 0.45 * (CONCRETE_FT / STEEL_FY) * b * H;
+    double M = tempDesign.maxMoment;
+    auto requiredArea = [&](double h0) { return std::max(M / (STEEL_FY * 0.9 * h0), minRebarArea); };
+    auto xiOk = [&](double area, double h0) { return (area * STEEL_FY) / (1.0 * CONCRETE_FC * b) / h0 < XI_B_LIMIT; };
+    auto byArea = [](const BarRowFill& fill, double area) { return fill.area < area; };
+
+    const BarRowFill* best[2] = { nullptr, nullptr };
+    double bestCost = std::numeric_limits<double>::max(), bestH0 = 0;
+    if (rows == 1) {
+        // h0 is largest for the smallest bars, which bounds the area needed from below.
+        double h0Max = H - base1 - STANDARD_REBAR_DIAMETERS[0] / 2.0;
+        if (h0Max <= 0) return false;
+        for (auto it = std::lower_bound(bottom.begin(), bottom.end(), requiredArea(h0Max), byArea); it != bottom.end(); ++it) {
+            if (!xiOk(it->area, h0Max)) break;
+            double h0 = H - base1 - it->firstMoment / it->area;
+            if (it->area < requiredArea(h0) || !xiOk(it->area, h0)) continue;
+            best[0] = &*it;
+            bestH0 = h0;
+            break;
+        }
+    }
+    else {
+        for (const BarRowFill& lower : bottom) {
+            if (lower.cost >= bestCost) break;
+            // The upper row only lowers h0 below that of the bottom row alone.
+            double h0Max = H - base1 - lower.firstMoment / lower.area;
+            if (h0Max <= 0) continue;
+            double lowerMoment = lower.area * base1 + lower.firstMoment;
+            for (int upperBar = 0; upperBar <= bottomBar; ++upperBar) {
+                const std::vector<BarRowFill>& upper = table.rows[1][upperBar];
+                for (auto it = std::lower_bound(upper.begin(), upper.end(), requiredArea(h0Max) - lower.area, byArea); it != upper.end(); ++it) {
+                    double area = lower.area + it->area;
+                    if (lower.cost + it->cost >= bestCost || !xiOk(area, h0Max)) break;
+                    double h0 = H - (lowerMoment + it->area * base2 + it->firstMoment) / area;
+                    if (h0 <= 0 || area < requiredArea(h0) || !xiOk(area, h0)) continue;
+                    best[0] = &lower;
+                    best[1] = &*it;
+                    bestCost = lower.cost + it->cost;
+                    bestH0 = h0;
+                    break;
+                }
+            }
+        }
+    }
+    if (!best[0]) {
+        REBAR_COUNT(RowCapacityRejects);
+        return false;
+    }
+
+    tempDesign.rebarRows = rows;
+    tempDesign.flexureRebarDiameter = best[0]->largeDiameter;
+    tempDesign.rebarCountRow1 = best[0]->largeCount + best[0]->smallCount;
+    tempDesign.rebarCountRow2 = best[1] ? best[1]->largeCount + best[1]->smallCount : 0;
+    // A layout with one diameter throughout is stored like a designFlexure one.
+    tempDesign.mixedDiameters = best[0]->smallCount > 0 || (best[1] && (best[1]->smallCount > 0 || best[1]->largeDiameter != best[0]->largeDiameter));
+    if (tempDesign.mixedDiameters) {
+        for (int row = 0; row < rows; ++row) {
+            tempDesign.rowDiameters[row][0] = best[row]->largeDiameter;
+            tempDesign.rowDiameters[row][1] = best[row]->smallDiameter;
+            tempDesign.rowBarCounts[row][0] = best[row]->largeCount;
+            tempDesign.rowBarCounts[row][1] = best[row]->smallCount;
+        }
+    }
+    tempParams.h0 = bestH0;
+    return true;
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::designShearForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const
+{
+    designShearForIteration(tempDesign, tempParams, 8, 2);
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::designShearForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams, double stirrupDiameter, int stirrupLegs) const
+{
+    REBAR_TIME_SCOPE(ShearDesign);
     tempDesign.bentRebarsUsed = false;
     tempDesign.bentRebarCount = 0;
-    tempDesign.stirrupDiameter = 8;
-    tempDesign.stirrupLegs = 2;
+    tempDesign.stirrupDiameter = stirrupDiameter;
+    tempDesign.stirrupLegs = stirrupLegs;
 
-    double Vd = this->design.maxShear;
+    double Vd = tempDesign.maxShear;
     double Vc = 0.20 * CONCRETE_FT * tempParams.width * tempParams.h0;
     double Vs_required = Vd - Vc;
 
@@ -266,47 +1206,115 @@ inline void RebarCalc::designShearForIteration(RebarDesign& tempDesign, const Br
         Vs_required -= Vsb;
     }
 
-    if (Vs_required > 0) {
-        tempDesign.stirrupSpacing = (stirrupTotalArea * STEEL_FY * tempParams.h0) / Vs_required;
-        tempDesign.stirrupSpacing = std::floor(tempDesign.stirrupSpacing / 25.0) * 25.0;
-        if (tempDesign.stirrupSpacing > 200) tempDesign.stirrupSpacing = 200;
-        if (tempDesign.stirrupSpacing < 100) tempDesign.stirrupSpacing = 100;
+    tempDesign.stirrupSpacing = stirrupSpacingFor(Vs_required, stirrupTotalArea * STEEL_FY * tempParams.h0);
+}
+
+// Spacing (mm) at which stirrups of resistance `stirrupResistance` (Asv * fy * h0) carry
+// Vs_required, rounded down to 25 mm and kept within 100..200 mm.
+template <typename Concrete, typename Steel>
+inline double RebarCalcT<Concrete, Steel>::stirrupSpacingFor(double Vs_required, double stirrupResistance)
+{
+    if (Vs_required <= 0) return 200;
+    double spacing = stirrupResistance / Vs_required;
+    spacing = std::floor(spacing / 25.0) * 25.0;
+    if (spacing > 200) spacing = 200;
+    if (spacing < 100) spacing = 100;
+    return spacing;
+}
+
+// Splits the span into spacing zones from the shear profile, reusing the stirrup size,
+// legs and bent-bar decision made for the support. Each half-span interval gets the
+// spacing its support-side demand needs and neighbours with equal spacing are merged
+// before the half is mirrored, so the cost is a few dozen flops per candidate.
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::designStirrupZones(RebarDesign& tempDesign, const BridgeParams& tempParams) const
+{
+    REBAR_TIME_SCOPE(ShearDesign);
+    double L = tempParams.span;
+    double Vc = 0.20 * CONCRETE_FT * tempParams.width * tempParams.h0;
+    double Vsb = 0;
+    if (tempDesign.bentRebarsUsed) {
+        double singleBentBarArea = M_PI * pow(tempDesign.flexureRebarDiameter / 2.0, 2);
+        Vsb = 0.75 * STEEL_FY * (tempDesign.bentRebarCount * singleBentBarArea) * sin(M_PI / 4.0);
     }
-    else {
-        tempDesign.stirrupSpacing = 200;
+    double stirrupTotalArea = tempDesign.stirrupLegs * M_PI * pow(tempDesign.stirrupDiameter / 2.0, 2);
+    double resistance = stirrupTotalArea * STEEL_FY * tempParams.h0;
+
+    StirrupZone half[SHEAR_PROFILE_INTERVALS];
+    int halfCount = 0;
+    double w = L / 2.0 / SHEAR_PROFILE_INTERVALS;
+    for (int i = 0; i < SHEAR_PROFILE_INTERVALS; ++i) {
+        double spacing = stirrupSpacingFor(shearDemand[i] - Vc - Vsb, resistance);
+        if (halfCount > 0 && half[halfCount - 1].spacing == spacing) half[halfCount - 1].end = (i + 1) * w;
+        else half[halfCount++] = { i * w, (i + 1) * w, spacing };
     }
+
+    // Stretch each zone to a whole number of spacings so stirrups fall on the zone ends; the
+    // denser zone wins any overlap and the midspan zone takes what is left of the half span.
+    int kept = 0;
+    double cursor = 0;
+    for (int j = 0; j < halfCount && cursor < L / 2.0; ++j) {
+        if (half[j].end <= cursor && j < halfCount - 1) continue;
+        double spacing = half[j].spacing;
+        double end = (j == halfCount - 1) ? L / 2.0 : cursor + std::ceil((half[j].end - cursor) / spacing - 1e-9) * spacing;
+        half[kept++] = { cursor, std::min(end, L / 2.0), spacing };
+        cursor = end;
+    }
+    halfCount = kept;
+
+    // The midspan zone runs across the centre line; the rest are mirrored onto the right half.
+    int count = 0;
+    for (int j = 0; j < halfCount; ++j) tempDesign.stirrupZones[count++] = half[j];
+    tempDesign.stirrupZones[count - 1].end = L - half[halfCount - 1].start;
+    for (int j = halfCount - 2; j >= 0; --j) tempDesign.stirrupZones[count++] = { L - half[j].end, L - half[j].start, half[j].spacing };
+    tempDesign.stirrupZoneCount = count;
+    tempDesign.stirrupSpacing = half[0].spacing;
 }
 
-inline void RebarCalc::calculateTotalCostForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const
+template <typename Concrete, typename Steel>
+inline int RebarCalcT<Concrete, Steel>::getStirrupZones(StirrupZone (&zones)[MAX_STIRRUP_ZONES]) const
 {
-    double numGirders = 1;
-    if (tempParams.girderSpacing > 0) {
-        numGirders = 10000.0 / tempParams.girderSpacing;
-        if (numGirders < 2) numGirders = 2;
+    if (design.stirrupZoneCount > 0) {
+        std::copy(design.stirrupZones, design.stirrupZones + design.stirrupZoneCount, zones);
+        return design.stirrupZoneCount;
     }
+    zones[0] = { 0, params.span, design.stirrupSpacing };
+    return 1;
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::calculateTotalCostForIteration(RebarDesign& tempDesign, const BridgeParams& tempParams) const
+{
+    REBAR_TIME_SCOPE(Costing);
+    REBAR_COUNT(CandidatesEvaluated);
+    double numGirders = girderCount(tempParams);
 
-    double cost_concrete_per_m3 = 600.0;
-    double cost_rebar_base_per_ton = 3500.0;
-    double cost_per_rebar_tied = 300.0;
+    double cost_concrete_per_m3 = costRates.concretePerM3;
+    double cost_rebar_base_per_ton = costRates.rebarBasePerTon;
+    double cost_per_rebar_tied = costRates.perRebarTied;
 
     double volume_m3 = (tempParams.span * tempParams.width * tempParams.height) / 1e9;
     tempDesign.concreteCost = volume_m3 * cost_concrete_per_m3 * numGirders;
 
     double total_longitudinal_bars = tempDesign.rebarCountRow1 + tempDesign.rebarCountRow2;
-    double extra_length_for_bends = 0;
-    if (tempDesign.bentRebarsUsed) {
-        extra_length_for_bends = tempDesign.bentRebarCount * (tempParams.height * 0.5);
-    }
-    double flex_rebar_volume = (M_PI * pow(tempDesign.flexureRebarDiameter / 2.0, 2)) * (total_longitudinal_bars * tempParams.span + extra_length_for_bends);
-    double flex_rebar_weight_ton = flex_rebar_volume * STEEL_DENSITY;
+    double flex_rebar_weight_ton, stirrup_weight_ton, num_stirrups;
+    steelQuantities(tempDesign, tempParams, flex_rebar_weight_ton, stirrup_weight_ton, num_stirrups);
     double diameter_cost_factor_flex = 1.0 + (tempDesign.flexureRebarDiameter - 14.0) * 0.025;
     double flexuralSteelCost = flex_rebar_weight_ton * (cost_rebar_base_per_ton * diameter_cost_factor_flex);
+    if (tempDesign.mixedDiameters) {
+        // Each diameter at its own price; the bent bars are bottom-row bars of flexureRebarDiameter.
+        flexuralSteelCost = 0;
+        for (int row = 0; row < tempDesign.rebarRows; ++row) {
+            for (int j = 0; j < 2; ++j) {
+                double d = tempDesign.rowDiameters[row][j];
+                double ton = tempDesign.rowBarCounts[row][j] * M_PI * pow(d / 2.0, 2) * tempParams.span * STEEL_DENSITY;
+                flexuralSteelCost += ton * (cost_rebar_base_per_ton * (1.0 + (d - 14.0) * 0.025));
+            }
+        }
+        double bentTon = flex_rebar_weight_ton - flexuralSteelArea(tempDesign) * tempParams.span * STEEL_DENSITY;
+        flexuralSteelCost += bentTon * (cost_rebar_base_per_ton * diameter_cost_factor_flex);
+    }
 
-    double stirrup_length = 2 * (tempParams.width + tempParams.height);
-    double num_stirrups = (tempDesign.stirrupSpacing > 0) ? (tempParams.span / tempDesign.stirrupSpacing) : 0;
-    double stirrup_total_area = M_PI * pow(tempDesign.stirrupDiameter / 2.0, 2);
-    double stirrup_volume = tempDesign.stirrupLegs * stirrup_total_area * stirrup_length * num_stirrups;
-    double stirrup_weight_ton = stirrup_volume * STEEL_DENSITY;
     double diameter_cost_factor_stirrup = 1.0 + (tempDesign.stirrupDiameter - 14.0) * 0.025;
     double stirrupSteelCost = stirrup_weight_ton * (cost_rebar_base_per_ton * diameter_cost_factor_stirrup);
 
@@ -315,25 +1323,385 @@ inline void RebarCalc::calculateTotalCostForIteration(RebarDesign& tempDesign, c
     tempDesign.totalCost = tempDesign.concreteCost + tempDesign.steelCost + tempDesign.laborCost;
 }
 
-inline int RebarCalc::calculateMaxBarsPerRow(double diameter, const BridgeParams& tempParams) const {
+// Steel of one girder: flexural bars and stirrups (ton) and the number of stirrups.
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::steelQuantities(const RebarDesign& tempDesign, const BridgeParams& tempParams, double& flexuralTon, double& stirrupTon, double& stirrupCount)
+{
+    double total_longitudinal_bars = tempDesign.rebarCountRow1 + tempDesign.rebarCountRow2;
+    double extra_length_for_bends = 0;
+    if (tempDesign.bentRebarsUsed) {
+        extra_length_for_bends = tempDesign.bentRebarCount * (tempParams.height * 0.5) * girderSpanCount(tempParams);
+    }
+    double flex_rebar_volume = (M_PI * pow(tempDesign.flexureRebarDiameter / 2.0, 2)) * (total_longitudinal_bars * tempParams.span + extra_length_for_bends);
+    if (tempDesign.mixedDiameters) {
+        flex_rebar_volume = flexuralSteelArea(tempDesign) * tempParams.span + (M_PI * pow(tempDesign.flexureRebarDiameter / 2.0, 2)) * extra_length_for_bends;
+    }
+    flexuralTon = flex_rebar_volume * STEEL_DENSITY;
+
+    double stirrup_length = 2 * (tempParams.width + tempParams.height);
+    double num_stirrups = (tempDesign.stirrupSpacing > 0) ? (tempParams.span / tempDesign.stirrupSpacing) : 0;
+    if (tempDesign.stirrupZoneCount > 0) {
+        num_stirrups = 0;
+        for (int z = 0; z < tempDesign.stirrupZoneCount; ++z) {
+            const StirrupZone& zone = tempDesign.stirrupZones[z];
+            num_stirrups += (zone.end - zone.start) / zone.spacing;
+        }
+    }
+    double stirrup_total_area = M_PI * pow(tempDesign.stirrupDiameter / 2.0, 2);
+    double stirrup_volume = tempDesign.stirrupLegs * stirrup_total_area * stirrup_length * num_stirrups;
+    stirrupTon = stirrup_volume * STEEL_DENSITY;
+    stirrupCount = num_stirrups;
+}
+
+template <typename Concrete, typename Steel>
+inline int RebarCalcT<Concrete, Steel>::calculateMaxBarsPerRow(double diameter, const BridgeParams& tempParams) const {
     double available_width = tempParams.width - (2 * CONCRETE_COVER) - (2 * 8.0);
     double min_spacing = std::max(25.0, diameter);
     if (available_width < diameter) return 0;
     return 1 + std::floor((available_width - diameter) / (diameter + min_spacing));
 }
+
+template <typename Concrete, typename Steel>
+inline double RebarCalcT<Concrete, Steel>::girderCount(const BridgeParams& tempParams) {
+    double numGirders = 1;
+    if (tempParams.girderSpacing > 0) {
+        numGirders = 10000.0 / tempParams.girderSpacing;
+        if (numGirders < 2) numGirders = 2;
+    }
+    return numGirders;
+}
+
+// =================================================================================
+// == JOINT SECTION OPTIMIZER (BRANCH AND BOUND) ==
+// =================================================================================
+
+// Cheapest cost any design of this section could reach. Every term is a bound that
+// calculateTotalCostForIteration can only exceed: the concrete of one girder is exact, the
+// flexural steel is at least the required area at the deepest possible h0 priced as the
+// cheapest bar, and the stirrups are at least the lightest option at the widest spacing.
+// Like the real cost, the sum is taken over all girders.
+template <typename Concrete, typename Steel>
+inline double RebarCalcT<Concrete, Steel>::sectionCostLowerBound(const RebarDesign& forces, const BridgeParams& section, const SectionSearchSpace& space) const
+{
+    double numGirders = girderCount(section);
+    double concreteCost = (section.span * section.width * section.height) / 1e9 * costRates.concretePerM3;
+
+    double smallestBar = STANDARD_REBAR_DIAMETERS[0];
+    double largestBar = STANDARD_REBAR_DIAMETERS[STANDARD_REBAR_COUNT - 1];
+    double deepest_h0 = section.height - CONCRETE_COVER - 8.0 - smallestBar / 2.0;
+    if (deepest_h0 <= 0) return std::numeric_limits<double>::max();
+    double requiredArea = forces.maxMoment / (STEEL_FY * 0.9 * deepest_h0);
+    double minRebarArea = 0.45 * (CONCRETE_FT / STEEL_FY) * section.width * section.height;
+    if (requiredArea < minRebarArea) requiredArea = minRebarArea;
+    double flexSteelCost = requiredArea * section.span * STEEL_DENSITY * costRates.rebarBasePerTon;
+    double minBars = std::max(2.0, std::ceil(requiredArea / (M_PI * pow(largestBar / 2.0, 2))));
+
+    double lightestStirrup = std::numeric_limits<double>::max();
+    for (double sd : space.stirrupDiameters) {
+        for (int legs : space.stirrupLegCounts) {
+            double weight = legs * M_PI * pow(sd / 2.0, 2) * (1.0 + (sd - 14.0) * 0.025);
+            lightestStirrup = std::min(lightestStirrup, weight);
+        }
+    }
+    double minStirrups = section.span / 200.0;
+    double stirrupCost = lightestStirrup * 2 * (section.width + section.height) * minStirrups * STEEL_DENSITY * costRates.rebarBasePerTon;
+    double laborCost = (minBars + minStirrups) * costRates.perRebarTied;
+
+    return (concreteCost + flexSteelCost + stirrupCost + laborCost) * numGirders;
+}
+
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runSectionOptimization(double span, double totalVehicleLoad, double wheelSpan, double girderSpacing, const SectionSearchSpace& space)
+{
+    resetDesign();
+    searchStats = {};
+
+    params.span = span;
+    params.wheelSpan = wheelSpan * 1000.0;
+    params.girderSpacing = girderSpacing;
+
+    double effectiveLoad_moment, effectiveLoad_shear;
+    distributeVehicleLoad(totalVehicleLoad, girderSpacing, effectiveLoad_moment, effectiveLoad_shear);
+
+    struct SectionCandidate
+    {
+        int widthIndex;
+        double width;
+        double height;
+        double maxMoment;
+        double maxShear;
+        double lowerBound;
+    };
+
+    int widthCount = (space.widthStep > 0) ? (int)std::floor((space.maxWidth - space.minWidth) / space.widthStep + 1e-9) + 1 : 1;
+    int heightCount = (space.heightStep > 0) ? (int)std::floor((space.maxHeight - space.minHeight) / space.heightStep + 1e-9) + 1 : 1;
+    if (widthCount <= 0 || heightCount <= 0 || space.stirrupDiameters.empty() || space.stirrupLegCounts.empty()) {
+        design.designPossible = false;
+        design.errorMessage = "Error: Empty section search space.";
+        return false;
+    }
+
+    // Forces depend on the section through the self-weight, so every section gets its own.
+    std::vector<SectionCandidate> sections;
+    sections.reserve((size_t)widthCount * heightCount);
+    for (int wi = 0; wi < widthCount; ++wi) {
+        for (int hi = 0; hi < heightCount; ++hi) {
+            SectionCandidate c;
+            c.widthIndex = wi;
+            c.width = space.minWidth + wi * space.widthStep;
+            c.height = space.minHeight + hi * space.heightStep;
+            params.width = c.width;
+            params.height = c.height;
+            calculateMaxForces(effectiveLoad_moment * 1000.0, effectiveLoad_shear * 1000.0);
+            c.maxMoment = design.maxMoment;
+            c.maxShear = design.maxShear;
+            c.lowerBound = sectionCostLowerBound(design, params, space);
+            sections.push_back(c);
+        }
+    }
+    std::sort(sections.begin(), sections.end(), [](const SectionCandidate& a, const SectionCandidate& b) {
+        return a.lowerBound < b.lowerBound;
+    });
+
+    long long stirrupOptions = (long long)space.stirrupDiameters.size() * space.stirrupLegCounts.size();
+    searchStats.candidatesInSpace = (long long)sections.size() * STANDARD_REBAR_COUNT * stirrupOptions;
+
+    // For a fixed width and bar, a moment-governed flexural failure (xi >= XI_B_LIMIT or too
+    // many bars for two rows) at some height also fails at every shallower height, because
+    // the required steel only grows as h0 shrinks. Remember the deepest such failure.
+    std::vector<double> failedUpToHeight((size_t)widthCount * STANDARD_REBAR_COUNT, -1.0);
+
+    double bestCost = std::numeric_limits<double>::max();
+    RebarDesign bestDesign;
+    BridgeParams bestParams = {};
+    bool solutionFound = false;
+
+    for (size_t s = 0; s < sections.size(); ++s) {
+        const SectionCandidate& c = sections[s];
+        if (c.lowerBound >= bestCost) {
+            // Sections are sorted by bound, so nothing after this one can win either.
+            searchStats.sectionsPrunedByCost += (long long)(sections.size() - s);
+            break;
+        }
+        if (cancelled()) {
+            design = {};
+            design.designPossible = false;
+            design.errorMessage = "Design cancelled.";
+            return false;
+        }
+        ++searchStats.sectionsVisited;
+
+        BridgeParams sectionParams = params;
+        sectionParams.width = c.width;
+        sectionParams.height = c.height;
+        if (zonedStirrups) {
+            // The shear profile depends on the self-weight, so it is rebuilt for each section visited.
+            params.width = c.width;
+            params.height = c.height;
+            calculateMaxForces(effectiveLoad_moment * 1000.0, effectiveLoad_shear * 1000.0);
+        }
+
+        for (int di = 0; di < STANDARD_REBAR_COUNT; ++di) {
+            double diameter = STANDARD_REBAR_DIAMETERS[di];
+            double& failHeight = failedUpToHeight[(size_t)c.widthIndex * STANDARD_REBAR_COUNT + di];
+            if (c.height <= failHeight) {
+                searchStats.flexurePrunedByBound += stirrupOptions;
+                continue;
+            }
+
+            RebarDesign flexDesign = {};
+            flexDesign.maxMoment = c.maxMoment;
+            flexDesign.maxShear = c.maxShear;
+            BridgeParams tempParams = sectionParams;
+            if (!designFlexureForDiameter(diameter, flexDesign, tempParams)) {
+                double h0 = c.height - CONCRETE_COVER - 8.0 - diameter / 2.0;
+                bool momentGoverned = h0 > 0 && c.maxMoment / (STEEL_FY * 0.9 * h0) >= 0.45 * (CONCRETE_FT / STEEL_FY) * c.width * c.height;
+                if (momentGoverned && c.height > failHeight) failHeight = c.height;
+                continue;
+            }
+
+            for (double stirrupDiameter : space.stirrupDiameters) {
+                for (int legs : space.stirrupLegCounts) {
+                    RebarDesign tempDesign = flexDesign;
+                    designShearForIteration(tempDesign, tempParams, stirrupDiameter, legs);
+                    if (zonedStirrups) designStirrupZones(tempDesign, tempParams);
+                    calculateTotalCostForIteration(tempDesign, tempParams);
+                    ++searchStats.candidatesEvaluated;
+
+                    if (tempDesign.totalCost < bestCost) {
+                        solutionFound = true;
+                        bestCost = tempDesign.totalCost;
+                        bestDesign = tempDesign;
+                        bestParams = tempParams;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!solutionFound) {
+        params.width = 0;
+        params.height = 0;
+        design = {};
+        design.designPossible = false;
+        design.errorMessage = "Error: No feasible section in the search space.\nWiden the width/height ranges.";
+        return false;
+    }
+
+    params = bestParams;
+    design = bestDesign;
+    return true;
+}
+
+// =================================================================================
+// == MULTI-OBJECTIVE SECTION SEARCH (PARETO FRONT) ==
+// =================================================================================
+template <typename Concrete, typename Steel>
+inline bool RebarCalcT<Concrete, Steel>::runParetoOptimization(double span, double totalVehicleLoad, double wheelSpan, double girderSpacing,
+    std::vector<ParetoDesign>& front, const SectionSearchSpace& space)
+{
+    resetDesign();
+    searchStats = {};
+    front.clear();
+
+    params.span = span;
+    params.wheelSpan = wheelSpan * 1000.0;
+    params.girderSpacing = girderSpacing;
+
+    double effectiveLoad_moment, effectiveLoad_shear;
+    distributeVehicleLoad(totalVehicleLoad, girderSpacing, effectiveLoad_moment, effectiveLoad_shear);
+
+    int widthCount = (space.widthStep > 0) ? (int)std::floor((space.maxWidth - space.minWidth) / space.widthStep + 1e-9) + 1 : 1;
+    int heightCount = (space.heightStep > 0) ? (int)std::floor((space.maxHeight - space.minHeight) / space.heightStep + 1e-9) + 1 : 1;
+    if (widthCount <= 0 || heightCount <= 0 || space.stirrupDiameters.empty() || space.stirrupLegCounts.empty()) {
+        design.designPossible = false;
+        design.errorMessage = "Error: Empty section search space.";
+        return false;
+    }
+
+    long long stirrupOptions = (long long)space.stirrupDiameters.size() * space.stirrupLegCounts.size();
+    searchStats.candidatesInSpace = (long long)widthCount * heightCount * STANDARD_REBAR_COUNT * 2 * stirrupOptions;
+
+    ParetoArchive<ParetoDesign, PARETO_OBJECTIVES> archive;
+    for (int wi = 0; wi < widthCount; ++wi) {
+        // Deepest first: a moment-governed flexural failure then rules out the rest of the
+        // column for that bar, exactly as in runSectionOptimization.
+        double failedUpToHeight[STANDARD_REBAR_COUNT];
+        std::fill(failedUpToHeight, failedUpToHeight + STANDARD_REBAR_COUNT, -1.0);
+        for (int hi = heightCount - 1; hi >= 0; --hi) {
+            if (cancelled()) {
+                design = {};
+                design.designPossible = false;
+                design.errorMessage = "Design cancelled.";
+                return false;
+            }
+            params.width = space.minWidth + wi * space.widthStep;
+            params.height = space.minHeight + hi * space.heightStep;
+            calculateMaxForces(effectiveLoad_moment * 1000.0, effectiveLoad_shear * 1000.0);
+            BridgeParams sectionParams = params;
+            ++searchStats.sectionsVisited;
+
+            for (int di = 0; di < STANDARD_REBAR_COUNT; ++di) {
+                double diameter = STANDARD_REBAR_DIAMETERS[di];
+                if (params.height <= failedUpToHeight[di]) {
+                    searchStats.flexurePrunedByBound += 2 * stirrupOptions;
+                    continue;
+                }
+                int maxBarsPerRow = calculateMaxBarsPerRow(diameter, sectionParams);
+
+                for (int minRows = 1; minRows <= 2; ++minRows) {
+                    RebarDesign flexDesign = {};
+                    flexDesign.maxMoment = design.maxMoment;
+                    flexDesign.maxShear = design.maxShear;
+                    BridgeParams tempParams = sectionParams;
+                    if (!designFlexureForDiameter(diameter, flexDesign, tempParams, minRows)) {
+                        // The two-row layout only fails where the natural one does, or for too few bars.
+                        if (minRows == 1) {
+                            double h0 = params.height - CONCRETE_COVER - 8.0 - diameter / 2.0;
+                            bool momentGoverned = h0 > 0 && design.maxMoment / (STEEL_FY * 0.9 * h0) >= 0.45 * (CONCRETE_FT / STEEL_FY) * params.width * params.height;
+                            if (momentGoverned) failedUpToHeight[di] = params.height;
+                            break;
+                        }
+                        continue;
+                    }
+                    // Already two rows: the forced layout would be the same design.
+                    if (minRows == 1 && flexDesign.rebarRows == 2) minRows = 2;
+
+                    for (double stirrupDiameter : space.stirrupDiameters) {
+                        for (int legs : space.stirrupLegCounts) {
+                            ParetoDesign candidate;
+                            candidate.design = flexDesign;
+                            candidate.params = tempParams;
+                            designShearForIteration(candidate.design, tempParams, stirrupDiameter, legs);
+                            if (zonedStirrups) designStirrupZones(candidate.design, tempParams);
+                            calculateTotalCostForIteration(candidate.design, tempParams);
+                            ++searchStats.candidatesEvaluated;
+
+                            double flexuralTon, stirrupTon, stirrupCount;
+                            steelQuantities(candidate.design, tempParams, flexuralTon, stirrupTon, stirrupCount);
+                            candidate.steelWeight = (flexuralTon + stirrupTon) * girderCount(tempParams);
+                            candidate.congestion = (double)std::max(candidate.design.rebarCountRow1, candidate.design.rebarCountRow2) / maxBarsPerRow;
+
+                            double objectives[PARETO_OBJECTIVES] = { candidate.design.totalCost, candidate.steelWeight, tempParams.height, candidate.congestion };
+                            archive.insert(objectives, std::move(candidate));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    front.reserve(archive.size());
+    archive.forEach([&front](const ParetoArchive<ParetoDesign, PARETO_OBJECTIVES>::Entry& entry) { front.push_back(entry.payload); });
+    std::sort(front.begin(), front.end(), [](const ParetoDesign& a, const ParetoDesign& b) {
+        return a.design.totalCost < b.design.totalCost;
+    });
+
+    if (front.empty()) {
+        params.width = 0;
+        params.height = 0;
+        design = {};
+        design.designPossible = false;
+        design.errorMessage = "Error: No feasible section in the search space.\nWiden the width/height ranges.";
+        return false;
+    }
+
+    params = front[0].params;
+    design = front[0].design;
+    return true;
+}
 // =================================================================================
 // == END RE-ARCHITECTED LOGIC ==
 // =================================================================================
 
-inline cv::Mat RebarCalc::generateCrossSectionImage()
+template <typename Concrete, typename Steel>
+inline cv::Mat RebarCalcT<Concrete, Steel>::generateCrossSectionImage()
+{
+    cv::Mat image;
+    drawCrossSection(image);
+    return image;
+}
+
+template <typename Concrete, typename Steel>
+inline cv::Mat RebarCalcT<Concrete, Steel>::generateLongitudinalSectionImage()
+{
+    cv::Mat image;
+    drawLongitudinalSection(image);
+    return image;
+}
+
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::drawCrossSection(cv::Mat& image)
 {
-    int img_w = 600, img_h = 600;
-    cv::Mat image(img_h, img_w, CV_8UC3, cv::Scalar(255, 255, 255));
+    REBAR_TIME_SCOPE(Drawing);
+    int img_w = CROSS_SECTION_IMAGE_SIZE.width, img_h = CROSS_SECTION_IMAGE_SIZE.height;
+    if (image.size() != CROSS_SECTION_IMAGE_SIZE || (image.type() != CV_8UC3 && image.type() != CV_8UC4)) image.create(img_h, img_w, CV_8UC3);
+    image.setTo(cv::Scalar(255, 255, 255, 255));
 
     if (!design.designPossible) {
-        cv::putText(image, "DESIGN FAILED", cv::Point(50, img_h / 2 - 20), cv::FONT_HERSHEY_SIMPLEX, 1.2, cv::Scalar(0, 0, 255), 3);
-        cv::putText(image, design.errorMessage, cv::Point(50, img_h / 2 + 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0), 1);
-        return image;
+        cv::putText(image, "DESIGN FAILED", cv::Point(50, img_h / 2 - 20), cv::FONT_HERSHEY_SIMPLEX, 1.2, cv::Scalar(0, 0, 255, 255), 3);
+        cv::putText(image, design.errorMessage, cv::Point(50, img_h / 2 + 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0, 255), 1);
+        return;
     }
 
     double scale = std::min((double)img_w * 0.8 / params.width, (double)img_h * 0.8 / params.height);
@@ -342,13 +1710,13 @@ inline cv::Mat RebarCalc::generateCrossSectionImage()
     int rect_x = (img_w - rect_w) / 2;
     int rect_y = (img_h - rect_h) / 2;
 
-    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(211, 211, 211), -1);
+    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(211, 211, 211, 255), -1);
     double stirrup_offset = CONCRETE_COVER * scale;
-    cv::rectangle(image, cv::Point(rect_x + stirrup_offset, rect_y + stirrup_offset), cv::Point(rect_x + rect_w - stirrup_offset, rect_y + rect_h - stirrup_offset), cv::Scalar(0, 0, 0), 2);
+    cv::rectangle(image, cv::Point(rect_x + stirrup_offset, rect_y + stirrup_offset), cv::Point(rect_x + rect_w - stirrup_offset, rect_y + rect_h - stirrup_offset), cv::Scalar(0, 0, 0, 255), 2);
 
     double rebar_radius_scaled = (design.flexureRebarDiameter / 2.0) * scale;
     cv::Scalar rebar_color = rebarColorMap.at(design.flexureRebarDiameter);
-    cv::Scalar bent_rebar_color = cv::Scalar(0, 0, 255);
+    cv::Scalar bent_rebar_color = cv::Scalar(0, 0, 255, 255);
 
     double x_start = rect_x + stirrup_offset + (8 * scale) + rebar_radius_scaled;
     double x_end = rect_x + rect_w - stirrup_offset - (8 * scale) - rebar_radius_scaled;
@@ -359,17 +1727,35 @@ inline cv::Mat RebarCalc::generateCrossSectionImage()
     int bottom_row_bar_count = std::max(straight_bars_in_row1, bars_in_row2);
     int second_row_bar_count = std::min(straight_bars_in_row1, bars_in_row2);
 
-    if (bottom_row_bar_count > 0) {
+    if (design.mixedDiameters) {
+        // Each bar at its own size and in the colour of its diameter, the rows as designed.
+        double y_row_base = rect_y + rect_h - stirrup_offset - (8 * scale);
+        for (int row = 0; row < design.rebarRows; ++row) {
+            double diameters[64];
+            int skip = (row == 0) ? design.bentRebarCount : 0;
+            int count = flexuralRowBars(design, row, skip, diameters, 64);
+            for (int i = 0; i < count; ++i) {
+                double t = (count > 1) ? (double)i / (count - 1) : 0.5;
+                double radius = (diameters[i] / 2.0) * scale;
+                cv::circle(image, cv::Point(x_start + t * (x_end - x_start), y_row_base - radius), radius, rebarColorMap.at(diameters[i]), -1);
+            }
+            double y_text = y_row_base - (design.rowDiameters[row][0] / 2.0) * scale;
+            if (count > 0) cv::putText(image, flexuralRowText(design, row, skip), cv::Point(rect_x + rect_w + 10, y_text + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0, 255), 1);
+            y_row_base -= (design.rowDiameters[row][0] + 25.0) * scale;
+        }
+    }
+
+    if (!design.mixedDiameters && bottom_row_bar_count > 0) {
         double y_pos_bottom_row = rect_y + rect_h - stirrup_offset - (8 * scale) - rebar_radius_scaled;
         for (int i = 0; i < bottom_row_bar_count; ++i) {
             double t = (bottom_row_bar_count > 1) ? (double)i / (bottom_row_bar_count - 1) : 0.5;
             cv::circle(image, cv::Point(x_start + t * (x_end - x_start), y_pos_bottom_row), rebar_radius_scaled, rebar_color, -1);
         }
         std::string row1_text = std::to_string(bottom_row_bar_count) + " x d" + std::to_string((int)design.flexureRebarDiameter);
-        cv::putText(image, row1_text, cv::Point(rect_x + rect_w + 10, y_pos_bottom_row + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 1);
+        cv::putText(image, row1_text, cv::Point(rect_x + rect_w + 10, y_pos_bottom_row + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0, 255), 1);
     }
 
-    if (second_row_bar_count > 0) {
+    if (!design.mixedDiameters && second_row_bar_count > 0) {
         double y_pos_bottom_row = rect_y + rect_h - stirrup_offset - (8 * scale) - rebar_radius_scaled;
         double y_pos_second_row = y_pos_bottom_row - (rebar_radius_scaled * 2) - (25.0 * scale);
         for (int i = 0; i < second_row_bar_count; ++i) {
@@ -377,35 +1763,55 @@ inline cv::Mat RebarCalc::generateCrossSectionImage()
             cv::circle(image, cv::Point(x_start + t * (x_end - x_start), y_pos_second_row), rebar_radius_scaled, rebar_color, -1);
         }
         std::string row2_text = std::to_string(second_row_bar_count) + " x d" + std::to_string((int)design.flexureRebarDiameter);
-        cv::putText(image, row2_text, cv::Point(rect_x + rect_w + 10, y_pos_second_row + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 1);
+        cv::putText(image, row2_text, cv::Point(rect_x + rect_w + 10, y_pos_second_row + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0, 255), 1);
+    }
+
+    double y_pos_top = rect_y + stirrup_offset + (8 * scale) + rebar_radius_scaled;
+    if (design.topRebarCount > 0) {
+        // Hogging bars of a continuous girder, drawn as in the section over a support.
+        double top_radius_scaled = (design.topRebarDiameter / 2.0) * scale;
+        double x_top_start = rect_x + stirrup_offset + (8 * scale) + top_radius_scaled;
+        double x_top_end = rect_x + rect_w - stirrup_offset - (8 * scale) - top_radius_scaled;
+        double y_top_bars = rect_y + stirrup_offset + (8 * scale) + top_radius_scaled;
+        int top_row1 = (design.topRebarRows > 1) ? (design.topRebarCount + 1) / 2 : design.topRebarCount;
+        for (int row = 0, count = top_row1; row < design.topRebarRows; ++row, count = design.topRebarCount - top_row1) {
+            for (int i = 0; i < count; ++i) {
+                double t = (count > 1) ? (double)i / (count - 1) : 0.5;
+                cv::circle(image, cv::Point(x_top_start + t * (x_top_end - x_top_start), y_top_bars), top_radius_scaled, rebarColorMap.at(design.topRebarDiameter), -1);
+            }
+            std::string top_text = std::to_string(count) + " x d" + std::to_string((int)design.topRebarDiameter) + " (Top, supports)";
+            cv::putText(image, top_text, cv::Point(rect_x + rect_w + 10, y_top_bars + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0, 255), 1);
+            y_top_bars += (top_radius_scaled * 2) + (25.0 * scale);
+        }
+        y_pos_top = y_top_bars - top_radius_scaled + rebar_radius_scaled;
     }
 
     if (design.bentRebarsUsed && design.bentRebarCount > 0) {
-        double y_pos_top = rect_y + stirrup_offset + (8 * scale) + rebar_radius_scaled;
         for (int i = 0; i < design.bentRebarCount; ++i) {
             double t = (design.bentRebarCount > 1) ? (double)i / (design.bentRebarCount - 1) : 0.5;
             cv::circle(image, cv::Point(x_start + t * (x_end - x_start), y_pos_top), rebar_radius_scaled, bent_rebar_color, -1);
         }
         std::string bent_text = std::to_string(design.bentRebarCount) + " x d" + std::to_string((int)design.flexureRebarDiameter) + " (Bent)";
-        cv::putText(image, bent_text, cv::Point(rect_x + rect_w + 10, y_pos_top + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 1);
+        cv::putText(image, bent_text, cv::Point(rect_x + rect_w + 10, y_pos_top + 5), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0, 255), 1);
     }
 
-    cv::putText(image, std::to_string((int)params.width) + "mm", cv::Point(rect_x, rect_y - 20), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0), 2);
-    cv::putText(image, std::to_string((int)params.height) + "mm", cv::Point(rect_x - 100, rect_y + rect_h / 2), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0), 2);
-
-    return image;
+    cv::putText(image, std::to_string((int)params.width) + "mm", cv::Point(rect_x, rect_y - 20), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0, 255), 2);
+    cv::putText(image, std::to_string((int)params.height) + "mm", cv::Point(rect_x - 100, rect_y + rect_h / 2), cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(0, 0, 0, 255), 2);
 }
 
-inline cv::Mat RebarCalc::generateLongitudinalSectionImage() {
-    int img_w = 1200, img_h = 400;
-    cv::Mat image(img_h, img_w, CV_8UC3, cv::Scalar(255, 255, 255));
+template <typename Concrete, typename Steel>
+inline void RebarCalcT<Concrete, Steel>::drawLongitudinalSection(cv::Mat& image) {
+    REBAR_TIME_SCOPE(Drawing);
+    int img_w = LONGITUDINAL_IMAGE_SIZE.width, img_h = LONGITUDINAL_IMAGE_SIZE.height;
+    if (image.size() != LONGITUDINAL_IMAGE_SIZE || (image.type() != CV_8UC3 && image.type() != CV_8UC4)) image.create(img_h, img_w, CV_8UC3);
+    image.setTo(cv::Scalar(255, 255, 255, 255));
 
-    if (params.span <= 0 || params.height <= 0) return image;
+    if (params.span <= 0 || params.height <= 0) return;
 
     if (!design.designPossible) {
-        cv::putText(image, "DESIGN FAILED", cv::Point(50, img_h / 2 - 20), cv::FONT_HERSHEY_SIMPLEX, 1.2, cv::Scalar(0, 0, 255), 3);
-        cv::putText(image, design.errorMessage, cv::Point(50, img_h / 2 + 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0), 1);
-        return image;
+        cv::putText(image, "DESIGN FAILED", cv::Point(50, img_h / 2 - 20), cv::FONT_HERSHEY_SIMPLEX, 1.2, cv::Scalar(0, 0, 255, 255), 3);
+        cv::putText(image, design.errorMessage, cv::Point(50, img_h / 2 + 20), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 0, 255), 1);
+        return;
     }
 
     double scale_x = (img_w * 0.9) / params.span;
@@ -415,23 +1821,29 @@ inline cv::Mat RebarCalc::generateLongitudinalSectionImage() {
     int rect_x = (img_w - rect_w) / 2;
     int rect_y = (img_h - rect_h) / 2;
 
-    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(211, 211, 211), -1);
-    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(0, 0, 0), 1);
+    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(211, 211, 211, 255), -1);
+    cv::rectangle(image, cv::Point(rect_x, rect_y), cv::Point(rect_x + rect_w, rect_y + rect_h), cv::Scalar(0, 0, 0, 255), 1);
 
-    if (design.stirrupSpacing > 0) {
-        for (double x_mm = design.stirrupSpacing; x_mm < params.span; x_mm += design.stirrupSpacing) {
-            cv::line(image, cv::Point(rect_x + (x_mm * scale_x), rect_y), cv::Point(rect_x + (x_mm * scale_x), rect_y + rect_h), cv::Scalar(128, 128, 128), 1);
+    // Each zone starts with a stirrup on its boundary; the first one starts a spacing in from the support.
+    StirrupZone zones[MAX_STIRRUP_ZONES];
+    int zoneCount = getStirrupZones(zones);
+    for (int z = 0; z < zoneCount; ++z) {
+        if (zones[z].spacing <= 0) continue;
+        for (double x_mm = zones[z].start + (z == 0 ? zones[z].spacing : 0); x_mm < zones[z].end; x_mm += zones[z].spacing) {
+            cv::line(image, cv::Point(rect_x + (x_mm * scale_x), rect_y), cv::Point(rect_x + (x_mm * scale_x), rect_y + rect_h), cv::Scalar(128, 128, 128, 255), 1);
         }
     }
 
     double y_bottom_row1 = rect_y + rect_h - (CONCRETE_COVER * scale_y) - (8.0 * scale_y) - (design.flexureRebarDiameter / 2.0 * scale_y);
     double y_bottom_row2 = y_bottom_row1 - (design.flexureRebarDiameter * scale_y) - (25.0 * scale_y);
     double y_top_section = rect_y + (CONCRETE_COVER * scale_y) + (8.0 * scale_y);
-    cv::Scalar rebar_color = rebarColorMap.at(design.flexureRebarDiameter);
-    cv::Scalar bent_rebar_color = cv::Scalar(0, 0, 255);
+    // With mixed diameters each row is drawn in the colour of its larger bar.
+    cv::Scalar rebar_color = rebarColorMap.at(design.mixedDiameters ? design.rowDiameters[0][0] : design.flexureRebarDiameter);
+    cv::Scalar bent_rebar_color = cv::Scalar(0, 0, 255, 255);
 
     if (design.rebarCountRow2 > 0) {
-        cv::line(image, cv::Point(rect_x, y_bottom_row2), cv::Point(rect_x + rect_w, y_bottom_row2), rebar_color, 2);
+        cv::Scalar row2_color = rebarColorMap.at(design.mixedDiameters ? design.rowDiameters[1][0] : design.flexureRebarDiameter);
+        cv::line(image, cv::Point(rect_x, y_bottom_row2), cv::Point(rect_x + rect_w, y_bottom_row2), row2_color, 2);
     }
 
     int bent_bar_count = design.bentRebarsUsed ? design.bentRebarCount : 0;
@@ -441,9 +1853,18 @@ inline cv::Mat RebarCalc::generateLongitudinalSectionImage() {
         cv::line(image, cv::Point(rect_x, y_bottom_row1), cv::Point(rect_x + rect_w, y_bottom_row1), rebar_color, 2);
     }
 
-    if (bent_bar_count > 0) {
-        int bend_point_bottom_left_x = rect_x + rect_w / 4;
-        int bend_point_bottom_right_x = rect_x + rect_w * 3 / 4;
+    // Pixel position of each support; a continuous girder is bent up within every span.
+    int spanCount = girderSpanCount(params);
+    auto support_x = [&](int support) {
+        if (support == 0) return rect_x;
+        if (support == spanCount) return rect_x + rect_w;
+        return rect_x + (int)(supportPosition(params, support) * scale_x);
+    };
+
+    for (int j = 0; j < spanCount && bent_bar_count > 0; ++j) {
+        int span_left_x = support_x(j), span_w = support_x(j + 1) - span_left_x;
+        int bend_point_bottom_left_x = span_left_x + span_w / 4;
+        int bend_point_bottom_right_x = span_left_x + span_w * 3 / 4;
 
         double delta_y = y_bottom_row1 - y_top_section;
         double delta_x = delta_y;
@@ -453,14 +1874,68 @@ inline cv::Mat RebarCalc::generateLongitudinalSectionImage() {
         cv::Point p_bottom_right(bend_point_bottom_right_x, y_bottom_row1);
         cv::Point p_top_right(bend_point_bottom_right_x + delta_x, y_top_section);
 
-        cv::line(image, cv::Point(rect_x, y_top_section), p_top_left, bent_rebar_color, 3);
+        cv::line(image, cv::Point(span_left_x, y_top_section), p_top_left, bent_rebar_color, 3);
         cv::line(image, p_top_left, p_bottom_left, bent_rebar_color, 3);
         cv::line(image, p_bottom_left, p_bottom_right, bent_rebar_color, 3);
         cv::line(image, p_bottom_right, p_top_right, bent_rebar_color, 3);
-        cv::line(image, p_top_right, cv::Point(rect_x + rect_w, y_top_section), bent_rebar_color, 3);
+        cv::line(image, p_top_right, cv::Point(span_left_x + span_w, y_top_section), bent_rebar_color, 3);
     }
 
-    return image;
+    if (params.spanCount > 1) {
+        // Top bars over the interior supports and a support symbol under every support.
+        if (design.topRebarCount > 0) {
+            cv::Scalar top_color = rebarColorMap.at(design.topRebarDiameter);
+            double y_top_row1 = rect_y + (CONCRETE_COVER * scale_y) + (8.0 * scale_y) + (design.topRebarDiameter / 2.0 * scale_y);
+            double y_top_row2 = y_top_row1 + (design.topRebarDiameter * scale_y) + (25.0 * scale_y);
+            for (int i = 1; i < spanCount; ++i) {
+                double start, end;
+                hoggingBarExtent(params, i, start, end);
+                cv::line(image, cv::Point(rect_x + start * scale_x, y_top_row1), cv::Point(rect_x + end * scale_x, y_top_row1), top_color, 2);
+                if (design.topRebarRows > 1) {
+                    cv::line(image, cv::Point(rect_x + start * scale_x, y_top_row2), cv::Point(rect_x + end * scale_x, y_top_row2), top_color, 2);
+                }
+            }
+        }
+        for (int i = 0; i <= spanCount; ++i) {
+            cv::Point support[3] = { cv::Point(support_x(i), rect_y + rect_h), cv::Point(support_x(i) - 10, rect_y + rect_h + 16),
+                cv::Point(support_x(i) + 10, rect_y + rect_h + 16) };
+            cv::fillConvexPoly(image, support, 3, cv::Scalar(0, 0, 0, 255));
+        }
+    }
+}
+
+typedef RebarCalcT<C50, HRB400> RebarCalc;
+
+// --- Runtime Grade Dispatch ---
+// Calls visit(MaterialTag<Concrete, Steel>()) for the policies of `grade`; the visitor
+// (typically a generic lambda) uses typename decltype(tag)::Calc to get a fully
+// specialized engine, so only the dispatch itself happens at run time.
+template <typename Concrete, typename Steel>
+struct MaterialTag
+{
+    typedef RebarCalcT<Concrete, Steel> Calc;
+};
+
+template <typename Concrete, typename Visitor>
+inline auto dispatchSteelGrade(SteelGrade steel, Visitor& visit) -> decltype(visit(MaterialTag<Concrete, HRB400>())) {
+    switch (steel) {
+    case SteelGrade::HRB335: return visit(MaterialTag<Concrete, HRB335>());
+    case SteelGrade::HRB500: return visit(MaterialTag<Concrete, HRB500>());
+    default: return visit(MaterialTag<Concrete, HRB400>());
+    }
+}
+
+template <typename Visitor>
+inline auto dispatchMaterialGrade(MaterialGrade grade, Visitor&& visit) -> decltype(visit(MaterialTag<C50, HRB400>())) {
+    switch (grade.concrete) {
+    case ConcreteGrade::C30: return dispatchSteelGrade<C30>(grade.steel, visit);
+    case ConcreteGrade::C35: return dispatchSteelGrade<C35>(grade.steel, visit);
+    case ConcreteGrade::C40: return dispatchSteelGrade<C40>(grade.steel, visit);
+    case ConcreteGrade::C45: return dispatchSteelGrade<C45>(grade.steel, visit);
+    case ConcreteGrade::C55: return dispatchSteelGrade<C55>(grade.steel, visit);
+    case ConcreteGrade::C60: return dispatchSteelGrade<C60>(grade.steel, visit);
+    default: return dispatchSteelGrade<C50>(grade.steel, visit);
+    }
 }
 
 // Auxiliary function to generate geometric parameters based on the span.
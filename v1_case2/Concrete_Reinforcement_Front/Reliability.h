@@ -0,0 +1,305 @@
+#pragma once
+
+#ifndef RELIABILITY_H
+#define RELIABILITY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "RebarCalc.h"
+#include "ThreadPool.h"
+
+// --- Random Variable ---
+// A basic variable of the reliability analysis, given by its mean and standard deviation.
+// Normal and Gumbel variables may be negative; Lognormal ones need a positive mean.
+struct RandomVariable
+{
+    enum Distribution { Fixed, Normal, Lognormal, Gumbel };
+    Distribution distribution = Fixed;
+    double mean = 0;
+    double stdDev = 0;
+
+    // Value at the standard normal variate z (the mean for Fixed).
+    double fromStandardNormal(double z) const;
+};
+
+// --- Reliability Analysis Settings ---
+// Strengths and loads are factors on the values the design used: concreteStrength scales
+// fc (and ft by its square root), steelYield scales fy, deadLoad and vehicleLoad scale the
+// dead and live parts of the design forces and resistanceModel the capacities. cover,
+// width and height are deviations (mm) from the nominal values. The defaults take the
+// design strengths to be their characteristic values divided by the material factors.
+struct ReliabilitySpec
+{
+    RandomVariable concreteStrength = { RandomVariable::Lognormal, 1.40, 0.21 };
+    RandomVariable steelYield = { RandomVariable::Lognormal, 1.20, 0.084 };
+    RandomVariable cover = { RandomVariable::Normal, 0, 6 };
+    RandomVariable width = { RandomVariable::Normal, 0, 5 };
+    RandomVariable height = { RandomVariable::Normal, 0, 5 };
+    RandomVariable deadLoad = { RandomVariable::Normal, 1.00, 0.08 };
+    RandomVariable vehicleLoad = { RandomVariable::Gumbel, 0.80, 0.12 };
+    RandomVariable resistanceModel = { RandomVariable::Lognormal, 1.00, 0.06 };
+    long long samples = 1000000;
+    uint64_t seed = 1;
+};
+
+// --- Reliability Analysis Results ---
+// A sample fails in flexure when the moment exceeds the flexural capacity or the section
+// is over-reinforced (xi at or above XI_B_LIMIT), and in shear when the support shear
+// exceeds the concrete, stirrup and bent-bar capacity. failures counts samples failing
+// in either. With no failure at all, reliabilityIndex is only the lower bound for one
+// failure in `samples` and lowerBound is set.
+struct ReliabilityResult
+{
+    long long samples = 0;
+    long long flexureFailures = 0;
+    long long shearFailures = 0;
+    long long failures = 0;
+    double failureProbability = 0;
+    double flexureProbability = 0;
+    double shearProbability = 0;
+    double reliabilityIndex = 0;
+    double estimateCoV = 0; // coefficient of variation of failureProbability
+    bool lowerBound = false;
+    double seconds = 0;
+    bool success = false;
+    std::string errorMessage;
+};
+
+// Standard normal quantile: the z with Phi(z) = p, for 0 < p < 1.
+double standardNormalQuantile(double p);
+
+// --- Counter-Based Random Numbers ---
+// Philox4x32-10: four 32-bit words from a 128-bit counter under a 64-bit key. Sample i
+// of a run uses counters (i, 0) and (i, 1) under the seed, so every sample is the same
+// whatever thread draws it and the results depend only on the seed.
+struct Philox4x32
+{
+    uint32_t key[2];
+    explicit Philox4x32(uint64_t seed) : key{ (uint32_t)seed, (uint32_t)(seed >> 32) } {}
+    void generate(uint64_t counter, uint32_t stream, uint32_t* out) const; // writes out[0..3]
+};
+
+// Estimates the failure probability of the design held by `calc` by Monte Carlo with
+// spec.samples samples, in chunks on `pool`. Only simply supported designs are supported.
+template <typename Concrete, typename Steel>
+bool runReliabilityAnalysis(const RebarCalcT<Concrete, Steel>& calc, const ReliabilitySpec& spec, ReliabilityResult& result,
+    WorkStealingPool& pool);
+
+
+// --- Function Implementations ---
+
+inline double RandomVariable::fromStandardNormal(double z) const {
+    switch (distribution) {
+    case Normal:
+        return mean + stdDev * z;
+    case Lognormal: {
+        double cov = stdDev / mean;
+        double sigma = std::sqrt(std::log1p(cov * cov));
+        return std::exp(std::log(mean) - 0.5 * sigma * sigma + sigma * z);
+    }
+    case Gumbel: {
+        // Largest-value type I through its CDF; log(Phi(z)) is taken from the upper tail so
+        // that large z keep their precision.
+        double alpha = M_PI / (stdDev * std::sqrt(6.0));
+        double mode = mean - 0.5772156649015329 / alpha;
+        double logU = std::log1p(-0.5 * std::erfc(z / std::sqrt(2.0)));
+        return mode - std::log(-logU) / alpha;
+    }
+    default:
+        return mean;
+    }
+}
+
+// Acklam's rational approximation, refined with one Halley step.
+inline double standardNormalQuantile(double p) {
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+    if (p <= 0) return -std::numeric_limits<double>::infinity();
+    if (p >= 1) return std::numeric_limits<double>::infinity();
+
+    double z;
+    if (p < 0.02425 || p > 1 - 0.02425) {
+        double q = std::sqrt(-2 * std::log(std::min(p, 1 - p)));
+        z = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+        if (p > 0.5) z = -z;
+    }
+    else {
+        double q = p - 0.5, r = q * q;
+        z = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+    }
+    double e = 0.5 * std::erfc(-z / std::sqrt(2.0)) - p;
+    double u = e * std::sqrt(2 * M_PI) * std::exp(z * z / 2);
+    return z - u / (1 + z * u / 2);
+}
+
+inline void Philox4x32::generate(uint64_t counter, uint32_t stream, uint32_t* out) const {
+    uint32_t x0 = (uint32_t)counter, x1 = (uint32_t)(counter >> 32), x2 = stream, x3 = 0;
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * x0;
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * x2;
+        uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+        uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+        x1 = (uint32_t)p1;
+        x3 = (uint32_t)p0;
+        x0 = y0;
+        x2 = y2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+}
+
+template <typename Concrete, typename Steel>
+inline bool runReliabilityAnalysis(const RebarCalcT<Concrete, Steel>& calc, const ReliabilitySpec& spec, ReliabilityResult& result,
+    WorkStealingPool& pool) {
+    typedef RebarCalcT<Concrete, Steel> Calc;
+    result = ReliabilityResult();
+    const RebarDesign& design = calc.getDesignResults();
+    const BridgeParams& params = calc.getParams();
+    if (!design.designPossible || design.flexureRebarDiameter <= 0) {
+        result.errorMessage = "Error: There is no successful design to analyse.";
+        return false;
+    }
+    if (params.spanCount > 1) {
+        result.errorMessage = "Error: Reliability analysis supports simply supported spans only.";
+        return false;
+    }
+    if (spec.samples <= 0) {
+        result.errorMessage = "Error: The sample count must be greater than zero.";
+        return false;
+    }
+    for (const RandomVariable* v : { &spec.concreteStrength, &spec.steelYield, &spec.deadLoad, &spec.vehicleLoad, &spec.resistanceModel }) {
+        if (v->stdDev < 0 || (v->distribution == RandomVariable::Lognormal && v->mean <= 0) ||
+            (v->distribution == RandomVariable::Gumbel && v->stdDev <= 0)) {
+            result.errorMessage = "Error: Invalid distribution parameters.";
+            return false;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // Nominal forces split as in calculateMaxForces: the dead part follows the sampled
+    // section, the rest of the design force is live load.
+    double L = params.span;
+    double nominalArea = params.width * params.height;
+    double q = nominalArea * Calc::CONCRETE_UNIT_WEIGHT;
+    double deadMoment = q * L * L / 8.0, liveMoment = design.maxMoment - deadMoment;
+    double deadShear = q * L / 2.0, liveShear = design.maxShear - deadShear;
+
+    // Steel as placed by the design.
+    double barArea = M_PI * pow(design.flexureRebarDiameter / 2.0, 2);
+    double As = flexuralSteelArea(design);
+    double stirrupArea = design.stirrupLegs * M_PI * pow(design.stirrupDiameter / 2.0, 2);
+    double stirrupRatio = design.stirrupSpacing > 0 ? stirrupArea / design.stirrupSpacing : 0;
+    double bentArea = design.bentRebarsUsed ? design.bentRebarCount * barArea : 0;
+
+    // Samples are drawn and checked a block at a time: the variates of a block are laid out
+    // variable by variable and the limit states run as plain loops over them.
+    constexpr int BLOCK = 256;
+    constexpr size_t CHUNK = 1 << 16;
+    const RandomVariable* variables[8] = { &spec.concreteStrength, &spec.steelYield, &spec.cover, &spec.width,
+        &spec.height, &spec.deadLoad, &spec.vehicleLoad, &spec.resistanceModel };
+    Philox4x32 rng(spec.seed);
+    size_t samples = (size_t)spec.samples;
+    size_t chunks = (samples + CHUNK - 1) / CHUNK;
+    struct Counts { long long flexure = 0, shear = 0, either = 0; };
+    std::vector<Counts> chunkCounts(chunks);
+
+    parallelFor(pool, 0, chunks, 1, [&](size_t firstChunk, size_t lastChunk) {
+        alignas(64) double x[8][BLOCK];
+        for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+            Counts counts;
+            size_t chunkEnd = std::min(samples, (chunk + 1) * CHUNK);
+            for (size_t blockBegin = chunk * CHUNK; blockBegin < chunkEnd; blockBegin += BLOCK) {
+                int n = (int)std::min<size_t>(BLOCK, chunkEnd - blockBegin);
+
+                // Eight uniforms per sample, turned into eight standard normals in pairs.
+                for (int i = 0; i < n; ++i) {
+                    uint32_t words[8];
+                    rng.generate(blockBegin + i, 0, words);
+                    rng.generate(blockBegin + i, 1, words + 4);
+                    for (int k = 0; k < 8; k += 2) {
+                        double u1 = (words[k] + 0.5) * (1.0 / 4294967296.0);
+                        double u2 = (words[k + 1] + 0.5) * (1.0 / 4294967296.0);
+                        double r = std::sqrt(-2.0 * std::log(u1));
+                        x[k][i] = r * std::cos(2 * M_PI * u2);
+                        x[k + 1][i] = r * std::sin(2 * M_PI * u2);
+                    }
+                }
+                for (int k = 0; k < 8; ++k) {
+                    const RandomVariable& v = *variables[k];
+                    double* column = x[k];
+                    if (v.distribution == RandomVariable::Normal) {
+                        for (int i = 0; i < n; ++i) column[i] = v.mean + v.stdDev * column[i];
+                    }
+                    else {
+                        for (int i = 0; i < n; ++i) column[i] = v.fromStandardNormal(column[i]);
+                    }
+                }
+
+                const double* fcFactor = x[0];
+                const double* fyFactor = x[1];
+                const double* dCover = x[2];
+                const double* dWidth = x[3];
+                const double* dHeight = x[4];
+                const double* dead = x[5];
+                const double* live = x[6];
+                const double* model = x[7];
+                int flexure = 0, shear = 0, either = 0;
+                for (int i = 0; i < n; ++i) {
+                    double b = params.width + dWidth[i];
+                    double h0 = params.h0 + dHeight[i] - dCover[i];
+                    double fy = Calc::STEEL_FY * fyFactor[i];
+                    double fc = Calc::CONCRETE_FC * fcFactor[i];
+                    double ft = Calc::CONCRETE_FT * std::sqrt(fcFactor[i]);
+                    double selfWeight = dead[i] * b * (params.height + dHeight[i]) / nominalArea;
+
+                    double moment = selfWeight * deadMoment + live[i] * liveMoment;
+                    double momentCapacity = model[i] * As * fy * 0.9 * h0;
+                    double xi = As * fy / (fc * b) / h0;
+                    int flexureFails = (moment > momentCapacity) | (xi >= Calc::XI_B_LIMIT);
+
+                    double shearForce = selfWeight * deadShear + live[i] * liveShear;
+                    double shearCapacity = model[i] * (0.20 * ft * b * h0 + stirrupRatio * fy * h0 + 0.75 * fy * bentArea * std::sin(M_PI / 4.0));
+                    int shearFails = shearForce > shearCapacity;
+
+                    flexure += flexureFails;
+                    shear += shearFails;
+                    either += flexureFails | shearFails;
+                }
+                counts.flexure += flexure;
+                counts.shear += shear;
+                counts.either += either;
+            }
+            chunkCounts[chunk] = counts;
+        }
+    });
+
+    for (const Counts& counts : chunkCounts) {
+        result.flexureFailures += counts.flexure;
+        result.shearFailures += counts.shear;
+        result.failures += counts.either;
+    }
+    result.samples = spec.samples;
+    double N = (double)spec.samples;
+    result.failureProbability = result.failures / N;
+    result.flexureProbability = result.flexureFailures / N;
+    result.shearProbability = result.shearFailures / N;
+    result.lowerBound = result.failures == 0;
+    double pf = result.lowerBound ? 1.0 / N : result.failureProbability;
+    result.reliabilityIndex = pf < 1 ? -standardNormalQuantile(pf) : -std::numeric_limits<double>::infinity();
+    result.estimateCoV = result.failures > 0 ? std::sqrt((1 - pf) / (N * pf)) : 0;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.success = true;
+    return true;
+}
+
+
+#endif // RELIABILITY_H
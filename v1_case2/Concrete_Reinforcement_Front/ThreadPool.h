@@ -0,0 +1,286 @@
+#pragma once
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- Work-Stealing Thread Pool ---
+// Every worker owns a deque: it pops its own work from the back (LIFO, cache-warm)
+// and steals from the front of the other deques when it runs dry. Tasks submitted
+// from outside the pool are spread round-robin over the worker deques.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Runs one queued task on the calling thread, if there is one. Used by waiters
+    // so that blocking on a TaskGroup never starves the pool (and never deadlocks
+    // when a task itself waits on nested work).
+    bool runPendingTask();
+    unsigned size() const { return (unsigned)workers.size(); }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue{ 0 };
+    std::atomic<int> queuedTasks{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+
+    bool popTask(unsigned preferredQueue, std::function<void()>& task);
+    void workerLoop(unsigned index);
+    static unsigned& currentWorkerIndex();
+};
+
+// --- Task Group ---
+// Tracks a set of tasks submitted to a pool so that a caller can wait for exactly
+// its own work, independently of anything else running on the same pool.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(WorkStealingPool& pool) : pool(pool) {}
+    ~TaskGroup() { finishTasks(); }
+
+    void run(std::function<void()> task);
+    // Waits for every task, then rethrows the first exception one of them threw.
+    void wait();
+
+private:
+    WorkStealingPool& pool;
+    std::atomic<int> pending{ 0 };
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void finishTasks();
+};
+
+// Splits [begin, end) into chunks of `grain` indices and runs body(chunkBegin, chunkEnd)
+// for each chunk on the pool. Blocks until every chunk has finished.
+template <typename Body>
+void parallelFor(WorkStealingPool& pool, size_t begin, size_t end, size_t grain, Body body);
+
+// Process-wide pool shared by the batch, sweep and service front ends.
+WorkStealingPool& sharedDesignPool();
+
+// --- Bounded Queue ---
+// Blocking FIFO between the stages of a pipeline that run on threads of their own: push
+// waits while `capacity` items are queued, so a fast stage cannot run away from a slow
+// one, and pop waits for an item. After close() pushes fail and pops drain what is left.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+    bool push(T item);
+    // False once the queue is closed and empty.
+    bool pop(T& item);
+    void close();
+
+private:
+    std::mutex mutex;
+    std::condition_variable notFull, notEmpty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+};
+
+
+// --- Function Implementations ---
+
+inline WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+
+    for (unsigned i = 0; i < threadCount; ++i) queues.emplace_back(new WorkerQueue());
+    for (unsigned i = 0; i < threadCount; ++i) workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+inline unsigned& WorkStealingPool::currentWorkerIndex() {
+    // Index of the worker running on this thread, or ~0u for foreign threads.
+    thread_local unsigned index = ~0u;
+    return index;
+}
+
+inline void WorkStealingPool::submit(std::function<void()> task) {
+    unsigned target = currentWorkerIndex();
+    if (target >= queues.size()) target = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    queuedTasks.fetch_add(1, std::memory_order_release);
+    {
+        // Taking the sleep mutex orders the push against a worker that is about to sleep.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+inline bool WorkStealingPool::popTask(unsigned preferredQueue, std::function<void()>& task) {
+    if (queuedTasks.load(std::memory_order_acquire) <= 0) return false;
+
+    unsigned count = (unsigned)queues.size();
+    if (preferredQueue < count) {
+        WorkerQueue& own = *queues[preferredQueue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    unsigned start = (preferredQueue < count) ? preferredQueue + 1 : nextQueue.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < count; ++i) {
+        WorkerQueue& victim = *queues[(start + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool WorkStealingPool::runPendingTask() {
+    std::function<void()> task;
+    if (!popTask(currentWorkerIndex(), task)) return false;
+    task();
+    return true;
+}
+
+inline void WorkStealingPool::workerLoop(unsigned index) {
+    currentWorkerIndex() = index;
+    std::function<void()> task;
+    while (true) {
+        if (popTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this] { return stopping || queuedTasks.load(std::memory_order_acquire) > 0; });
+        if (stopping && queuedTasks.load(std::memory_order_acquire) <= 0) return;
+    }
+}
+
+inline void TaskGroup::run(std::function<void()> task) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    pool.submit([this, task = std::move(task)]() {
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        }
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+    });
+}
+
+inline void TaskGroup::wait() {
+    finishTasks();
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        std::swap(failure, error);
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+inline void TaskGroup::finishTasks() {
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!pool.runPendingTask()) std::this_thread::yield();
+    }
+}
+
+template <typename Body>
+void parallelFor(WorkStealingPool& pool, size_t begin, size_t end, size_t grain, Body body) {
+    if (begin >= end) return;
+    if (grain == 0) grain = 1;
+
+    TaskGroup group(pool);
+    for (size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grain) {
+        size_t chunkEnd = std::min(end, chunkBegin + grain);
+        group.run([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); });
+    }
+    group.wait();
+}
+
+inline WorkStealingPool& sharedDesignPool() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+template <typename T>
+inline bool BoundedQueue<T>::push(T item) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+    }
+    notEmpty.notify_one();
+    return true;
+}
+
+template <typename T>
+inline bool BoundedQueue<T>::pop(T& item) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+    }
+    notFull.notify_one();
+    return true;
+}
+
+template <typename T>
+inline void BoundedQueue<T>::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    notFull.notify_all();
+    notEmpty.notify_all();
+}
+
+
+#endif // THREADPOOL_H
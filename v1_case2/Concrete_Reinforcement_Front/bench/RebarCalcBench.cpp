@@ -0,0 +1,560 @@
+// --- RebarCalc Micro-Benchmark ---
+// Times the design and drawing hot paths of RebarCalc over a fixed corpus of beams and
+// optionally compares the result with a stored baseline. Needs no Qt; build it on Linux
+// next to the project headers, e.g.
+//
+//   g++ -std=c++17 -O2 -I.. RebarCalcBench.cpp $(pkg-config --cflags --libs opencv4) -o rebarcalc_bench
+//
+// and run
+//
+//   ./rebarcalc_bench --json current.json [--baseline baseline.json] [--threshold 10]
+//
+// With a baseline, any benchmark whose ns/op grew by more than the threshold (percent),
+// or whose allocations per op grew at all, is reported and the run exits with status 1.
+
+#include "../BatchRunner.h"
+#include "../RebarCalc.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Allocation Counter ---
+// Every global operator new in the process goes through here, including OpenCV's and the
+// standard library's, so allocations per op include everything a stage causes.
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+// --- Beam Corpus ---
+struct BenchBeam
+{
+    double span, width, height, load, wheelSpan, girderSpacing;
+};
+
+// Highway girders as they come up in practice: spans of 8-30 m, span/depth ratios of
+// 10-18, webs of 300-700 mm, design vehicles of 200-650 kN. A few beams are deliberately
+// too slender to be designed, so the failure paths are timed as well. The generator is
+// a fixed xorshift, so every platform and compiler sees the same corpus.
+inline std::vector<BenchBeam> makeBenchCorpus(size_t count, uint64_t seed) {
+    uint64_t state = seed ? seed : 1;
+    auto next = [&state](int choices) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (int)(state % (uint64_t)choices);
+    };
+    std::vector<BenchBeam> corpus(count);
+    for (BenchBeam& beam : corpus) {
+        beam.span = 8000.0 + 1000.0 * next(23);
+        beam.width = 300.0 + 50.0 * next(9);
+        double ratio = 10.0 + next(9);
+        beam.height = std::round(beam.span / ratio / 50.0) * 50.0;
+        beam.load = 200.0 + 50.0 * next(10);
+        beam.wheelSpan = 1.2 + 0.6 * next(2);
+        beam.girderSpacing = 1800.0 + 200.0 * next(6);
+    }
+    return corpus;
+}
+
+// --- Continuous Envelope Check ---
+// The continuous-girder envelope against a brute force that steps the train in fine
+// steps and solves the three-moment equation exactly at every position, on spans of
+// unequal length. Returns the largest shortfall of the envelope below the brute force
+// as a fraction of the brute-force peak of the same quantity (0 when it is conservative).
+inline double continuousEnvelopeShortfall(const std::vector<double>& spans, const AxleTrain& train, int intervalsPerSpan, double step) {
+    ContinuousBeamAnalyzer analyzer;
+    ContinuousEnvelope envelope;
+    analyzer.computeEnvelope(spans, train, intervalsPerSpan, true, envelope);
+
+    int n = (int)spans.size();
+    std::vector<double> start(n + 1, 0.0);
+    for (int j = 0; j < n; ++j) start[j + 1] = start[j] + spans[j];
+    size_t count = envelope.stationCount();
+    std::vector<double> mMax(count, 0.0), mMin(count, 0.0), vMax(count, 0.0), vMin(count, 0.0);
+    std::vector<double> rhs(n + 1), c(n + 1), M(n + 1);
+    double length = train.length();
+    for (int direction = 0; direction < 2; ++direction) {
+        for (double lead = 0; lead <= start[n] + length + step; lead += step) {
+            // Interior support i: L_{i-1} M_{i-1} + 2 (L_{i-1} + L_i) M_i + L_i M_{i+1} = rhs_i.
+            std::fill(rhs.begin(), rhs.end(), 0.0);
+            for (size_t a = 0; a < train.size(); ++a) {
+                double offset = direction ? length - train.offsets[a] : train.offsets[a];
+                double p = lead - offset;
+                if (p < 0 || p > start[n]) continue;
+                int j = (int)(std::upper_bound(start.begin() + 1, start.end() - 1, p) - start.begin()) - 1;
+                double L = spans[j], u = p - start[j], P = train.loads[a] * 1000.0;
+                if (j + 1 < n) rhs[j + 1] -= P * u * (L * L - u * u) / L;
+                if (j > 0) rhs[j] -= P * (L - u) * (L * L - (L - u) * (L - u)) / L;
+            }
+            M.assign(n + 1, 0.0);
+            if (n > 1) {
+                // Thomas algorithm over the interior supports 1..n-1.
+                for (int i = 1; i < n; ++i) {
+                    double diag = 2.0 * (spans[i - 1] + spans[i]), low = i > 1 ? spans[i - 1] : 0.0;
+                    double pivot = diag - (i > 1 ? low * c[i - 1] : 0.0);
+                    c[i] = (i < n - 1 ? spans[i] : 0.0) / pivot;
+                    rhs[i] = (rhs[i] - (i > 1 ? low * rhs[i - 1] : 0.0)) / pivot;
+                }
+                for (int i = n - 1; i >= 1; --i) M[i] = rhs[i] - (i < n - 1 ? c[i] * M[i + 1] : 0.0);
+            }
+            for (size_t s = 0; s < count; ++s) {
+                int j = envelope.stationSpan[s];
+                double L = spans[j], x = envelope.stations[s] - start[j];
+                double moment = M[j] * (1.0 - x / L) + M[j + 1] * (x / L);
+                double shear = (M[j + 1] - M[j]) / L;
+                for (size_t a = 0; a < train.size(); ++a) {
+                    double offset = direction ? length - train.offsets[a] : train.offsets[a];
+                    double p = lead - offset;
+                    if (p < start[j] || p > start[j + 1]) continue;
+                    double u = p - start[j], P = train.loads[a] * 1000.0;
+                    moment += u < x ? P * u * (L - x) / L : P * x * (L - u) / L;
+                    shear += u < x ? -P * u / L : P * (1.0 - u / L);
+                }
+                mMax[s] = std::max(mMax[s], moment);
+                mMin[s] = std::min(mMin[s], moment);
+                vMax[s] = std::max(vMax[s], shear);
+                vMin[s] = std::min(vMin[s], shear);
+            }
+        }
+    }
+
+    double peak[4] = { 0, 0, 0, 0 };
+    for (size_t s = 0; s < count; ++s) {
+        peak[0] = std::max(peak[0], mMax[s]);
+        peak[1] = std::max(peak[1], -mMin[s]);
+        peak[2] = std::max(peak[2], vMax[s]);
+        peak[3] = std::max(peak[3], -vMin[s]);
+    }
+    double worst = 0;
+    for (size_t s = 0; s < count; ++s) {
+        worst = std::max(worst, (mMax[s] - envelope.momentMax[s]) / peak[0]);
+        worst = std::max(worst, (envelope.momentMin[s] - mMin[s]) / peak[1]);
+        worst = std::max(worst, (vMax[s] - envelope.shearMax[s]) / peak[2]);
+        worst = std::max(worst, (envelope.shearMin[s] - vMin[s]) / peak[3]);
+    }
+    return worst;
+}
+
+// --- Benchmark Harness ---
+struct BenchResult
+{
+    std::string name;
+    double nsPerOp = 0;
+    double allocationsPerOp = 0;
+    double opsPerSecond = 0;
+    long long operations = 0;
+};
+
+// Needs private access to time the design stages one by one (see the friend
+// declaration in RebarCalc).
+class RebarCalcBench
+{
+public:
+    RebarCalcBench(const std::vector<BenchBeam>& corpus, double minSeconds) : corpus(corpus), minSeconds(minSeconds) {}
+    void run(const std::string& filter, std::vector<BenchResult>& results);
+    size_t feasibleBeams() const;
+
+private:
+    // The state each stage starts from, prepared once per beam outside the timed loops.
+    struct PreparedBeam
+    {
+        BridgeParams params;
+        double momentLoad, shearLoad; // N, already distributed to one girder
+        RebarDesign forces;           // after calculateMaxForces
+        RebarDesign design;           // the finished design (feasible beams only)
+        BridgeParams designParams;
+        bool feasible;
+    };
+
+    const std::vector<BenchBeam>& corpus;
+    double minSeconds;
+    std::vector<PreparedBeam> prepared;
+    RebarCalc calc;
+    DesignScratch scratch;
+    DesignKernelResult kernelResult;
+    std::vector<BeamInput> batchInputs;
+    std::vector<BeamResult> batchResults;
+    double sink = 0; // consumed results, so that nothing is optimized away
+    static constexpr double SAMPLE_SECONDS = 0.002;
+
+    void prepare();
+    // A sample repeats passes over the corpus for at least SAMPLE_SECONDS, so that the
+    // clock resolution does not matter for the fast stages. Samples are taken until both
+    // minSeconds and five samples have been spent; ns/op is the median sample.
+    BenchResult measure(const std::string& name, const std::function<long long()>& pass);
+};
+
+inline void RebarCalcBench::prepare() {
+    prepared.clear();
+    prepared.reserve(corpus.size());
+    for (const BenchBeam& beam : corpus) {
+        PreparedBeam p;
+        calc.runDesign(beam.span, beam.width, beam.height, beam.load, beam.wheelSpan, beam.girderSpacing);
+        p.feasible = calc.design.designPossible;
+        p.design = calc.design;
+        p.designParams = calc.params;
+        calc.distributeVehicleLoad(beam.load, beam.girderSpacing, p.momentLoad, p.shearLoad);
+        p.momentLoad *= 1000.0;
+        p.shearLoad *= 1000.0;
+        calc.resetDesign();
+        calc.params.span = beam.span;
+        calc.params.width = beam.width;
+        calc.params.height = beam.height;
+        calc.params.wheelSpan = beam.wheelSpan * 1000.0;
+        calc.params.girderSpacing = beam.girderSpacing;
+        calc.calculateMaxForces(p.momentLoad, p.shearLoad);
+        p.params = calc.params;
+        p.forces = calc.design;
+        prepared.push_back(std::move(p));
+    }
+}
+
+inline size_t RebarCalcBench::feasibleBeams() const {
+    size_t count = 0;
+    for (const PreparedBeam& p : prepared) count += p.feasible ? 1 : 0;
+    return count;
+}
+
+inline BenchResult RebarCalcBench::measure(const std::string& name, const std::function<long long()>& pass) {
+    pass(); // warm-up: caches, lazily grown buffers
+
+    std::vector<double> samples;
+    long long operations = 0;
+    long long allocations = 0;
+    double elapsed = 0;
+    while (elapsed < minSeconds || samples.size() < 5) {
+        long long allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        long long ops = 0;
+        double seconds = 0;
+        do {
+            long long passOps = pass();
+            if (passOps <= 0) break;
+            ops += passOps;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (seconds < SAMPLE_SECONDS);
+        allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        if (ops <= 0) break;
+        operations += ops;
+        elapsed += seconds;
+        samples.push_back(seconds * 1e9 / ops);
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.operations = operations;
+    if (!samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        result.nsPerOp = samples[samples.size() / 2];
+        result.allocationsPerOp = (double)allocations / operations;
+        result.opsPerSecond = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0;
+    }
+    return result;
+}
+
+inline void RebarCalcBench::run(const std::string& filter, std::vector<BenchResult>& results) {
+    prepare();
+    auto wanted = [&filter](const char* name) { return filter.empty() || std::strstr(name, filter.c_str()); };
+
+    if (wanted("runDesign")) {
+        results.push_back(measure("runDesign", [this]() {
+            for (const BenchBeam& b : corpus) {
+                calc.runDesign(b.span, b.width, b.height, b.load, b.wheelSpan, b.girderSpacing);
+                sink += calc.design.totalCost;
+            }
+            return (long long)corpus.size();
+        }));
+    }
+    // The kernel in every mode that changes its work: uniform and zoned stirrups, and the
+    // mixed-diameter row tables, which live in the scratch.
+    static const struct { const char* name; bool zoned, mixed; } kernelModes[] = {
+        { "designKernel", false, false }, { "designKernel/zoned", true, false }, { "designKernel/mixed", false, true } };
+    for (const auto& mode : kernelModes) {
+        if (!wanted(mode.name)) continue;
+        calc.setStirrupZoning(mode.zoned);
+        calc.setMixedDiameters(mode.mixed);
+        results.push_back(measure(mode.name, [this]() {
+            for (const BenchBeam& b : corpus) {
+                calc.designKernel(b.span, b.width, b.height, b.load, b.wheelSpan, b.girderSpacing, scratch, kernelResult);
+                sink += kernelResult.design.totalCost;
+            }
+            return (long long)corpus.size();
+        }));
+    }
+    calc.setStirrupZoning(false);
+    calc.setMixedDiameters(false);
+    // The batch front end as --batch runs it, per row: the default cache answering repeats,
+    // and a cache too small for the corpus, where every row misses and evicts.
+    static const struct { const char* name; size_t cacheEntries; } batchModes[] = {
+        { "batch/default", 65536 }, { "batch/cacheMisses", 0 } };
+    for (const auto& mode : batchModes) {
+        if (!wanted(mode.name)) continue;
+        batchInputs.resize(corpus.size());
+        for (size_t i = 0; i < corpus.size(); ++i) {
+            const BenchBeam& b = corpus[i];
+            batchInputs[i].span = b.span;
+            batchInputs[i].width = b.width;
+            batchInputs[i].height = b.height;
+            batchInputs[i].vehicleLoad = b.load;
+            batchInputs[i].wheelSpan = b.wheelSpan;
+            batchInputs[i].girderSpacing = b.girderSpacing;
+        }
+        DesignCache cache(mode.cacheEntries > 0 ? mode.cacheEntries : corpus.size() / 4);
+        BatchRunner runner(sharedDesignPool());
+        runner.setCache(&cache);
+        results.push_back(measure(mode.name, [this, &runner]() {
+            runner.designBlock(batchInputs, batchResults);
+            sink += batchResults[0].design.totalCost;
+            return (long long)batchInputs.size();
+        }));
+    }
+    if (wanted("calculateMaxForces")) {
+        results.push_back(measure("calculateMaxForces", [this]() {
+            for (const PreparedBeam& p : prepared) {
+                calc.params = p.params;
+                calc.calculateMaxForces(p.momentLoad, p.shearLoad);
+                sink += calc.design.maxMoment;
+            }
+            return (long long)prepared.size();
+        }));
+    }
+    if (wanted("findOptimalDesign")) {
+        // Restoring the forces is a plain struct copy and is timed along with the search.
+        results.push_back(measure("findOptimalDesign", [this]() {
+            for (const PreparedBeam& p : prepared) {
+                calc.params = p.params;
+                calc.design = p.forces;
+                calc.findOptimalDesign();
+                sink += calc.design.totalCost;
+            }
+            return (long long)prepared.size();
+        }));
+    }
+    if (wanted("designShearForIteration")) {
+        results.push_back(measure("designShearForIteration", [this]() {
+            long long ops = 0;
+            for (const PreparedBeam& p : prepared) {
+                if (!p.feasible) continue;
+                RebarDesign tempDesign = p.design;
+                calc.designShearForIteration(tempDesign, p.designParams);
+                sink += tempDesign.stirrupSpacing;
+                ++ops;
+            }
+            return ops;
+        }));
+    }
+    if (wanted("calculateTotalCostForIteration")) {
+        results.push_back(measure("calculateTotalCostForIteration", [this]() {
+            long long ops = 0;
+            for (const PreparedBeam& p : prepared) {
+                if (!p.feasible) continue;
+                RebarDesign tempDesign = p.design;
+                calc.calculateTotalCostForIteration(tempDesign, p.designParams);
+                sink += tempDesign.totalCost;
+                ++ops;
+            }
+            return ops;
+        }));
+    }
+    // The drawings are far slower than the design, so they cycle through a slice of the corpus.
+    const size_t drawingBeams = std::min<size_t>(prepared.size(), 64);
+    if (wanted("generateCrossSectionImage")) {
+        results.push_back(measure("generateCrossSectionImage", [this, drawingBeams]() {
+            for (size_t i = 0; i < drawingBeams; ++i) {
+                calc.restoreDesign(prepared[i].designParams, prepared[i].design);
+                cv::Mat image = calc.generateCrossSectionImage();
+                sink += image.rows;
+            }
+            return (long long)drawingBeams;
+        }));
+    }
+    if (wanted("generateLongitudinalSectionImage")) {
+        results.push_back(measure("generateLongitudinalSectionImage", [this, drawingBeams]() {
+            for (size_t i = 0; i < drawingBeams; ++i) {
+                calc.restoreDesign(prepared[i].designParams, prepared[i].design);
+                cv::Mat image = calc.generateLongitudinalSectionImage();
+                sink += image.rows;
+            }
+            return (long long)drawingBeams;
+        }));
+    }
+    if (sink == 42.0) std::cerr << "";
+}
+
+// --- JSON Report ---
+inline void writeBenchJson(std::ostream& out, const std::vector<BenchResult>& results, size_t corpusSize, uint64_t seed) {
+    out << std::setprecision(10);
+    out << "{\n  \"corpus\": " << corpusSize << ",\n  \"seed\": " << seed << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp << ", \"allocs_per_op\": " << r.allocationsPerOp
+            << ", \"ops_per_sec\": " << r.opsPerSecond << ", \"operations\": " << r.operations << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads back the benchmarks of a report written by writeBenchJson (name, ns/op and
+// allocations per op; everything else is ignored).
+inline bool readBenchJson(std::istream& in, std::vector<BenchResult>& results) {
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    auto numberAfter = [&text](size_t from, const char* key, double& value) {
+        size_t at = text.find(key, from);
+        if (at == std::string::npos) return false;
+        value = std::strtod(text.c_str() + at + std::strlen(key), nullptr);
+        return true;
+    };
+    size_t pos = 0;
+    while ((pos = text.find("\"name\": \"", pos)) != std::string::npos) {
+        pos += 9;
+        size_t end = text.find('"', pos);
+        if (end == std::string::npos) return false;
+        BenchResult r;
+        r.name = text.substr(pos, end - pos);
+        size_t objectEnd = text.find('}', end);
+        if (!numberAfter(end, "\"ns_per_op\": ", r.nsPerOp) || !numberAfter(end, "\"allocs_per_op\": ", r.allocationsPerOp)
+            || text.find("\"ns_per_op\": ", end) > objectEnd) {
+            return false;
+        }
+        results.push_back(r);
+        pos = end;
+    }
+    return !results.empty();
+}
+
+int main(int argc, char* argv[]) {
+    size_t corpusSize = 2000;
+    uint64_t seed = 20240601;
+    double minMilliseconds = 300;
+    double threshold = 10;
+    std::string filter, jsonPath, baselinePath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--corpus" && i + 1 < argc) corpusSize = (size_t)std::atoll(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = (uint64_t)std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--min-time" && i + 1 < argc) minMilliseconds = std::atof(argv[++i]);
+        else if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) threshold = std::atof(argv[++i]);
+        else {
+            std::cerr << "Usage: rebarcalc_bench [--corpus N] [--seed N] [--min-time ms] [--filter name] [--json out.json]"
+                " [--baseline baseline.json] [--threshold percent]\n";
+            return 2;
+        }
+    }
+    if (corpusSize == 0) {
+        std::cerr << "Error: The corpus must hold at least one beam\n";
+        return 2;
+    }
+
+    std::vector<BenchBeam> corpus = makeBenchCorpus(corpusSize, seed);
+    RebarCalcBench bench(corpus, minMilliseconds / 1000.0);
+    std::vector<BenchResult> results;
+    bench.run(filter, results);
+
+    std::cout << corpusSize << " beams (" << bench.feasibleBeams() << " feasible), seed " << seed << "\n";
+    std::cout << std::left << std::setw(34) << "benchmark" << std::right << std::setw(14) << "ns/op" << std::setw(14) << "allocs/op"
+        << std::setw(16) << "ops/s" << "\n";
+    for (const BenchResult& r : results) {
+        std::cout << std::left << std::setw(34) << r.name << std::right << std::fixed << std::setprecision(1) << std::setw(14) << r.nsPerOp
+            << std::setprecision(2) << std::setw(14) << r.allocationsPerOp << std::setprecision(0) << std::setw(16) << r.opsPerSecond << "\n";
+    }
+
+    // The design kernel promises no heap allocation once its scratch is warm (the warm-up
+    // pass of measure), whatever the baseline says. The batch front end may allocate for
+    // each pool task of GRAIN_SIZE rows (the task itself), but not for each row.
+    int failedChecks = 0;
+    for (const BenchResult& r : results) {
+        if (r.name.compare(0, 12, "designKernel") == 0 && r.allocationsPerOp > 0) {
+            std::cerr << "Error: " << r.name << " allocates " << std::setprecision(2) << r.allocationsPerOp << " times per design\n";
+            ++failedChecks;
+        }
+        if (r.name.compare(0, 5, "batch") == 0 && r.allocationsPerOp * BatchRunner::GRAIN_SIZE > 8) {
+            std::cerr << "Error: " << r.name << " allocates " << std::setprecision(2) << r.allocationsPerOp * BatchRunner::GRAIN_SIZE
+                << " times per pool task\n";
+            ++failedChecks;
+        }
+    }
+
+    // The continuous-girder envelope must not fall below a fine-step brute force by more
+    // than the interpolation of its influence table (a few hundredths of a percent).
+    if (filter.empty() || std::strstr("continuousEnvelope", filter.c_str())) {
+        AxleTrain train;
+        AxleTrain::parse("35@0,145@4.3,145@8.6", train);
+        const std::vector<std::vector<double>> girders = { { 20000, 35000, 25000 }, { 12000, 41000 }, { 18000, 27000, 33000, 21000, 15000 } };
+        double worst = 0;
+        for (const std::vector<double>& spans : girders) {
+            worst = std::max(worst, continuousEnvelopeShortfall(spans, train, ContinuousBeamAnalyzer::DEFAULT_INTERVALS_PER_SPAN, 5.0));
+        }
+        std::cout << "continuousEnvelope: worst shortfall " << std::setprecision(3) << worst * 100.0 << "% against a 5 mm brute force\n";
+        if (worst > 0.001) {
+            std::cerr << "Error: The continuous-girder envelope is unconservative by " << worst * 100.0 << "%\n";
+            ++failedChecks;
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: Cannot open output file " << jsonPath << "\n";
+            return 1;
+        }
+        writeBenchJson(out, results, corpusSize, seed);
+    }
+
+    if (failedChecks > 0) return 1;
+    if (baselinePath.empty()) return 0;
+    std::ifstream in(baselinePath, std::ios::binary);
+    std::vector<BenchResult> baseline;
+    if (!in || !readBenchJson(in, baseline)) {
+        std::cerr << "Error: Cannot read baseline file " << baselinePath << "\n";
+        return 1;
+    }
+    int regressions = 0;
+    for (const BenchResult& r : results) {
+        for (const BenchResult& b : baseline) {
+            if (b.name != r.name) continue;
+            double change = b.nsPerOp > 0 ? (r.nsPerOp / b.nsPerOp - 1.0) * 100.0 : 0.0;
+            bool slower = change > threshold;
+            // Allocation counts do not depend on timing noise, so any growth is a regression.
+            bool allocates = r.allocationsPerOp > b.allocationsPerOp + 1e-9;
+            std::cout << (slower || allocates ? "REGRESSION " : "ok         ") << std::left << std::setw(34) << r.name << std::right
+                << std::showpos << std::setprecision(1) << std::setw(8) << change << "%" << std::noshowpos;
+            if (allocates) std::cout << "  allocs/op " << std::setprecision(2) << b.allocationsPerOp << " -> " << r.allocationsPerOp;
+            std::cout << "\n";
+            if (slower || allocates) ++regressions;
+        }
+    }
+    if (regressions > 0) {
+        std::cerr << regressions << " benchmark(s) regressed beyond " << threshold << "% against " << baselinePath << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,9 +1,37 @@
 #include "stdafx.h"
 #include "Concrete_Reinforcement_Front.h"
+#include "BatchRunner.h"
+#include "DesignService.h"
+#include "Fatigue.h"
+#include "DesignSurrogate.h"
 #include <QtWidgets/QApplication>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // Headless batch mode: design a whole file of beams without creating any Qt objects.
+    if (argc > 1 && std::strcmp(argv[1], "--batch") == 0) {
+        return runBatchCommandLine(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--query") == 0) {
+        return runStoreQueryCommandLine(argc, argv);
+    }
+    // Design service: answers JSON-lines requests on stdin/stdout or a local socket.
+    if (argc > 1 && std::strcmp(argv[1], "--serve") == 0) {
+        return runServiceCommandLine(argc, argv);
+    }
+    // Fatigue check of one design against a weigh-in-motion traffic record.
+    if (argc > 1 && std::strcmp(argv[1], "--fatigue") == 0) {
+        return runFatigueCommandLine(argc, argv);
+    }
+    // Surrogate table for instant previews: build it offline, or measure its error.
+    if (argc > 1 && std::strcmp(argv[1], "--build-surrogate") == 0) {
+        return runBuildSurrogateCommandLine(argc, argv);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--surrogate-check") == 0) {
+        return runSurrogateCheckCommandLine(argc, argv);
+    }
+
     // QApplication is a class that manages the GUI application's control flow and main settings.
     QApplication a(argc, argv);
     // Concrete_Reinforcement_Front is the main window of the application.